@@ -76,9 +76,17 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
         get_clause(x->conds, query->conds);
         check_clause({x->tab_name}, query->conds);        
     } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(parse)) {
-        // 处理insert 的values值
-        for (auto &sv_val : x->vals) {
-            query->values.push_back(convert_sv_value(sv_val));
+        // 处理insert 的values值，每行一组
+        for (auto &sv_row : x->rows) {
+            std::vector<Value> row;
+            for (auto &sv_val : sv_row) {
+                row.push_back(convert_sv_value(sv_val));
+            }
+            query->values.push_back(std::move(row));
+        }
+    } else if (auto x = std::dynamic_pointer_cast<ast::CopyFrom>(parse)) {
+        if (!sm_manager_->db_.is_table(x->tab_name)) {
+            throw TableNotFoundError(x->tab_name);
         }
     } else {
         // do nothing
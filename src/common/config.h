@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <string>
 
 #define BUFFER_LENGTH 8192
 
@@ -34,6 +35,8 @@ static constexpr int HEADER_PAGE_ID = 0;                                      //
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte  4KB
 static constexpr int BUFFER_POOL_SIZE = 65536;                                // size of buffer pool 256MB
 // static constexpr int BUFFER_POOL_SIZE = 262144;                                // size of buffer pool 1GB
+static constexpr int BUFFER_POOL_INSTANCES = 1;                               // default number of buffer pool partitions
+static constexpr size_t BUFFER_POOL_RESIZE_TIMEOUT_MS = 1000;                 // how long a shrink waits for pinned pages
 static constexpr int LOG_BUFFER_SIZE = (1024 * PAGE_SIZE);                    // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
 
@@ -45,10 +48,38 @@ using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 using timestamp_t = int32_t;  // timestamp type, used for transaction concurrency
 
+// buffer pool frame memory: frames live in one page-aligned region, optionally on 2MB huge pages
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;                          // try MAP_HUGETLB, then transparent huge pages
+static constexpr int BUFFER_POOL_NUMA_SPREAD = -2;                            // place instance i on node i % num_nodes
+static constexpr int BUFFER_POOL_NUMA_NODE = -1;                              // -1: no binding, >= 0: bind all instances
+
+// open table and index files with O_DIRECT, bypassing the OS page cache; falls back to buffered I/O when rejected
+static constexpr bool DISK_DIRECT_IO = false;
+
+// asynchronous page I/O: "io_uring" falls back to "thread_pool" when the kernel does not allow io_uring
+static const std::string ASYNC_IO_BACKEND = "io_uring";
+static constexpr size_t ASYNC_IO_WORKERS = 8;                                 // worker threads of the thread pool backend
+static constexpr unsigned ASYNC_IO_QUEUE_DEPTH = 256;                         // submission queue depth of io_uring
+
+static constexpr size_t PAGE_CLEANER_INTERVAL_MS = 10;                        // wake-up interval of the page cleaner
+static constexpr size_t PAGE_CLEANER_PAGES_PER_SECOND = 10000;                // default flush rate of the page cleaner
+static constexpr double PAGE_CLEANER_LOW_WATER_RATIO = 0.1;                   // keep at least this ratio of frames clean
+
+// sequential read-ahead of table and index-leaf scans
+static constexpr size_t READ_AHEAD_TRIGGER = 2;                               // sequential accesses before read-ahead starts
+static constexpr size_t READ_AHEAD_MIN_WINDOW = 4;                            // initial read-ahead window in pages
+static constexpr size_t READ_AHEAD_MAX_WINDOW = 64;                           // the window doubles up to this many pages
+
+// statistics: counters are split into shards so that threads do not contend on one cache line
+static constexpr size_t STATS_COUNTER_SHARDS = 16;                            // number of shards of each counter
+static constexpr size_t STATS_DUMP_INTERVAL_S = 0;                            // periodic dump interval, 0 disables it
+static const std::string STATS_DUMP_FILE_NAME = "stats.log";
+
 // log file
 static const std::string LOG_FILE_NAME = "db.log";
 
-// replacer
+// replacer: "LRU", "CLOCK" or "LRU-K"
 static const std::string REPLACER_TYPE = "LRU";
+static constexpr size_t LRUK_REPLACER_K = 2;                                  // K used by the LRU-K replacer
 
 static const std::string DB_META_NAME = "db.meta";
@@ -37,6 +37,8 @@ class InternalError : public RMDBError {
 class UnixError : public RMDBError {
    public:
     UnixError() : RMDBError(strerror(errno)) {}
+
+    explicit UnixError(int error) : RMDBError(strerror(error)) {}
 };
 
 class FileNotOpenError : public RMDBError {
@@ -71,6 +73,28 @@ class InvalidRecordSizeError : public RMDBError {
     InvalidRecordSizeError(int record_size) : RMDBError("Invalid record size: " + std::to_string(record_size)) {}
 };
 
+class InvalidStorageError : public RMDBError {
+   public:
+    InvalidStorageError(const std::string &storage) : RMDBError("Invalid storage layout: " + storage) {}
+};
+
+class InvalidCompressionError : public RMDBError {
+   public:
+    InvalidCompressionError(const std::string &compression)
+        : RMDBError("Invalid page compression: " + compression) {}
+};
+
+class InvalidLatchModeError : public RMDBError {
+   public:
+    InvalidLatchModeError(const std::string &latch_mode) : RMDBError("Invalid index latch mode: " + latch_mode) {}
+};
+
+class InvalidFillFactorError : public RMDBError {
+   public:
+    InvalidFillFactorError(int fill_factor)
+        : RMDBError("Invalid index fill factor: " + std::to_string(fill_factor) + ", expected 10 to 100") {}
+};
+
 // IX errors
 class InvalidColLengthError : public RMDBError {
    public:
@@ -149,6 +173,12 @@ class IncompatibleTypeError : public RMDBError {
         : RMDBError("Incompatible type error: lhs " + lhs + ", rhs " + rhs) {}
 };
 
+class LoadDataError : public RMDBError {
+   public:
+    LoadDataError(const std::string &filename, int line_no)
+        : RMDBError("Invalid data in file " + filename + " at line " + std::to_string(line_no)) {}
+};
+
 class AmbiguousColumnError : public RMDBError {
    public:
     AmbiguousColumnError(const std::string &col_name) : RMDBError("Ambiguous column: " + col_name) {}
@@ -50,7 +50,7 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context) {
     if (auto x = std::dynamic_pointer_cast<DDLPlan>(plan)) {
         switch (x->tag) {
             case T_CreateTable: {
-                sm_manager_->create_table(x->tab_name_, x->cols_, context);
+                sm_manager_->create_table(x->tab_name_, x->cols_, context, x->layout_, x->compression_);
                 break;
             }
             case T_DropTable: {
@@ -58,13 +58,18 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context) {
                 break;
             }
             case T_CreateIndex: {
-                sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context);
+                sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context, x->latch_mode_,
+                                          x->fill_factor_);
                 break;
             }
             case T_DropIndex: {
                 sm_manager_->drop_index(x->tab_name_, x->tab_col_names_, context);
                 break;
             }
+            case T_Vacuum: {
+                sm_manager_->vacuum_table(x->tab_name_, context);
+                break;
+            }
             default:
                 throw InternalError("Unexpected field type");
                 break;
@@ -72,7 +77,7 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context) {
     }
 }
 
-// 执行help; show tables; desc table; begin; commit; abort;语句
+// 执行help; show tables; show stats; desc table; begin; commit; abort;语句
 void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Context *context) {
     if (auto x = std::dynamic_pointer_cast<OtherPlan>(plan)) {
         switch (x->tag) {
@@ -85,6 +90,10 @@ void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Co
                 sm_manager_->show_tables(context);
                 break;
             }
+            case T_ShowStats: {
+                sm_manager_->show_stats(context);
+                break;
+            }
             case T_DescTable: {
                 sm_manager_->desc_table(x->tab_name_, context);
                 break;
@@ -143,7 +152,7 @@ void QlManager::select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot,
     size_t num_rec = 0;
     // 执行query_plan
     for (executorTreeRoot->beginTuple(); !executorTreeRoot->is_end(); executorTreeRoot->nextTuple()) {
-        auto Tuple = executorTreeRoot->Next();
+        auto Tuple = executorTreeRoot->NextView();
         std::vector<std::string> columns;
         for (auto &col : executorTreeRoot->cols()) {
             std::string col_str;
@@ -19,6 +19,8 @@ class AbstractExecutor {
    public:
     Rid _abstract_rid;
 
+    std::unique_ptr<RmRecord> _abstract_rec;
+
     Context *context_;
 
     virtual ~AbstractExecutor() = default;
@@ -42,6 +44,13 @@ class AbstractExecutor {
 
     virtual std::unique_ptr<RmRecord> Next() = 0;
 
+    // 返回当前元组的只读指针，在下一次调用beginTuple或nextTuple前有效。
+    // 默认保存Next()拷贝出的元组，扫描算子直接返回指向缓冲池页面的视图，不拷贝记录
+    virtual const RmRecord *NextView() {
+        _abstract_rec = Next();
+        return _abstract_rec.get();
+    }
+
     virtual ColMeta get_col_offset(const TabCol &target) { return ColMeta();};
 
     std::vector<ColMeta>::const_iterator get_col(const std::vector<ColMeta> &rec_cols, const TabCol &target) {
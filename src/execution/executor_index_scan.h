@@ -33,6 +33,7 @@ class IndexScanExecutor : public AbstractExecutor {
 
     Rid rid_;
     std::unique_ptr<RecScan> scan_;
+    RmRecordView view_;              // rid_对应记录的视图，pin住记录所在的页面，扫描结束时释放
 
     SmManager *sm_manager_;
 
@@ -108,21 +109,23 @@ class IndexScanExecutor : public AbstractExecutor {
         scan_ = std::make_unique<IxScan>(ih, lower, upper, sm_manager_->get_bpm());
         while (!scan_->is_end()) {
             rid_ = scan_->rid();
-            auto rec = fh_->get_record(rid_, context_);
-            if (eval_conds(cols_, fed_conds_, rec.get())) {
-                break;
+            view_ = fh_->get_record_view(rid_, context_);
+            if (eval_conds(cols_, fed_conds_, view_.get())) {
+                return;
             }
             scan_->next();
         }
+        view_.reset();
     }
 
     void nextTuple() override {
         assert(!is_end());
         for (scan_->next(); !scan_->is_end(); scan_->next()) {
             rid_ = scan_->rid();
-            auto rec = fh_->get_record(rid_, context_);
-            if (eval_conds(cols_, fed_conds_, rec.get())) break;
+            view_ = fh_->get_record_view(rid_, context_);
+            if (eval_conds(cols_, fed_conds_, view_.get())) return;
         }
+        view_.reset();
     }
 
     bool is_end() const override { return scan_->is_end(); }
@@ -133,7 +136,12 @@ class IndexScanExecutor : public AbstractExecutor {
 
     std::unique_ptr<RmRecord> Next() override {
         assert(!is_end());
-        return fh_->get_record(rid_, context_);
+        return view_.to_record();
+    }
+
+    const RmRecord *NextView() override {
+        assert(!is_end());
+        return view_.get();
     }
 
     Rid &rid() override { return rid_; }
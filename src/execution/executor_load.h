@@ -0,0 +1,313 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include <algorithm>
+#include <fstream>
+
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "recovery/log_manager.h"
+#include "system/sm.h"
+
+/**
+ * @description: 批量装载：多行insert和COPY FROM。记录直接按顺序填满新分配的页面，不经过空闲空间映射逐条查找；
+ * 索引在所有记录装载完成后按排序后的键值自底向上构建。装载期间持有表级写锁，
+ * 装载结束时只写一条BULK_LOAD日志，而不是每条记录一条日志；日志持久化之后再写回数据页。
+ * 装载中途失败时删除已写入的记录和索引项；索引全部构建完成后才登记事务的写操作，回滚时删除的索引项都确实存在
+ */
+class LoadExecutor : public AbstractExecutor {
+   private:
+    static constexpr int LOAD_BATCH_SIZE = 4096;  // 每批写入数据文件的记录条数
+
+    TabMeta tab_;                               // 表的元数据
+    std::vector<std::vector<Value>> rows_;      // 多行insert需要插入的数据
+    std::string file_name_;                     // COPY FROM的数据文件，为空表示装载rows_
+    RmFileHandle *fh_;                          // 表的数据文件句柄
+    std::string tab_name_;                      // 表名称
+    Rid rid_;
+    SmManager *sm_manager_;
+
+    std::vector<char> batch_;                   // 当前批次的记录
+    int batch_size_ = 0;                        // 当前批次的记录条数
+    std::vector<Rid> rids_;                     // 已装载的所有记录的位置
+    std::vector<std::unique_ptr<IxSorter>> sorters_;  // 每个索引已装载的键值对，超出内存时写入临时文件
+
+   public:
+    LoadExecutor(SmManager *sm_manager, const std::string &tab_name, std::vector<std::vector<Value>> rows,
+                 Context *context)
+        : rows_(std::move(rows)) {
+        init(sm_manager, tab_name, context);
+    }
+
+    LoadExecutor(SmManager *sm_manager, const std::string &tab_name, const std::string &file_name, Context *context)
+        : file_name_(file_name) {
+        init(sm_manager, tab_name, context);
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        batch_.resize((size_t)LOAD_BATCH_SIZE * fh_->get_file_hdr().record_size);
+        sorters_.clear();
+        for (auto &index : tab_.indexes) {
+            std::vector<ColType> col_types;
+            std::vector<int> col_lens;
+            for (auto &col : index.cols) {
+                col_types.push_back(col.type);
+                col_lens.push_back(col.len);
+            }
+            sorters_.push_back(std::make_unique<IxSorter>(col_types, col_lens));
+        }
+        try {
+            if (file_name_.empty()) {
+                for (auto &values : rows_) {
+                    add_row(values);
+                }
+            } else {
+                load_file();
+            }
+            flush_batch();
+            build_indexes();
+        } catch (RMDBError &) {
+            undo_load();
+            throw;
+        }
+        // 事务回滚时逐条删除装载的记录及其索引项
+        if (context_) {
+            for (auto &rid : rids_) {
+                context_->txn_->append_write_record(new WriteRecord(WType::INSERT_TUPLE, tab_name_, rid));
+            }
+        }
+
+        // 装载写入的页面都是新页面，只需一条日志记录装载的范围。日志的LSN记为这些页面的页面LSN，
+        // 后台写回线程在日志持久化之前不会写回它们
+        if (context_ != nullptr && context_->log_mgr_ != nullptr && !rids_.empty()) {
+            BulkLoadLogRecord log_record(context_->txn_->get_transaction_id(), tab_name_, rids_.front().page_no,
+                                         rids_.back().page_no, static_cast<int>(rids_.size()));
+            log_record.prev_lsn_ = context_->txn_->get_prev_lsn();
+            lsn_t lsn = context_->log_mgr_->add_log_to_buffer(&log_record);
+            context_->txn_->set_prev_lsn(lsn);
+            set_page_lsn(lsn);
+            context_->log_mgr_->flush_log_to_disk();
+        }
+        sm_manager_->get_bpm()->flush_all_pages(fh_->GetFd());
+        return nullptr;
+    }
+
+    Rid &rid() override { return rid_; }
+
+   private:
+    void init(SmManager *sm_manager, const std::string &tab_name, Context *context) {
+        sm_manager_ = sm_manager;
+        tab_ = sm_manager_->db_.get_table(tab_name);
+        tab_name_ = tab_name;
+        fh_ = sm_manager_->fhs_.at(tab_name).get();
+        context_ = context;
+
+        // 表级写锁，装载期间其他事务不会看到写了一半的页面
+        if (context_) {
+            context_->lock_mgr_->lock_exclusive_on_table(context->txn_, fh_->GetFd());
+        }
+    }
+
+    /**
+     * @description: 把一行数据转换为记录放入当前批次，批次满时写入数据文件
+     * @param {vector<Value>&} values 一行数据
+     */
+    void add_row(std::vector<Value> &values) {
+        if (values.size() != tab_.cols.size()) {
+            throw InvalidValueCountError();
+        }
+        char *rec = batch_.data() + (size_t)batch_size_ * fh_->get_file_hdr().record_size;
+        for (size_t i = 0; i < values.size(); i++) {
+            auto &col = tab_.cols[i];
+            auto &val = values[i];
+            if (col.type != val.type) {
+                throw IncompatibleTypeError(coltype2str(col.type), coltype2str(val.type));
+            }
+            val.init_raw(col.len);
+            memcpy(rec + col.offset, val.raw->data, col.len);
+        }
+        if (++batch_size_ == LOAD_BATCH_SIZE) {
+            flush_batch();
+        }
+    }
+
+    /**
+     * @description: 逐行读取逗号分隔的数据文件，第一行与列名相同时视为表头跳过
+     */
+    void load_file() {
+        std::ifstream in(file_name_);
+        if (!in.is_open()) {
+            throw FileNotFoundError(file_name_);
+        }
+        std::string line;
+        int line_no = 0;
+        while (std::getline(in, line)) {
+            line_no++;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            std::vector<std::string> fields;
+            size_t begin = 0;
+            while (true) {
+                size_t end = line.find(',', begin);
+                fields.push_back(line.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+                if (end == std::string::npos) {
+                    break;
+                }
+                begin = end + 1;
+            }
+            if (fields.size() != tab_.cols.size()) {
+                throw LoadDataError(file_name_, line_no);
+            }
+            if (line_no == 1 && is_header(fields)) {
+                continue;
+            }
+            std::vector<Value> values(fields.size());
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (!parse_field(fields[i], tab_.cols[i].type, &values[i])) {
+                    throw LoadDataError(file_name_, line_no);
+                }
+            }
+            add_row(values);
+        }
+    }
+
+    bool is_header(const std::vector<std::string> &fields) const {
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (fields[i] != tab_.cols[i].name) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @description: 把数据文件中的一个字段转换为对应类型的值，字符串两端的引号被去掉
+     * @return {bool} 字段格式是否合法
+     */
+    static bool parse_field(const std::string &field, ColType type, Value *val) {
+        try {
+            size_t pos = 0;
+            if (type == TYPE_INT) {
+                val->set_int(std::stoi(field, &pos));
+            } else if (type == TYPE_FLOAT) {
+                val->set_float(std::stof(field, &pos));
+            } else {
+                std::string str = field;
+                if (str.size() >= 2 && (str.front() == '\'' || str.front() == '"') && str.back() == str.front()) {
+                    str = str.substr(1, str.size() - 2);
+                }
+                val->set_str(std::move(str));
+                return true;
+            }
+            return pos == field.size();
+        } catch (std::logic_error &) {
+            return false;
+        }
+    }
+
+    /**
+     * @description: 把当前批次的记录写入数据文件，并记录每条记录的位置和索引键值
+     */
+    void flush_batch() {
+        if (batch_size_ == 0) {
+            return;
+        }
+        int record_size = fh_->get_file_hdr().record_size;
+        size_t first = rids_.size();
+        fh_->bulk_insert_records(batch_.data(), batch_size_, &rids_);
+        std::vector<char> key;
+        for (int r = 0; r < batch_size_; r++) {
+            const char *rec = batch_.data() + (size_t)r * record_size;
+            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                auto &index = tab_.indexes[i];
+                key.clear();
+                for (int j = 0; j < index.col_num; ++j) {
+                    key.insert(key.end(), rec + index.cols[j].offset, rec + index.cols[j].offset + index.cols[j].len);
+                }
+                sorters_[i]->add(key.data(), rids_[first + r]);
+            }
+        }
+        batch_size_ = 0;
+    }
+
+    /**
+     * @description: 装载失败时删除已写入数据文件的记录。索引可能只构建了一部分，只删除指向这些记录的索引项，
+     * 键值相同的已有记录的索引项不受影响
+     */
+    void undo_load() {
+        batch_size_ = 0;
+        sorters_.clear();
+        Transaction *txn = context_ ? context_->txn_ : nullptr;
+        std::vector<char> key;
+        for (auto &rid : rids_) {
+            auto rec = fh_->get_record(rid, context_);
+            for (auto &index : tab_.indexes) {
+                auto ih =
+                    sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+                key.clear();
+                for (int j = 0; j < index.col_num; ++j) {
+                    key.insert(key.end(), rec->data + index.cols[j].offset,
+                               rec->data + index.cols[j].offset + index.cols[j].len);
+                }
+                ih->delete_entry(key.data(), rid, txn);
+            }
+            fh_->delete_record(rid, context_);
+        }
+        rids_.clear();
+    }
+
+    /**
+     * @description: 把装载写入的所有页面的页面LSN设为lsn
+     * @param {lsn_t} lsn BULK_LOAD日志的LSN
+     */
+    void set_page_lsn(lsn_t lsn) {
+        auto bpm = sm_manager_->get_bpm();
+        for (size_t i = 0; i < rids_.size(); i++) {
+            if (i > 0 && rids_[i].page_no == rids_[i - 1].page_no) {
+                continue;
+            }
+            PageId page_id{fh_->GetFd(), rids_[i].page_no};
+            Page *page = bpm->fetch_page(page_id);
+            if (page != nullptr) {
+                page->set_page_lsn(lsn);
+                bpm->unpin_page(page_id, false);
+            }
+        }
+    }
+
+    /**
+     * @description: 对每个索引的键值排序后构建索引；索引非空时退化为按键值顺序逐条插入。重复的键值只保留第一条
+     */
+    void build_indexes() {
+        for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+            auto &index = tab_.indexes[i];
+            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+            if (!ih->bulk_load(sorters_[i].get())) {
+                Transaction *txn = context_ ? context_->txn_ : nullptr;
+                const char *keys;
+                const Rid *rids;
+                for (int n; (n = sorters_[i]->next_batch(&keys, &rids)) > 0;) {
+                    for (int k = 0; k < n; k++) {
+                        ih->insert_entry(keys + (size_t)k * index.col_tot_len, rids[k], txn);
+                    }
+                }
+            }
+            sm_manager_->get_bpm()->flush_all_pages(ih->GetFd());
+            sorters_[i].reset();
+        }
+    }
+};
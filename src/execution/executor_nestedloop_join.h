@@ -56,7 +56,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
         }
         right_->beginTuple();
         while (!is_end()) {
-            if (eval_conds(cols_, fed_conds_, left_->Next().get(), right_->Next().get())) {
+            if (eval_conds(cols_, fed_conds_, left_->NextView(), right_->NextView())) {
                 break;
             }
             right_->nextTuple();
@@ -75,7 +75,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
             right_->beginTuple();
         }
         while (!is_end()) {
-            if (eval_conds(cols_, fed_conds_, left_->Next().get(), right_->Next().get())) {
+            if (eval_conds(cols_, fed_conds_, left_->NextView(), right_->NextView())) {
                 break;
             }
             right_->nextTuple();
@@ -89,8 +89,8 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
     std::unique_ptr<RmRecord> Next() override {
         assert(!is_end());
         auto record = std::make_unique<RmRecord>(len_);
-        auto left_record = left_->Next();
-        auto right_record = right_->Next();
+        auto left_record = left_->NextView();
+        auto right_record = right_->NextView();
         memcpy(record->data, left_record->data, left_record->size);
         memcpy(record->data + left_record->size, right_record->data, right_record->size);
         return record;
@@ -57,7 +57,7 @@ class ProjectionExecutor : public AbstractExecutor {
     std::unique_ptr<RmRecord> Next() override {
         assert(!is_end());
         auto &prev_cols = prev_->cols();
-        auto prev_rec = prev_->Next();
+        auto prev_rec = prev_->NextView();
         auto &proj_cols = cols_;
         auto proj_rec = std::make_unique<RmRecord>(len_);
         for (size_t proj_idx = 0; proj_idx < proj_cols.size(); proj_idx++) {
@@ -24,14 +24,19 @@ class SeqScanExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;         // scan后生成的记录的字段
     size_t len_;                        // scan后生成的每条记录的长度
     std::vector<Condition> fed_conds_;  // 同conds_，两个字段相同
+    std::vector<RmVarCol> read_cols_;   // 需要从页面中取出的字段，为空时为所有字段，只对PAX格式的表有效
+    std::vector<RmZonePredicate> zone_preds_;   // 条件中INT、FLOAT字段与常量的比较，用于通过zone map跳过页面
 
     Rid rid_;
-    std::unique_ptr<RecScan> scan_;  // table_iterator
+    std::unique_ptr<RmBatchScan> scan_;  // table_iterator，按页批量取出记录
+    int batch_idx_;                      // rid_在当前批次中的位置
+    RmRecord rec_{};                     // 指向当前批次中rid_对应的记录，不拥有数据
 
     SmManager *sm_manager_;
 
    public:
-    SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context) {
+    SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context,
+                    const std::vector<ColMeta> &read_cols = {}) {
         sm_manager_ = sm_manager;
         tab_name_ = std::move(tab_name);
         conds_ = std::move(conds);
@@ -39,10 +44,22 @@ class SeqScanExecutor : public AbstractExecutor {
         fh_ = sm_manager_->fhs_.at(tab_name_).get();
         cols_ = tab.cols;
         len_ = cols_.back().offset + cols_.back().len;
+        rec_.size = fh_->get_file_hdr().record_size;
 
         context_ = context;
 
         fed_conds_ = conds_;
+        for (auto &col : read_cols) {
+            read_cols_.push_back(RmVarCol{static_cast<int16_t>(col.offset), static_cast<int16_t>(col.len)});
+        }
+        for (auto &cond : fed_conds_) {
+            if (!cond.is_rhs_val || cond.rhs_val.type == TYPE_STRING) {
+                continue;
+            }
+            auto lhs_col = get_col(cols_, cond.lhs_col);
+            double value = cond.rhs_val.type == TYPE_INT ? cond.rhs_val.int_val : cond.rhs_val.float_val;
+            zone_preds_.push_back(RmZonePredicate{lhs_col->offset, cond.op, value});
+        }
 
         // 表级读锁
         if (context_) {
@@ -61,18 +78,9 @@ class SeqScanExecutor : public AbstractExecutor {
      *
      */
     void beginTuple() override {
-        scan_ = std::make_unique<RmScan>(fh_);
-        for (; !scan_->is_end(); scan_->next()) {
-            rid_ = scan_->rid();
-            try {
-                auto rec = fh_->get_record(rid_, context_);
-                if (eval_conds(cols_, fed_conds_, rec.get())) {
-                    break;
-                }
-            } catch (RecordNotFoundError &e) {
-                std::cerr << e.what() << std::endl;
-            }
-        }
+        scan_ = std::make_unique<RmBatchScan>(fh_, read_cols_, zone_preds_);
+        batch_idx_ = -1;
+        find_next();
     }
 
     /**
@@ -81,23 +89,22 @@ class SeqScanExecutor : public AbstractExecutor {
      */
     void nextTuple() override {
         assert(!is_end());
-        for (scan_->next(); !scan_->is_end(); scan_->next()) {
-            rid_ = scan_->rid();
-            auto rec = fh_->get_record(rid_, context_);
-            if (eval_conds(cols_, fed_conds_, rec.get())) {
-                break;
-            }
-        }
+        find_next();
     }
 
     /**
-     * @brief 返回下一个满足扫描条件的记录
+     * @brief 返回下一个满足扫描条件的记录，从当前批次中拷贝，不再重新读取页面
      *
      * @return std::unique_ptr<RmRecord>
      */
     std::unique_ptr<RmRecord> Next() override {
         assert(!is_end());
-        return fh_->get_record(rid_, context_);
+        return std::make_unique<RmRecord>(rec_.size, rec_.data);
+    }
+
+    const RmRecord *NextView() override {
+        assert(!is_end());
+        return &rec_;
     }
 
     Rid &rid() override { return rid_; }
@@ -139,4 +146,25 @@ class SeqScanExecutor : public AbstractExecutor {
         return std::all_of(conds.begin(), conds.end(),
                            [&](const Condition &cond) { return eval_cond(rec_cols, cond, rec); });
     }
+
+   private:
+    /**
+     * @brief 从当前批次的下一条记录开始查找满足谓词条件的记录，当前批次用完后取下一个页面的批次。
+     * 表级读锁已在构造时申请，因此不再对每条记录加行级读锁
+     */
+    void find_next() {
+        while (true) {
+            if (++batch_idx_ >= scan_->size()) {
+                if (!scan_->next_batch()) {
+                    return;
+                }
+                batch_idx_ = 0;
+            }
+            rid_ = scan_->rid(batch_idx_);
+            rec_.data = scan_->record(batch_idx_);
+            if (eval_conds(cols_, fed_conds_, &rec_)) {
+                return;
+            }
+        }
+    }
 };
\ No newline at end of file
@@ -10,6 +10,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <limits>
 #include <vector>
 
 #include "defs.h"
@@ -21,6 +22,31 @@ constexpr int IX_LEAF_HEADER_PAGE = 1;
 constexpr int IX_INIT_ROOT_PAGE = 2;
 constexpr int IX_INIT_NUM_PAGES = 3;
 constexpr int IX_MAX_COL_LEN = 512;
+constexpr int IX_DELETED_NODE = -2;     // 被合并或被移出树的结点，其next_free_page_no置为此值，乐观读者遇到后从根结点重新查找
+constexpr double IX_BULK_FILL_FACTOR = 0.9;          // 批量构建时结点默认填到的比例，留出的空间使之后的插入不会马上分裂
+constexpr size_t IX_SORT_MEMORY = 64 << 20;          // 建索引时在内存中排序的键值对最多占用的字节数，超出时写出一个有序的run
+constexpr int IX_SORT_BATCH_SIZE = 4096;             // 排序后每批交给批量构建的键值对数量
+constexpr int IX_OLC_READER_SLOTS = 64;              // 乐观查找登记epoch的槽数，同时进行的乐观查找超过此数时等待空闲的槽
+
+/* 索引键的形式，决定结点内查找时使用哪个特化的比较函数 */
+enum IxKeyKind : int {
+    IX_KEY_INT = 0,         // 单个INT字段
+    IX_KEY_FLOAT = 1,       // 单个FLOAT字段
+    IX_KEY_STRING = 2,      // 单个定长字符串字段，按字节比较
+    IX_KEY_COMPOSITE = 3,   // 多个字段，逐个字段比较
+};
+
+/* 结点的存储格式，记录在索引文件头中 */
+enum IxFormatVersion : int {
+    IX_FORMAT_FIXED = 0,    // 每个key按col_tot_len_定长存储，旧版本的文件都是这种格式
+    IX_FORMAT_PREFIX = 1,   // 结点内的key去掉公共前缀和末尾的最小值后按结点内统一的长度存储，叶子结点分裂时上移截短的分隔键
+};
+
+/* 索引的并发控制方式，建索引时通过LATCH选项指定 */
+enum IxLatchMode : int {
+    IX_LATCH_CRABBING = 0,      // 查找时自上而下对结点加读锁
+    IX_LATCH_OPTIMISTIC = 1,    // 查找时不加锁，读完结点后校验页面版本号，与分裂并发时沿右链接向右查找
+};
 
 class IxFileHdr {
 public: 
@@ -36,10 +62,20 @@ public:
     // first_leaf初始化之后没有进行修改，只不过是在测试文件中遍历叶子结点的时候用了
     page_id_t first_leaf_;              // 首叶节点对应的页号，在上层IxManager的open函数进行初始化，初始化为root page_no
     page_id_t last_leaf_;               // 尾叶节点对应的页号
+    IxLatchMode latch_mode_;            // 并发控制方式，旧版本的文件头中没有此字段，按IX_LATCH_CRABBING处理
+    IxFormatVersion format_version_;    // 结点的存储格式，旧版本的文件头中没有此字段，按IX_FORMAT_FIXED处理
+    IxKeyKind key_kind_;                // 索引键的形式，由col_types_推出，不写入磁盘
+    int prefix_max_len_;                // 开头连续的字符串字段的总长度，按字节比较，结点内的公共前缀不超过这个长度；不写入磁盘
+    int prefix_max_cols_;               // 开头连续的字符串字段的数量，不写入磁盘
+    std::vector<char> key_min_;         // 每个字段都取最小值的key，结点中省略与它相同的key末尾；不写入磁盘
     int tot_len_;                       // 记录结构体的整体长度
 
     IxFileHdr() {
         tot_len_ = col_num_ = 0;
+        latch_mode_ = IX_LATCH_CRABBING;
+        format_version_ = IX_FORMAT_FIXED;
+        key_kind_ = IX_KEY_COMPOSITE;
+        prefix_max_len_ = prefix_max_cols_ = 0;
     }
 
     IxFileHdr(page_id_t first_free_page_no, int num_pages, page_id_t root_page, int col_num,
@@ -47,14 +83,52 @@ public:
                 : first_free_page_no_(first_free_page_no), num_pages_(num_pages), root_page_(root_page), col_num_(col_num),
                 col_tot_len_(col_tot_len), btree_order_(btree_order), keys_size_(keys_size), first_leaf_(first_leaf), last_leaf_(last_leaf) {
                     tot_len_ = 0;
+                    latch_mode_ = IX_LATCH_CRABBING;
+                    format_version_ = IX_FORMAT_FIXED;
+                    key_kind_ = IX_KEY_COMPOSITE;
+                    prefix_max_len_ = prefix_max_cols_ = 0;
                 } 
 
     void update_tot_len() {
         tot_len_ = 0;
-        tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 6;
+        tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 6 + sizeof(IxLatchMode) + sizeof(IxFormatVersion);
         tot_len_ += sizeof(ColType) * col_num_ + sizeof(int) * col_num_;
     }
 
+    /**
+     * @brief 由col_types_和col_lens_推出key_kind_，以及前缀压缩用到的prefix_max_len_、prefix_max_cols_和key_min_
+     */
+    void update_key_kind() {
+        prefix_max_len_ = prefix_max_cols_ = 0;
+        while (prefix_max_cols_ < col_num_ && col_types_[prefix_max_cols_] == TYPE_STRING) {
+            prefix_max_len_ += col_lens_[prefix_max_cols_++];
+        }
+        key_min_.assign(col_tot_len_, 0);
+        for (int i = 0, offset = 0; i < col_num_; offset += col_lens_[i], i++) {
+            if (col_types_[i] == TYPE_INT) {
+                int value = std::numeric_limits<int>::min();
+                memcpy(key_min_.data() + offset, &value, sizeof(value));
+            } else if (col_types_[i] == TYPE_FLOAT) {
+                float value = -std::numeric_limits<float>::infinity();
+                memcpy(key_min_.data() + offset, &value, sizeof(value));
+            }
+        }
+        key_kind_ = IX_KEY_COMPOSITE;
+        if (col_num_ == 1) {
+            switch (col_types_[0]) {
+                case TYPE_INT:
+                    key_kind_ = IX_KEY_INT;
+                    break;
+                case TYPE_FLOAT:
+                    key_kind_ = IX_KEY_FLOAT;
+                    break;
+                case TYPE_STRING:
+                    key_kind_ = IX_KEY_STRING;
+                    break;
+            }
+        }
+    }
+
     void serialize(char* dest) {
         int offset = 0;
         memcpy(dest + offset, &tot_len_, sizeof(int));
@@ -85,6 +159,10 @@ public:
         offset += sizeof(page_id_t);
         memcpy(dest + offset, &last_leaf_, sizeof(page_id_t));
         offset += sizeof(page_id_t);
+        memcpy(dest + offset, &latch_mode_, sizeof(IxLatchMode));
+        offset += sizeof(IxLatchMode);
+        memcpy(dest + offset, &format_version_, sizeof(IxFormatVersion));
+        offset += sizeof(IxFormatVersion);
         assert(offset == tot_len_);
     }
 
@@ -123,18 +201,34 @@ public:
         offset += sizeof(page_id_t);
         last_leaf_ = *reinterpret_cast<const page_id_t*>(src + offset);
         offset += sizeof(page_id_t);
+        if (offset < tot_len_) {
+            latch_mode_ = *reinterpret_cast<const IxLatchMode*>(src + offset);
+            offset += sizeof(IxLatchMode);
+        }
+        if (offset < tot_len_) {
+            format_version_ = *reinterpret_cast<const IxFormatVersion*>(src + offset);
+            offset += sizeof(IxFormatVersion);
+        }
         assert(offset == tot_len_);
+        update_key_kind();
     }
 };
 
 class IxPageHdr {
 public:
-    page_id_t next_free_page_no;    // unused
+    page_id_t next_free_page_no;    // unused；结点被删除后置为IX_DELETED_NODE
     page_id_t parent;               // 父亲节点所在页面的叶号
     int num_key;                    // # current keys (always equals to #child - 1) 已插入的keys数量，key_idx∈[0,num_key)
     bool is_leaf;                   // 是否为叶节点
     page_id_t prev_leaf;            // previous leaf node's page_no, effective only when is_leaf is true
-    page_id_t next_leaf;            // next leaf node's page_no, effective only when is_leaf is true
+    page_id_t next_leaf;            // next leaf node's page_no；内部结点中为同一层右兄弟的页号（B-link的右链接），最右结点为IX_NO_PAGE
+};
+
+/* IX_FORMAT_PREFIX的结点在IxPageHdr之后存放的信息，之后依次是公共前缀、各个key存储的部分，rid放在页面末尾 */
+class IxPrefixHdr {
+public:
+    int16_t prefix_len;             // 结点中所有key的公共前缀的长度
+    int16_t key_len;                // 每个key去掉公共前缀后存储的长度，之后的部分与file_hdr->key_min_相同
 };
 
 class Iid {
@@ -10,7 +10,11 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_index_handle.h"
 
+#include <cmath>
+#include <thread>
+
 #include "ix_scan.h"
+#include "ix_sorter.h"
 
 /**
  * @brief 在当前node中查找第一个>=target的key_idx
@@ -23,38 +27,223 @@ int IxNodeHandle::lower_bound(const char *target) const {
     // 查找当前节点中第一个大于等于target的key，并返回key的位置给上层
     // 提示: 可以采用多种查找方式，如顺序遍历、二分查找等；使用ix_compare()函数进行比较
 
-    int l = 0, r = page_hdr->num_key;
-    while (l < r) {
-        int mid = (l + r) >> 1;
-        if (ix_compare(target, get_key(mid), file_hdr->col_types_, file_hdr->col_lens_) > 0) {
-            l = mid + 1;
-        } else {
-            r = mid;
-        }
-    }
-    return l;
+    return search<false>(target);
 }
 
 /**
  * @brief 在当前node中查找第一个>target的key_idx
  *
- * @return key_idx，范围为[1,num_key)，如果返回的key_idx=num_key，则表示target大于等于最后一个key
- * @note 注意此处的范围从1开始
+ * @return key_idx，范围为[0,num_key)，如果返回的key_idx=num_key，则表示target大于等于最后一个key
+ * @note 内部结点的key(0)不参与路由，target小于key(0)时internal_lookup()同样取第0个孩子
  */
 int IxNodeHandle::upper_bound(const char *target) const {
     // Todo:
     // 查找当前节点中第一个大于target的key，并返回key的位置给上层
     // 提示: 可以采用多种查找方式：顺序遍历、二分查找等；使用ix_compare()函数进行比较
 
-    int l = 1, r = page_hdr->num_key;
-    while (l < r) {
-        int mid = (l + r) >> 1;
-        if (ix_compare(target, get_key(mid), file_hdr->col_types_, file_hdr->col_lens_) >= 0)
-            l = mid + 1;
-        else
-            r = mid;
+    return search<true>(target);
+}
+
+/**
+ * @brief IX_FORMAT_PREFIX结点中的查找：target先与公共前缀比较，相同时再与每个key存储的部分二分查找
+ */
+int IxNodeHandle::search_prefix(const char *target, bool upper) const {
+    IxNodeLayout node_layout = layout();
+    int n = std::clamp(page_hdr->num_key, 0, node_layout.capacity);
+    if (n == 0) {
+        return 0;
+    }
+    int cmp = memcmp(target, node_layout.prefix, node_layout.prefix_len);
+    if (cmp != 0) {
+        return cmp < 0 ? 0 : n;
+    }
+    auto before = [&](int key_idx) {
+        int key_cmp = compare_stored(node_layout.keys + key_idx * node_layout.key_len, node_layout, target);
+        return upper ? key_cmp <= 0 : key_cmp < 0;
+    };
+    int low = 0;
+    while (n > 1) {
+        int half = n >> 1;
+        low += before(low + half - 1) ? half : 0;
+        n -= half;
+    }
+    return low + (before(low) ? 1 : 0);
+}
+
+/**
+ * @brief 比较公共前缀与target相同的结点中存储的key和target
+ *
+ * @param stored 结点中某个key存储的部分，它的完整key是公共前缀 + stored + key_min_的剩余部分
+ * @return 与ix_compare(完整key, target)的符号相同
+ */
+int IxNodeHandle::compare_stored(const char *stored, const IxNodeLayout &node_layout, const char *target) const {
+    int prefix_len = node_layout.prefix_len;
+    int end = prefix_len + node_layout.key_len;
+    int bytes_len = file_hdr->prefix_max_len_;
+    const char *key_min = file_hdr->key_min_.data();
+    // 开头的字符串字段按字节比较
+    int cmp = memcmp(stored, target + prefix_len, std::min(end, bytes_len) - prefix_len);
+    if (cmp == 0 && end < bytes_len) {
+        cmp = memcmp(key_min + end, target + end, bytes_len - end);
+    }
+    if (cmp != 0 || bytes_len == file_hdr->col_tot_len_) {
+        return cmp;
+    }
+    // 之后的字段还原出完整的值，按类型比较
+    char key[IX_MAX_COL_LEN];
+    int fill = std::max(end, bytes_len);
+    memcpy(key + bytes_len, stored + (bytes_len - prefix_len), fill - bytes_len);
+    memcpy(key + fill, key_min + fill, file_hdr->col_tot_len_ - fill);
+    int offset = bytes_len;
+    for (int i = file_hdr->prefix_max_cols_; i < file_hdr->col_num_; offset += file_hdr->col_lens_[i], i++) {
+        cmp = ix_compare(key + offset, target + offset, file_hdr->col_types_[i], file_hdr->col_lens_[i]);
+        if (cmp != 0) {
+            return cmp;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 比较key与结点中第key_idx个key
+ *
+ * @return 与ix_compare(key, 第key_idx个key)的符号相同
+ */
+int IxNodeHandle::compare_key(const char *key, int key_idx) const {
+    if (file_hdr->format_version_ != IX_FORMAT_PREFIX) {
+        return ix_compare(key, get_key(key_idx), file_hdr->col_types_, file_hdr->col_lens_);
+    }
+    IxNodeLayout node_layout = layout();
+    // 乐观查找读到的num_key可能与公共前缀不一致
+    key_idx = std::clamp(key_idx, 0, node_layout.capacity - 1);
+    int cmp = memcmp(key, node_layout.prefix, node_layout.prefix_len);
+    if (cmp != 0) {
+        return cmp;
     }
-    return l;
+    return -compare_stored(node_layout.keys + key_idx * node_layout.key_len, node_layout, key);
+}
+
+/**
+ * @brief 把第key_idx个完整的key复制到dest
+ */
+void IxNodeHandle::copy_key(int key_idx, char *dest) const {
+    IxNodeLayout node_layout = layout();
+    int end = node_layout.prefix_len + node_layout.key_len;
+    memcpy(dest, node_layout.prefix, node_layout.prefix_len);
+    memcpy(dest + node_layout.prefix_len, node_layout.keys + key_idx * node_layout.key_len, node_layout.key_len);
+    memcpy(dest + end, file_hdr->key_min_.data() + end, file_hdr->col_tot_len_ - end);
+}
+
+/**
+ * @brief 把从pos开始的n个完整的键值对复制到keys和rids
+ */
+void IxNodeHandle::copy_pairs(int pos, int n, char *keys, Rid *rids) const {
+    for (int i = 0; i < n; i++) {
+        copy_key(pos + i, keys + i * file_hdr->col_tot_len_);
+    }
+    memcpy(rids, get_rid(pos), n * sizeof(Rid));
+}
+
+/**
+ * @brief 计算结点加入n个有序的key（或用它们替换已有的key）之后的公共前缀长度和每个key存储的长度
+ */
+void IxNodeHandle::merged_layout(const char *keys, int n, int *prefix_len, int *key_len) const {
+    int len = file_hdr->col_tot_len_;
+    int prefix = 0, sig_len = 0;
+    if (page_hdr->num_key == 0) {
+        prefix = ix_common_prefix(keys, keys + (n - 1) * len, file_hdr->prefix_max_len_);
+    } else {
+        IxNodeLayout node_layout = layout();
+        prefix = node_layout.prefix_len;
+        sig_len = node_layout.prefix_len + node_layout.key_len;
+        for (int i = 0; i < n; i++) {
+            prefix = ix_common_prefix(keys + i * len, node_layout.prefix, prefix);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        sig_len = std::max(sig_len, ix_key_trim_len(keys + i * len, file_hdr));
+    }
+    *prefix_len = prefix;
+    *key_len = std::max(sig_len - prefix, 0);
+}
+
+/**
+ * @brief 按给定的公共前缀长度和key的存储长度，把n个完整的键值对写入结点
+ */
+void IxNodeHandle::encode(const char *keys, const Rid *rids, int n, int prefix_len, int key_len) {
+    auto prefix_hdr = reinterpret_cast<IxPrefixHdr *>(page->get_data() + sizeof(IxPageHdr));
+    prefix_hdr->prefix_len = prefix_len;
+    prefix_hdr->key_len = key_len;
+    IxNodeLayout node_layout = layout();
+    assert(n < node_layout.capacity);
+    if (n > 0) {
+        memcpy(node_layout.prefix, keys, prefix_len);
+    }
+    for (int i = 0; i < n; i++) {
+        memcpy(node_layout.keys + i * key_len, keys + i * file_hdr->col_tot_len_ + prefix_len, key_len);
+    }
+    memcpy(node_layout.rids, rids, n * sizeof(Rid));
+    page_hdr->num_key = n;
+}
+
+/**
+ * @brief 用n个有序的完整键值对替换结点中的内容，IX_FORMAT_PREFIX下取它们最长的公共前缀
+ */
+void IxNodeHandle::assign(const char *keys, const Rid *rids, int n) {
+    if (file_hdr->format_version_ != IX_FORMAT_PREFIX) {
+        assert(n < get_max_size());
+        memcpy(get_key(0), keys, n * file_hdr->col_tot_len_);
+        memcpy(get_rid(0), rids, n * sizeof(Rid));
+        page_hdr->num_key = n;
+        return;
+    }
+    page_hdr->num_key = 0;
+    int prefix_len = 0, key_len = 0;
+    if (n > 0) {
+        merged_layout(keys, n, &prefix_len, &key_len);
+    }
+    encode(keys, rids, n, prefix_len, key_len);
+}
+
+/**
+ * @brief 结点插入key之后是否仍然不需要分裂
+ */
+bool IxNodeHandle::can_insert(const char *key) const {
+    if (file_hdr->format_version_ != IX_FORMAT_PREFIX) {
+        return page_hdr->num_key + 1 < file_hdr->btree_order_ + 1;
+    }
+    int prefix_len, key_len;
+    merged_layout(key, 1, &prefix_len, &key_len);
+    return page_hdr->num_key + 1 < ix_node_capacity(prefix_len, key_len);
+}
+
+/**
+ * @brief 把第key_idx个key替换为key
+ *
+ * @return 是否替换成功；IX_FORMAT_PREFIX下key使结点压缩得更少、放不下原来的键值对时返回false，结点不变
+ */
+bool IxNodeHandle::set_key(int key_idx, const char *key) {
+    if (file_hdr->format_version_ != IX_FORMAT_PREFIX) {
+        memcpy(get_key(key_idx), key, file_hdr->col_tot_len_);
+        return true;
+    }
+    int prefix_len, key_len;
+    merged_layout(key, 1, &prefix_len, &key_len);
+    if (page_hdr->num_key >= ix_node_capacity(prefix_len, key_len)) {
+        return false;
+    }
+    IxNodeLayout node_layout = layout();
+    if (prefix_len == node_layout.prefix_len && key_len == node_layout.key_len) {
+        memcpy(node_layout.keys + key_idx * key_len, key + prefix_len, key_len);
+        return true;
+    }
+    int n = page_hdr->num_key, len = file_hdr->col_tot_len_;
+    std::vector<char> keys(n * len);
+    std::vector<Rid> rids(n);
+    copy_pairs(0, n, keys.data(), rids.data());
+    memcpy(keys.data() + key_idx * len, key, len);
+    encode(keys.data(), rids.data(), n, prefix_len, key_len);
+    return true;
 }
 
 /**
@@ -74,7 +263,7 @@ bool IxNodeHandle::leaf_lookup(const char *key, Rid **value) {
 
     int index = lower_bound(key);
     if (index < page_hdr->num_key) {
-        if (ix_compare(get_key(index), key, file_hdr->col_types_, file_hdr->col_lens_) == 0) {
+        if (compare_key(key, index) == 0) {
             *value = get_rid(index);
             return true;
         }
@@ -107,14 +296,16 @@ page_id_t IxNodeHandle::internal_lookup(const char *key) {
  * @param pos 要插入键值对的位置
  * @param (key, rid) 连续键值对的起始地址，也就是第一个键值对，可以通过(key, rid)来获取n个键值对
  * @param n 键值对数量
+ * @return 是否插入成功；插入后结点需要分裂（键值对数量达到get_max_size()）时返回false，结点不变
  * @note [0,pos)           [pos,num_key)
  *                            key_slot
  *                            /      \
  *                           /        \
  *       [0,pos)     [pos,pos+n)   [pos+n,num_key+n)
  *                      key           key_slot
+ * IX_FORMAT_PREFIX下插入的key改变了公共前缀或存储长度时，整个结点重新编码
  */
-void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n) {
+bool IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n) {
     // Todo:
     // 1. 判断pos的合法性
     // 2. 通过key获取n个连续键值对的key值，并把n个key值插入到pos位置
@@ -122,18 +313,44 @@ void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n)
     // 4. 更新当前节点的键数量
 
     if (pos < 0 || pos > page_hdr->num_key) {
-        return;
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+    int size = page_hdr->num_key, len = file_hdr->col_tot_len_;
+    int prefix_len = 0, key_len = len;
+    if (file_hdr->format_version_ == IX_FORMAT_PREFIX) {
+        merged_layout(key, n, &prefix_len, &key_len);
+    }
+    IxNodeLayout node_layout = layout();
+    if (file_hdr->format_version_ == IX_FORMAT_PREFIX) {
+        if (size + n >= ix_node_capacity(prefix_len, key_len)) {
+            return false;
+        }
+    } else if (size + n >= node_layout.capacity) {
+        return false;
+    }
+    if (file_hdr->format_version_ == IX_FORMAT_PREFIX &&
+        (size == 0 || prefix_len != node_layout.prefix_len || key_len != node_layout.key_len)) {
+        std::vector<char> keys((size + n) * len);
+        std::vector<Rid> rids(size + n);
+        copy_pairs(0, pos, keys.data(), rids.data());
+        memcpy(keys.data() + pos * len, key, n * len);
+        memcpy(rids.data() + pos, rid, n * sizeof(Rid));
+        copy_pairs(pos, size - pos, keys.data() + (pos + n) * len, rids.data() + pos + n);
+        encode(keys.data(), rids.data(), size + n, prefix_len, key_len);
+        return true;
     }
-    char *key_start = get_key(pos);
-    char *key_end = get_key(pos + n);
-    Rid *rid_start = get_rid(pos);
-    Rid *rid_end = get_rid(pos + n);
-    int num = page_hdr->num_key - pos;
-    memmove(key_end, key_start, num * file_hdr->col_tot_len_);
-    memmove(rid_end, rid_start, num * sizeof(Rid));
-    memcpy(key_start, key, n * file_hdr->col_tot_len_);
-    memcpy(rid_start, rid, n * sizeof(Rid));
+    char *key_start = node_layout.keys + pos * key_len;
+    memmove(key_start + n * key_len, key_start, (size - pos) * key_len);
+    memmove(node_layout.rids + pos + n, node_layout.rids + pos, (size - pos) * sizeof(Rid));
+    for (int i = 0; i < n; i++) {
+        memcpy(key_start + i * key_len, key + i * len + prefix_len, key_len);
+    }
+    memcpy(node_layout.rids + pos, rid, n * sizeof(Rid));
     page_hdr->num_key += n;
+    return true;
 }
 
 /**
@@ -142,6 +359,7 @@ void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n)
  *
  * @param (key, value) 要插入的键值对
  * @return int 键值对数量
+ * @note 调用者保证结点插入后不需要分裂
  */
 int IxNodeHandle::insert(const char *key, const Rid &value) {
     // Todo:
@@ -151,10 +369,12 @@ int IxNodeHandle::insert(const char *key, const Rid &value) {
     // 4. 返回完成插入操作之后的键值对数量
 
     int pos = lower_bound(key);
-    if ((pos < page_hdr->num_key) && (ix_compare(key, get_key(pos), file_hdr->col_types_, file_hdr->col_lens_) == 0)) {
+    if ((pos < page_hdr->num_key) && (compare_key(key, pos) == 0)) {
         // pass
     } else {
-        insert_pair(pos, key, value);
+        bool inserted = insert_pair(pos, key, value);
+        assert(inserted);
+        (void)inserted;
     }
     return page_hdr->num_key;
 }
@@ -163,6 +383,7 @@ int IxNodeHandle::insert(const char *key, const Rid &value) {
  * @brief 用于在结点中的指定位置删除单个键值对
  *
  * @param pos 要删除键值对的位置
+ * @note IX_FORMAT_PREFIX下不重新计算公共前缀，结点按原来的方式编码，仍然放得下
  */
 void IxNodeHandle::erase_pair(int pos) {
     // Todo:
@@ -173,13 +394,11 @@ void IxNodeHandle::erase_pair(int pos) {
     if (pos < 0 || pos >= page_hdr->num_key) {
         return;
     }
-    char *key_start = get_key(pos);
-    char *key_end = get_key(pos + 1);
-    Rid *rid_start = get_rid(pos);
-    Rid *rid_end = get_rid(pos + 1);
+    IxNodeLayout node_layout = layout();
+    char *key_start = node_layout.keys + pos * node_layout.key_len;
     int num = page_hdr->num_key - pos - 1;
-    memmove(key_start, key_end, num * file_hdr->col_tot_len_);
-    memmove(rid_start, rid_end, num * sizeof(Rid));
+    memmove(key_start, key_start + node_layout.key_len, num * node_layout.key_len);
+    memmove(node_layout.rids + pos, node_layout.rids + pos + 1, num * sizeof(Rid));
     page_hdr->num_key -= 1;
 }
 
@@ -196,7 +415,7 @@ int IxNodeHandle::remove(const char *key) {
     // 3. 返回完成删除操作后的键值对数量
 
     int pos = lower_bound(key);
-    if ((pos < page_hdr->num_key) && (ix_compare(key, get_key(pos), file_hdr->col_types_, file_hdr->col_lens_) == 0)) {
+    if ((pos < page_hdr->num_key) && (compare_key(key, pos) == 0)) {
         erase_pair(pos);
     }
     return page_hdr->num_key;
@@ -215,31 +434,353 @@ IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffe
     // disk_manager管理的fd对应的文件中，设置从file_hdr_->num_pages开始分配page_no
     int now_page_no = disk_manager_->get_fd2pageno(fd);
     disk_manager_->set_fd2pageno(fd, now_page_no + 1);
+    update_root_page_no(file_hdr_->root_page_);
 }
 
 /**
- * @brief 用于查找指定键所在的叶子结点
+ * @brief 更新根结点的page_no，调用者持有root_latch_的写锁
+ * @note IX_LATCH_OPTIMISTIC下新的根结点页面被pin住后发布给乐观查找。原来的根结点页面记为在当前epoch被替换，
+ * 在此之前开始的乐观查找可能还在不pin地读它，等这些查找都结束后才unpin：正在读它的线程不会读到被替换的帧，
+ * 它被分裂后沿右链接向右查找，被删除后从新的根结点重新查找
+ */
+void IxIndexHandle::update_root_page_no(page_id_t root) {
+    file_hdr_->root_page_ = root;
+    if (file_hdr_->latch_mode_ != IX_LATCH_OPTIMISTIC) {
+        return;
+    }
+    Page *old_root = olc_root_.load(std::memory_order_relaxed);
+    if (old_root != nullptr && old_root->get_page_id().page_no == root) {
+        return;
+    }
+    Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, root});
+    olc_root_.store(page);
+    if (old_root != nullptr) {
+        // 在新的根结点发布之后推进epoch，登记的epoch大于替换时epoch的查找一定读到新的根结点
+        olc_retired_roots_.emplace_back(old_root, olc_epoch_.fetch_add(1));
+    }
+    reclaim_retired_roots();
+}
+
+/**
+ * @brief 乐观查找开始时登记当前的epoch，此后被替换的根结点页面在查找结束前不会被unpin
+ * @return 登记使用的槽，查找结束时传给olc_exit()
+ */
+int IxIndexHandle::olc_enter() {
+    // 同一线程总是从同一个槽开始尝试，通常不与其他线程争用
+    static thread_local int hint = static_cast<int>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    uint64_t epoch = olc_epoch_.load();
+    for (int i = 0;; i++) {
+        int slot = static_cast<int>((static_cast<unsigned>(hint) + i) % IX_OLC_READER_SLOTS);
+        uint64_t expected = 0;
+        if (olc_readers_[slot].epoch.compare_exchange_strong(expected, epoch)) {
+            return slot;
+        }
+        if (i % IX_OLC_READER_SLOTS == IX_OLC_READER_SLOTS - 1) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief 乐观查找结束时注销登记。还有旧根结点页面没有unpin时尝试unpin，root_latch_被占用时留给之后的查找或写操作
+ * @param slot olc_enter()返回的槽
+ */
+void IxIndexHandle::olc_exit(int slot) {
+    olc_readers_[slot].epoch.store(0);
+    if (olc_num_retired_.load(std::memory_order_relaxed) > 0 && root_latch_.try_lock()) {
+        reclaim_retired_roots();
+        root_latch_.unlock();
+    }
+}
+
+/**
+ * @brief unpin已经没有乐观查找能读到的旧根结点页面：所有正在进行的查找登记的epoch都大于它被替换时的epoch。
+ * 调用者持有root_latch_的写锁
+ */
+void IxIndexHandle::reclaim_retired_roots() {
+    if (olc_retired_roots_.empty()) {
+        return;
+    }
+    uint64_t min_epoch = UINT64_MAX;
+    for (auto &reader : olc_readers_) {
+        uint64_t epoch = reader.epoch.load();
+        if (epoch != 0) {
+            min_epoch = std::min(min_epoch, epoch);
+        }
+    }
+    auto it = olc_retired_roots_.begin();
+    for (; it != olc_retired_roots_.end() && it->second < min_epoch; ++it) {
+        buffer_pool_manager_->unpin_page(it->first->get_page_id(), false);
+    }
+    olc_retired_roots_.erase(olc_retired_roots_.begin(), it);
+    olc_num_retired_.store(olc_retired_roots_.size(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 关闭索引前unpin根结点页面和尚未unpin的旧根结点页面
+ */
+void IxIndexHandle::unpin_root_pages() {
+    std::scoped_lock lock{root_latch_};
+    for (auto &[page, epoch] : olc_retired_roots_) {
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+    olc_retired_roots_.clear();
+    olc_num_retired_.store(0, std::memory_order_relaxed);
+    Page *page = olc_root_.exchange(nullptr);
+    if (page != nullptr) {
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+}
+
+/**
+ * @brief 用于查找指定键所在的叶子结点，按latch crabbing的方式自上而下加锁：
+ * 查找时对孩子结点加读锁后立即释放父结点的读锁；
+ * 插入和删除时对路径上的结点加写锁并放入事务的index_latch_page_set，孩子结点安全（不会分裂或合并）时释放所有祖先结点的写锁，
+ * 根结点被释放前一直持有root_latch_的写锁
  * @param key 要查找的目标key值
  * @param operation 查找到目标键值对后要进行的操作类型
- * @param transaction 事务参数，如果不需要则默认传入nullptr
+ * @param transaction 事务参数，插入和删除时不能为nullptr
  * @return [leaf node] and [root_is_latched] 返回目标叶子结点以及根结点是否加锁
  * @note need to Unlatch and unpin the leaf node outside!
- * 注意：用了FindLeafPage之后一定要unlatch叶结点，否则下次latch该结点会堵塞！
+ * 注意：查找时需要在外面对叶结点runlatch并unpin；插入和删除时叶结点在index_latch_page_set中，由release_latch_page_set()释放
  */
 std::pair<IxNodeHandle *, bool> IxIndexHandle::find_leaf_page(const char *key, Operation operation,
                                                             Transaction *transaction, bool find_first) {
-    // Todo:
-    // 1. 获取根节点
-    // 2. 从根节点开始不断向下查找目标key
-    // 3. 找到包含该key值的叶子结点停止查找，并返回叶子节点
+    if (operation == Operation::FIND) {
+        root_latch_.lock_shared();
+        IxNodeHandle *cur = fetch_node(file_hdr_->root_page_);
+        cur->page->rlatch();
+        root_latch_.unlock_shared();
+        while (!cur->is_leaf_page()) {
+            IxNodeHandle *child = fetch_node(cur->internal_lookup(key));
+            child->page->rlatch();
+            cur->page->runlatch();
+            buffer_pool_manager_->unpin_page(cur->get_page_id(), false);
+            delete cur;
+            cur = child;
+        }
+        return std::make_pair(cur, false);
+    }
 
+    bool root_is_latched = true;
+    root_latch_.lock();
     IxNodeHandle *cur = fetch_node(file_hdr_->root_page_);
-    while (!cur->page_hdr->is_leaf) {
-        page_id_t page_no = cur->internal_lookup(key);
+    cur->page->wlatch();
+    if (is_safe(cur, key, operation, true)) {
+        release_latch_page_set(transaction, &root_is_latched, false);
+    }
+    transaction->append_index_latch_page_set(cur->page);
+    while (!cur->is_leaf_page()) {
+        IxNodeHandle *child = fetch_node(cur->internal_lookup(key));
+        child->page->wlatch();
+        if (is_safe(child, key, operation, false)) {
+            release_latch_page_set(transaction, &root_is_latched, false);
+        }
+        transaction->append_index_latch_page_set(child->page);
+        delete cur;
+        cur = child;
+    }
+    return std::make_pair(cur, root_is_latched);
+}
+
+/**
+ * @brief 插入和删除先乐观地查找叶子结点：路径上的内部结点只加读锁，叶子结点加写锁。
+ * 大多数插入和删除不会引起分裂、合并或修改父结点，只需要锁住叶子结点
+ * @return 叶子结点对本次操作安全时返回加了写锁的叶子结点，需要在外面wunlatch并unpin；否则返回nullptr，调用者改用find_leaf_page()
+ * @note 结点是否为叶子结点在创建后不再改变，因此可以在加锁前判断孩子结点应加读锁还是写锁
+ */
+IxNodeHandle *IxIndexHandle::find_leaf_page_optimistic(const char *key, Operation operation) {
+    root_latch_.lock_shared();
+    IxNodeHandle *cur = fetch_node(file_hdr_->root_page_);
+    bool is_root = true;
+    if (cur->is_leaf_page()) {
+        cur->page->wlatch();
+    } else {
+        cur->page->rlatch();
+    }
+    root_latch_.unlock_shared();
+    while (!cur->is_leaf_page()) {
+        IxNodeHandle *child = fetch_node(cur->internal_lookup(key));
+        if (child->is_leaf_page()) {
+            child->page->wlatch();
+        } else {
+            child->page->rlatch();
+        }
+        cur->page->runlatch();
         buffer_pool_manager_->unpin_page(cur->get_page_id(), false);
-        cur = fetch_node(page_no);
+        delete cur;
+        cur = child;
+        is_root = false;
+    }
+    if (is_safe(cur, key, operation, is_root)) {
+        return cur;
+    }
+    cur->page->wunlatch();
+    buffer_pool_manager_->unpin_page(cur->get_page_id(), false);
+    delete cur;
+    return nullptr;
+}
+
+/**
+ * @brief 判断node在本次插入或删除后是否安全，即对node的修改不会影响到它的父结点
+ * @param is_root node是否为根结点
+ * @note 插入后不会分裂，删除后不会下溢；且node的第一个key不会改变，否则需要通过maintain_parent()更新父结点中的key。
+ * 结点的第一个key是其子树中最小的key，插入更小的key或删除不大于它的key时才可能改变。
+ * 根结点没有下溢的限制，但叶子根结点被删空、内部根结点只剩一个孩子时需要调整根结点。
+ * IX_FORMAT_PREFIX下父结点中的key只是子树的下界，不随第一个key改变；叶子结点能否放下取决于插入的key，
+ * 内部结点可能因孩子分裂插入两个key、因孩子重分配替换一个key，键值对数量不超过btree_order时按任何方式编码都放得下
+ */
+bool IxIndexHandle::is_safe(IxNodeHandle *node, const char *key, Operation operation, bool is_root) {
+    if (operation == Operation::FIND) {
+        return true;
+    }
+    if (file_hdr_->format_version_ == IX_FORMAT_PREFIX) {
+        if (node->is_leaf_page() && operation == Operation::INSERT) {
+            return node->can_insert(key);
+        }
+        if (!node->is_leaf_page() && node->get_size() + 2 > file_hdr_->btree_order_) {
+            return false;
+        }
+        if (operation == Operation::DELETE) {
+            return is_root ? node->get_size() > (node->is_leaf_page() ? 1 : 2)
+                           : node->get_size() - 1 >= node->get_min_size();
+        }
+        return true;
+    }
+    if (is_root) {
+        if (operation == Operation::INSERT) {
+            return node->get_size() + 1 < node->get_max_size();
+        }
+        return node->get_size() > (node->is_leaf_page() ? 1 : 2);
+    }
+    int cmp = ix_compare(key, node->get_key(0), file_hdr_->col_types_, file_hdr_->col_lens_);
+    if (operation == Operation::INSERT) {
+        return node->get_size() + 1 < node->get_max_size() && cmp >= 0;
+    }
+    return node->get_size() - 1 >= node->get_min_size() && cmp > 0;
+}
+
+/**
+ * @brief 对不在查找路径上、但结构修改需要用到的结点（合并或重分配时的兄弟结点）加写锁，放入index_latch_page_set
+ * @note node的pin由index_latch_page_set持有，在release_latch_page_set()中unpin
+ */
+void IxIndexHandle::latch_page(IxNodeHandle *node, Transaction *transaction) {
+    node->page->wlatch();
+    transaction->append_index_latch_page_set(node->page);
+}
+
+/**
+ * @brief 释放index_latch_page_set中所有结点的写锁并unpin，如果持有root_latch_也一并释放
+ * @param is_dirty 结点是否被修改；查找过程中释放的祖先结点未被修改
+ */
+void IxIndexHandle::release_latch_page_set(Transaction *transaction, bool *root_is_latched, bool is_dirty) {
+    if (*root_is_latched) {
+        root_latch_.unlock();
+        *root_is_latched = false;
+    }
+    auto page_set = transaction->get_index_latch_page_set();
+    for (Page *page : *page_set) {
+        page->wunlatch();
+        buffer_pool_manager_->unpin_page(page->get_page_id(), is_dirty);
+    }
+    page_set->clear();
+}
+
+/**
+ * @brief 用乐观锁耦合（optimistic lock coupling）的方式查找key所在的叶子结点，不对任何结点加锁：
+ * 读完一个结点后校验页面的版本号，读到孩子结点的版本号之后再校验父结点，保证孩子结点的范围包含key。
+ * 写者按B-link的方式维护每一层的右链接，key大于结点中所有key时查看右兄弟的第一个key，必要时向右移动；
+ * 结点被并发修改时，只要它没有被删除且第一个key不大于key，key就在它或它右边的结点中，从它继续查找，
+ * 因此与分裂并发的查找不需要从根结点重新开始
+ * @param key 要查找的目标key值
+ * @param[out] version 叶子结点的版本号，调用者读完叶子结点后需要校验，校验失败时重新查找
+ * @return 被pin住的叶子结点，调用者负责unpin
+ * @note 结点的is_leaf在创建后不再改变；被删除的结点会被标记为IX_DELETED_NODE，但页面不会被复用，
+ * 因此读到的页面号总是指向某个（可能已被删除的）结点
+ */
+IxNodeHandle IxIndexHandle::find_leaf_page_olc(const char *key, uint64_t *version) {
+    // 登记之后读到的根结点页面在查找结束前一直被pin住
+    int slot = olc_enter();
+    while (true) {
+        // 读根结点时不pin，只写本线程登记用的槽，不写其他共享的cache line
+        IxNodeHandle cur(file_hdr_, olc_root_.load());
+        bool pinned = false;
+        uint64_t v = cur.page->read_version();
+        // cur被并发修改后重新读取其版本号，返回能否从cur继续查找
+        auto reread = [&]() {
+            v = cur.page->read_version();
+            bool covers = !cur.is_deleted() && cur.get_size() > 0 && cur.compare_key(key, 0) >= 0;
+            return cur.page->validate(v) && covers;
+        };
+        bool restart = false;
+        while (!restart) {
+            if (cur.is_deleted()) {
+                restart = true;
+                break;
+            }
+            // key大于结点中所有的key时，可能属于分裂出去的右兄弟
+            int size = cur.get_size();
+            if (size == 0 || cur.compare_key(key, size - 1) > 0) {
+                page_id_t right = cur.get_right_link();
+                if (!cur.page->validate(v)) {
+                    restart = !reread();
+                    continue;
+                }
+                if (right != IX_NO_PAGE) {
+                    IxNodeHandle next(file_hdr_, buffer_pool_manager_->fetch_page(PageId{fd_, right}));
+                    uint64_t next_v = next.page->read_version();
+                    bool next_deleted = next.is_deleted();
+                    bool move = next.get_size() > 0 && next.compare_key(key, 0) >= 0;
+                    // 校验cur保证读next期间cur没有分裂，next仍是cur的右兄弟
+                    if (!next.page->validate(next_v) || !cur.page->validate(v) || next_deleted) {
+                        buffer_pool_manager_->unpin_page(next.get_page_id(), false);
+                        restart = next_deleted || !reread();
+                        continue;
+                    }
+                    if (move) {
+                        if (pinned) {
+                            buffer_pool_manager_->unpin_page(cur.get_page_id(), false);
+                        }
+                        cur = next;
+                        v = next_v;
+                        pinned = true;
+                        continue;
+                    }
+                    buffer_pool_manager_->unpin_page(next.get_page_id(), false);
+                }
+            }
+            if (cur.is_leaf_page()) {
+                if (!pinned) {
+                    buffer_pool_manager_->fetch_page(cur.get_page_id());
+                }
+                *version = v;
+                olc_exit(slot);
+                return cur;
+            }
+
+            page_id_t child_no = cur.internal_lookup(key);
+            if (!cur.page->validate(v)) {
+                restart = !reread();
+                continue;
+            }
+            IxNodeHandle child(file_hdr_, buffer_pool_manager_->fetch_page(PageId{fd_, child_no}));
+            uint64_t child_v = child.page->read_version();
+            if (!cur.page->validate(v)) {
+                buffer_pool_manager_->unpin_page(child.get_page_id(), false);
+                restart = !reread();
+                continue;
+            }
+            if (pinned) {
+                buffer_pool_manager_->unpin_page(cur.get_page_id(), false);
+            }
+            cur = child;
+            v = child_v;
+            pinned = true;
+        }
+        if (pinned) {
+            buffer_pool_manager_->unpin_page(cur.get_page_id(), false);
+        }
     }
-    return std::make_pair(cur, false);
 }
 
 /**
@@ -257,28 +798,126 @@ bool IxIndexHandle::get_value(const char *key, std::vector<Rid> *result, Transac
     // 3. 把rid存入result参数中
     // 提示：使用完buffer_pool提供的page之后，记得unpin page；记得处理并发的上锁
 
-    std::scoped_lock lock{root_latch_};
-    std::pair<IxNodeHandle *, bool> leaf_page = find_leaf_page(key, Operation::FIND, transaction, true);
-    IxNodeHandle *node = leaf_page.first;
+    if (file_hdr_->latch_mode_ == IX_LATCH_OPTIMISTIC) {
+        while (true) {
+            uint64_t version;
+            IxNodeHandle leaf = find_leaf_page_olc(key, &version);
+            Rid *rid;
+            bool found = leaf.leaf_lookup(key, &rid);
+            Rid value = found ? *rid : Rid{};
+            bool valid = leaf.page->validate(version);
+            buffer_pool_manager_->unpin_page(leaf.get_page_id(), false);
+            if (valid) {
+                if (found) {
+                    result->push_back(value);
+                }
+                return found;
+            }
+        }
+    }
+
+    IxNodeHandle *node = find_leaf_page(key, Operation::FIND, transaction, true).first;
     Rid *rid;
-    if (node && node->leaf_lookup(key, &rid)) {
+    bool found = node->leaf_lookup(key, &rid);
+    if (found) {
         result->push_back(*rid);
-        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
-        return true;
-    } else {
-    	buffer_pool_manager_->unpin_page(node->get_page_id(), false);
-    	return false;
     }
+    node->page->runlatch();
+    buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
+    return found;
+}
+
+/**
+ * @brief 结点放不下时，确定把n个有序键值对分到几个结点中：IX_FORMAT_FIXED下从中间分成两半；
+ * IX_FORMAT_PREFIX下每个结点能放下的键值对数量取决于其中的key，优先分成两个结点，并让两边尽量平均，
+ * 分不成两个时分成三个，每个结点都不少于min_size
+ * @return 每个新结点的第一个键值对的位置
+ */
+std::vector<int> IxIndexHandle::split_points(const char *keys, int n) const {
+    if (file_hdr_->format_version_ != IX_FORMAT_PREFIX) {
+        return {n / 2};
+    }
+    int min_size = (file_hdr_->btree_order_ + 1) / 2;
+    // 能放下的区间的子区间也能放下：左边[0,m)在m不超过left_max时能放下，右边[m,n)在m不小于right_min时能放下
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (fits(keys, 0, mid)) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    int left_max = lo;
+    lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (fits(keys, mid, n)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    int right_min = lo;
+    if (std::max(right_min, min_size) <= std::min(left_max, n - min_size)) {
+        return {std::clamp(n / 2, std::max(right_min, min_size), std::min(left_max, n - min_size))};
+    }
+    // 插入的key使两边都压缩得很少时，把它单独分到中间的结点
+    for (int a = min_size; a <= std::min(left_max, n - 2 * min_size); a++) {
+        int b = std::max(a + min_size, right_min);
+        if (b <= n - min_size && fits(keys, a, b)) {
+            return {a, b};
+        }
+    }
+    throw InternalError("IxIndexHandle::split_points: cannot split node");
 }
 
 /**
- * @brief  将传入的一个node拆分(Split)成两个结点，在node的右边生成一个新结点new node
+ * @brief 有序的key中[begin, end)的键值对能否放进一个结点而不需要分裂
+ */
+bool IxIndexHandle::fits(const char *keys, int begin, int end) const {
+    int n = end - begin;
+    if (file_hdr_->format_version_ != IX_FORMAT_PREFIX || n == 0) {
+        return n < file_hdr_->btree_order_ + 1;
+    }
+    size_t len = file_hdr_->col_tot_len_;
+    int prefix_len = ix_common_prefix(keys + begin * len, keys + (end - 1) * len, file_hdr_->prefix_max_len_);
+    int sig_len = 0;
+    for (int i = begin; i < end; i++) {
+        sig_len = std::max(sig_len, ix_key_trim_len(keys + i * len, file_hdr_));
+    }
+    return n < ix_node_capacity(prefix_len, std::max(sig_len - prefix_len, 0));
+}
+
+/**
+ * @brief 取出node中的所有键值对，并在pos处插入n个键值对（replace时替换第pos个键值对），用于结点放不下时分裂
+ */
+void IxIndexHandle::collect_pairs(IxNodeHandle *node, int pos, const char *key, const Rid *rid, int n, bool replace,
+                                  std::vector<char> *keys, std::vector<Rid> *rids) const {
+    int len = file_hdr_->col_tot_len_;
+    int size = node->get_size();
+    int tail = replace ? pos + n : pos;
+    keys->resize((size_t)(pos + n + size - tail) * len);
+    rids->resize(pos + n + size - tail);
+    node->copy_pairs(0, pos, keys->data(), rids->data());
+    memcpy(keys->data() + pos * len, key, n * len);
+    memcpy(rids->data() + pos, rid, n * sizeof(Rid));
+    node->copy_pairs(tail, size - tail, keys->data() + (pos + n) * len, rids->data() + pos + n);
+}
+
+/**
+ * @brief  将传入的一个node拆分(Split)成两个或三个结点，node保留最左边的键值对，右边依次是新建的结点
  * @param node 需要拆分的结点
- * @return 拆分得到的new_node
+ * @param keys, rids node中原有的键值对和要插入的键值对，已按顺序排好
+ * @param[out] separators 每个新结点在父结点中的key：内部结点为新结点的第一个key；
+ * IX_FORMAT_PREFIX的叶子结点为它与左边结点之间截短的分隔键
+ * @return 拆分得到的新结点
  * @note need to unpin the new node outside
  * 注意：本函数执行完毕后，原node和new node都需要在函数外面进行unpin
  */
-IxNodeHandle *IxIndexHandle::split(IxNodeHandle *node) {
+std::vector<IxNodeHandle *> IxIndexHandle::split(IxNodeHandle *node, const std::vector<char> &keys,
+                                                 const std::vector<Rid> &rids, std::vector<char> *separators) {
     // Todo:
     // 1. 将原结点的键值对平均分配，右半部分分裂为新的右兄弟结点
     //    需要初始化新节点的page_hdr内容
@@ -286,43 +925,93 @@ IxNodeHandle *IxIndexHandle::split(IxNodeHandle *node) {
     //    为新节点分配键值对，更新旧节点的键值对数记录
     // 3. 如果新的右兄弟结点不是叶子结点，更新该结点的所有孩子结点的父节点信息(使用IxIndexHandle::maintain_child())
 
-    IxNodeHandle *new_node = create_node();
-    int pos = node->page_hdr->num_key >> 1;
-    new_node->page_hdr->is_leaf = node->page_hdr->is_leaf;
-    new_node->page_hdr->parent = node->page_hdr->parent;
-    new_node->page_hdr->next_free_page_no = node->page_hdr->next_free_page_no;
-    new_node->insert_pairs(0, node->get_key(pos), node->get_rid(pos), node->page_hdr->num_key - pos);
-    node->page_hdr->num_key = pos;
-    if (new_node->page_hdr->is_leaf) {
-        new_node->page_hdr->prev_leaf = node->get_page_no();
-        new_node->page_hdr->next_leaf = node->page_hdr->next_leaf;
-        IxNodeHandle *next = fetch_node(new_node->page_hdr->next_leaf);
-        next->page_hdr->prev_leaf = new_node->get_page_no();
+    int len = file_hdr_->col_tot_len_;
+    int n = rids.size();
+    std::vector<int> points = split_points(keys.data(), n);
+    points.push_back(n);
+    bool truncate = node->is_leaf_page() && file_hdr_->format_version_ == IX_FORMAT_PREFIX;
+    separators->resize(points.size() * len - len);
+
+    // 新结点先填好并链接到node原来的右兄弟，最后才把node链接到第一个新结点
+    std::vector<IxNodeHandle *> new_nodes;
+    page_id_t next_page_no = node->page_hdr->next_leaf;
+    for (size_t i = points.size() - 1; i-- > 0;) {
+        IxNodeHandle *new_node = create_node();
+        new_node->page_hdr->is_leaf = node->page_hdr->is_leaf;
+        new_node->page_hdr->parent = node->page_hdr->parent;
+        new_node->page_hdr->next_free_page_no = node->page_hdr->next_free_page_no;
+        new_node->page_hdr->num_key = 0;
+        new_node->assign(keys.data() + points[i] * len, rids.data() + points[i], points[i + 1] - points[i]);
+        new_node->page_hdr->next_leaf = next_page_no;
+        next_page_no = new_node->get_page_no();
+        char *separator = separators->data() + i * len;
+        if (truncate) {
+            ix_separator(keys.data() + (points[i] - 1) * len, keys.data() + points[i] * len, separator, file_hdr_);
+        } else {
+            memcpy(separator, keys.data() + points[i] * len, len);
+        }
+        new_nodes.insert(new_nodes.begin(), new_node);
+    }
+    node->assign(keys.data(), rids.data(), points[0]);
+
+    if (node->is_leaf_page()) {
+        page_id_t prev_page_no = node->get_page_no();
+        for (IxNodeHandle *new_node : new_nodes) {
+            new_node->page_hdr->prev_leaf = prev_page_no;
+            prev_page_no = new_node->get_page_no();
+        }
+        // 叶子结点的prev_leaf只由持有其前驱结点写锁的线程读写，这里持有node，不需要对next加锁
+        IxNodeHandle *next = fetch_node(new_nodes.back()->page_hdr->next_leaf);
+        next->page_hdr->prev_leaf = prev_page_no;
         buffer_pool_manager_->unpin_page(next->get_page_id(), true);
-        node->page_hdr->next_leaf = new_node->get_page_no();
+        delete next;
+        std::scoped_lock lock{file_hdr_latch_};
+        if (file_hdr_->last_leaf_ == node->get_page_no()) {
+            file_hdr_->last_leaf_ = prev_page_no;
+        }
     } else {
-        for (int i = 0; i < new_node->page_hdr->num_key; i++) {
-            maintain_child(new_node, i);
+        for (IxNodeHandle *new_node : new_nodes) {
+            new_node->page_hdr->prev_leaf = IX_NO_PAGE;
+            for (int i = 0; i < new_node->page_hdr->num_key; i++) {
+                maintain_child(new_node, i);
+            }
         }
     }
-    return new_node;
+    // 内部结点也按B-link的方式链接到右兄弟，与分裂并发的乐观查找沿右链接找到被移走的key
+    node->page_hdr->next_leaf = new_nodes.front()->get_page_no();
+    return new_nodes;
+}
+
+/**
+ * @brief 分裂放不下keys和rids的node，并把新结点插入父结点
+ * @param keys, rids node中原有的键值对和要插入的键值对
+ */
+void IxIndexHandle::split_into_parent(IxNodeHandle *node, const std::vector<char> &keys, const std::vector<Rid> &rids,
+                                      Transaction *transaction) {
+    std::vector<char> separators;
+    std::vector<IxNodeHandle *> new_nodes = split(node, keys, rids, &separators);
+    insert_into_parent(node, separators.data(), new_nodes, transaction);
+    for (IxNodeHandle *new_node : new_nodes) {
+        buffer_pool_manager_->unpin_page(new_node->get_page_id(), true);
+        delete new_node;
+    }
 }
 
 /**
  * @brief Insert key & value pair into internal page after split
  * 拆分(Split)后，向上找到old_node的父结点
- * 将new_node的第一个key插入到父结点，其位置在 父结点指向old_node的孩子指针 之后
- * 如果插入后>=maxsize，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
- * 直到找到的old_node为根结点时，结束递归（此时将会新建一个根R，关键字为key，old_node和new_node为其孩子）
+ * 将每个new_node的separator插入到父结点，其位置在 父结点指向old_node的孩子指针 之后
+ * 如果父结点放不下，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
+ * 直到找到的old_node为根结点时，结束递归（此时将会新建一个根R，old_node和new_nodes为其孩子）
  *
- * @param (old_node, new_node) 原结点为old_node，old_node被分裂之后产生了新的右兄弟结点new_node
- * @param key 要插入parent的key
- * @note 一个结点插入了键值对之后需要分裂，分裂后左半部分的键值对保留在原结点，在参数中称为old_node，
- * 右半部分的键值对分裂为新的右兄弟节点，在参数中称为new_node（参考Split函数来理解old_node和new_node）
+ * @param (old_node, new_nodes) 原结点为old_node，old_node被分裂之后产生了新的右兄弟结点new_nodes
+ * @param separators 要插入parent的key，与new_nodes一一对应
+ * @note 一个结点插入了键值对之后需要分裂，分裂后最左边的键值对保留在原结点，在参数中称为old_node，
+ * 其余的键值对分裂为新的右兄弟节点，在参数中称为new_nodes（参考Split函数来理解old_node和new_nodes）
  * @note 本函数执行完毕后，new node和old node都需要在函数外面进行unpin
  */
-void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node,
-                                     Transaction *transaction) {
+void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *separators,
+                                     const std::vector<IxNodeHandle *> &new_nodes, Transaction *transaction) {
     // Todo:
     // 1. 分裂前的结点（原结点, old_node）是否为根结点，如果为根结点需要分配新的root
     // 2. 获取原结点（old_node）的父亲结点
@@ -330,28 +1019,64 @@ void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *key,
     // 4. 如果父亲结点仍需要继续分裂，则进行递归插入
     // 提示：记得unpin page
 
-    if (old_node->get_page_no() == file_hdr_->root_page_) {
+    int len = file_hdr_->col_tot_len_;
+    int n = new_nodes.size();
+    std::vector<Rid> new_rids;
+    for (IxNodeHandle *new_node : new_nodes) {
+        new_rids.push_back(Rid{new_node->get_page_no(), -1});
+    }
+    // old_node需要分裂，它的父结点（或根结点时的root_latch_）一定还在index_latch_page_set中
+    if (old_node->is_root_page()) {
         IxNodeHandle *new_root = create_node();
         new_root->page_hdr->is_leaf = false;
         new_root->page_hdr->num_key = 0;
         new_root->page_hdr->parent = INVALID_PAGE_ID;
         new_root->page_hdr->next_free_page_no = IX_NO_PAGE;
+        new_root->page_hdr->prev_leaf = IX_NO_PAGE;
+        new_root->page_hdr->next_leaf = IX_NO_PAGE;
 
-        new_root->insert_pair(0, old_node->get_key(0), {old_node->get_page_no(), -1});
-        new_root->insert_pair(1, key, {new_node->get_page_no(), -1});
-        new_node->page_hdr->parent = old_node->page_hdr->parent = new_root->get_page_no();
-        file_hdr_->root_page_ = new_root->get_page_no();
+        // IX_FORMAT_PREFIX下父结点中的key是子树的下界，最左边的孩子取最小的key，之后插入更小的key时不需要更新
+        std::vector<char> root_keys(len);
+        if (file_hdr_->format_version_ == IX_FORMAT_PREFIX) {
+            memcpy(root_keys.data(), file_hdr_->key_min_.data(), len);
+        } else {
+            old_node->copy_key(0, root_keys.data());
+        }
+        root_keys.insert(root_keys.end(), separators, separators + n * len);
+        new_rids.insert(new_rids.begin(), Rid{old_node->get_page_no(), -1});
+        new_root->assign(root_keys.data(), new_rids.data(), n + 1);
+        old_node->page_hdr->parent = new_root->get_page_no();
+        for (IxNodeHandle *new_node : new_nodes) {
+            new_node->page_hdr->parent = new_root->get_page_no();
+        }
+        update_root_page_no(new_root->get_page_no());
+        buffer_pool_manager_->unpin_page(new_root->get_page_id(), true);
+        delete new_root;
     } else {
         IxNodeHandle *parent = fetch_node(old_node->get_parent_page_no());
-        int pos = parent->find_child(old_node);
-        parent->insert_pair(pos + 1, key, {new_node->get_page_no(), -1});
-        if (parent->get_size() == parent->get_max_size()) {
-            IxNodeHandle *new_node_split = split(parent);
-            insert_into_parent(parent, new_node_split->get_key(0), new_node_split, transaction);
-            buffer_pool_manager_->unpin_page(new_node_split->get_page_id(), true);
+        int pos = parent->find_child(old_node) + 1;
+        if (!parent->insert_pairs(pos, separators, new_rids.data(), n)) {
+            std::vector<char> keys;
+            std::vector<Rid> rids;
+            collect_pairs(parent, pos, separators, new_rids.data(), n, false, &keys, &rids);
+            split_into_parent(parent, keys, rids, transaction);
         }
         buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
-    }	
+        delete parent;
+    }
+}
+
+/**
+ * @brief 把parent中第rank个孩子的key替换为separator，parent放不下时分裂
+ * @note 用于IX_FORMAT_PREFIX下重分配之后更新分隔键
+ */
+void IxIndexHandle::update_separator(IxNodeHandle *parent, int rank, const char *separator, Transaction *transaction) {
+    if (!parent->set_key(rank, separator)) {
+        std::vector<char> keys;
+        std::vector<Rid> rids;
+        collect_pairs(parent, rank, separator, parent->get_rid(rank), 1, true, &keys, &rids);
+        split_into_parent(parent, keys, rids, transaction);
+    }
 }
 
 /**
@@ -367,20 +1092,272 @@ page_id_t IxIndexHandle::insert_entry(const char *key, const Rid &value, Transac
     // 3. 如果结点已满，分裂结点，并把新结点的相关信息插入父节点
     // 提示：记得unpin page；若当前叶子节点是最右叶子节点，则需要更新file_hdr_.last_leaf；记得处理并发的上锁
 
+    IxNodeHandle *leaf_page = find_leaf_page_optimistic(key, Operation::INSERT);
+    if (leaf_page != nullptr) {
+        int num = leaf_page->page_hdr->num_key;
+        bool flag = (leaf_page->insert(key, value) > num);
+        page_id_t page_no = leaf_page->get_page_no();
+        leaf_page->page->wunlatch();
+        buffer_pool_manager_->unpin_page(leaf_page->get_page_id(), flag);
+        delete leaf_page;
+        return page_no;
+    }
+
+    // 叶子结点可能分裂，重新查找并锁住可能被修改的祖先结点
+    Transaction local_txn(INVALID_TXN_ID);
+    if (transaction == nullptr) {
+        transaction = &local_txn;
+    }
+    auto [leaf, root_is_latched] = find_leaf_page(key, Operation::INSERT, transaction);
+    int num = leaf->page_hdr->num_key;
+    int pos = leaf->lower_bound(key);
+    bool flag = pos == num || leaf->compare_key(key, pos) != 0;
+    if (flag) {
+        // IX_FORMAT_PREFIX下父结点中的key是子树的下界，插入更小的key不需要更新
+        bool insert_first = num > 0 && pos == 0 && file_hdr_->format_version_ != IX_FORMAT_PREFIX;
+        if (leaf->insert_pair(pos, key, value)) {
+            if (insert_first) {
+                maintain_parent(leaf);
+            }
+        } else {
+            std::vector<char> keys;
+            std::vector<Rid> rids;
+            collect_pairs(leaf, pos, key, &value, 1, false, &keys, &rids);
+            std::vector<char> separators;
+            std::vector<IxNodeHandle *> new_nodes = split(leaf, keys, rids, &separators);
+            if (insert_first) {
+                maintain_parent(leaf);
+            }
+            insert_into_parent(leaf, separators.data(), new_nodes, transaction);
+            for (IxNodeHandle *new_node : new_nodes) {
+                buffer_pool_manager_->unpin_page(new_node->get_page_id(), true);
+                delete new_node;
+            }
+        }
+    }
+    page_id_t page_no = leaf->get_page_no();
+    release_latch_page_set(transaction, &root_is_latched, true);
+    delete leaf;
+    return page_no;
+}
+
+/**
+ * @brief 从已排序的键值对自底向上构建B+树：依次填满叶子结点，再逐层为上一层的结点建立父结点，
+ * 每个结点只写一次，不需要查找和分裂
+ * @param keys num_keys个连续存放的key，按ix_compare升序排列且没有重复
+ * @param rids 与keys一一对应的rid
+ * @param num_keys 键值对数量
+ * @param fill_factor 每个结点填到的比例，取值(0, 1]
+ * @return bool 索引为空时构建并返回true；索引中已有键值对时不做修改并返回false，调用者需逐条插入
+ * @note 根结点所在的页面（IX_INIT_ROOT_PAGE）被复用为第一个叶子结点
+ */
+bool IxIndexHandle::bulk_load(const char *keys, const Rid *rids, int num_keys, double fill_factor) {
+    bool done = false;
+    return bulk_load_batches(
+        [&](const char **batch_keys, const Rid **batch_rids) {
+            *batch_keys = keys;
+            *batch_rids = rids;
+            return std::exchange(done, true) ? 0 : num_keys;
+        },
+        fill_factor);
+}
+
+/**
+ * @brief 从sorter中按批取出排好序的键值对构建B+树，叶子结点边取边写，内存中只保留每个叶子结点的分隔键
+ * @return bool 同bulk_load(keys, rids, num_keys)；返回false时sorter中的键值对没有被取出
+ */
+bool IxIndexHandle::bulk_load(IxSorter *sorter, double fill_factor) {
+    return bulk_load_batches(
+        [sorter](const char **batch_keys, const Rid **batch_rids) { return sorter->next_batch(batch_keys, batch_rids); },
+        fill_factor);
+}
+
+/**
+ * @brief 批量构建的实现：next_batch依次给出一批有序的键值对，返回0表示结束
+ */
+bool IxIndexHandle::bulk_load_batches(const std::function<int(const char **, const Rid **)> &next_batch,
+                                      double fill_factor) {
+    if (!(fill_factor > 0 && fill_factor <= 1)) {
+        throw InternalError("IxIndexHandle::bulk_load: fill factor out of range");
+    }
     std::scoped_lock lock{root_latch_};
-    IxNodeHandle *leaf_page = find_leaf_page(key, Operation::INSERT, transaction).first;
-    int num = leaf_page->page_hdr->num_key;
-    bool flag = (leaf_page->insert(key, value) > num);
-    if (flag && leaf_page->page_hdr->num_key == leaf_page->get_max_size()) {
-        IxNodeHandle *new_node = split(leaf_page);
-        if (file_hdr_->last_leaf_ == leaf_page->get_page_no()) {
-            file_hdr_->last_leaf_ = new_node->get_page_no();
-        }
-        insert_into_parent(leaf_page, new_node->get_key(0), new_node, transaction);
-        buffer_pool_manager_->unpin_page(new_node->get_page_id(), true);
+    IxNodeHandle *root = fetch_node(file_hdr_->root_page_);
+    if (!root->is_leaf_page() || root->get_size() != 0) {
+        buffer_pool_manager_->unpin_page(root->get_page_id(), false);
+        delete root;
+        return false;
     }
-    buffer_pool_manager_->unpin_page(leaf_page->get_page_id(), flag);
-    return leaf_page->get_page_id().page_no;
+    // 构建期间对空树的根结点加写锁，正在读它的线程读完后才开始覆盖，乐观查找的线程会发现它被修改
+    root->page->wlatch();
+
+    // 叶子层：每一批只构建后面还有完整结点的结点，剩下的键值对与下一批一起处理，最后一批统一分配末尾的结点
+    size_t len = file_hdr_->col_tot_len_;
+    IxBuildLevel level{true};
+    std::vector<char> pending_keys;
+    std::vector<Rid> pending_rids;
+    const char *keys;
+    const Rid *rids;
+    for (int n; (n = next_batch(&keys, &rids)) > 0;) {
+        if (!pending_rids.empty()) {
+            pending_keys.insert(pending_keys.end(), keys, keys + n * len);
+            pending_rids.insert(pending_rids.end(), rids, rids + n);
+            keys = pending_keys.data();
+            rids = pending_rids.data();
+            n = pending_rids.size();
+        }
+        int used = build_nodes(&level, keys, rids, n, false, fill_factor);
+        std::vector<char> rest_keys(keys + used * len, keys + n * len);
+        std::vector<Rid> rest_rids(rids + used, rids + n);
+        pending_keys.swap(rest_keys);
+        pending_rids.swap(rest_rids);
+    }
+    build_nodes(&level, pending_keys.data(), pending_rids.data(), pending_rids.size(), true, fill_factor);
+    if (level.node_rids.empty()) {
+        root->page->wunlatch();
+        buffer_pool_manager_->unpin_page(root->get_page_id(), false);
+        delete root;
+        return true;
+    }
+
+    page_id_t first_leaf = level.node_rids.front().page_no;
+    page_id_t last_leaf = level.node_rids.back().page_no;
+    {
+        std::scoped_lock hdr_lock{file_hdr_latch_};
+        file_hdr_->first_leaf_ = first_leaf;
+        file_hdr_->last_leaf_ = last_leaf;
+    }
+    IxNodeHandle *leaf_header = fetch_node(IX_LEAF_HEADER_PAGE);
+    leaf_header->set_next_leaf(first_leaf);
+    leaf_header->set_prev_leaf(last_leaf);
+    buffer_pool_manager_->unpin_page(leaf_header->get_page_id(), true);
+    delete leaf_header;
+
+    // 每个结点在上一层中的key和页面号作为上一层的键值对
+    while (level.node_rids.size() > 1) {
+        IxBuildLevel parent{false};
+        build_nodes(&parent, level.node_keys.data(), level.node_rids.data(), level.node_rids.size(), true, fill_factor);
+        level = std::move(parent);
+    }
+    update_root_page_no(level.node_rids.front().page_no);
+    root->page->wunlatch();
+    buffer_pool_manager_->unpin_page(root->get_page_id(), true);
+    delete root;
+    return true;
+}
+
+/**
+ * @brief 把有序的键值对依次放进level这一层新建的结点中。每个结点先求出最多能放下的数量：IX_FORMAT_FIXED下为
+ * btree_order，IX_FORMAT_PREFIX下取决于其中的key；再按fill_factor只填到其中一部分，但不少于min_size。
+ * 最后一个结点不足min_size时与前一个结点重新分配，因此除了只有一个结点的情况外，每个结点都不少于min_size
+ * @param last 是否是这一层最后的键值对；不是时只构建后面至少还有max_node_keys个键值对的结点，
+ * 末尾的重新分配不会涉及已经写好的结点
+ * @return int 已放进结点的键值对数量，last为true时为num_keys
+ * @note 结点在上一层中的key为它的第一个key；IX_FORMAT_PREFIX的叶子结点为截短的分隔键，第一个叶子结点为最小的key。
+ * 内部结点的孩子在这里被指向新的父结点；叶子结点之间按顺序链接，首尾与leaf header相连；
+ * 内部结点也链接到右兄弟，最右结点的右链接为IX_NO_PAGE
+ */
+int IxIndexHandle::build_nodes(IxBuildLevel *level, const char *keys, const Rid *rids, int num_keys, bool last,
+                               double fill_factor) {
+    // 任何结点中的键值对都少于max_node_keys个
+    constexpr int max_node_keys = PAGE_SIZE / sizeof(Rid);
+    size_t len = file_hdr_->col_tot_len_;
+    bool prefix = file_hdr_->format_version_ == IX_FORMAT_PREFIX;
+    int min_size = (file_hdr_->btree_order_ + 1) / 2;
+    // 每个结点的第一个键值对的位置
+    std::vector<int> points;
+    int pos = 0;
+    while (pos < num_keys) {
+        int lo = pos + 1, hi = std::min(num_keys, pos + max_node_keys);
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (fits(keys, pos, mid)) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        int size = lo - pos;
+        int end = pos + std::min(size, std::max(min_size, static_cast<int>(std::ceil(size * fill_factor))));
+        if (!last && num_keys - end < max_node_keys) {
+            break;
+        }
+        points.push_back(pos);
+        pos = end;
+    }
+    if (last && points.size() > 1 && num_keys - points.back() < min_size) {
+        int begin = points[points.size() - 2];
+        points.pop_back();
+        // 不少于2 * min_size个时分成两个结点，否则不超过btree_order个，合并成一个结点一定放得下
+        if (num_keys - begin >= 2 * min_size) {
+            for (int point : split_points(keys + begin * len, num_keys - begin)) {
+                points.push_back(begin + point);
+            }
+        }
+    }
+    points.push_back(pos);
+
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        int size = points[i + 1] - points[i];
+        bool first_node = level->node_rids.empty();
+        // 第一个叶子复用空树的根结点页面
+        IxNodeHandle *node = level->is_leaf && first_node ? fetch_node(file_hdr_->root_page_) : create_node();
+        node->page_hdr->next_free_page_no = IX_NO_PAGE;
+        node->page_hdr->parent = IX_NO_PAGE;
+        node->page_hdr->is_leaf = level->is_leaf;
+        node->page_hdr->num_key = 0;
+        const char *first = keys + points[i] * len;
+        node->assign(first, rids + points[i], size);
+        if (level->is_leaf) {
+            node->set_prev_leaf(level->prev == nullptr ? IX_LEAF_HEADER_PAGE : level->prev->get_page_no());
+            node->set_next_leaf(IX_LEAF_HEADER_PAGE);
+        } else {
+            node->set_prev_leaf(IX_NO_PAGE);
+            node->set_next_leaf(IX_NO_PAGE);
+            for (int j = 0; j < size; j++) {
+                maintain_child(node, j);
+            }
+        }
+        if (level->prev != nullptr) {
+            level->prev->set_next_leaf(node->get_page_no());
+            buffer_pool_manager_->unpin_page(level->prev->get_page_id(), true);
+            delete level->prev;
+        }
+        size_t offset = level->node_keys.size();
+        level->node_keys.resize(offset + len);
+        char *node_key = level->node_keys.data() + offset;
+        if (prefix && level->is_leaf && first_node) {
+            memcpy(node_key, file_hdr_->key_min_.data(), len);
+        } else if (prefix && level->is_leaf) {
+            ix_separator(level->last_key.data(), first, node_key, file_hdr_);
+        } else {
+            memcpy(node_key, first, len);
+        }
+        level->node_rids.push_back(Rid{node->get_page_no(), -1});
+        level->last_key.assign(first + (size - 1) * len, first + size * len);
+        level->prev = node;
+    }
+    if (last && level->prev != nullptr) {
+        buffer_pool_manager_->unpin_page(level->prev->get_page_id(), true);
+        delete level->prev;
+        level->prev = nullptr;
+    }
+    return pos;
+}
+
+/**
+ * @brief 只有key对应的记录位置为value时才删除该键值对。用于撤销插入：因键值重复而没有写入索引的记录，
+ * 不会删掉键值相同的另一条记录的索引项
+ * @param key 要删除的key值
+ * @param value key应当对应的记录位置
+ * @param transaction 事务指针
+ * @return 是否删除了键值对
+ */
+bool IxIndexHandle::delete_entry(const char *key, const Rid &value, Transaction *transaction) {
+    std::vector<Rid> result;
+    if (!get_value(key, &result, transaction) || !(result.front() == value)) {
+        return false;
+    }
+    return delete_entry(key, transaction);
 }
 
 /**
@@ -395,14 +1372,34 @@ bool IxIndexHandle::delete_entry(const char *key, Transaction *transaction) {
     // 3. 如果删除成功需要调用CoalesceOrRedistribute来进行合并或重分配操作，并根据函数返回结果判断是否有结点需要删除
     // 4. 如果需要并发，并且需要删除叶子结点，则需要在事务的delete_page_set中添加删除结点的对应页面；记得处理并发的上锁
 
-    std::scoped_lock lock{root_latch_};
-    IxNodeHandle *leaf_page = find_leaf_page(key, Operation::DELETE, transaction).first;
-    int num = leaf_page->page_hdr->num_key;
-    bool flag = (leaf_page->remove(key) < num);
+    IxNodeHandle *leaf_page = find_leaf_page_optimistic(key, Operation::DELETE);
+    if (leaf_page != nullptr) {
+        int num = leaf_page->page_hdr->num_key;
+        bool flag = (leaf_page->remove(key) < num);
+        leaf_page->page->wunlatch();
+        buffer_pool_manager_->unpin_page(leaf_page->get_page_id(), flag);
+        delete leaf_page;
+        return flag;
+    }
+
+    // 叶子结点可能下溢或需要更新父结点中的key，重新查找并锁住可能被修改的祖先结点
+    Transaction local_txn(INVALID_TXN_ID);
+    if (transaction == nullptr) {
+        transaction = &local_txn;
+    }
+    auto [leaf, root_is_latched] = find_leaf_page(key, Operation::DELETE, transaction);
+    int num = leaf->page_hdr->num_key;
+    // IX_FORMAT_PREFIX下父结点中的key是子树的下界，删除第一个key不需要更新
+    bool erase_first = num > 0 && file_hdr_->format_version_ != IX_FORMAT_PREFIX && leaf->compare_key(key, 0) == 0;
+    bool flag = (leaf->remove(key) < num);
     if (flag) {
-        coalesce_or_redistribute(leaf_page);
+        if (erase_first) {
+            maintain_parent(leaf);
+        }
+        coalesce_or_redistribute(leaf, transaction, &root_is_latched);
     }
-    buffer_pool_manager_->unpin_page(leaf_page->get_page_id(), flag);
+    release_latch_page_set(transaction, &root_is_latched, flag);
+    delete leaf;
     return flag;
 }
 
@@ -428,34 +1425,38 @@ bool IxIndexHandle::coalesce_or_redistribute(IxNodeHandle *node, Transaction *tr
     // NodeMinSize*2)，则只需要重新分配键值对（调用Redistribute函数）
     // 5. 如果不满足上述条件，则需要合并两个结点，将右边的结点合并到左边的结点（调用Coalesce函数）
 
-    if (node->get_page_no() == file_hdr_->root_page_)
-        return adjust_root(node);
-    else if (node->get_size() >= node->get_min_size()) {
-        maintain_parent(node);
+    // 未下溢的结点不需要处理（此时即使是根结点也不需要调整）。
+    // 下溢的结点要么是根结点，要么在查找时被判断为不安全，它的父结点一定还在index_latch_page_set中
+    if (node->get_size() >= node->get_min_size()) {
         return false;
+    }
+    if (node->is_root_page()) {
+        return adjust_root(node);
+    }
+    IxNodeHandle *parent = fetch_node(node->get_parent_page_no());
+    int index = parent->find_child(node);
+    IxNodeHandle *neighbor;
+    if (index > 0) {
+        neighbor = fetch_node(parent->get_rid(index - 1)->page_no);
     } else {
-        IxNodeHandle *parent = fetch_node(node->get_parent_page_no());
-        int index = parent->find_child(node);
-        IxNodeHandle *neighbor;
-        if (index > 0) {
-            neighbor = fetch_node(parent->get_rid(index - 1)->page_no);
-        } else {
-            neighbor = fetch_node(parent->get_rid(index + 1)->page_no);
-        }
-        if (node->get_size() + neighbor->get_size() >= node->get_min_size() * 2) {
-            redistribute(neighbor, node, parent, index);
-            buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
-            buffer_pool_manager_->unpin_page(neighbor->get_page_id(), true);
-            return false;
-        } else {
-            IxNodeHandle *neighbor_node = neighbor;
-            IxNodeHandle *parent_node = parent;
-            coalesce(&neighbor_node, &node, &parent_node, index, transaction, root_is_latched);
-            buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
-            buffer_pool_manager_->unpin_page(neighbor->get_page_id(), true);
-            return true;
-        }
+        neighbor = fetch_node(parent->get_rid(index + 1)->page_no);
+    }
+    // 兄弟结点与node同属于已锁住的parent，其他线程只可能在经过parent之后还持有它，这里加锁直到操作结束
+    latch_page(neighbor, transaction);
+    bool deleted;
+    if (node->get_size() + neighbor->get_size() >= node->get_min_size() * 2) {
+        redistribute(neighbor, node, parent, index, transaction);
+        deleted = false;
+    } else {
+        IxNodeHandle *neighbor_node = neighbor;
+        IxNodeHandle *parent_node = parent;
+        coalesce(&neighbor_node, &node, &parent_node, index, transaction, root_is_latched);
+        deleted = true;
     }
+    buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
+    delete parent;
+    delete neighbor;
+    return deleted;
 }
 
 /**
@@ -471,15 +1472,18 @@ bool IxIndexHandle::adjust_root(IxNodeHandle *old_root_node) {
     // 3. 除了上述两种情况，不需要进行操作
 
     if (!old_root_node->is_leaf_page() && old_root_node->page_hdr->num_key == 1) {
+        // child的parent字段由持有old_root_node写锁的线程维护，不需要对child加锁
         IxNodeHandle *child = fetch_node(old_root_node->get_rid(0)->page_no);
         release_node_handle(*old_root_node);
-        file_hdr_->root_page_ = child->get_page_no();
+        old_root_node->page_hdr->next_free_page_no = IX_DELETED_NODE;
+        update_root_page_no(child->get_page_no());
         child->set_parent_page_no(IX_NO_PAGE);
         buffer_pool_manager_->unpin_page(child->get_page_id(), true);
+        delete child;
         return true;
     } else if (old_root_node->is_leaf_page() && !old_root_node->page_hdr->num_key) {
         release_node_handle(*old_root_node);
-        file_hdr_->root_page_ = IX_INIT_ROOT_PAGE;
+        update_root_page_no(IX_INIT_ROOT_PAGE);
         return true;
     } else
         return false;
@@ -499,25 +1503,39 @@ bool IxIndexHandle::adjust_root(IxNodeHandle *old_root_node) {
  * index>0，则neighbor是node前驱结点，表示：neighbor(left)  node(right)
  * 注意更新parent结点的相关kv对
  */
-void IxIndexHandle::redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index) {
+void IxIndexHandle::redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                                 Transaction *transaction) {
     // Todo:
     // 1. 通过index判断neighbor_node是否为node的前驱结点
     // 2. 从neighbor_node中移动一个键值对到node结点中
     // 3. 更新父节点中的相关信息，并且修改移动键值对对应孩字结点的父结点信息（maintain_child函数）
     // 注意：neighbor_node的位置不同，需要移动的键值对不同，需要分类讨论
 
-    if (index == 0) {
-        node->insert_pair(node->get_size(), neighbor_node->get_key(0), *(neighbor_node->get_rid(0)));
-        neighbor_node->erase_pair(0);
-        maintain_child(node, node->get_size());
-        maintain_parent(neighbor_node);
-    } else {
-        node->insert_pair(0, neighbor_node->get_key(neighbor_node->get_size() - 1),
-                          *(neighbor_node->get_rid(neighbor_node->get_size() - 1)));
-        neighbor_node->erase_pair(neighbor_node->get_size() - 1);
-        maintain_child(node, 0);
-        maintain_parent(node);
+    int len = file_hdr_->col_tot_len_;
+    std::vector<char> moved(len), separator(len);
+    int from = index == 0 ? 0 : neighbor_node->get_size() - 1;
+    Rid rid = *neighbor_node->get_rid(from);
+    neighbor_node->copy_key(from, moved.data());
+    neighbor_node->erase_pair(from);
+    // node下溢后少于min_size个键值对，移入一个后按任何方式编码都放得下
+    bool inserted = node->insert_pair(index == 0 ? node->get_size() : 0, moved.data(), rid);
+    assert(inserted);
+    (void)inserted;
+    maintain_child(node, index == 0 ? node->get_size() - 1 : 0);
+    if (file_hdr_->format_version_ != IX_FORMAT_PREFIX) {
+        maintain_parent(index == 0 ? neighbor_node : node);
+        return;
     }
+    // 右边结点的第一个key作为新的分隔键，叶子结点截短为与左边结点的最后一个key之间的分隔键
+    IxNodeHandle *left = index == 0 ? node : neighbor_node;
+    IxNodeHandle *right = index == 0 ? neighbor_node : node;
+    right->copy_key(0, separator.data());
+    if (right->is_leaf_page()) {
+        std::vector<char> last(len), first = separator;
+        left->copy_key(left->get_size() - 1, last.data());
+        ix_separator(last.data(), first.data(), separator.data(), file_hdr_);
+    }
+    update_separator(parent, index == 0 ? 1 : index, separator.data(), transaction);
 }
 
 /**
@@ -546,20 +1564,33 @@ bool IxIndexHandle::coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
         std::swap(node, neighbor_node);
         index += 1;
     }
-    if ((*node)->is_leaf_page() && (*node)->get_page_no() == file_hdr_->last_leaf_) {
-        file_hdr_->last_leaf_ = (*neighbor_node)->get_page_no();
+    if ((*node)->is_leaf_page()) {
+        std::scoped_lock lock{file_hdr_latch_};
+        if ((*node)->get_page_no() == file_hdr_->last_leaf_) {
+            file_hdr_->last_leaf_ = (*neighbor_node)->get_page_no();
+        }
     }
-    (*neighbor_node)
-        ->insert_pairs((*neighbor_node)->get_size(), (*node)->get_key(0), (*node)->get_rid(0), (*node)->get_size());
+    int pos = (*neighbor_node)->get_size();
+    int len = file_hdr_->col_tot_len_;
+    std::vector<char> keys((*node)->get_size() * len);
+    std::vector<Rid> rids((*node)->get_size());
+    (*node)->copy_pairs(0, (*node)->get_size(), keys.data(), rids.data());
+    // 合并后的键值对数量小于btree_order + 1，按任何方式编码都放得下
+    bool merged = (*neighbor_node)->insert_pairs(pos, keys.data(), rids.data(), (*node)->get_size());
+    assert(merged);
+    (void)merged;
     for (int i = 0; i < (*node)->get_size(); i++) {
-        maintain_child(*neighbor_node, i + (*neighbor_node)->get_size());
+        maintain_child(*neighbor_node, pos + i);
     }
     if ((*node)->is_leaf_page()) {
         erase_leaf(*node);
+    } else {
+        (*neighbor_node)->set_next_leaf((*node)->get_next_leaf());
     }
     release_node_handle(**node);
+    (*node)->page_hdr->next_free_page_no = IX_DELETED_NODE;
     (*parent)->erase_pair(index);
-    return coalesce_or_redistribute(*parent, transaction);
+    return coalesce_or_redistribute(*parent, transaction, root_is_latched);
 }
 
 /**
@@ -573,11 +1604,16 @@ bool IxIndexHandle::coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
  */
 Rid IxIndexHandle::get_rid(const Iid &iid) const {
     IxNodeHandle *node = fetch_node(iid.page_no);
-    if (iid.slot_no >= node->get_size()) {
+    node->page->rlatch();
+    bool valid = iid.slot_no < node->get_size();
+    Rid rid = valid ? *node->get_rid(iid.slot_no) : Rid{};
+    node->page->runlatch();
+    buffer_pool_manager_->unpin_page(node->get_page_id(), false);  // unpin it!
+    delete node;
+    if (!valid) {
         throw IndexEntryNotFoundError();
     }
-    buffer_pool_manager_->unpin_page(node->get_page_id(), false);  // unpin it!
-    return *node->get_rid(iid.slot_no);
+    return rid;
 }
 
 /**
@@ -589,16 +1625,19 @@ Rid IxIndexHandle::get_rid(const Iid &iid) const {
  * 可用*(int *)key转换回去
  */
 Iid IxIndexHandle::lower_bound(const char *key) {
-    std::scoped_lock lock{root_latch_};
+    if (file_hdr_->latch_mode_ == IX_LATCH_OPTIMISTIC) {
+        return leaf_bound_olc(key, false);
+    }
     IxNodeHandle *node = find_leaf_page(key, Operation::FIND, nullptr, true).first;
     int key_idx = node->lower_bound(key);
-    Iid iid;
-    if (key_idx == node->get_size()) {
-        iid = leaf_end();
-    } else {
-        iid = {.page_no = node->get_page_no(), .slot_no = key_idx};
+    Iid iid = {.page_no = node->get_page_no(), .slot_no = key_idx};
+    if (key_idx == node->get_size() && node->get_next_leaf() != IX_LEAF_HEADER_PAGE) {
+        // key位于两个叶子之间时，结果是下一个叶子的第一个位置；最后一个叶子的末尾即leaf_end()
+        iid = {.page_no = node->get_next_leaf(), .slot_no = 0};
     }
+    node->page->runlatch();
     buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
     return iid;
 }
 
@@ -609,19 +1648,43 @@ Iid IxIndexHandle::lower_bound(const char *key) {
  * @return Iid
  */
 Iid IxIndexHandle::upper_bound(const char *key) {
-    std::scoped_lock lock{root_latch_};
+    if (file_hdr_->latch_mode_ == IX_LATCH_OPTIMISTIC) {
+        return leaf_bound_olc(key, true);
+    }
     IxNodeHandle *node = find_leaf_page(key, Operation::FIND, nullptr, true).first;
     int key_idx = node->upper_bound(key);
-    Iid iid;
-    if (key_idx == node->get_size()) {
-        iid = leaf_end();
-    } else {
-        iid = {.page_no = node->get_page_no(), .slot_no = key_idx};
+    Iid iid = {.page_no = node->get_page_no(), .slot_no = key_idx};
+    if (key_idx == node->get_size() && node->get_next_leaf() != IX_LEAF_HEADER_PAGE) {
+        // key位于两个叶子之间时，结果是下一个叶子的第一个位置；最后一个叶子的末尾即leaf_end()
+        iid = {.page_no = node->get_next_leaf(), .slot_no = 0};
     }
+    node->page->runlatch();
     buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
     return iid;
 }
 
+/**
+ * @brief IX_LATCH_OPTIMISTIC下的lower_bound和upper_bound：不加锁读叶子结点，校验失败时重新查找
+ * @param upper 为true时查找第一个大于key的位置，否则查找第一个大于等于key的位置
+ */
+Iid IxIndexHandle::leaf_bound_olc(const char *key, bool upper) {
+    while (true) {
+        uint64_t version;
+        IxNodeHandle leaf = find_leaf_page_olc(key, &version);
+        int key_idx = upper ? leaf.upper_bound(key) : leaf.lower_bound(key);
+        Iid iid = {.page_no = leaf.get_page_no(), .slot_no = key_idx};
+        if (key_idx == leaf.get_size() && leaf.get_next_leaf() != IX_LEAF_HEADER_PAGE) {
+            iid = {.page_no = leaf.get_next_leaf(), .slot_no = 0};
+        }
+        bool valid = leaf.page->validate(version);
+        buffer_pool_manager_->unpin_page(leaf.get_page_id(), false);
+        if (valid) {
+            return iid;
+        }
+    }
+}
+
 /**
  * @brief 指向最后一个叶子的最后一个结点的后一个
  * 用处在于可以作为IxScan的最后一个
@@ -629,9 +1692,17 @@ Iid IxIndexHandle::upper_bound(const char *key) {
  * @return Iid
  */
 Iid IxIndexHandle::leaf_end() const {
-    IxNodeHandle *node = fetch_node(file_hdr_->last_leaf_);
-    Iid iid = {.page_no = file_hdr_->last_leaf_, .slot_no = node->get_size()};
+    page_id_t last_leaf;
+    {
+        std::scoped_lock lock{file_hdr_latch_};
+        last_leaf = file_hdr_->last_leaf_;
+    }
+    IxNodeHandle *node = fetch_node(last_leaf);
+    node->page->rlatch();
+    Iid iid = {.page_no = last_leaf, .slot_no = node->get_size()};
+    node->page->runlatch();
     buffer_pool_manager_->unpin_page(node->get_page_id(), false);  // unpin it!
+    delete node;
     return iid;
 }
 
@@ -642,6 +1713,7 @@ Iid IxIndexHandle::leaf_end() const {
  * @return Iid
  */
 Iid IxIndexHandle::leaf_begin() const {
+    std::scoped_lock lock{file_hdr_latch_};
     Iid iid = {.page_no = file_hdr_->first_leaf_, .slot_no = 0};
     return iid;
 }
@@ -672,7 +1744,10 @@ IxNodeHandle *IxIndexHandle::fetch_node(int page_no) const {
  */
 IxNodeHandle *IxIndexHandle::create_node() {
     IxNodeHandle *node;
-    file_hdr_->num_pages_++;
+    {
+        std::scoped_lock lock{file_hdr_latch_};
+        file_hdr_->num_pages_++;
+    }
 
     PageId new_page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
     // 从3开始分配page_no，第一次分配之后，new_page_id.page_no=3，file_hdr_.num_pages=4
@@ -685,6 +1760,8 @@ IxNodeHandle *IxIndexHandle::create_node() {
  * @brief 从node开始更新其父节点的第一个key，一直向上更新直到根节点
  *
  * @param node
+ * @note 只有node是父结点的第一个孩子时，父结点的第一个key才会随之改变，需要继续向上更新。
+ * 第一个key改变的结点在查找时都被判断为不安全，因此这里访问的父结点都还在index_latch_page_set中
  */
 void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
     IxNodeHandle *curr = node;
@@ -694,14 +1771,21 @@ void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
         int rank = parent->find_child(curr);
         char *parent_key = parent->get_key(rank);
         char *child_first_key = curr->get_key(0);
-        if (memcmp(parent_key, child_first_key, file_hdr_->col_tot_len_) == 0) {
-            assert(buffer_pool_manager_->unpin_page(parent->get_page_id(), true));
-            break;
+        bool changed = memcmp(parent_key, child_first_key, file_hdr_->col_tot_len_) != 0;
+        if (changed) {
+            memcpy(parent_key, child_first_key, file_hdr_->col_tot_len_);  // 修改了parent node
+        }
+        buffer_pool_manager_->unpin_page(parent->get_page_id(), changed);
+        if (curr != node) {
+            delete curr;
         }
-        memcpy(parent_key, child_first_key, file_hdr_->col_tot_len_);  // 修改了parent node
         curr = parent;
-
-        assert(buffer_pool_manager_->unpin_page(parent->get_page_id(), true));
+        if (!changed || rank > 0) {
+            break;
+        }
+    }
+    if (curr != node) {
+        delete curr;
     }
 }
 
@@ -713,13 +1797,16 @@ void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
 void IxIndexHandle::erase_leaf(IxNodeHandle *leaf) {
     assert(leaf->is_leaf_page());
 
+    // leaf总是被合并到持有写锁的前驱结点中；next的prev_leaf只由持有其前驱结点（即leaf）写锁的线程读写
     IxNodeHandle *prev = fetch_node(leaf->get_prev_leaf());
     prev->set_next_leaf(leaf->get_next_leaf());
     buffer_pool_manager_->unpin_page(prev->get_page_id(), true);
+    delete prev;
 
     IxNodeHandle *next = fetch_node(leaf->get_next_leaf());
     next->set_prev_leaf(leaf->get_prev_leaf());  // 注意此处是SetPrevLeaf()
     buffer_pool_manager_->unpin_page(next->get_page_id(), true);
+    delete next;
 }
 
 /**
@@ -728,11 +1815,14 @@ void IxIndexHandle::erase_leaf(IxNodeHandle *leaf) {
  * @param node
  */
 void IxIndexHandle::release_node_handle(IxNodeHandle &node) {
+    std::scoped_lock lock{file_hdr_latch_};
     file_hdr_->num_pages_--;
 }
 
 /**
  * @brief 将node的第child_idx个孩子结点的父节点置为node
+ * @note 结点的parent字段只由持有其父结点写锁的线程读写，调用者持有node（以及孩子原来的父结点）的写锁，
+ * 因此不需要对孩子结点加锁，也避免了与持有孩子结点、向下查找的线程死锁
  */
 void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx) {
     if (!node->is_leaf_page()) {
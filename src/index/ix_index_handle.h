@@ -10,13 +10,16 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <shared_mutex>
+
 #include "ix_defs.h"
 #include "transaction/transaction.h"
 
 enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、插入、删除
 
-static const bool binary_search = false;
-
 inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
     switch (type) {
         case TYPE_INT: {
@@ -46,6 +49,112 @@ inline int ix_compare(const char* a, const char* b, const std::vector<ColType>&
     return 0;
 }
 
+/**
+ * @brief 按索引键的形式特化的比较：返回key是否排在target之前（upper为true时为不排在target之后）。
+ * 单个INT、FLOAT字段直接比较数值，单个字符串字段直接memcmp，不需要每次比较都判断字段类型；复合键逐个字段比较
+ */
+template <IxKeyKind kind, bool upper>
+inline bool ix_key_before(const char *key, const char *target, const IxFileHdr *file_hdr) {
+    if constexpr (kind == IX_KEY_INT) {
+        int k = *reinterpret_cast<const int *>(key);
+        int t = *reinterpret_cast<const int *>(target);
+        return upper ? k <= t : k < t;
+    } else if constexpr (kind == IX_KEY_FLOAT) {
+        float k = *reinterpret_cast<const float *>(key);
+        float t = *reinterpret_cast<const float *>(target);
+        return upper ? k <= t : k < t;
+    } else if constexpr (kind == IX_KEY_STRING) {
+        int cmp = memcmp(key, target, file_hdr->col_tot_len_);
+        return upper ? cmp <= 0 : cmp < 0;
+    } else {
+        int cmp = ix_compare(key, target, file_hdr->col_types_, file_hdr->col_lens_);
+        return upper ? cmp <= 0 : cmp < 0;
+    }
+}
+
+/**
+ * @brief 在结点的n个有序key中查找第一个不排在target之前的位置（upper为false时是第一个>=target的位置，
+ * 为true时是第一个>target的位置），都排在target之前时返回n
+ * @note 无分支的二分查找：每轮把范围减半，比较结果只决定范围的起点是否后移，编译为条件传送而不是条件跳转，
+ * 不会因为分支预测失败而停顿；INT和FLOAT键的长度在编译时确定
+ */
+template <IxKeyKind kind, bool upper>
+inline int ix_node_search(const char *keys, int n, const char *target, const IxFileHdr *file_hdr) {
+    if (n <= 0) {
+        return 0;
+    }
+    const size_t key_len = (kind == IX_KEY_INT || kind == IX_KEY_FLOAT) ? sizeof(int) : file_hdr->col_tot_len_;
+    int base = 0;
+    while (n > 1) {
+        int half = n >> 1;
+        base = ix_key_before<kind, upper>(keys + (base + half) * key_len, target, file_hdr) ? base + half : base;
+        n -= half;
+    }
+    return base + ix_key_before<kind, upper>(keys + base * key_len, target, file_hdr);
+}
+
+/**
+ * @brief a和b的前max_len个字节中公共前缀的长度
+ */
+inline int ix_common_prefix(const char *a, const char *b, int max_len) {
+    int len = 0;
+    while (len < max_len && a[len] == b[len]) {
+        len++;
+    }
+    return len;
+}
+
+/**
+ * @brief key去掉末尾与file_hdr->key_min_相同的部分之后的长度
+ */
+inline int ix_key_trim_len(const char *key, const IxFileHdr *file_hdr) {
+    int len = file_hdr->col_tot_len_;
+    const char *key_min = file_hdr->key_min_.data();
+    while (len > 0 && key[len - 1] == key_min[len - 1]) {
+        len--;
+    }
+    return len;
+}
+
+/**
+ * @brief 生成left和right之间的截短的分隔键sep，满足left < sep <= right：保留到第一个不同的字段，
+ * 它是字符串字段时只保留到第一个不同的字节，之后的部分取各字段的最小值，存储时被省略
+ */
+inline void ix_separator(const char *left, const char *right, char *sep, const IxFileHdr *file_hdr) {
+    int offset = 0;
+    for (int i = 0; i < file_hdr->col_num_; offset += file_hdr->col_lens_[i], i++) {
+        int col_len = file_hdr->col_lens_[i];
+        if (ix_compare(left + offset, right + offset, file_hdr->col_types_[i], col_len) != 0) {
+            if (file_hdr->col_types_[i] == TYPE_STRING) {
+                col_len = ix_common_prefix(left + offset, right + offset, col_len) + 1;
+            }
+            offset += col_len;
+            break;
+        }
+    }
+    memcpy(sep, right, offset);
+    memcpy(sep + offset, file_hdr->key_min_.data() + offset, file_hdr->col_tot_len_ - offset);
+}
+
+/**
+ * @brief IX_FORMAT_PREFIX的结点中，公共前缀长prefix_len、每个key存储key_len个字节时能存放的键值对数量
+ * @note 与IX_FORMAT_FIXED的btree_order + 1相对应，结点中的键值对数量总是小于它
+ */
+inline int ix_node_capacity(int prefix_len, int key_len) {
+    return static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr) - sizeof(IxPrefixHdr) - prefix_len) /
+                            (key_len + sizeof(Rid)));
+}
+
+/* 结点中各部分的位置：IX_FORMAT_FIXED下是固定的，IX_FORMAT_PREFIX下由结点的IxPrefixHdr决定 */
+struct IxNodeLayout {
+    int prefix_len;     // 公共前缀的长度
+    int key_len;        // 每个key存储的长度
+    int capacity;       // 能存放的键值对数量，即get_max_size()
+    char *prefix;       // 公共前缀
+    char *keys;         // 第0个key存储的位置
+    Rid *rids;          // 第0个rid的位置
+};
+
 /* 管理B+树中的每个节点 */
 class IxNodeHandle {
     friend class IxIndexHandle;
@@ -55,25 +164,44 @@ class IxNodeHandle {
     const IxFileHdr *file_hdr;      // 节点所在文件的头部信息
     Page *page;                     // 存储节点的页面
     IxPageHdr *page_hdr;            // page->data的第一部分，指针指向首地址，长度为sizeof(IxPageHdr)
-    char *keys;                     // page->data的第二部分，指针指向首地址，长度为file_hdr->keys_size，每个key的长度为file_hdr->col_len
-    Rid *rids;                      // page->data的第三部分，指针指向首地址
 
    public:
     IxNodeHandle() = default;
 
     IxNodeHandle(const IxFileHdr *file_hdr_, Page *page_) : file_hdr(file_hdr_), page(page_) {
         page_hdr = reinterpret_cast<IxPageHdr *>(page->get_data());
-        keys = page->get_data() + sizeof(IxPageHdr);
-        rids = reinterpret_cast<Rid *>(keys + file_hdr->keys_size_);
+    }
+
+    /**
+     * @brief 结点中key和rid的位置。IX_FORMAT_FIXED下依次是IxPageHdr、keys_size_字节的keys和rids；
+     * IX_FORMAT_PREFIX下依次是IxPageHdr、IxPrefixHdr、公共前缀和每个key存储的部分，rids放在页面末尾
+     * @note 乐观查找可能读到正在被修改的结点，这里把长度限制在合法范围内，保证不会越过页面，读到的内容由版本号校验
+     */
+    IxNodeLayout layout() const {
+        char *data = page->get_data();
+        if (file_hdr->format_version_ != IX_FORMAT_PREFIX) {
+            char *keys = data + sizeof(IxPageHdr);
+            return {0, file_hdr->col_tot_len_, file_hdr->btree_order_ + 1, keys, keys,
+                    reinterpret_cast<Rid *>(keys + file_hdr->keys_size_)};
+        }
+        auto prefix_hdr = reinterpret_cast<const IxPrefixHdr *>(data + sizeof(IxPageHdr));
+        int prefix_len = std::clamp<int>(prefix_hdr->prefix_len, 0, file_hdr->prefix_max_len_);
+        int key_len = std::clamp<int>(prefix_hdr->key_len, 0, file_hdr->col_tot_len_ - prefix_len);
+        int capacity = ix_node_capacity(prefix_len, key_len);
+        char *prefix = data + sizeof(IxPageHdr) + sizeof(IxPrefixHdr);
+        return {prefix_len, key_len, capacity, prefix, prefix + prefix_len,
+                reinterpret_cast<Rid *>(data + PAGE_SIZE) - capacity};
     }
 
     int get_size() { return page_hdr->num_key; }
 
     void set_size(int size) { page_hdr->num_key = size; }
 
-    int get_max_size() { return file_hdr->btree_order_ + 1; }
+    /* 结点中的键值对数量达到max_size之前就要分裂；IX_FORMAT_PREFIX下随结点中key的压缩情况变化 */
+    int get_max_size() { return layout().capacity; }
 
-    int get_min_size() { return get_max_size() / 2; }
+    /* 不压缩时最多能存放的键值对数量的一半 */
+    int get_min_size() { return (file_hdr->btree_order_ + 1) / 2; }
 
     int key_at(int i) { return *(int *)get_key(i); }
 
@@ -94,25 +222,69 @@ class IxNodeHandle {
 
     bool is_root_page() { return get_parent_page_no() == INVALID_PAGE_ID; }
 
+    bool is_deleted() { return page_hdr->next_free_page_no == IX_DELETED_NODE; }
+
+    /* 同一层右兄弟的page_no（B-link的右链接），没有右兄弟时返回IX_NO_PAGE */
+    page_id_t get_right_link() {
+        if (is_leaf_page() && page_hdr->next_leaf == IX_LEAF_HEADER_PAGE) {
+            return IX_NO_PAGE;
+        }
+        return page_hdr->next_leaf;
+    }
+
     void set_next_leaf(page_id_t page_no) { page_hdr->next_leaf = page_no; }
 
     void set_prev_leaf(page_id_t page_no) { page_hdr->prev_leaf = page_no; }
 
     void set_parent_page_no(page_id_t parent) { page_hdr->parent = parent; }
 
-    char *get_key(int key_idx) const { return keys + key_idx * file_hdr->col_tot_len_; }
+    /* 第key_idx个key存储的位置：IX_FORMAT_FIXED下即完整的key，IX_FORMAT_PREFIX下不含公共前缀和省略的末尾 */
+    char *get_key(int key_idx) const {
+        IxNodeLayout node_layout = layout();
+        return node_layout.keys + key_idx * node_layout.key_len;
+    }
+
+    Rid *get_rid(int rid_idx) const { return &layout().rids[rid_idx]; }
+
+    void set_rid(int rid_idx, const Rid &rid) { layout().rids[rid_idx] = rid; }
+
+    void copy_key(int key_idx, char *dest) const;
 
-    Rid *get_rid(int rid_idx) const { return &rids[rid_idx]; }
+    void copy_pairs(int pos, int n, char *keys, Rid *rids) const;
 
-    void set_key(int key_idx, const char *key) { memcpy(keys + key_idx * file_hdr->col_tot_len_, key, file_hdr->col_tot_len_); }
+    int compare_key(const char *key, int key_idx) const;
 
-    void set_rid(int rid_idx, const Rid &rid) { rids[rid_idx] = rid; }
+    bool set_key(int key_idx, const char *key);
 
     int lower_bound(const char *target) const;
 
     int upper_bound(const char *target) const;
 
-    void insert_pairs(int pos, const char *key, const Rid *rid, int n);
+    /* 按file_hdr->key_kind_选择特化的ix_node_search()，IX_FORMAT_PREFIX的结点先比较公共前缀 */
+    template <bool upper>
+    int search(const char *target) const {
+        if (file_hdr->format_version_ == IX_FORMAT_PREFIX) {
+            return search_prefix(target, upper);
+        }
+        char *keys = layout().keys;
+        int n = page_hdr->num_key;
+        switch (file_hdr->key_kind_) {
+            case IX_KEY_INT:
+                return ix_node_search<IX_KEY_INT, upper>(keys, n, target, file_hdr);
+            case IX_KEY_FLOAT:
+                return ix_node_search<IX_KEY_FLOAT, upper>(keys, n, target, file_hdr);
+            case IX_KEY_STRING:
+                return ix_node_search<IX_KEY_STRING, upper>(keys, n, target, file_hdr);
+            default:
+                return ix_node_search<IX_KEY_COMPOSITE, upper>(keys, n, target, file_hdr);
+        }
+    }
+
+    bool insert_pairs(int pos, const char *key, const Rid *rid, int n);
+
+    bool can_insert(const char *key) const;
+
+    void assign(const char *keys, const Rid *rids, int n);
 
     page_id_t internal_lookup(const char *key);
 
@@ -121,7 +293,7 @@ class IxNodeHandle {
     int insert(const char *key, const Rid &value);
 
     // 用于在结点中的指定位置插入单个键值对
-    void insert_pair(int pos, const char *key, const Rid &rid) { insert_pairs(pos, key, &rid, 1); }
+    bool insert_pair(int pos, const char *key, const Rid &rid) { return insert_pairs(pos, key, &rid, 1); }
 
     void erase_pair(int pos);
 
@@ -146,15 +318,42 @@ class IxNodeHandle {
      * @return int
      */
     int find_child(IxNodeHandle *child) {
+        Rid *rids = layout().rids;
         int rid_idx;
         for (rid_idx = 0; rid_idx < page_hdr->num_key; rid_idx++) {
-            if (get_rid(rid_idx)->page_no == child->get_page_no()) {
+            if (rids[rid_idx].page_no == child->get_page_no()) {
                 break;
             }
         }
         assert(rid_idx < page_hdr->num_key);
         return rid_idx;
     }
+
+   private:
+    // for IX_FORMAT_PREFIX
+    int search_prefix(const char *target, bool upper) const;
+
+    int compare_stored(const char *stored, const IxNodeLayout &node_layout, const char *target) const;
+
+    void merged_layout(const char *keys, int n, int *prefix_len, int *key_len) const;
+
+    void encode(const char *keys, const Rid *rids, int n, int prefix_len, int key_len);
+};
+
+class IxSorter;
+
+/* 批量构建时正在构建的一层 */
+struct IxBuildLevel {
+    bool is_leaf;
+    IxNodeHandle *prev = nullptr;       // 这一层最后创建的结点，创建下一个结点时链接到它的右边
+    std::vector<char> last_key;         // prev中最后一个key，用于计算下一个叶子结点的截短的分隔键
+    std::vector<char> node_keys;        // 每个结点在上一层中的key
+    std::vector<Rid> node_rids;         // 每个结点的页面号，作为上一层的rid
+};
+
+/* 乐观查找开始时登记的epoch，0表示空闲。每个槽独占一个cache line，不同线程的登记互不干扰 */
+struct alignas(64) IxOlcReaderSlot {
+    std::atomic<uint64_t> epoch{0};
 };
 
 /* B+树 */
@@ -167,11 +366,23 @@ class IxIndexHandle {
     BufferPoolManager *buffer_pool_manager_;
     int fd_;                                    // 存储B+树的文件
     IxFileHdr* file_hdr_;                       // 存了root_page，但其初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
-    std::mutex root_latch_;
+    std::shared_mutex root_latch_;              // 保护file_hdr_->root_page_：查找时持有读锁直到锁住根结点，可能改变根结点的写操作持有写锁
+    mutable std::mutex file_hdr_latch_;         // 保护file_hdr_中的num_pages_、first_leaf_和last_leaf_
+    std::atomic<Page *> olc_root_{nullptr};     // 乐观查找的起点，即根结点所在的页面，只在IX_LATCH_OPTIMISTIC下使用。一直被pin住，乐观查找读根结点时不需要pin
+    std::vector<std::pair<Page *, uint64_t>> olc_retired_roots_;   // 被替换的根结点页面及替换时的epoch，仍可能被乐观查找读到，保持pin住；受root_latch_保护
+    std::atomic<size_t> olc_num_retired_{0};    // olc_retired_roots_中的页面数，乐观查找结束时据此决定是否尝试unpin
+    std::atomic<uint64_t> olc_epoch_{1};        // 每替换一次根结点加一
+    IxOlcReaderSlot olc_readers_[IX_OLC_READER_SLOTS];  // 正在进行的乐观查找开始时的epoch
 
    public:
     IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
+    int GetFd() { return fd_; }
+
+    IxLatchMode get_latch_mode() const { return file_hdr_->latch_mode_; }
+
+    void unpin_root_pages();
+
     // for search
     bool get_value(const char *key, std::vector<Rid> *result, Transaction *transaction);
 
@@ -181,18 +392,28 @@ class IxIndexHandle {
     // for insert
     page_id_t insert_entry(const char *key, const Rid &value, Transaction *transaction);
 
-    IxNodeHandle *split(IxNodeHandle *node);
+    std::vector<IxNodeHandle *> split(IxNodeHandle *node, const std::vector<char> &keys, const std::vector<Rid> &rids,
+                                      std::vector<char> *separators);
 
-    void insert_into_parent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node, Transaction *transaction);
+    void insert_into_parent(IxNodeHandle *old_node, const char *separators, const std::vector<IxNodeHandle *> &new_nodes,
+                            Transaction *transaction);
+
+    // for bulk load
+    bool bulk_load(const char *keys, const Rid *rids, int num_keys, double fill_factor = IX_BULK_FILL_FACTOR);
+
+    bool bulk_load(IxSorter *sorter, double fill_factor = IX_BULK_FILL_FACTOR);
 
     // for delete
     bool delete_entry(const char *key, Transaction *transaction);
 
+    bool delete_entry(const char *key, const Rid &value, Transaction *transaction);
+
     bool coalesce_or_redistribute(IxNodeHandle *node, Transaction *transaction = nullptr,
                                 bool *root_is_latched = nullptr);
     bool adjust_root(IxNodeHandle *old_root_node);
 
-    void redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
+    void redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                      Transaction *transaction = nullptr);
 
     bool coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
                   Transaction *transaction, bool *root_is_latched);
@@ -207,7 +428,27 @@ class IxIndexHandle {
 
    private:
     // 辅助函数
-    void update_root_page_no(page_id_t root) { file_hdr_->root_page_ = root; }
+    void update_root_page_no(page_id_t root);
+
+    // for latch crabbing
+    IxNodeHandle *find_leaf_page_optimistic(const char *key, Operation operation);
+
+    bool is_safe(IxNodeHandle *node, const char *key, Operation operation, bool is_root);
+
+    void latch_page(IxNodeHandle *node, Transaction *transaction);
+
+    void release_latch_page_set(Transaction *transaction, bool *root_is_latched, bool is_dirty);
+
+    // for optimistic lock coupling
+    IxNodeHandle find_leaf_page_olc(const char *key, uint64_t *version);
+
+    int olc_enter();
+
+    void olc_exit(int slot);
+
+    void reclaim_retired_roots();
+
+    Iid leaf_bound_olc(const char *key, bool upper);
 
     bool is_empty() const { return file_hdr_->root_page_ == IX_NO_PAGE; }
 
@@ -216,6 +457,19 @@ class IxIndexHandle {
 
     IxNodeHandle *create_node();
 
+    // for split
+    std::vector<int> split_points(const char *keys, int n) const;
+
+    bool fits(const char *keys, int begin, int end) const;
+
+    void collect_pairs(IxNodeHandle *node, int pos, const char *key, const Rid *rid, int n, bool replace,
+                       std::vector<char> *keys, std::vector<Rid> *rids) const;
+
+    void split_into_parent(IxNodeHandle *node, const std::vector<char> &keys, const std::vector<Rid> &rids,
+                           Transaction *transaction);
+
+    void update_separator(IxNodeHandle *parent, int rank, const char *separator, Transaction *transaction);
+
     // for maintain data structure
     void maintain_parent(IxNodeHandle *node);
 
@@ -227,4 +481,10 @@ class IxIndexHandle {
 
     // for index test
     Rid get_rid(const Iid &iid) const;
+
+    // for bulk load
+    bool bulk_load_batches(const std::function<int(const char **, const Rid **)> &next_batch, double fill_factor);
+
+    int build_nodes(IxBuildLevel *level, const char *keys, const Rid *rids, int num_keys, bool last,
+                    double fill_factor);
 };
\ No newline at end of file
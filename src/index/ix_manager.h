@@ -54,7 +54,8 @@ class IxManager {
         return disk_manager_->is_file(ix_name);
     }
 
-    void create_index(const std::string &filename, const std::vector<ColMeta>& index_cols) {
+    void create_index(const std::string &filename, const std::vector<ColMeta>& index_cols,
+                      IxLatchMode latch_mode = IX_LATCH_CRABBING, IxFormatVersion format_version = IX_FORMAT_PREFIX) {
         std::string ix_name = get_index_name(filename, index_cols);
         // Create index file
         disk_manager_->create_file(ix_name);
@@ -75,7 +76,13 @@ class IxManager {
         }
         // 根据 |page_hdr| + (|attr| + |rid|) * (n + 1) <= PAGE_SIZE 求得n的最大值btree_order
         // 即 n <= btree_order，那么btree_order就是每个结点最多可插入的键值对数量（实际还多留了一个空位，但其不可插入）
-        int btree_order = static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr)) / (col_tot_len + sizeof(Rid)) - 1);
+        // 不以字符串字段开头的索引键没有可以压缩的公共前缀，按定长格式存储
+        if (index_cols.empty() || index_cols[0].type != TYPE_STRING) {
+            format_version = IX_FORMAT_FIXED;
+        }
+        // IX_FORMAT_PREFIX的结点还要存放IxPrefixHdr，btree_order是key不能压缩时的键值对数量
+        int page_hdr_size = sizeof(IxPageHdr) + (format_version == IX_FORMAT_PREFIX ? sizeof(IxPrefixHdr) : 0);
+        int btree_order = static_cast<int>((PAGE_SIZE - page_hdr_size) / (col_tot_len + sizeof(Rid)) - 1);
         assert(btree_order > 2);
 
         // Create file header and write to file
@@ -86,6 +93,8 @@ class IxManager {
             fhdr->col_types_.push_back(index_cols[i].type);
             fhdr->col_lens_.push_back(index_cols[i].len);
         }
+        fhdr->latch_mode_ = latch_mode;
+        fhdr->format_version_ = format_version;
         fhdr->update_tot_len();
         
         char* data = new char[fhdr->tot_len_];
@@ -156,7 +165,8 @@ class IxManager {
         return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
     }
 
-    void close_index(const IxIndexHandle *ih) {
+    void close_index(IxIndexHandle *ih) {
+        ih->unpin_root_pages();
         char* data = new char[ih->file_hdr_->tot_len_];
         ih->file_hdr_->serialize(data);
         disk_manager_->write_page(ih->fd_, IX_FILE_HDR_PAGE, data, ih->file_hdr_->tot_len_);
@@ -11,21 +11,82 @@ See the Mulan PSL v2 for more details. */
 #include "ix_scan.h"
 
 /**
- * @brief
- * @todo 加上读锁（需要使用缓冲池得到page）
+ * @brief 移动到下一个键值对，读取叶子结点时加读锁；每次只锁一个叶子，不会与自上而下加锁的插入和删除死锁
  */
 void IxScan::next() {
     assert(!is_end());
     IxNodeHandle *node = ih_->fetch_node(iid_.page_no);
+    node->page->rlatch();
     assert(node->is_leaf_page());
     assert(iid_.slot_no < node->get_size());
     // increment slot no
     iid_.slot_no++;
-    if (iid_.page_no != ih_->file_hdr_->last_leaf_ && iid_.slot_no == node->get_size()) {
+    // 最后一个叶子的next_leaf指向leaf header，此时停在leaf_end()
+    bool next_leaf = node->get_next_leaf() != IX_LEAF_HEADER_PAGE && iid_.slot_no == node->get_size();
+    if (next_leaf) {
         // go to next leaf
         iid_.slot_no = 0;
         iid_.page_no = node->get_next_leaf();
     }
+    node->page->runlatch();
+    bpm_->unpin_page(node->get_page_id(), false);
+    delete node;
+    if (next_leaf) {
+        read_ahead(iid_.page_no);
+    }
+}
+
+/**
+ * @brief 扫描进入一个新的叶子时调用。叶子链上后续叶子的页号不连续，
+ * 这里借助父结点中排在该叶子之后的孩子指针找到它们，并通过缓冲池异步预读。
+ * 预读不跨越父结点，到达下一个父结点的叶子后继续
+ *
+ * @param leaf_page_no 新叶子的页号
+ */
+void IxScan::read_ahead(page_id_t leaf_page_no) {
+    size_t begin;
+    size_t count = read_ahead_.on_access(++leaf_seq_, &begin);
+    if (count == 0) {
+        return;
+    }
+
+    // parent字段可能被并发的分裂修改，这里只作为预读的依据，读到旧的父结点也不影响正确性
+    IxNodeHandle *leaf = ih_->fetch_node(leaf_page_no);
+    leaf->page->rlatch();
+    page_id_t parent_page_no = leaf->get_parent_page_no();
+    leaf->page->runlatch();
+    bpm_->unpin_page(leaf->get_page_id(), false);
+    delete leaf;
+    if (parent_page_no == INVALID_PAGE_ID) {
+        read_ahead_.truncate(begin);
+        return;
+    }
+
+    IxNodeHandle *parent = ih_->fetch_node(parent_page_no);
+    parent->page->rlatch();
+    int leaf_idx = 0;
+    while (leaf_idx < parent->get_size() && parent->value_at(leaf_idx) != leaf_page_no) {
+        leaf_idx++;
+    }
+    std::vector<page_id_t> page_nos;
+    size_t end = begin;
+    for (; end < begin + count; end++) {
+        size_t child_idx = leaf_idx + (end - leaf_seq_);
+        if (child_idx >= static_cast<size_t>(parent->get_size())) {
+            break;
+        }
+        page_nos.push_back(parent->value_at(child_idx));
+    }
+    parent->page->runlatch();
+    bpm_->unpin_page(parent->get_page_id(), false);
+    delete parent;
+
+    if (end < begin + count) {
+        read_ahead_.truncate(end);
+    }
+    if (!page_nos.empty()) {
+        bpm_->prefetch_pages(ih_->fd_, page_nos);
+    }
 }
 
 Rid IxScan::rid() const { return ih_->get_rid(iid_); }
\ No newline at end of file
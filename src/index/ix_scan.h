@@ -12,17 +12,20 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_defs.h"
 #include "ix_index_handle.h"
+#include "storage/read_ahead.h"
 
 // class IxIndexHandle;
 
 // 用于遍历叶子结点
 // 用于直接遍历叶子结点，而不用findleafpage来得到叶子结点
-// TODO：对page遍历时，要加上读锁
+// 遍历时每次只对当前叶子结点加读锁
 class IxScan : public RecScan {
     const IxIndexHandle *ih_;
     Iid iid_;  // 初始为lower（用于遍历的指针）
     Iid end_;  // 初始为upper
     BufferPoolManager *bpm_;
+    ReadAheadWindow read_ahead_;    // 沿叶子链顺序扫描时预读后续叶子
+    size_t leaf_seq_ = 0;           // 当前叶子是本次扫描访问的第几个叶子
 
    public:
     IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm)
@@ -35,4 +38,7 @@ class IxScan : public RecScan {
     Rid rid() const override;
 
     const Iid &iid() const { return iid_; }
+
+   private:
+    void read_ahead(page_id_t leaf_page_no);
 };
\ No newline at end of file
@@ -0,0 +1,198 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ix_sorter.h"
+
+/**
+ * @param col_types 索引字段的类型
+ * @param col_lens 索引字段的长度
+ * @param memory_limit 内存中的键值对（连同排序用的下标）最多占用的字节数
+ */
+IxSorter::IxSorter(const std::vector<ColType> &col_types, const std::vector<int> &col_lens, size_t memory_limit)
+    : col_types_(col_types), col_lens_(col_lens) {
+    key_len_ = 0;
+    for (int len : col_lens_) {
+        key_len_ += len;
+    }
+    max_buffered_ = std::max<size_t>(1, memory_limit / (key_len_ + sizeof(Rid) + sizeof(int)));
+}
+
+/**
+ * @note 临时文件由tmpfile()创建，关闭后自动删除
+ */
+IxSorter::~IxSorter() {
+    for (auto &run : runs_) {
+        fclose(run.file);
+    }
+}
+
+/**
+ * @description: 加入一个键值对，内存中的键值对达到上限时先写出一个run
+ * @param {char*} key 索引键
+ * @param {Rid&} rid 记录的位置
+ */
+void IxSorter::add(const char *key, const Rid &rid) {
+    if (merging_) {
+        throw InternalError("IxSorter::add: sorter has started output");
+    }
+    if (rids_.size() >= max_buffered_) {
+        spill();
+    }
+    keys_.insert(keys_.end(), key, key + key_len_);
+    rids_.push_back(rid);
+}
+
+/**
+ * @description: 按key升序取出下一批键值对，第一次调用时结束输入
+ * @param {char**} keys 传出参数：连续存放的key，在下一次调用前有效
+ * @param {Rid**} rids 传出参数：与keys一一对应的rid
+ * @return {int} 这一批键值对的数量，为0表示已全部取出
+ */
+int IxSorter::next_batch(const char **keys, const Rid **rids) {
+    if (!merging_) {
+        start_merge();
+    }
+    batch_keys_.clear();
+    batch_rids_.clear();
+    const char *key;
+    Rid rid;
+    while (batch_rids_.size() < IX_SORT_BATCH_SIZE && pop(&key, &rid)) {
+        if (has_last_ && ix_compare(key, last_key_.data(), col_types_, col_lens_) == 0) {
+            continue;
+        }
+        batch_keys_.insert(batch_keys_.end(), key, key + key_len_);
+        batch_rids_.push_back(rid);
+        last_key_.assign(key, key + key_len_);
+        has_last_ = true;
+    }
+    *keys = batch_keys_.data();
+    *rids = batch_rids_.data();
+    return static_cast<int>(batch_rids_.size());
+}
+
+/**
+ * @description: 对内存中的键值对排序，结果放在order_中；key相同时按加入的顺序
+ */
+void IxSorter::sort_buffer() {
+    order_.resize(rids_.size());
+    for (size_t i = 0; i < order_.size(); i++) {
+        order_[i] = static_cast<int>(i);
+    }
+    const char *keys = keys_.data();
+    size_t len = key_len_;
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+        int res = ix_compare(keys + a * len, keys + b * len, col_types_, col_lens_);
+        return res < 0 || (res == 0 && a < b);
+    });
+    order_pos_ = 0;
+}
+
+/**
+ * @description: 把内存中的键值对排序后写入一个新的临时文件，清空内存
+ */
+void IxSorter::spill() {
+    sort_buffer();
+    FILE *file = tmpfile();
+    if (file == nullptr) {
+        throw UnixError();
+    }
+    runs_.push_back(IxSortRun{file, std::vector<char>(key_len_), Rid{}});
+    for (int i : order_) {
+        fwrite(keys_.data() + (size_t)i * key_len_, key_len_, 1, file);
+        fwrite(&rids_[i], sizeof(Rid), 1, file);
+    }
+    if (fflush(file) != 0 || ferror(file)) {
+        throw UnixError();
+    }
+    rewind(file);
+    keys_.clear();
+    rids_.clear();
+    order_.clear();
+}
+
+/**
+ * @description: 结束输入：没有写出过run时直接在内存中排序；否则把剩下的键值对也写成run，用各run的第一个键值对建堆
+ */
+void IxSorter::start_merge() {
+    merging_ = true;
+    if (runs_.empty()) {
+        sort_buffer();
+        return;
+    }
+    if (!rids_.empty()) {
+        spill();
+    }
+    // 归并时只需要每个run的head，释放内存中的缓冲区
+    std::vector<char>().swap(keys_);
+    std::vector<Rid>().swap(rids_);
+    std::vector<int>().swap(order_);
+    pop_key_.resize(key_len_);
+    auto greater = [this](int a, int b) {
+        int res = ix_compare(runs_[a].head_key.data(), runs_[b].head_key.data(), col_types_, col_lens_);
+        return res > 0 || (res == 0 && a > b);
+    };
+    for (int i = 0; i < num_runs(); i++) {
+        if (read_head(&runs_[i])) {
+            heap_.push_back(i);
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), greater);
+}
+
+/**
+ * @description: 读出run中的下一个键值对作为它的head
+ * @return {bool} run中是否还有键值对
+ */
+bool IxSorter::read_head(IxSortRun *run) {
+    if (fread(run->head_key.data(), key_len_, 1, run->file) != 1 ||
+        fread(&run->head_rid, sizeof(Rid), 1, run->file) != 1) {
+        if (ferror(run->file)) {
+            throw UnixError();
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @description: 取出下一个最小的键值对（可能与上一个重复）
+ * @return {bool} 是否还有键值对
+ * @note 归并时key指向的内容在下一次调用时被覆盖
+ */
+bool IxSorter::pop(const char **key, Rid *rid) {
+    if (runs_.empty()) {
+        if (order_pos_ == order_.size()) {
+            return false;
+        }
+        int i = order_[order_pos_++];
+        *key = keys_.data() + (size_t)i * key_len_;
+        *rid = rids_[i];
+        return true;
+    }
+    if (heap_.empty()) {
+        return false;
+    }
+    auto greater = [this](int a, int b) {
+        int res = ix_compare(runs_[a].head_key.data(), runs_[b].head_key.data(), col_types_, col_lens_);
+        return res > 0 || (res == 0 && a > b);
+    };
+    std::pop_heap(heap_.begin(), heap_.end(), greater);
+    IxSortRun &run = runs_[heap_.back()];
+    // 取出的key换到pop_key_中，run的head随后被下一个键值对覆盖
+    pop_key_.swap(run.head_key);
+    *key = pop_key_.data();
+    *rid = run.head_rid;
+    if (read_head(&run)) {
+        std::push_heap(heap_.begin(), heap_.end(), greater);
+    } else {
+        heap_.pop_back();
+    }
+    return true;
+}
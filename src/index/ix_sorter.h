@@ -0,0 +1,73 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "ix_index_handle.h"
+
+/**
+ * @description: 为批量构建索引排序键值对。加入的键值对先放在内存中，超过memory_limit时排序后写入临时文件，
+ * 成为一个有序的run；全部加入后，只有内存中的键值对时直接排序，否则对所有run做多路归并。
+ * key相同的键值对只输出最先加入的一个，与按加入顺序逐条insert_entry的结果相同
+ */
+class IxSorter {
+   public:
+    IxSorter(const std::vector<ColType> &col_types, const std::vector<int> &col_lens,
+             size_t memory_limit = IX_SORT_MEMORY);
+
+    ~IxSorter();
+
+    void add(const char *key, const Rid &rid);
+
+    int next_batch(const char **keys, const Rid **rids);
+
+    int num_runs() const { return static_cast<int>(runs_.size()); }
+
+   private:
+    /* 写入临时文件的一个有序run，归并时head_key和head_rid是它当前最小的键值对 */
+    struct IxSortRun {
+        FILE *file;
+        std::vector<char> head_key;
+        Rid head_rid;
+    };
+
+    void sort_buffer();
+
+    void spill();
+
+    void start_merge();
+
+    bool read_head(IxSortRun *run);
+
+    bool pop(const char **key, Rid *rid);
+
+    std::vector<ColType> col_types_;
+    std::vector<int> col_lens_;
+    int key_len_;
+    size_t max_buffered_;               // 内存中最多存放的键值对数量
+
+    std::vector<char> keys_;            // 内存中的键值对，按加入的顺序
+    std::vector<Rid> rids_;
+    std::vector<int> order_;            // 排序后内存中键值对的下标
+    size_t order_pos_ = 0;              // 下一个输出的order_的位置
+
+    std::vector<IxSortRun> runs_;       // 已写入临时文件的run，按生成的顺序
+    std::vector<int> heap_;             // 归并时以各run的head为key的小根堆，key相同时先生成的run在上
+    std::vector<char> pop_key_;         // 归并时最近一次取出的key
+    bool merging_ = false;              // 是否已开始输出
+
+    std::vector<char> batch_keys_;      // next_batch()输出的一批键值对
+    std::vector<Rid> batch_rids_;
+    std::vector<char> last_key_;        // 上一个输出的key，用于去掉重复的key
+    bool has_last_ = false;
+};
@@ -23,12 +23,15 @@ typedef enum PlanTag{
     T_Invalid = 1,
     T_Help,
     T_ShowTable,
+    T_ShowStats,
     T_DescTable,
     T_CreateTable,
     T_DropTable,
     T_CreateIndex,
     T_DropIndex,
+    T_Vacuum,
     T_Insert,
+    T_CopyFrom,
     T_Update,
     T_Delete,
     T_select,
@@ -74,6 +77,7 @@ class ScanPlan : public Plan
         size_t len_;                               
         std::vector<Condition> fed_conds_;
         std::vector<std::string> index_col_names_;
+        std::vector<ColMeta> read_cols_;    // 查询用到的字段，为空时为所有字段，PAX格式的表扫描时只取出这些字段
     
 };
 
@@ -137,7 +141,7 @@ class DMLPlan : public Plan
 {
     public:
         DMLPlan(PlanTag tag, std::shared_ptr<Plan> subplan,std::string tab_name,
-                std::vector<Value> values, std::vector<Condition> conds,
+                std::vector<std::vector<Value>> values, std::vector<Condition> conds,
                 std::vector<SetClause> set_clauses)
         {
             Plan::tag = tag;
@@ -150,9 +154,10 @@ class DMLPlan : public Plan
         ~DMLPlan(){}
         std::shared_ptr<Plan> subplan_;
         std::string tab_name_;
-        std::vector<Value> values_;
+        std::vector<std::vector<Value>> values_;
         std::vector<Condition> conds_;
         std::vector<SetClause> set_clauses_;
+        std::string file_name_;     // copy from的数据文件
 };
 
 // ddl语句, 包括create/drop table; create/drop index;
@@ -170,9 +175,13 @@ class DDLPlan : public Plan
         std::string tab_name_;
         std::vector<std::string> tab_col_names_;
         std::vector<ColDef> cols_;
+        RmLayout layout_ = RM_LAYOUT_FIXED;    // create table时表文件的页面格式
+        PageCompression compression_ = PAGE_COMPRESSION_NONE;  // create table时表文件的页面压缩方式
+        IxLatchMode latch_mode_ = IX_LATCH_CRABBING;           // create index时索引的并发控制方式
+        double fill_factor_ = IX_BULK_FILL_FACTOR;             // create index时批量构建的结点填到的比例
 };
 
-// help; show tables; desc tables; begin; abort; commit; rollback语句对应的plan
+// help; show tables; show stats; desc tables; begin; abort; commit; rollback语句对应的plan
 class OtherPlan : public Plan
 {
     public:
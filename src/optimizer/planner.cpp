@@ -11,6 +11,7 @@ See the Mulan PSL v2 for more details. */
 #include "planner.h"
 
 #include <memory>
+#include <set>
 
 #include "execution/executor_delete.h"
 #include "execution/executor_index_scan.h"
@@ -141,18 +142,21 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query) {
     // // Scan table , 生成表算子列表tab_nodes
     std::vector<std::shared_ptr<Plan>> table_scan_executors(tables.size());
     for (size_t i = 0; i < tables.size(); i++) {
+        // 连接条件在pop_conds之后才从query->conds中取出，需要先收集用到的字段
+        auto read_cols = get_read_cols(query, tables[i]);
         auto curr_conds = pop_conds(query->conds, tables[i]);
         // int index_no = get_indexNo(tables[i], curr_conds);
         std::vector<std::string> index_col_names;
         bool index_exist = get_index_cols(tables[i], curr_conds, index_col_names);
+        std::shared_ptr<ScanPlan> scan_plan;
         if (index_exist == false) {  // 该表没有索引
             index_col_names.clear();
-            table_scan_executors[i] =
-                std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
+            scan_plan = std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
         } else {  // 存在索引
-            table_scan_executors[i] =
-                std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+            scan_plan = std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
         }
+        scan_plan->read_cols_ = std::move(read_cols);
+        table_scan_executors[i] = scan_plan;
     }
     // 只有一个表，不需要join。
     if (tables.size() == 1) {
@@ -242,6 +246,42 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query) {
     return table_join_executors;
 }
 
+/**
+ * @brief select语句中表tab_name被用到的字段：投影列、where和连接条件中的字段，以及排序字段
+ *
+ * @param query 查询
+ * @param tab_name 表名
+ * @return std::vector<ColMeta> 按字段在表中的顺序排列
+ */
+std::vector<ColMeta> Planner::get_read_cols(std::shared_ptr<Query> query, const std::string &tab_name) {
+    std::set<std::string> used;
+    for (auto &col : query->cols) {
+        if (col.tab_name == tab_name) {
+            used.insert(col.col_name);
+        }
+    }
+    for (auto &cond : query->conds) {
+        if (cond.lhs_col.tab_name == tab_name) {
+            used.insert(cond.lhs_col.col_name);
+        }
+        if (!cond.is_rhs_val && cond.rhs_col.tab_name == tab_name) {
+            used.insert(cond.rhs_col.col_name);
+        }
+    }
+    auto x = std::dynamic_pointer_cast<ast::SelectStmt>(query->parse);
+    if (x->has_sort) {
+        // 排序字段只有列名，按列名匹配
+        used.insert(x->order->cols->col_name);
+    }
+    std::vector<ColMeta> read_cols;
+    for (auto &col : sm_manager_->db_.get_table(tab_name).cols) {
+        if (used.count(col.name)) {
+            read_cols.push_back(col);
+        }
+    }
+    return read_cols;
+}
+
 std::shared_ptr<Plan> Planner::generate_sort_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan) {
     auto x = std::dynamic_pointer_cast<ast::SelectStmt>(query->parse);
     if (!x->has_sort) {
@@ -290,27 +330,45 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
             if (auto sv_col_def = std::dynamic_pointer_cast<ast::ColDef>(field)) {
                 ColDef col_def = {.name = sv_col_def->col_name,
                                   .type = interp_sv_type(sv_col_def->type_len->type),
-                                  .len = sv_col_def->type_len->len};
+                                  .len = sv_col_def->type_len->len,
+                                  .var_len = sv_col_def->type_len->type == ast::SV_TYPE_VARCHAR};
                 col_defs.push_back(col_def);
             } else {
                 throw InternalError("Unexpected field type");
             }
         }
-        plannerRoot = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, std::vector<std::string>(), col_defs);
+        auto ddl_plan = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, std::vector<std::string>(), col_defs);
+        ddl_plan->layout_ = interp_storage(x->storage);
+        ddl_plan->compression_ = interp_compression(x->compression);
+        plannerRoot = ddl_plan;
     } else if (auto x = std::dynamic_pointer_cast<ast::DropTable>(query->parse)) {
         // drop table;
         plannerRoot =
             std::make_shared<DDLPlan>(T_DropTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(query->parse)) {
         // create index;
-        plannerRoot = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+        auto ddl_plan = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+        ddl_plan->latch_mode_ = interp_latch_mode(x->latch_mode);
+        ddl_plan->fill_factor_ = interp_fill_factor(x->fill_factor);
+        plannerRoot = ddl_plan;
     } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(query->parse)) {
         // drop index
         plannerRoot = std::make_shared<DDLPlan>(T_DropIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::Vacuum>(query->parse)) {
+        // vacuum
+        plannerRoot =
+            std::make_shared<DDLPlan>(T_Vacuum, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(query->parse)) {
         // insert;
         plannerRoot = std::make_shared<DMLPlan>(T_Insert, std::shared_ptr<Plan>(), x->tab_name, query->values,
                                                 std::vector<Condition>(), std::vector<SetClause>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::CopyFrom>(query->parse)) {
+        // copy from;
+        auto dml_plan =
+            std::make_shared<DMLPlan>(T_CopyFrom, std::shared_ptr<Plan>(), x->tab_name, std::vector<std::vector<Value>>(),
+                                      std::vector<Condition>(), std::vector<SetClause>());
+        dml_plan->file_name_ = x->file_name;
+        plannerRoot = dml_plan;
     } else if (auto x = std::dynamic_pointer_cast<ast::DeleteStmt>(query->parse)) {
         // delete;
         // 生成表扫描方式
@@ -329,7 +387,7 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
                 std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
         }
 
-        plannerRoot = std::make_shared<DMLPlan>(T_Delete, table_scan_executors, x->tab_name, std::vector<Value>(),
+        plannerRoot = std::make_shared<DMLPlan>(T_Delete, table_scan_executors, x->tab_name, std::vector<std::vector<Value>>(),
                                                 query->conds, std::vector<SetClause>());
     } else if (auto x = std::dynamic_pointer_cast<ast::UpdateStmt>(query->parse)) {
         // update;
@@ -348,13 +406,13 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
             table_scan_executors =
                 std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
         }
-        plannerRoot = std::make_shared<DMLPlan>(T_Update, table_scan_executors, x->tab_name, std::vector<Value>(),
+        plannerRoot = std::make_shared<DMLPlan>(T_Update, table_scan_executors, x->tab_name, std::vector<std::vector<Value>>(),
                                                 query->conds, query->set_clauses);
     } else if (auto x = std::dynamic_pointer_cast<ast::SelectStmt>(query->parse)) {
         std::shared_ptr<plannerInfo> root = std::make_shared<plannerInfo>(x);
         // 生成select语句的查询执行计划
         std::shared_ptr<Plan> projection = generate_select_plan(std::move(query), context);
-        plannerRoot = std::make_shared<DMLPlan>(T_select, projection, std::string(), std::vector<Value>(),
+        plannerRoot = std::make_shared<DMLPlan>(T_select, projection, std::string(), std::vector<std::vector<Value>>(),
                                                 std::vector<Condition>(), std::vector<SetClause>());
     } else {
         throw InternalError("Unexpected AST root");
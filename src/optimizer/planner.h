@@ -10,6 +10,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <memory>
@@ -42,6 +43,8 @@ class Planner {
 
     std::shared_ptr<Plan> make_one_rel(std::shared_ptr<Query> query);
 
+    std::vector<ColMeta> get_read_cols(std::shared_ptr<Query> query, const std::string &tab_name);
+
     std::shared_ptr<Plan> generate_sort_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
     
     std::shared_ptr<Plan> generate_select_plan(std::shared_ptr<Query> query, Context *context);
@@ -52,7 +55,58 @@ class Planner {
 
     ColType interp_sv_type(ast::SvType sv_type) {
         std::map<ast::SvType, ColType> m = {
-            {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_STRING}};
+            {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_STRING},
+            {ast::SV_TYPE_VARCHAR, TYPE_STRING}};
         return m.at(sv_type);
     }
+
+    // CREATE TABLE ... STORAGE = <storage>中的页面格式，不区分大小写，未指定时为定长格式
+    RmLayout interp_storage(const std::string &storage) {
+        std::string name = storage;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::map<std::string, RmLayout> m = {
+            {"", RM_LAYOUT_FIXED}, {"fixed", RM_LAYOUT_FIXED}, {"slotted", RM_LAYOUT_SLOTTED}, {"pax", RM_LAYOUT_PAX}};
+        auto it = m.find(name);
+        if (it == m.end()) {
+            throw InvalidStorageError(storage);
+        }
+        return it->second;
+    }
+
+    // CREATE TABLE ... COMPRESSION = <compression>中的页面压缩方式，不区分大小写，未指定时不压缩
+    PageCompression interp_compression(const std::string &compression) {
+        std::string name = compression;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::map<std::string, PageCompression> m = {
+            {"", PAGE_COMPRESSION_NONE}, {"none", PAGE_COMPRESSION_NONE}, {"zero_run", PAGE_COMPRESSION_ZERO_RUN}};
+        auto it = m.find(name);
+        if (it == m.end()) {
+            throw InvalidCompressionError(compression);
+        }
+        return it->second;
+    }
+
+    // CREATE INDEX ... LATCH = <latch_mode>中索引的并发控制方式，不区分大小写，未指定时使用latch crabbing
+    IxLatchMode interp_latch_mode(const std::string &latch_mode) {
+        std::string name = latch_mode;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::map<std::string, IxLatchMode> m = {
+            {"", IX_LATCH_CRABBING}, {"crabbing", IX_LATCH_CRABBING}, {"optimistic", IX_LATCH_OPTIMISTIC}};
+        auto it = m.find(name);
+        if (it == m.end()) {
+            throw InvalidLatchModeError(latch_mode);
+        }
+        return it->second;
+    }
+
+    // CREATE INDEX ... FILLFACTOR = <percent>中结点填到的百分比，取值10到100，未指定时使用IX_BULK_FILL_FACTOR
+    double interp_fill_factor(int fill_factor) {
+        if (fill_factor == 0) {
+            return IX_BULK_FILL_FACTOR;
+        }
+        if (fill_factor < 10 || fill_factor > 100) {
+            throw InvalidFillFactorError(fill_factor);
+        }
+        return fill_factor / 100.0;
+    }
 };
@@ -19,7 +19,7 @@ enum JoinType {
 namespace ast {
 
 enum SvType {
-    SV_TYPE_INT, SV_TYPE_FLOAT, SV_TYPE_STRING
+    SV_TYPE_INT, SV_TYPE_FLOAT, SV_TYPE_STRING, SV_TYPE_VARCHAR
 };
 
 enum SvCompOp {
@@ -43,6 +43,9 @@ struct Help : public TreeNode {
 struct ShowTables : public TreeNode {
 };
 
+struct ShowStats : public TreeNode {
+};
+
 struct TxnBegin : public TreeNode {
 };
 
@@ -76,9 +79,13 @@ struct ColDef : public Field {
 struct CreateTable : public TreeNode {
     std::string tab_name;
     std::vector<std::shared_ptr<Field>> fields;
+    std::string storage;        // 页面格式，未指定时为空
+    std::string compression;    // 页面压缩方式，未指定时为空
 
-    CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_) :
-            tab_name(std::move(tab_name_)), fields(std::move(fields_)) {}
+    CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_, std::string storage_ = "",
+                std::string compression_ = "") :
+            tab_name(std::move(tab_name_)), fields(std::move(fields_)), storage(std::move(storage_)),
+            compression(std::move(compression_)) {}
 };
 
 struct DropTable : public TreeNode {
@@ -96,9 +103,13 @@ struct DescTable : public TreeNode {
 struct CreateIndex : public TreeNode {
     std::string tab_name;
     std::vector<std::string> col_names;
+    std::string latch_mode;     // 并发控制方式，未指定时为空
+    int fill_factor;            // 批量构建时结点填到的百分比，未指定时为0
 
-    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_) :
-            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
+    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_, std::string latch_mode_ = "",
+                int fill_factor_ = 0) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)), latch_mode(std::move(latch_mode_)),
+            fill_factor(fill_factor_) {}
 };
 
 struct DropIndex : public TreeNode {
@@ -109,6 +120,12 @@ struct DropIndex : public TreeNode {
             tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
 };
 
+struct Vacuum : public TreeNode {
+    std::string tab_name;
+
+    Vacuum(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
+};
+
 struct Expr : public TreeNode {
 };
 
@@ -168,10 +185,18 @@ struct OrderBy : public TreeNode
 
 struct InsertStmt : public TreeNode {
     std::string tab_name;
-    std::vector<std::shared_ptr<Value>> vals;
+    std::vector<std::vector<std::shared_ptr<Value>>> rows;  // VALUES后的每一行
+
+    InsertStmt(std::string tab_name_, std::vector<std::vector<std::shared_ptr<Value>>> rows_) :
+            tab_name(std::move(tab_name_)), rows(std::move(rows_)) {}
+};
+
+struct CopyFrom : public TreeNode {
+    std::string tab_name;
+    std::string file_name;
 
-    InsertStmt(std::string tab_name_, std::vector<std::shared_ptr<Value>> vals_) :
-            tab_name(std::move(tab_name_)), vals(std::move(vals_)) {}
+    CopyFrom(std::string tab_name_, std::string file_name_) :
+            tab_name(std::move(tab_name_)), file_name(std::move(file_name_)) {}
 };
 
 struct DeleteStmt : public TreeNode {
@@ -246,6 +271,7 @@ struct SemValue {
 
     std::shared_ptr<Value> sv_val;
     std::vector<std::shared_ptr<Value>> sv_vals;
+    std::vector<std::vector<std::shared_ptr<Value>>> sv_val_rows;
 
     std::shared_ptr<Col> sv_col;
     std::vector<std::shared_ptr<Col>> sv_cols;
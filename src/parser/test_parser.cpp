@@ -16,14 +16,24 @@ See the Mulan PSL v2 for more details. */
 int main() {
     std::vector<std::string> sqls = {
         "show tables;",
+        "show stats;",
         "desc tb;",
         "create table tb (a int, b float, c char(4));",
+        "create table tb (a int, b varchar(20)) storage = slotted;",
+        "create table tb (a int, b float, c char(4)) storage = pax;",
+        "create table tb (a int, c char(200)) compression = zero_run;",
+        "create table tb (a int, b varchar(20)) storage = slotted compression = none;",
+        "create index tb (a, b) latch = optimistic;",
+        "create index tb (a) fillfactor = 70;",
         "drop table tb;",
         "create index tb(a);",
         "create index tb(a, b, c);",
         "drop index tb(a, b, c);",
         "drop index tb(b);",
+        "vacuum tb;",
         "insert into tb values (1, 3.14, 'pi');",
+        "insert into tb values (1, 3.14, 'pi'), (2, 2.72, 'e');",
+        "copy tb from 'tb.csv';",
         "delete from tb where a = 1;",
         "update tb set a = 1, b = 2.2, c = 'xyz' where x = 2 and y < 1.1 and z > 'abc';",
         "select * from tb;",
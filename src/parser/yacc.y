@@ -21,8 +21,8 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY
-WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY
+%token SHOW TABLES STATS CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY
+WHERE UPDATE SET SELECT INT CHAR VARCHAR FLOAT INDEX STORAGE COMPRESSION LATCH FILLFACTOR COPY VACUUM AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
@@ -40,7 +40,9 @@ WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_CO
 %type <sv_expr> expr
 %type <sv_val> value
 %type <sv_vals> valueList
-%type <sv_str> tbName colName
+%type <sv_val_rows> valueRows
+%type <sv_str> tbName colName optStorage optCompression optLatch
+%type <sv_int> optFillFactor
 %type <sv_strs> tableList colNameList
 %type <sv_col> col
 %type <sv_cols> colList selector
@@ -106,12 +108,16 @@ dbStmt:
     {
         $$ = std::make_shared<ShowTables>();
     }
+    |   SHOW STATS
+    {
+        $$ = std::make_shared<ShowStats>();
+    }
     ;
 
 ddl:
-        CREATE TABLE tbName '(' fieldList ')'
+        CREATE TABLE tbName '(' fieldList ')' optStorage optCompression
     {
-        $$ = std::make_shared<CreateTable>($3, $5);
+        $$ = std::make_shared<CreateTable>($3, $5, $7, $8);
     }
     |   DROP TABLE tbName
     {
@@ -121,20 +127,28 @@ ddl:
     {
         $$ = std::make_shared<DescTable>($2);
     }
-    |   CREATE INDEX tbName '(' colNameList ')'
+    |   CREATE INDEX tbName '(' colNameList ')' optLatch optFillFactor
     {
-        $$ = std::make_shared<CreateIndex>($3, $5);
+        $$ = std::make_shared<CreateIndex>($3, $5, $7, $8);
     }
     |   DROP INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<DropIndex>($3, $5);
     }
+    |   VACUUM tbName
+    {
+        $$ = std::make_shared<Vacuum>($2);
+    }
     ;
 
 dml:
-        INSERT INTO tbName VALUES '(' valueList ')'
+        INSERT INTO tbName VALUES valueRows
     {
-        $$ = std::make_shared<InsertStmt>($3, $6);
+        $$ = std::make_shared<InsertStmt>($3, $5);
+    }
+    |   COPY tbName FROM VALUE_STRING
+    {
+        $$ = std::make_shared<CopyFrom>($2, $4);
     }
     |   DELETE FROM tbName optWhereClause
     {
@@ -188,12 +202,27 @@ type:
     {
         $$ = std::make_shared<TypeLen>(SV_TYPE_STRING, $3);
     }
+    |   VARCHAR '(' VALUE_INT ')'
+    {
+        $$ = std::make_shared<TypeLen>(SV_TYPE_VARCHAR, $3);
+    }
     |   FLOAT
     {
         $$ = std::make_shared<TypeLen>(SV_TYPE_FLOAT, sizeof(float));
     }
     ;
 
+valueRows:
+        '(' valueList ')'
+    {
+        $$ = std::vector<std::vector<std::shared_ptr<Value>>>{$2};
+    }
+    |   valueRows ',' '(' valueList ')'
+    {
+        $$.push_back($4);
+    }
+    ;
+
 valueList:
         value
     {
@@ -227,6 +256,41 @@ condition:
     }
     ;
 
+optStorage:
+        /* epsilon */ { /* ignore*/ }
+    |   STORAGE '=' IDENTIFIER
+    {
+        $$ = $3;
+    }
+    ;
+
+optCompression:
+        /* epsilon */ { /* ignore*/ }
+    |   COMPRESSION '=' IDENTIFIER
+    {
+        $$ = $3;
+    }
+    ;
+
+optLatch:
+        /* epsilon */ { /* ignore*/ }
+    |   LATCH '=' IDENTIFIER
+    {
+        $$ = $3;
+    }
+    ;
+
+optFillFactor:
+        /* epsilon */
+    {
+        $$ = 0;
+    }
+    |   FILLFACTOR '=' VALUE_INT
+    {
+        $$ = $3;
+    }
+    ;
+
 optWhereClause:
         /* epsilon */ { /* ignore*/ }
     |   WHERE whereClause
@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #include "execution/executor_delete.h"
 #include "execution/executor_index_scan.h"
 #include "execution/executor_insert.h"
+#include "execution/executor_load.h"
 #include "execution/executor_nestedloop_join.h"
 #include "execution/executor_projection.h"
 #include "execution/executor_seq_scan.h"
@@ -98,8 +99,20 @@ class Portal {
                 }
 
                 case T_Insert: {
+                    // 多行insert走批量装载的路径
+                    std::unique_ptr<AbstractExecutor> root;
+                    if (x->values_.size() == 1) {
+                        root = std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, x->values_.front(), context);
+                    } else {
+                        root = std::make_unique<LoadExecutor>(sm_manager_, x->tab_name_, x->values_, context);
+                    }
+
+                    return std::make_shared<PortalStmt>(PORTAL_DML_WITHOUT_SELECT, std::vector<TabCol>(),
+                                                        std::move(root), plan);
+                }
+                case T_CopyFrom: {
                     std::unique_ptr<AbstractExecutor> root =
-                        std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, x->values_, context);
+                        std::make_unique<LoadExecutor>(sm_manager_, x->tab_name_, x->file_name_, context);
 
                     return std::make_shared<PortalStmt>(PORTAL_DML_WITHOUT_SELECT, std::vector<TabCol>(),
                                                         std::move(root), plan);
@@ -149,7 +162,7 @@ class Portal {
             return std::make_unique<ProjectionExecutor>(convert_plan_executor(x->subplan_, context), x->sel_cols_);
         } else if (auto x = std::dynamic_pointer_cast<ScanPlan>(plan)) {
             if (x->tag == T_SeqScan) {
-                return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context);
+                return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context, x->read_cols_);
             } else {
                 return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_,
                                                            context);
@@ -10,11 +10,19 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RM_BITMAP_AVX2
+#endif
+
 static constexpr int BITMAP_WIDTH = 8;
 static constexpr unsigned BITMAP_HIGHEST_BIT = 0x80u;  // 128 (2^7)
+static constexpr int BITMAP_WORD_BITS = 64;             // 按64位的字扫描
+static constexpr int BITMAP_AVX2_MIN_BYTES = 64;        // 剩余部分不少于64字节时才用AVX2一次跳过32字节
 
 class Bitmap {
    public:
@@ -39,23 +47,126 @@ class Bitmap {
      * @return 找到了就返回偏移位置，没找到就返回max_n
      */
     static int next_bit(bool bit, const char *bm, int max_n, int curr) {
-        for (int i = curr + 1; i < max_n; i++) {
-            if (is_set(bm, i) == bit) {
-                return i;
-            }
+        int pos = curr + 1;
+        if (pos >= max_n) {
+            return max_n;
+        }
+        // 页面中的记录通常是连续存放的，先单独检查紧接着的一位
+        if (is_set(bm, pos) == bit) {
+            return pos;
         }
-        return max_n;
+        return scan_next_bit(bit, bm, max_n, pos);
     }
 
     // 找第一个为0 or 1的位
     static int first_bit(bool bit, const char *bm, int max_n) { return next_bit(bit, bm, max_n, -1); }
 
+    // 统计[0,max_n)中为1的位数
+    static int count(const char *bm, int max_n) {
+        int num_words = (max_n + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+        int cnt = 0;
+        for (int word_no = 0; word_no < num_words; word_no++) {
+            cnt += __builtin_popcountll(load_word(bm, max_n, word_no));
+        }
+        return cnt;
+    }
+
+    /**
+     * @brief 按从小到大的顺序对[0,max_n)中每个为1的位调用f(pos)，每次处理一个字，适合一次取出页面中的所有记录
+     */
+    template <typename F>
+    static void for_each_set_bit(const char *bm, int max_n, F &&f) {
+        int num_words = (max_n + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+        for (int word_no = 0; word_no < num_words; word_no++) {
+            uint64_t word = load_word(bm, max_n, word_no);
+            while (word != 0) {
+                f(word_no * BITMAP_WORD_BITS + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
     // for example:
     // rid_.slot_no = Bitmap::next_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page,
     // rid_.slot_no); int slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
 
    private:
+    /**
+     * @brief next_bit中紧接着的一位不符合时，从pos开始按字查找，不内联以保持next_bit的快速路径足够小
+     */
+    __attribute__((noinline)) static int scan_next_bit(bool bit, const char *bm, int max_n, int pos) {
+        // 找0时把每个字取反，统一为找1；第一个字中pos之前的位被屏蔽
+        uint64_t flip = bit ? 0 : ~0ull;
+        int word_no = pos / BITMAP_WORD_BITS;
+        uint64_t word = (load_word(bm, max_n, word_no) ^ flip) & (~0ull << (pos % BITMAP_WORD_BITS));
+        int num_words = (max_n + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+        while (word == 0) {
+            if (++word_no >= num_words) {
+                return max_n;
+            }
+#ifdef RM_BITMAP_AVX2
+            int num_bytes = get_bucket(max_n - 1) + 1;
+            if (num_bytes - word_no * 8 >= BITMAP_AVX2_MIN_BYTES && has_avx2()) {
+                word_no = skip_uniform_avx2(bm, word_no * 8, num_bytes, bit ? 0 : 0xff) / 8;
+            }
+#endif
+            word = load_word(bm, max_n, word_no) ^ flip;
+        }
+        // max_n之后的位按0读入，找0时可能越过max_n
+        return std::min(word_no * BITMAP_WORD_BITS + __builtin_ctzll(word), max_n);
+    }
+
     static int get_bucket(int pos) { return pos / BITMAP_WIDTH; }
 
     static char get_bit(int pos) { return BITMAP_HIGHEST_BIT >> static_cast<char>(pos % BITMAP_WIDTH); }
+
+    /**
+     * @brief 读出第word_no个64位的字，pos位对应字的第pos % 64位（从最低位数起），因此可以用ctz查找、用word & (word - 1)逐个清除；
+     * 位图只有(max_n + 7) / 8个字节，max_n及之后的位都按0读入
+     */
+    static uint64_t load_word(const char *bm, int max_n, int word_no) {
+        int num_bytes = get_bucket(max_n - 1) + 1;
+        int begin = word_no * 8;
+        uint64_t word = 0;
+        if (begin + 8 <= num_bytes) {
+            memcpy(&word, bm + begin, 8);
+        } else {
+            memcpy(&word, bm + begin, num_bytes - begin);
+        }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        // 字节内的位序是从最高位开始的，把每个字节内的位反转
+        word = ((word >> 1) & 0x5555555555555555ull) | ((word & 0x5555555555555555ull) << 1);
+        word = ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+        word = ((word >> 4) & 0x0f0f0f0f0f0f0f0full) | ((word & 0x0f0f0f0f0f0f0f0full) << 4);
+        int tail = (word_no + 1) * BITMAP_WORD_BITS - max_n;
+        if (tail > 0) {
+            word &= ~0ull >> tail;
+        }
+        return word;
+    }
+
+#ifdef RM_BITMAP_AVX2
+    static bool has_avx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    /**
+     * @brief 从第begin个字节开始每次比较32个字节，跳过所有字节都等于fill的部分
+     * @return 第一个含有不等于fill的字节的32字节块的起点，剩余不足32字节时返回剩余部分的起点
+     */
+    __attribute__((target("avx2"))) static int skip_uniform_avx2(const char *bm, int begin, int end, int fill) {
+        const __m256i target = _mm256_set1_epi8(static_cast<char>(fill));
+        while (begin + 32 <= end) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bm + begin));
+            if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target))) != 0xffffffffu) {
+                break;
+            }
+            begin += 32;
+        }
+        return begin;
+    }
+#endif
 };
@@ -17,21 +17,50 @@ constexpr int RM_NO_PAGE = -1;
 constexpr int RM_FILE_HDR_PAGE = 0;
 constexpr int RM_FIRST_RECORD_PAGE = 1;
 constexpr int RM_MAX_RECORD_SIZE = 512;
+constexpr int RM_INSERT_PARTITIONS = 16;     // 插入线程按分区记录上一次插入的页面，不同分区的线程优先使用不同的页面
+constexpr int RM_PAGE_LATCH_STRIPES = 64;    // 保护页面bitmap和页头的latch个数，按页号取模
+constexpr int RM_FSM_REBUILD_BATCH = 64;     // 重建空闲空间映射时每批预读的页面个数
+const std::string RM_FSM_FILE_SUFFIX = ".fsm";  // 关闭表文件时保存空闲空间映射的文件后缀
+const std::string RM_ZONE_MAP_FILE_SUFFIX = ".zmap";  // 关闭表文件时保存zone map的文件后缀
+
+/* 表数据文件的页面格式，建表时通过STORAGE选项指定 */
+enum RmLayout : int {
+    RM_LAYOUT_FIXED = 0,    // 定长记录：页面由bitmap和等长的slot组成
+    RM_LAYOUT_SLOTTED = 1,  // 变长记录：页面由slot目录和从页尾向前存放的记录组成，VARCHAR字段只存放实际长度
+    RM_LAYOUT_PAX = 2,      // 按列存放：bitmap与定长格式相同，页面中每个字段的值连续存放在该字段的minipage中
+};
 
 /* 文件头，记录表数据文件的元信息，写入磁盘中文件的第0号页面 */
 struct RmFileHdr {
-    int record_size;            // 表中每条记录的大小，由于不包含变长字段，因此当前字段初始化后保持不变
+    int record_size;            // 表中每条记录在内存中的大小（变长字段按最大长度计算），初始化后保持不变
     int num_pages;              // 文件中分配的页面个数（初始化为1）
-    int num_records_per_page;   // 每个页面最多能存储的元组个数
-    int first_free_page_no;     // 文件中当前第一个包含空闲空间的页面号（初始化为-1）
-    int bitmap_size;            // 每个页面bitmap大小
+    int num_records_per_page;   // 每个页面最多能存储的元组个数，slotted格式下为0，PAX格式下与定长格式相同
+    int first_free_page_no;     // 保留字段，始终为-1，空闲页面改由RmFreeSpaceMap管理
+    int bitmap_size;            // 每个页面bitmap大小，slotted格式下为0
+    int layout;                 // 页面格式，RmLayout
+    int num_var_cols;           // 文件头之后紧跟的RmVarCol个数：slotted格式下为变长字段的个数，PAX格式下为所有字段的个数
+};
+
+/* 字段在内存中定长记录里的位置。slotted格式的页面中变长字段只存放去掉末尾填充'\0'后的部分；
+ * PAX格式的页面中偏移量为offset、长度为len的字段，其minipage从slots + offset * num_records_per_page开始 */
+struct RmVarCol {
+    int16_t offset;
+    int16_t len;
 };
 
 /* 表数据文件中每个页面的页头，记录每个页面的元信息 */
 struct RmPageHdr {
-    int next_free_page_no;  // 当前页面满了之后，下一个包含空闲空间的页面号（初始化为-1）
-    int num_records;        // 当前页面中当前已经存储的记录个数（初始化为0）
+    int next_free_page_no;  // 保留字段，始终为-1
+    int num_records;        // 当前页面中当前已经存储的记录个数（初始化为0），slotted格式下为已使用的slot个数
+};
+
+/* slotted格式下记录在页面中的第一个字节，表示记录的种类 */
+enum RmRecordFlag : uint8_t {
+    RM_RECORD_NORMAL = 0,   // 记录存放在自己的rid处
+    RM_RECORD_FORWARD = 1,  // 更新后记录变长、原页面放不下，记录被移到了其他页面，之后是记录所在的Rid
+    RM_RECORD_MOVED = 2,    // 从其他页面移来的记录，之后是记录自己的Rid和记录的数据，扫描时跳过
 };
+constexpr int RM_MIN_STORED_SIZE = 1 + sizeof(Rid);     // slotted格式下每条记录至少占用的字节数，保证能原地改为FORWARD
 
 /* 表中的记录 */
 struct RmRecord {
@@ -10,6 +10,61 @@ See the Mulan PSL v2 for more details. */
 
 #include "rm_file_handle.h"
 
+#include <algorithm>
+#include <unordered_map>
+
+/**
+ * @description: 当前线程所属的插入分区。线程第一次插入时按顺序分配，之后固定不变
+ */
+static int get_insert_partition() {
+    static std::atomic<int> next_partition{0};
+    thread_local int partition = next_partition.fetch_add(1, std::memory_order_relaxed) % RM_INSERT_PARTITIONS;
+    return partition;
+}
+
+/**
+ * @description: 页面中可用于插入的空闲空间
+ * @return {int} 定长格式为空闲slot个数，slotted格式为空闲字节数（包括碎片）
+ */
+int RmPageHandle::get_free_space() const {
+    if (is_slotted()) {
+        return get_slotted_page().get_free_space();
+    }
+    return file_hdr->num_records_per_page - page_hdr->num_records;
+}
+
+/**
+ * @description: 判断slot_no上是否存放着一条记录，slotted格式下从其他页面移来的记录属于其原来的rid，不计入
+ * @param {int} slot_no slot号
+ */
+bool RmPageHandle::has_record(int slot_no) const {
+    if (!is_slotted()) {
+        return Bitmap::is_set(bitmap, slot_no);
+    }
+    int len;
+    char* stored = get_slotted_page().get_record(slot_no, &len);
+    return stored != nullptr && stored[0] != RM_RECORD_MOVED;
+}
+
+/**
+ * @description: 查找slot_no之后第一个存放了记录的slot
+ * @return {int} slot号，不存在时返回-1
+ * @param {int} slot_no 起始slot号（不包括），为-1时从第一个slot开始
+ */
+int RmPageHandle::next_record(int slot_no) const {
+    if (!is_slotted()) {
+        int next = Bitmap::next_bit(true, bitmap, file_hdr->num_records_per_page, slot_no);
+        return next < file_hdr->num_records_per_page ? next : -1;
+    }
+    int num_slots = get_slotted_page().get_num_slots();
+    for (int next = slot_no + 1; next < num_slots; next++) {
+        if (has_record(next)) {
+            return next;
+        }
+    }
+    return -1;
+}
+
 /**
  * @description: 获取当前表中记录号为rid的记录
  * @param {Rid&} rid 记录号，指定记录的位置
@@ -29,13 +84,65 @@ std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid& rid, Context* cont
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
 
     std::unique_ptr<RmRecord> record = std::make_unique<RmRecord>(file_hdr_.record_size);
-    char* slot = page_handle.get_slot(rid.slot_no);
-    memcpy(record->data, slot, file_hdr_.record_size);
     record->size = file_hdr_.record_size;
+    if (!page_handle.is_slotted()) {
+        read_slot(page_handle, rid.slot_no, record->data);
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        return record;
+    }
 
+    // slotted格式：记录可能因为更新变长被移到了其他页面，原位置存放其新的Rid
+    Rid moved_to = rid;
+    {
+        std::scoped_lock lock{get_page_latch(rid.page_no)};
+        int len;
+        char* stored = page_handle.get_slotted_page().get_record(rid.slot_no, &len);
+        if (stored == nullptr || stored[0] == RM_RECORD_MOVED) {
+            buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            throw RecordNotFoundError(rid.page_no, rid.slot_no);
+        }
+        if (stored[0] == RM_RECORD_FORWARD) {
+            memcpy(&moved_to, stored + 1, sizeof(Rid));
+        } else {
+            decode_record(stored + 1, record->data);
+        }
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    if (moved_to != rid) {
+        RmPageHandle moved_handle = fetch_page_handle(moved_to.page_no);
+        {
+            std::scoped_lock lock{get_page_latch(moved_to.page_no)};
+            int len;
+            char* stored = moved_handle.get_slotted_page().get_record(moved_to.slot_no, &len);
+            decode_record(stored + 1 + sizeof(Rid), record->data);
+        }
+        buffer_pool_manager_->unpin_page(moved_handle.page->get_page_id(), false);
+    }
     return record;
 }
 
+/**
+ * @description: 获取记录的只读视图，定长格式下视图直接指向页面中的slot并保持页面的pin，不拷贝记录
+ * @return {RmRecordView} rid对应记录的视图
+ * @param {Rid&} rid 记录号，指定记录的位置
+ * @param {Context*} context
+ */
+RmRecordView RmFileHandle::get_record_view(const Rid& rid, Context* context) const {
+    if (file_hdr_.layout != RM_LAYOUT_FIXED) {
+        // slotted格式的记录需要解码，PAX格式的记录分散在各个字段的minipage中，都无法直接引用页面中的数据
+        return RmRecordView(get_record(rid, context));
+    }
+
+    // 申请行级读锁
+    if (context) {
+        context->lock_mgr_->lock_shared_on_record(context->txn_, rid, fd_);
+    }
+
+    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    return RmRecordView(buffer_pool_manager_, page_handle.page, page_handle.get_slot(rid.slot_no),
+                        file_hdr_.record_size);
+}
+
 /**
  * @description: 在当前表中插入一条记录，不指定插入位置
  * @param {char*} buf 要插入的记录的数据
@@ -48,28 +155,72 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
     // 2. 在page handle中找到空闲slot位置
     // 3. 将buf复制到空闲slot位置
     // 4. 更新page_handle.page_hdr中的数据结构
-    // 注意考虑插入一条记录后页面已满的情况，需要更新file_hdr_.first_free_page_no
-
-    RmPageHandle page_handle = create_page_handle();
-
-    int new_slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
-
-    // 申请行级写锁
-    Rid rid{page_handle.page->get_page_id().page_no, new_slot_no};
-    if (context) {
-        context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_);
+    Rid rid;
+    if (file_hdr_.layout != RM_LAYOUT_SLOTTED) {
+        rid = insert_stored_record(buf, file_hdr_.record_size, context);
+    } else {
+        char stored[PAGE_SIZE];
+        int len = encode_stored_record(buf, stored);
+        rid = insert_stored_record(stored, len, context);
     }
+    update_zone_map(rid.page_no, buf);
+    return rid;
+}
 
-    Bitmap::set(page_handle.bitmap, new_slot_no);
-    char* slot = page_handle.get_slot(new_slot_no);
-    memcpy(slot, buf, file_hdr_.record_size);
-
-    page_handle.page_hdr->num_records++;
-    if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
-        file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
+/**
+ * @description: 将页面中存放的形式的记录插入到表中。通过空闲空间映射占用一个空闲空间足够的页面，
+ * 同一分区的线程优先使用上一次插入的页面，其他插入者在页面被释放前不会选中它，并发的插入因此分散在不同的页面上
+ * @return {Rid} 插入的记录的记录号（位置）
+ * @param {char*} stored 定长格式为记录本身，slotted格式为带有RmRecordFlag的记录
+ * @param {int} len stored的长度
+ * @param {Context*} context 为nullptr时不申请行级写锁
+ */
+Rid RmFileHandle::insert_stored_record(const char* stored, int len, Context* context) {
+    load_free_space_map();
+    bool slotted = file_hdr_.layout == RM_LAYOUT_SLOTTED;
+    int min_free_space = slotted ? len + (int)sizeof(RmSlot) : 1;
+    std::atomic<int>& hint = insert_hints_[get_insert_partition()];
+    while (true) {
+        RmPageHandle page_handle = create_page_handle(min_free_space, hint.load(std::memory_order_relaxed));
+        PageId page_id = page_handle.page->get_page_id();
+        hint.store(page_id.page_no, std::memory_order_relaxed);
+
+        int new_slot_no = -1;
+        {
+            std::scoped_lock lock{get_page_latch(page_id.page_no)};
+            RmSlottedPage slotted_page = page_handle.get_slotted_page();
+            if (slotted) {
+                new_slot_no = slotted_page.find_free_slot(len);
+            } else if (page_handle.page_hdr->num_records < file_hdr_.num_records_per_page) {
+                new_slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
+            }
+            if (new_slot_no != -1) {
+                // 申请行级写锁
+                if (context) {
+                    try {
+                        context->lock_mgr_->lock_exclusive_on_record(context->txn_, Rid{page_id.page_no, new_slot_no},
+                                                                     fd_);
+                    } catch (...) {
+                        free_space_map_.release_page(page_id.page_no, page_handle.get_free_space());
+                        buffer_pool_manager_->unpin_page(page_id, false);
+                        throw;
+                    }
+                }
+                if (slotted) {
+                    slotted_page.insert(new_slot_no, stored, len);
+                } else {
+                    Bitmap::set(page_handle.bitmap, new_slot_no);
+                    write_slot(page_handle, new_slot_no, stored);
+                    page_handle.page_hdr->num_records++;
+                }
+            }
+            free_space_map_.release_page(page_id.page_no, page_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(page_id, new_slot_no != -1);
+        if (new_slot_no != -1) {
+            return Rid{page_id.page_no, new_slot_no};
+        }
     }
-    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
-    return Rid{page_handle.page->get_page_id().page_no, new_slot_no};
 }
 
 /**
@@ -79,6 +230,65 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
  */
 void RmFileHandle::insert_record(const Rid& rid, char* buf) {}
 
+/**
+ * @description: 批量插入记录：直接填满新分配的页面，不查找已有页面的空闲空间，也不申请行级锁，
+ * 调用者需持有表级写锁。装载结束后页面的剩余空间登记到空闲空间映射中，之后的插入可以继续使用
+ * @param {char*} buf num_records条连续存放的定长记录
+ * @param {int} num_records 记录的条数
+ * @param {vector<Rid>*} rids 依次追加每条记录的记录号
+ */
+void RmFileHandle::bulk_insert_records(const char* buf, int num_records, std::vector<Rid>* rids) {
+    load_free_space_map();
+    load_zone_map();
+    bool slotted = file_hdr_.layout == RM_LAYOUT_SLOTTED;
+    char stored[PAGE_SIZE];
+    int i = 0;
+    while (i < num_records) {
+        RmPageHandle page_handle = create_new_page_handle();
+        PageId page_id = page_handle.page->get_page_id();
+        {
+            std::scoped_lock lock{get_page_latch(page_id.page_no)};
+            if (!slotted) {
+                int n = std::min(num_records - i, file_hdr_.num_records_per_page);
+                const char* records = buf + (size_t)i * file_hdr_.record_size;
+                if (page_handle.is_pax()) {
+                    // 按字段依次填充minipage
+                    for (const RmVarCol& col : var_cols_) {
+                        for (int slot_no = 0; slot_no < n; slot_no++) {
+                            memcpy(page_handle.get_field(col, slot_no),
+                                   records + (size_t)slot_no * file_hdr_.record_size + col.offset, col.len);
+                        }
+                    }
+                } else {
+                    memcpy(page_handle.slots, records, (size_t)n * file_hdr_.record_size);
+                }
+                for (int slot_no = 0; slot_no < n; slot_no++) {
+                    update_zone_map(page_id.page_no, records + (size_t)slot_no * file_hdr_.record_size);
+                    Bitmap::set(page_handle.bitmap, slot_no);
+                    rids->push_back(Rid{page_id.page_no, slot_no});
+                }
+                page_handle.page_hdr->num_records = n;
+                i += n;
+            } else {
+                // 空页面一定能放下一条记录，因此每个页面至少装入一条
+                RmSlottedPage slotted_page = page_handle.get_slotted_page();
+                for (; i < num_records; i++) {
+                    int len = encode_stored_record(buf + (size_t)i * file_hdr_.record_size, stored);
+                    int slot_no = slotted_page.find_free_slot(len);
+                    if (slot_no == -1) {
+                        break;
+                    }
+                    slotted_page.insert(slot_no, stored, len);
+                    update_zone_map(page_id.page_no, buf + (size_t)i * file_hdr_.record_size);
+                    rids->push_back(Rid{page_id.page_no, slot_no});
+                }
+            }
+            free_space_map_.release_page(page_id.page_no, page_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(page_id, true);
+    }
+}
+
 /**
  * @description: 删除记录文件中记录号为rid的记录
  * @param {Rid&} rid 要删除的记录的记录号（位置）
@@ -88,24 +298,94 @@ void RmFileHandle::delete_record(const Rid& rid, Context* context) {
     // Todo:
     // 1. 获取指定记录所在的page handle
     // 2. 更新page_handle.page_hdr中的数据结构
-    // 注意考虑删除一条记录后页面未满的情况，需要调用release_page_handle()
+    // 删除记录后更新空闲空间映射中该页面的空闲空间，页面立即可以被插入者再次使用
 
     // 申请行级写锁
     if (context) {
         context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_);
     }
 
-    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    load_free_space_map();
+    if (file_hdr_.layout != RM_LAYOUT_SLOTTED) {
+        RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+        {
+            std::scoped_lock lock{get_page_latch(rid.page_no)};
+            Bitmap::reset(page_handle.bitmap, rid.slot_no);
+            page_handle.page_hdr->num_records--;
+            free_space_map_.set_free_space(rid.page_no, page_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+        return;
+    }
 
-    Bitmap::reset(page_handle.bitmap, rid.slot_no);
-    page_handle.page_hdr->num_records--;
+    // slotted格式：记录被移走时同时删除其所在位置上的记录
+    Rid moved_to = rid;
+    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    {
+        std::scoped_lock lock{get_page_latch(rid.page_no)};
+        int len;
+        char* stored = page_handle.get_slotted_page().get_record(rid.slot_no, &len);
+        if (stored == nullptr || stored[0] == RM_RECORD_MOVED) {
+            buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            throw RecordNotFoundError(rid.page_no, rid.slot_no);
+        }
+        if (stored[0] == RM_RECORD_FORWARD) {
+            memcpy(&moved_to, stored + 1, sizeof(Rid));
+        }
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    erase_stored_record(rid);
+    if (moved_to != rid) {
+        erase_stored_record(moved_to);
+    }
+}
 
-    if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page - 1) {
-        release_page_handle(page_handle);
+/**
+ * @description: 从slotted页面中删除rid处存放的记录（包括FORWARD和MOVED记录），并更新空闲空间映射
+ * @param {Rid&} rid 记录在页面中的位置
+ */
+void RmFileHandle::erase_stored_record(const Rid& rid) {
+    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    {
+        std::scoped_lock lock{get_page_latch(rid.page_no)};
+        page_handle.get_slotted_page().erase(rid.slot_no);
+        free_space_map_.set_free_space(rid.page_no, page_handle.get_free_space());
     }
     buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
 }
 
+/**
+ * @description: 读出定长或PAX格式页面中slot_no上的记录，PAX格式下从每个字段的minipage中依次取出
+ * @param {RmPageHandle&} page_handle 记录所在的页面
+ * @param {int} slot_no slot号
+ * @param {char*} buf 读出的记录，长度为record_size
+ */
+void RmFileHandle::read_slot(const RmPageHandle& page_handle, int slot_no, char* buf) const {
+    if (!page_handle.is_pax()) {
+        memcpy(buf, page_handle.get_slot(slot_no), file_hdr_.record_size);
+        return;
+    }
+    for (const RmVarCol& col : var_cols_) {
+        memcpy(buf + col.offset, page_handle.get_field(col, slot_no), col.len);
+    }
+}
+
+/**
+ * @description: 把记录写入定长或PAX格式页面中的slot_no，PAX格式下每个字段分别写入其minipage
+ * @param {RmPageHandle&} page_handle 记录所在的页面
+ * @param {int} slot_no slot号
+ * @param {char*} buf 记录的数据，长度为record_size
+ */
+void RmFileHandle::write_slot(const RmPageHandle& page_handle, int slot_no, const char* buf) const {
+    if (!page_handle.is_pax()) {
+        memcpy(page_handle.get_slot(slot_no), buf, file_hdr_.record_size);
+        return;
+    }
+    for (const RmVarCol& col : var_cols_) {
+        memcpy(page_handle.get_field(col, slot_no), buf + col.offset, col.len);
+    }
+}
+
 /**
  * @description: 更新记录文件中记录号为rid的记录
  * @param {Rid&} rid 要更新的记录的记录号（位置）
@@ -122,14 +402,388 @@ void RmFileHandle::update_record(const Rid& rid, char* buf, Context* context) {
         context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_);
     }
 
+    // 先扩大页面的范围再写入记录，扫描看到新的值时范围一定已经包含它
+    update_zone_map(rid.page_no, buf);
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    if (!page_handle.is_slotted()) {
+        write_slot(page_handle, rid.slot_no, buf);
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+        return;
+    }
 
-    char* slot = page_handle.get_slot(rid.slot_no);
-    memcpy(slot, buf, file_hdr_.record_size);
+    // slotted格式：新记录在原位置放不下时，把记录移到其他页面，原位置改为指向新位置的FORWARD记录，rid保持不变。
+    // 记录已经被移走时，先尝试在其当前所在的位置更新。任何时候最多只持有一个页面的latch
+    load_free_space_map();
+    char stored[PAGE_SIZE];
+    int len = encode_stored_record(buf, stored);
+    Rid moved_to = rid;
+    bool updated;
+    {
+        std::scoped_lock lock{get_page_latch(rid.page_no)};
+        RmSlottedPage slotted_page = page_handle.get_slotted_page();
+        int old_len;
+        char* old = slotted_page.get_record(rid.slot_no, &old_len);
+        if (old == nullptr || old[0] == RM_RECORD_MOVED) {
+            buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            throw RecordNotFoundError(rid.page_no, rid.slot_no);
+        }
+        if (old[0] == RM_RECORD_FORWARD) {
+            memcpy(&moved_to, old + 1, sizeof(Rid));
+            updated = false;
+        } else {
+            updated = slotted_page.update(rid.slot_no, stored, len);
+            free_space_map_.set_free_space(rid.page_no, page_handle.get_free_space());
+        }
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), updated);
+    if (updated) {
+        return;
+    }
 
+    // 移走的记录依次存放RM_RECORD_MOVED、原来的rid和编码后的记录
+    char moved[PAGE_SIZE];
+    moved[0] = RM_RECORD_MOVED;
+    memcpy(moved + 1, &rid, sizeof(Rid));
+    memcpy(moved + 1 + sizeof(Rid), stored + 1, len - 1);
+    int moved_len = len + sizeof(Rid);
+    if (moved_to != rid) {
+        RmPageHandle moved_handle = fetch_page_handle(moved_to.page_no);
+        {
+            std::scoped_lock lock{get_page_latch(moved_to.page_no)};
+            updated = moved_handle.get_slotted_page().update(moved_to.slot_no, moved, moved_len);
+            free_space_map_.set_free_space(moved_to.page_no, moved_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(moved_handle.page->get_page_id(), updated);
+        if (updated) {
+            return;
+        }
+        erase_stored_record(moved_to);
+    }
+
+    Rid new_moved_to = insert_stored_record(moved, moved_len, nullptr);
+    char forward[RM_MIN_STORED_SIZE];
+    forward[0] = RM_RECORD_FORWARD;
+    memcpy(forward + 1, &new_moved_to, sizeof(Rid));
+    page_handle = fetch_page_handle(rid.page_no);
+    {
+        std::scoped_lock lock{get_page_latch(rid.page_no)};
+        page_handle.get_slotted_page().update(rid.slot_no, forward, sizeof(forward));
+        free_space_map_.set_free_space(rid.page_no, page_handle.get_free_space());
+    }
     buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
 }
 
+/**
+ * @description: 整理数据文件：从最后一个页面开始，把记录依次移到前面页面的空闲空间中。调用者需持有表级写锁。
+ * slotted格式下移到其他页面的记录尽量放回原位置，其rid不变；其他被移动的记录的rid会改变，调用者根据moves更新索引，
+ * 之后再调用truncate_empty_pages写回页面并截掉文件末尾的空页面。整理不写日志，移动只在缓冲池中进行
+ * @param {vector<pair<Rid, Rid>>*} moves 依次追加每条被移动的记录原来的rid和新的rid
+ */
+void RmFileHandle::compact(std::vector<std::pair<Rid, Rid>>* moves) {
+    load_free_space_map();
+    load_zone_map();
+    bool slotted = file_hdr_.layout == RM_LAYOUT_SLOTTED;
+    size_t first_move = moves->size();
+    int lo = RM_FIRST_RECORD_PAGE;
+    for (int hi = file_hdr_.num_pages - 1; hi > lo; hi--) {
+        // 前面的页面放不下hi中的某条记录时，hi之前的页面已经足够紧密，停止整理
+        if (!(slotted ? compact_slotted_page(hi, &lo, moves) : compact_page(hi, &lo, moves))) {
+            break;
+        }
+    }
+
+    // slotted格式下先移到前面某个页面的记录可能随该页面再次被移动，只保留每条记录最初和最终的位置。
+    // 记录只会移到更靠前的页面，被移走的位置不会再被其他记录占用
+    auto rid_key = [](const Rid& rid) { return (static_cast<int64_t>(rid.page_no) << 32) | (uint32_t)rid.slot_no; };
+    std::unordered_map<int64_t, size_t> moved_to;
+    size_t num_moves = first_move;
+    for (size_t i = first_move; i < moves->size(); i++) {
+        auto [from, to] = (*moves)[i];
+        auto it = moved_to.find(rid_key(from));
+        if (it != moved_to.end()) {
+            size_t idx = it->second;
+            moved_to.erase(it);
+            (*moves)[idx].second = to;
+            moved_to[rid_key(to)] = idx;
+        } else {
+            moved_to[rid_key(to)] = num_moves;
+            (*moves)[num_moves++] = {from, to};
+        }
+    }
+    moves->resize(num_moves);
+}
+
+/**
+ * @description: 写回所有页面，再截掉文件末尾的空页面，使文件大小与现存的记录数量相当。调用者需持有表级写锁
+ * @return {int} 截掉的页面个数
+ */
+int RmFileHandle::truncate_empty_pages() {
+    load_free_space_map();
+    load_zone_map();
+    int num_pages = file_hdr_.num_pages;
+    while (num_pages > RM_FIRST_RECORD_PAGE) {
+        RmPageHandle page_handle = fetch_page_handle(num_pages - 1);
+        bool empty = page_handle.page_hdr->num_records == 0;
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        if (!empty) {
+            break;
+        }
+        num_pages--;
+    }
+    // 记录移动后原来的范围不再准确，按整理后的页面重建
+    rebuild_zone_map(num_pages);
+
+    // 先写回所有页面，被截掉的页面从缓冲池中删除时不再写回，之后才能截断文件
+    buffer_pool_manager_->wait_for_prefetch();
+    buffer_pool_manager_->flush_all_pages(fd_);
+    int num_truncated = file_hdr_.num_pages - num_pages;
+    if (num_truncated == 0) {
+        return 0;
+    }
+    for (int page_no = num_pages; page_no < file_hdr_.num_pages; page_no++) {
+        buffer_pool_manager_->delete_page(PageId{fd_, page_no});
+    }
+    disk_manager_->truncate_file(fd_, num_pages);
+    {
+        std::scoped_lock lock{file_latch_};
+        file_hdr_.num_pages = num_pages;
+    }
+    disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char*)&file_hdr_, sizeof(file_hdr_));
+
+    std::vector<int> free_space(num_pages);
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        free_space[page_no] = free_space_map_.get_free_space(page_no);
+    }
+    free_space_map_.reset(num_pages);
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        free_space_map_.set_free_space(page_no, free_space[page_no]);
+    }
+    for (auto& hint : insert_hints_) {
+        hint.store(RM_NO_PAGE, std::memory_order_relaxed);
+    }
+    return num_truncated;
+}
+
+/**
+ * @description: 把记录存放到[*lo, hi)中第一个空闲空间足够的页面，*lo随之跳过已经放不下任何记录的页面
+ * @return {Rid} 记录存放的位置，没有空闲空间足够的页面时返回page_no为RM_NO_PAGE的Rid
+ * @param {char*} stored 页面中存放的形式的记录
+ * @param {int} len stored的长度
+ * @param {int*} lo 查找的起始页面
+ * @param {int} hi 查找的结束页面（不包括）
+ */
+Rid RmFileHandle::place_stored_record(const char* stored, int len, int* lo, int hi) {
+    bool slotted = file_hdr_.layout == RM_LAYOUT_SLOTTED;
+    int min_free_space = slotted ? len + (int)sizeof(RmSlot) : 1;
+    int full_free_space = slotted ? RM_MIN_STORED_SIZE + (int)sizeof(RmSlot) : 1;
+    while (*lo < hi && free_space_map_.get_free_space(*lo) < full_free_space) {
+        (*lo)++;
+    }
+    for (int page_no = *lo; page_no < hi; page_no++) {
+        if (free_space_map_.get_free_space(page_no) < min_free_space) {
+            continue;
+        }
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        int slot_no = -1;
+        {
+            std::scoped_lock lock{get_page_latch(page_no)};
+            if (slotted) {
+                RmSlottedPage slotted_page = page_handle.get_slotted_page();
+                slot_no = slotted_page.find_free_slot(len);
+                if (slot_no != -1) {
+                    slotted_page.insert(slot_no, stored, len);
+                }
+            } else {
+                slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
+                Bitmap::set(page_handle.bitmap, slot_no);
+                write_slot(page_handle, slot_no, stored);
+                page_handle.page_hdr->num_records++;
+            }
+            free_space_map_.set_free_space(page_no, page_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), slot_no != -1);
+        if (slot_no != -1) {
+            return Rid{page_no, slot_no};
+        }
+    }
+    return Rid{RM_NO_PAGE, -1};
+}
+
+/**
+ * @description: 把定长格式页面中的所有记录移到前面的页面
+ * @return {bool} 页面是否已被清空
+ * @param {int} page_no 被清空的页面
+ * @param {int*} lo 前面的页面中第一个可能有空闲slot的页面
+ * @param {vector<pair<Rid, Rid>>*} moves 依次追加每条被移动的记录原来的rid和新的rid
+ */
+bool RmFileHandle::compact_page(int page_no, int* lo, std::vector<std::pair<Rid, Rid>>* moves) {
+    RmPageHandle page_handle = fetch_page_handle(page_no);
+    bool dirty = false;
+    bool emptied = true;
+    std::vector<char> record(file_hdr_.record_size);
+    for (int slot_no = page_handle.next_record(-1); slot_no != -1; slot_no = page_handle.next_record(slot_no)) {
+        read_slot(page_handle, slot_no, record.data());
+        Rid new_rid = place_stored_record(record.data(), file_hdr_.record_size, lo, page_no);
+        if (new_rid.page_no == RM_NO_PAGE) {
+            emptied = false;
+            break;
+        }
+        {
+            std::scoped_lock lock{get_page_latch(page_no)};
+            Bitmap::reset(page_handle.bitmap, slot_no);
+            page_handle.page_hdr->num_records--;
+            free_space_map_.set_free_space(page_no, page_handle.get_free_space());
+        }
+        moves->emplace_back(Rid{page_no, slot_no}, new_rid);
+        dirty = true;
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), dirty);
+    return emptied;
+}
+
+/**
+ * @description: 把slotted页面中的所有记录移到前面的页面。rid在本页面的记录（包括FORWARD记录）被重新插入，rid改变；
+ * 从前面的页面移来的MOVED记录优先放回其原位置，放不下时移到前面的其他页面并修改原位置的FORWARD记录，rid不变
+ * @return {bool} 页面是否已被清空
+ * @param {int} page_no 被清空的页面
+ * @param {int*} lo 前面的页面中第一个可能有空闲空间的页面
+ * @param {vector<pair<Rid, Rid>>*} moves 依次追加每条rid改变的记录原来的rid和新的rid
+ */
+bool RmFileHandle::compact_slotted_page(int page_no, int* lo, std::vector<std::pair<Rid, Rid>>* moves) {
+    RmPageHandle page_handle = fetch_page_handle(page_no);
+    int num_slots = page_handle.get_slotted_page().get_num_slots();
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+
+    char stored[PAGE_SIZE];
+    char moved[PAGE_SIZE];
+    for (int slot_no = 0; slot_no < num_slots; slot_no++) {
+        Rid rid{page_no, slot_no};
+        Rid home = rid;
+        int moved_len = 0;
+        page_handle = fetch_page_handle(page_no);
+        {
+            std::scoped_lock lock{get_page_latch(page_no)};
+            char* old = page_handle.get_slotted_page().get_record(slot_no, &moved_len);
+            if (old != nullptr && old[0] == RM_RECORD_MOVED) {
+                memcpy(&home, old + 1, sizeof(Rid));
+                memcpy(moved, old, moved_len);
+            } else if (old == nullptr) {
+                home = Rid{RM_NO_PAGE, -1};
+            }
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+
+        if (home == rid) {
+            // 本页面的NORMAL或FORWARD记录：先在前面的页面插入一份，再删除原记录及其移动后的位置
+            auto record = get_record(rid, nullptr);
+            int len = encode_stored_record(record->data, stored);
+            Rid new_rid = place_stored_record(stored, len, lo, page_no);
+            if (new_rid.page_no == RM_NO_PAGE) {
+                return false;
+            }
+            delete_record(rid, nullptr);
+            moves->emplace_back(rid, new_rid);
+            continue;
+        }
+        // 空slot，或原位置在本页面的MOVED记录：后者在处理其FORWARD记录时被一起删除
+        if (home.page_no == RM_NO_PAGE || home.page_no == page_no) {
+            continue;
+        }
+
+        stored[0] = RM_RECORD_NORMAL;
+        int len = moved_len - sizeof(Rid);
+        memcpy(stored + 1, moved + 1 + sizeof(Rid), len - 1);
+        RmPageHandle home_handle = fetch_page_handle(home.page_no);
+        bool updated;
+        {
+            std::scoped_lock lock{get_page_latch(home.page_no)};
+            updated = home_handle.get_slotted_page().update(home.slot_no, stored, len);
+            free_space_map_.set_free_space(home.page_no, home_handle.get_free_space());
+        }
+        buffer_pool_manager_->unpin_page(home_handle.page->get_page_id(), updated);
+        if (!updated) {
+            Rid new_moved_to = place_stored_record(moved, moved_len, lo, page_no);
+            if (new_moved_to.page_no == RM_NO_PAGE) {
+                return false;
+            }
+            char forward[RM_MIN_STORED_SIZE];
+            forward[0] = RM_RECORD_FORWARD;
+            memcpy(forward + 1, &new_moved_to, sizeof(Rid));
+            home_handle = fetch_page_handle(home.page_no);
+            {
+                std::scoped_lock lock{get_page_latch(home.page_no)};
+                home_handle.get_slotted_page().update(home.slot_no, forward, sizeof(forward));
+                free_space_map_.set_free_space(home.page_no, home_handle.get_free_space());
+            }
+            buffer_pool_manager_->unpin_page(home_handle.page->get_page_id(), true);
+        }
+        erase_stored_record(rid);
+    }
+    return true;
+}
+
+/**
+ * @description: 生成记录在slotted页面中原位置存放的形式：RM_RECORD_NORMAL加上编码后的记录，不足RM_MIN_STORED_SIZE时补0
+ * @return {int} 存放的长度
+ * @param {char*} buf 定长记录
+ * @param {char*} stored 存放的形式
+ */
+int RmFileHandle::encode_stored_record(const char* buf, char* stored) const {
+    stored[0] = RM_RECORD_NORMAL;
+    int len = 1 + encode_record(buf, stored + 1);
+    if (len < RM_MIN_STORED_SIZE) {
+        memset(stored + len, 0, RM_MIN_STORED_SIZE - len);
+        len = RM_MIN_STORED_SIZE;
+    }
+    return len;
+}
+
+/**
+ * @description: 将内存中的定长记录编码为slotted页面中存放的形式：定长字段原样复制，
+ * 变长字段去掉末尾填充的'\0'，以2字节的长度加实际内容存放
+ * @return {int} 编码后的长度，不超过record_size + 2 * num_var_cols
+ * @param {char*} buf 定长记录
+ * @param {char*} out 编码结果
+ */
+int RmFileHandle::encode_record(const char* buf, char* out) const {
+    int pos = 0;
+    int out_len = 0;
+    for (const RmVarCol& col : var_cols_) {
+        memcpy(out + out_len, buf + pos, col.offset - pos);
+        out_len += col.offset - pos;
+        uint16_t len = col.len;
+        while (len > 0 && buf[col.offset + len - 1] == '\0') {
+            len--;
+        }
+        memcpy(out + out_len, &len, sizeof(len));
+        memcpy(out + out_len + sizeof(len), buf + col.offset, len);
+        out_len += sizeof(len) + len;
+        pos = col.offset + col.len;
+    }
+    memcpy(out + out_len, buf + pos, file_hdr_.record_size - pos);
+    return out_len + file_hdr_.record_size - pos;
+}
+
+/**
+ * @description: encode_record的逆过程，变长字段的其余部分填充'\0'
+ * @param {char*} stored 编码后的记录
+ * @param {char*} buf 还原出的定长记录，长度为record_size
+ */
+void RmFileHandle::decode_record(const char* stored, char* buf) const {
+    int pos = 0;
+    for (const RmVarCol& col : var_cols_) {
+        memcpy(buf + pos, stored, col.offset - pos);
+        stored += col.offset - pos;
+        uint16_t len;
+        memcpy(&len, stored, sizeof(len));
+        memcpy(buf + col.offset, stored + sizeof(len), len);
+        memset(buf + col.offset + len, 0, col.len - len);
+        stored += sizeof(len) + len;
+        pos = col.offset + col.len;
+    }
+    memcpy(buf + pos, stored, file_hdr_.record_size - pos);
+}
+
 /**
  * 以下函数为辅助函数，仅提供参考，可以选择完成如下函数，也可以删除如下函数，在单元测试中不涉及如下函数接口的直接调用
  */
@@ -151,7 +805,7 @@ RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
 }
 
 /**
- * @description: 创建一个新的page handle
+ * @description: 创建一个新的page handle，新页面在空闲空间映射中处于被占用状态，使用者需调用free_space_map_.release_page释放
  * @return {RmPageHandle} 新的PageHandle
  */
 RmPageHandle RmFileHandle::create_new_page_handle() {
@@ -160,46 +814,194 @@ RmPageHandle RmFileHandle::create_new_page_handle() {
     // 2.更新page handle中的相关信息
     // 3.更新file_hdr_
 
-    Page* page = buffer_pool_manager_->new_page(new PageId{fd_, INVALID_PAGE_ID});
+    PageId page_id{fd_, INVALID_PAGE_ID};
+    Page* page = buffer_pool_manager_->new_page(&page_id);
 
     RmPageHandle page_handle = RmPageHandle(&file_hdr_, page);
-    page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
-    page_handle.page_hdr->num_records = 0;
-
-    file_hdr_.first_free_page_no = page->get_page_id().page_no;
-    file_hdr_.num_pages++;
+    if (page_handle.is_slotted()) {
+        page_handle.get_slotted_page().init();
+    } else {
+        page_handle.page_hdr->next_free_page_no = RM_NO_PAGE;
+        page_handle.page_hdr->num_records = 0;
+    }
+    free_space_map_.acquire_new_page(page_id.page_no);
 
+    std::scoped_lock lock{file_latch_};
+    file_hdr_.num_pages = std::max(file_hdr_.num_pages, page_id.page_no + 1);
     return page_handle;
 }
 
 /**
- * @brief 创建或获取一个空闲的page handle
+ * @brief 从空闲空间映射中占用一个空闲空间足够的页面，没有这样的页面时创建新页面
  *
+ * @param min_free_space 需要的空闲空间
+ * @param hint 优先使用的页面
  * @return RmPageHandle 返回生成的空闲page handle
- * @note pin the page, remember to unpin it outside!
+ * @note pin the page, remember to unpin it outside! 页面同时在空闲空间映射中被占用，需要调用release_page释放
  */
-RmPageHandle RmFileHandle::create_page_handle() {
-    // Todo:
-    // 1. 判断file_hdr_中是否还有空闲页
-    //     1.1 没有空闲页：使用缓冲池来创建一个新page；可直接调用create_new_page_handle()
-    //     1.2 有空闲页：直接获取第一个空闲页
-    // 2. 生成page handle并返回给上层
-
-    if (file_hdr_.first_free_page_no == -1) {
+RmPageHandle RmFileHandle::create_page_handle(int min_free_space, int hint) {
+    int page_no = free_space_map_.acquire_page(min_free_space, hint);
+    if (page_no == RM_NO_PAGE) {
         return create_new_page_handle();
-    } else {
-        return fetch_page_handle(file_hdr_.first_free_page_no);
     }
+    return fetch_page_handle(page_no);
 }
 
 /**
- * @description: 当一个页面从没有空闲空间的状态变为有空闲空间状态时，更新文件头和页头中空闲页面相关的元数据
+ * @description: 获取页面的空闲空间
+ * @return {int} 空闲空间映射中记录的空闲空间，定长格式为空闲slot个数，slotted格式为空闲字节数
+ * @param {int} page_no 页面号
  */
-void RmFileHandle::release_page_handle(RmPageHandle& page_handle) {
-    // Todo:
-    // 当page从已满变成未满，考虑如何更新：
-    // 1. page_handle.page_hdr->next_free_page_no
-    // 2. file_hdr_.first_free_page_no
-    page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
-    file_hdr_.first_free_page_no = page_handle.page->get_page_id().page_no;
+int RmFileHandle::get_free_space(int page_no) {
+    load_free_space_map();
+    return free_space_map_.get_free_space(page_no);
+}
+
+/**
+ * @description: 第一次插入或删除记录时加载空闲空间映射：优先读取上一次关闭文件时保存的映射，
+ * 保存的映射不存在或与文件不一致（如系统崩溃后）时扫描所有页面的页头重建。
+ * 加载后删除保存的映射，此后映射只在内存中维护，直到下一次正常关闭文件
+ */
+void RmFileHandle::load_free_space_map() {
+    if (fsm_loaded_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::call_once(fsm_once_, [this]() {
+        if (!free_space_map_.load(fsm_path_, file_hdr_.num_pages)) {
+            free_space_map_.reset(file_hdr_.num_pages);
+            for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr_.num_pages; page_no++) {
+                prefetch_rebuild_batch(page_no);
+                RmPageHandle page_handle = fetch_page_handle(page_no);
+                free_space_map_.set_free_space(page_no, page_handle.get_free_space());
+                buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            }
+        }
+        if (disk_manager_->is_file(fsm_path_)) {
+            disk_manager_->destroy_file(fsm_path_);
+        }
+        fsm_loaded_.store(true, std::memory_order_release);
+    });
+}
+
+/**
+ * @description: 关闭文件时保存空闲空间映射，下一次打开文件后无需重新扫描所有页面。映射未加载过时保存的映射仍然有效，无需重写
+ */
+void RmFileHandle::save_free_space_map() const {
+    if (fsm_loaded_.load(std::memory_order_acquire)) {
+        free_space_map_.save(fsm_path_);
+    }
+}
+
+/**
+ * @description: 重建空闲空间映射或zone map时按顺序读取所有页面，每批的第一个页面处预读整批页面
+ * @param {int} page_no 即将读取的页面号
+ */
+void RmFileHandle::prefetch_rebuild_batch(int page_no) const {
+    if ((page_no - RM_FIRST_RECORD_PAGE) % RM_FSM_REBUILD_BATCH != 0) {
+        return;
+    }
+    std::vector<page_id_t> page_nos;
+    for (int i = page_no; i < std::min(page_no + RM_FSM_REBUILD_BATCH, file_hdr_.num_pages); i++) {
+        page_nos.push_back(i);
+    }
+    buffer_pool_manager_->prefetch_pages(fd_, page_nos);
+}
+
+/**
+ * @description: 判断page_no页上是否可能有满足所有谓词的记录，顺序扫描据此跳过整个页面
+ * @return {bool} 为false时页面上一定没有满足条件的记录；表没有建立zone map时总是返回true
+ * @param {int} page_no 页面号
+ * @param {vector<RmZonePredicate>&} preds 扫描条件中字段与常量比较的谓词
+ */
+bool RmFileHandle::page_may_match(int page_no, const std::vector<RmZonePredicate>& preds) const {
+    if (zone_map_.empty() || preds.empty()) {
+        return true;
+    }
+    load_zone_map();
+    return zone_map_.may_match(page_no, preds);
+}
+
+/**
+ * @description: 第一次使用zone map时加载：与空闲空间映射相同，优先读取上一次关闭文件时保存的zone map，
+ * 不存在或与文件不一致时扫描所有页面重建。加载后删除保存的文件，系统崩溃后不会读到过期的范围
+ */
+void RmFileHandle::load_zone_map() const {
+    if (zone_map_.empty() || zone_map_loaded_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::call_once(zone_map_once_, [this]() {
+        if (!zone_map_.load(zone_map_path_, file_hdr_.num_pages)) {
+            rebuild_zone_map(file_hdr_.num_pages);
+        }
+        if (disk_manager_->is_file(zone_map_path_)) {
+            disk_manager_->destroy_file(zone_map_path_);
+        }
+        zone_map_loaded_.store(true, std::memory_order_release);
+    });
+}
+
+/**
+ * @description: 扫描前num_pages个页面中的所有记录重建zone map。slotted格式下从其他页面移来的记录计入其原来的rid所在的页面
+ * @param {int} num_pages 需要扫描的页面个数
+ */
+void RmFileHandle::rebuild_zone_map(int num_pages) const {
+    if (zone_map_.empty()) {
+        return;
+    }
+    zone_map_.reset(num_pages);
+    std::vector<char> record(file_hdr_.record_size);
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < num_pages; page_no++) {
+        prefetch_rebuild_batch(page_no);
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        {
+            std::scoped_lock lock{get_page_latch(page_no)};
+            if (!page_handle.is_slotted()) {
+                Bitmap::for_each_set_bit(page_handle.bitmap, file_hdr_.num_records_per_page, [&](int slot_no) {
+                    read_slot(page_handle, slot_no, record.data());
+                    zone_map_.update(page_no, record.data());
+                });
+            } else {
+                RmSlottedPage slotted_page = page_handle.get_slotted_page();
+                for (int slot_no = 0; slot_no < slotted_page.get_num_slots(); slot_no++) {
+                    int len;
+                    char* stored = slotted_page.get_record(slot_no, &len);
+                    if (stored == nullptr || stored[0] == RM_RECORD_FORWARD) {
+                        continue;
+                    }
+                    if (stored[0] == RM_RECORD_NORMAL) {
+                        decode_record(stored + 1, record.data());
+                        zone_map_.update(page_no, record.data());
+                    } else {
+                        Rid home;
+                        memcpy(&home, stored + 1, sizeof(Rid));
+                        decode_record(stored + 1 + sizeof(Rid), record.data());
+                        zone_map_.update(home.page_no, record.data());
+                    }
+                }
+            }
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+}
+
+/**
+ * @description: 记录插入或更新时扩大其rid所在页面的范围
+ * @param {int} page_no 记录的rid所在的页面
+ * @param {char*} record 定长记录
+ */
+void RmFileHandle::update_zone_map(int page_no, const char* record) {
+    if (zone_map_.empty()) {
+        return;
+    }
+    load_zone_map();
+    zone_map_.update(page_no, record);
+}
+
+/**
+ * @description: 关闭文件时保存zone map，zone map未加载过时保存的文件仍然有效，无需重写
+ */
+void RmFileHandle::save_zone_map() const {
+    if (zone_map_loaded_.load(std::memory_order_acquire)) {
+        zone_map_.save(zone_map_path_);
+    }
 }
\ No newline at end of file
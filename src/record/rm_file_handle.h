@@ -12,11 +12,16 @@ See the Mulan PSL v2 for more details. */
 
 #include <assert.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 #include "bitmap.h"
 #include "common/context.h"
 #include "rm_defs.h"
+#include "rm_free_space_map.h"
+#include "rm_slotted_page.h"
+#include "rm_zone_map.h"
 
 class RmManager;
 
@@ -27,6 +32,8 @@ struct RmPageHandle {
     RmPageHdr *page_hdr;        // page->data的第一部分，存储页面元信息，指针指向首地址，长度为sizeof(RmPageHdr)
     char *bitmap;               // page->data的第二部分，存储页面的bitmap，指针指向首地址，长度为file_hdr->bitmap_size
     char *slots;                // page->data的第三部分，存储表的记录，指针指向首地址，每个slot的长度为file_hdr->record_size
+                                // slotted格式下bitmap和slots无意义，页面数据通过RmSlottedPage访问
+                                // PAX格式下slots依次存放每个字段的minipage，通过get_field访问
 
     RmPageHandle(const RmFileHdr *fhdr_, Page *page_) : file_hdr(fhdr_), page(page_) {
         page_hdr = reinterpret_cast<RmPageHdr *>(page->get_data() + page->OFFSET_PAGE_HDR);
@@ -38,11 +45,92 @@ struct RmPageHandle {
     char* get_slot(int slot_no) const {
         return slots + slot_no * file_hdr->record_size;  // slots的首地址 + slot个数 * 每个slot的大小(每个record的大小)
     }
+
+    bool is_slotted() const { return file_hdr->layout == RM_LAYOUT_SLOTTED; }
+
+    bool is_pax() const { return file_hdr->layout == RM_LAYOUT_PAX; }
+
+    // PAX格式下slot_no上的记录的col字段的地址，同一字段的值在其minipage中连续存放
+    char* get_field(const RmVarCol &col, int slot_no) const {
+        return slots + col.offset * file_hdr->num_records_per_page + slot_no * col.len;
+    }
+
+    RmSlottedPage get_slotted_page() const { return RmSlottedPage(page->get_data()); }
+
+    int get_free_space() const;
+
+    bool has_record(int slot_no) const;
+
+    int next_record(int slot_no) const;
+};
+
+/**
+ * @description: 记录的只读视图，get()返回的RmRecord直接指向缓冲池中页面的slot，视图存在期间页面保持pin，
+ * 不拷贝记录。slotted格式的记录在页面中经过编码，视图持有一份解码后的拷贝。
+ * 记录需要在视图销毁后继续使用时调用to_record拷贝
+ */
+class RmRecordView {
+   public:
+    RmRecordView() { reset(); }
+
+    RmRecordView(BufferPoolManager *bpm, Page *page, char *data, int size) : bpm_(bpm), page_(page) {
+        record_.data = data;
+        record_.size = size;
+    }
+
+    explicit RmRecordView(std::unique_ptr<RmRecord> record) : owned_(std::move(record)) {
+        record_.data = owned_->data;
+        record_.size = owned_->size;
+    }
+
+    RmRecordView(const RmRecordView &) = delete;
+    RmRecordView &operator=(const RmRecordView &) = delete;
+
+    RmRecordView(RmRecordView &&other) noexcept { *this = std::move(other); }
+
+    RmRecordView &operator=(RmRecordView &&other) noexcept {
+        if (this != &other) {
+            reset();
+            std::swap(bpm_, other.bpm_);
+            std::swap(page_, other.page_);
+            std::swap(owned_, other.owned_);
+            std::swap(record_.data, other.record_.data);
+            std::swap(record_.size, other.record_.size);
+        }
+        return *this;
+    }
+
+    ~RmRecordView() { reset(); }
+
+    bool is_valid() const { return record_.data != nullptr; }
+
+    const RmRecord *get() const { return &record_; }
+
+    std::unique_ptr<RmRecord> to_record() const { return std::make_unique<RmRecord>(record_.size, record_.data); }
+
+    // 释放视图，unpin其指向的页面
+    void reset() {
+        if (page_ != nullptr) {
+            bpm_->unpin_page(page_->get_page_id(), false);
+        }
+        bpm_ = nullptr;
+        page_ = nullptr;
+        owned_.reset();
+        record_.data = nullptr;
+        record_.size = 0;
+    }
+
+   private:
+    BufferPoolManager *bpm_ = nullptr;
+    Page *page_ = nullptr;                  // 视图pin住的页面，为nullptr时不持有pin
+    std::unique_ptr<RmRecord> owned_;       // slotted格式下解码后的记录
+    RmRecord record_;                       // 不拥有数据，指向页面或owned_
 };
 
 /* 每个RmFileHandle对应一个表的数据文件，里面有多个page，每个page的数据封装在RmPageHandle中 */
 class RmFileHandle {      
     friend class RmScan;    
+    friend class RmBatchScan;
     friend class RmManager;
 
    private:
@@ -50,9 +138,22 @@ class RmFileHandle {
     BufferPoolManager *buffer_pool_manager_;
     int fd_;        // 打开文件后产生的文件句柄
     RmFileHdr file_hdr_;    // 文件头，维护当前表文件的元数据
+    std::string fsm_path_;  // 关闭文件时保存空闲空间映射的文件
+    std::vector<RmVarCol> var_cols_;    // slotted格式下按偏移量排列的变长字段，PAX格式下为所有字段
+    RmFreeSpaceMap free_space_map_;     // 每个页面的空闲空间，第一次插入或删除记录时加载
+    std::once_flag fsm_once_;
+    std::atomic<bool> fsm_loaded_{false};
+    std::atomic<int> insert_hints_[RM_INSERT_PARTITIONS];  // 每个插入分区上一次插入的页面
+    mutable std::mutex page_latches_[RM_PAGE_LATCH_STRIPES];    // 保护页面的bitmap、页头和slotted页面中记录的位置
+    std::mutex file_latch_;     // 保护file_hdr_.num_pages的更新
+    std::string zone_map_path_;         // 关闭文件时保存zone map的文件
+    mutable RmZoneMap zone_map_;        // 每个页面上INT和FLOAT字段的范围，第一次使用时加载
+    mutable std::once_flag zone_map_once_;
+    mutable std::atomic<bool> zone_map_loaded_{false};
 
    public:
-    RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
+    RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd,
+                 std::vector<RmZoneCol> zone_cols = {})
         : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
         // 注意：这里从磁盘中读出文件描述符为fd的文件的file_hdr，读到内存中
         // 这里实际就是初始化file_hdr，只不过是从磁盘中读出进行初始化
@@ -60,33 +161,97 @@ class RmFileHandle {
         disk_manager_->read_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
         // disk_manager管理的fd对应的文件中，设置从file_hdr_.num_pages开始分配page_no
         disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages);
+        if (file_hdr_.num_var_cols > 0) {
+            std::vector<char> buf(sizeof(RmFileHdr) + file_hdr_.num_var_cols * sizeof(RmVarCol));
+            disk_manager_->read_page(fd, RM_FILE_HDR_PAGE, buf.data(), buf.size());
+            var_cols_.resize(file_hdr_.num_var_cols);
+            memcpy(var_cols_.data(), buf.data() + sizeof(RmFileHdr), file_hdr_.num_var_cols * sizeof(RmVarCol));
+        }
+        fsm_path_ = disk_manager_->get_file_name(fd) + RM_FSM_FILE_SUFFIX;
+        zone_map_path_ = disk_manager_->get_file_name(fd) + RM_ZONE_MAP_FILE_SUFFIX;
+        zone_map_.init(std::move(zone_cols));
+        for (auto &hint : insert_hints_) {
+            hint.store(RM_NO_PAGE, std::memory_order_relaxed);
+        }
     }
 
     RmFileHdr get_file_hdr() { return file_hdr_; }
     int GetFd() { return fd_; }
 
-    /* 判断指定位置上是否已经存在一条记录，通过Bitmap来判断 */
+    /* 判断指定位置上是否已经存在一条记录，定长格式通过Bitmap来判断，slotted格式通过slot目录判断 */
     bool is_record(const Rid &rid) const {
         RmPageHandle page_handle = fetch_page_handle(rid.page_no);
-        return Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+        bool exists;
+        {
+            std::scoped_lock lock{get_page_latch(rid.page_no)};
+            exists = page_handle.has_record(rid.slot_no);  // page的slot_no位置上是否有record
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        return exists;
     }
 
     std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
 
+    RmRecordView get_record_view(const Rid &rid, Context *context) const;
+
     Rid insert_record(char *buf, Context *context);
 
     void insert_record(const Rid &rid, char *buf);
 
+    void bulk_insert_records(const char *buf, int num_records, std::vector<Rid> *rids);
+
     void delete_record(const Rid &rid, Context *context);
 
     void update_record(const Rid &rid, char *buf, Context *context);
 
+    void compact(std::vector<std::pair<Rid, Rid>> *moves);
+
+    int truncate_empty_pages();
+
     RmPageHandle create_new_page_handle();
 
     RmPageHandle fetch_page_handle(int page_no) const;
 
+    int get_free_space(int page_no);
+
+    void save_free_space_map() const;
+
+    bool page_may_match(int page_no, const std::vector<RmZonePredicate> &preds) const;
+
+    void save_zone_map() const;
+
    private:
-    RmPageHandle create_page_handle();
+    RmPageHandle create_page_handle(int min_free_space, int hint);
+
+    Rid insert_stored_record(const char *stored, int len, Context *context);
+
+    void erase_stored_record(const Rid &rid);
+
+    void read_slot(const RmPageHandle &page_handle, int slot_no, char *buf) const;
+
+    void write_slot(const RmPageHandle &page_handle, int slot_no, const char *buf) const;
+
+    Rid place_stored_record(const char *stored, int len, int *lo, int hi);
+
+    bool compact_page(int page_no, int *lo, std::vector<std::pair<Rid, Rid>> *moves);
+
+    bool compact_slotted_page(int page_no, int *lo, std::vector<std::pair<Rid, Rid>> *moves);
+
+    int encode_stored_record(const char *buf, char *stored) const;
+
+    int encode_record(const char *buf, char *out) const;
+
+    void decode_record(const char *stored, char *buf) const;
+
+    void load_free_space_map();
+
+    void prefetch_rebuild_batch(int page_no) const;
+
+    void load_zone_map() const;
+
+    void rebuild_zone_map(int num_pages) const;
+
+    void update_zone_map(int page_no, const char *record);
 
-    void release_page_handle(RmPageHandle &page_handle);
+    std::mutex &get_page_latch(int page_no) const { return page_latches_[page_no % RM_PAGE_LATCH_STRIPES]; }
 };
\ No newline at end of file
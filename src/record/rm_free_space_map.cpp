@@ -0,0 +1,206 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_free_space_map.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "errors.h"
+#include "rm_defs.h"
+
+/**
+ * @description: 清空映射，文件中有num_pages个页面，所有页面的空闲空间都为0
+ * @param {int} num_pages 页面个数
+ */
+void RmFreeSpaceMap::reset(int num_pages) {
+    std::scoped_lock lock{latch_};
+    num_pages_ = 0;
+    capacity_ = 1;
+    free_space_.clear();
+    claimed_.clear();
+    tree_.assign(2, 0);
+    grow(num_pages);
+}
+
+int RmFreeSpaceMap::get_num_pages() const {
+    std::scoped_lock lock{latch_};
+    return num_pages_;
+}
+
+int RmFreeSpaceMap::get_free_space(int page_no) const {
+    std::scoped_lock lock{latch_};
+    return page_no < num_pages_ ? free_space_[page_no] : 0;
+}
+
+/**
+ * @description: 更新页面的空闲空间，页面号超出当前范围时扩展映射。被占用的页面在释放前仍对插入者不可见
+ * @param {int} page_no 页面号
+ * @param {int} free_space 页面的空闲空间
+ */
+void RmFreeSpaceMap::set_free_space(int page_no, int free_space) {
+    std::scoped_lock lock{latch_};
+    grow(page_no + 1);
+    free_space_[page_no] = static_cast<uint16_t>(free_space);
+    update_leaf(page_no);
+}
+
+/**
+ * @description: 从hint开始向后查找第一个未被占用且空闲空间不少于min_free_space的页面，到达末尾后从头查找，
+ * 找到后将其标记为被占用，直到调用release_page
+ * @return {int} 被占用的页面号，所有页面都没有足够的空闲空间时返回RM_NO_PAGE
+ * @param {int} min_free_space 需要的空闲空间，至少为1
+ * @param {int} hint 优先查找的页面，一般为调用者上一次插入的页面
+ */
+int RmFreeSpaceMap::acquire_page(int min_free_space, int hint) {
+    std::scoped_lock lock{latch_};
+    uint16_t need = static_cast<uint16_t>(std::max(min_free_space, 1));
+    if (tree_[1] < need) {
+        return RM_NO_PAGE;
+    }
+    size_t from = hint > 0 && hint < num_pages_ ? hint : 0;
+    int page_no = find_first(1, 0, capacity_, from, need);
+    if (page_no == -1) {
+        page_no = find_first(1, 0, capacity_, 0, need);
+    }
+    claimed_[page_no] = true;
+    update_leaf(page_no);
+    return page_no;
+}
+
+/**
+ * @description: 登记一个刚分配的页面，页面在调用release_page之前处于被占用状态
+ * @param {int} page_no 新页面的页面号
+ */
+void RmFreeSpaceMap::acquire_new_page(int page_no) {
+    std::scoped_lock lock{latch_};
+    grow(page_no + 1);
+    free_space_[page_no] = 0;
+    claimed_[page_no] = true;
+    update_leaf(page_no);
+}
+
+/**
+ * @description: 释放acquire_page占用的页面，同时更新其空闲空间
+ * @param {int} page_no 页面号
+ * @param {int} free_space 页面当前的空闲空间
+ */
+void RmFreeSpaceMap::release_page(int page_no, int free_space) {
+    std::scoped_lock lock{latch_};
+    free_space_[page_no] = static_cast<uint16_t>(free_space);
+    claimed_[page_no] = false;
+    update_leaf(page_no);
+}
+
+/**
+ * @description: 从文件中读取close时保存的映射。文件不存在、已损坏或页面个数与表文件不一致时返回false
+ * @return {bool} 是否读取成功
+ * @param {string&} path 映射文件的路径
+ * @param {int} num_pages 表文件当前的页面个数
+ */
+bool RmFreeSpaceMap::load(const std::string &path, int num_pages) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    uint32_t magic = 0;
+    int saved_pages = -1;
+    ifs.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    ifs.read(reinterpret_cast<char *>(&saved_pages), sizeof(saved_pages));
+    if (!ifs || magic != FILE_MAGIC || saved_pages != num_pages) {
+        return false;
+    }
+    std::vector<uint16_t> free_space(num_pages);
+    ifs.read(reinterpret_cast<char *>(free_space.data()), num_pages * sizeof(uint16_t));
+    if (!ifs || ifs.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+
+    reset(num_pages);
+    std::scoped_lock lock{latch_};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        free_space_[page_no] = free_space[page_no];
+        tree_[capacity_ + page_no] = free_space[page_no];
+    }
+    for (size_t node = capacity_ - 1; node > 0; node--) {
+        tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+    }
+    return true;
+}
+
+/**
+ * @description: 将映射保存到文件中，下一次打开表文件时无需重新扫描所有页面
+ * @param {string&} path 映射文件的路径
+ */
+void RmFreeSpaceMap::save(const std::string &path) const {
+    std::scoped_lock lock{latch_};
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+    ofs.write(reinterpret_cast<const char *>(&num_pages_), sizeof(num_pages_));
+    ofs.write(reinterpret_cast<const char *>(free_space_.data()), num_pages_ * sizeof(uint16_t));
+    if (!ofs) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 将页面个数扩展到num_pages，叶子不够时容量翻倍并重建线段树，调用者需持有latch_
+ */
+void RmFreeSpaceMap::grow(int num_pages) {
+    if (num_pages <= num_pages_) {
+        return;
+    }
+    free_space_.resize(num_pages, 0);
+    claimed_.resize(num_pages, false);
+    num_pages_ = num_pages;
+    if (static_cast<size_t>(num_pages) <= capacity_) {
+        return;
+    }
+    while (capacity_ < static_cast<size_t>(num_pages)) {
+        capacity_ *= 2;
+    }
+    tree_.assign(2 * capacity_, 0);
+    for (int page_no = 0; page_no < num_pages_; page_no++) {
+        tree_[capacity_ + page_no] = claimed_[page_no] ? 0 : free_space_[page_no];
+    }
+    for (size_t node = capacity_ - 1; node > 0; node--) {
+        tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+    }
+}
+
+/**
+ * @description: 页面的空闲空间或占用状态改变后，更新其叶子及所有祖先结点，调用者需持有latch_
+ */
+void RmFreeSpaceMap::update_leaf(int page_no) {
+    size_t node = capacity_ + page_no;
+    tree_[node] = claimed_[page_no] ? 0 : free_space_[page_no];
+    for (node /= 2; node > 0; node /= 2) {
+        tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+    }
+}
+
+/**
+ * @description: 在结点node（覆盖叶子[lo, hi)）的子树中查找下标不小于from、值不小于min_free_space的第一个叶子
+ * @return {int} 叶子的下标，不存在时返回-1
+ */
+int RmFreeSpaceMap::find_first(size_t node, size_t lo, size_t hi, size_t from, uint16_t min_free_space) const {
+    if (hi <= from || tree_[node] < min_free_space) {
+        return -1;
+    }
+    if (hi - lo == 1) {
+        return static_cast<int>(lo);
+    }
+    size_t mid = (lo + hi) / 2;
+    int found = find_first(2 * node, lo, mid, from, min_free_space);
+    if (found == -1) {
+        found = find_first(2 * node + 1, mid, hi, from, min_free_space);
+    }
+    return found;
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @description: 空闲空间映射，记录表数据文件中每个页面的空闲空间，单位由使用者决定（定长记录为空闲slot个数）。
+ * 空闲空间保存在一棵最大值线段树的叶子中，查找从某个页面开始第一个空闲空间足够的页面只需O(log n)。
+ * 插入者通过acquire_page独占一个页面，被占用的页面在树中视为已满，其他插入者会被分散到其余未满页面上，
+ * 而不是争用同一个页面；删除记录后直接更新对应页面的空闲空间，页面立即可以被再次使用
+ */
+class RmFreeSpaceMap {
+   public:
+    void reset(int num_pages);
+
+    int get_num_pages() const;
+
+    int get_free_space(int page_no) const;
+
+    void set_free_space(int page_no, int free_space);
+
+    int acquire_page(int min_free_space, int hint);
+
+    void acquire_new_page(int page_no);
+
+    void release_page(int page_no, int free_space);
+
+    bool load(const std::string &path, int num_pages);
+
+    void save(const std::string &path) const;
+
+   private:
+    void grow(int num_pages);
+
+    void update_leaf(int page_no);
+
+    int find_first(size_t node, size_t lo, size_t hi, size_t from, uint16_t min_free_space) const;
+
+    static constexpr uint32_t FILE_MAGIC = 0x4d534652;  // "RFSM"
+
+    mutable std::mutex latch_;
+    int num_pages_ = 0;
+    size_t capacity_ = 1;                   // 线段树的叶子个数，为2的幂
+    std::vector<uint16_t> free_space_;      // 每个页面的空闲空间
+    std::vector<bool> claimed_;             // 页面是否正被某个插入者占用
+    std::vector<uint16_t> tree_;            // tree_[capacity_ + i]为第i个页面可被分配的空闲空间，内部结点为子结点的最大值
+};
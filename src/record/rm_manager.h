@@ -26,16 +26,38 @@ class RmManager {
     RmManager(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
         : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager) {}
 
+    /**
+     * @description: 表中记录在内存中的最大长度。slotted格式下记录被移到其他页面后还要存放标志和原来的rid，
+     * 每个变长字段额外存放2字节的长度，这些都要能放进一个空的slotted页面中
+     * @return {int} 记录的最大长度
+     * @param {RmLayout} layout 页面格式
+     * @param {int} num_var_cols 变长字段的个数
+     */
+    static int get_max_record_size(RmLayout layout, int num_var_cols) {
+        if (layout == RM_LAYOUT_SLOTTED) {
+            return RmSlottedPage::MAX_RECORD_SIZE - RM_MIN_STORED_SIZE - num_var_cols * (int)sizeof(uint16_t);
+        }
+        return RM_MAX_RECORD_SIZE;
+    }
+
     /**
      * @description: 创建表的数据文件并初始化相关信息
      * @param {string&} filename 要创建的文件名称
      * @param {int} record_size 表中记录的大小
+     * @param {RmLayout} layout 页面格式
+     * @param {vector<RmVarCol>&} var_cols slotted格式下为变长字段，PAX格式下为所有字段，需按偏移量排列；定长格式下不使用
+     * @param {PageCompression} compression 页面写回磁盘时的压缩方式
      */
-    void create_file(const std::string &filename, int record_size) {
-        if (record_size < 1 || record_size > RM_MAX_RECORD_SIZE) {
+    void create_file(const std::string &filename, int record_size, RmLayout layout = RM_LAYOUT_FIXED,
+                     const std::vector<RmVarCol> &var_cols = {},
+                     PageCompression compression = PAGE_COMPRESSION_NONE) {
+        std::vector<RmVarCol> stored_var_cols = layout != RM_LAYOUT_FIXED ? var_cols : std::vector<RmVarCol>();
+        if (record_size < 1 || record_size > get_max_record_size(layout, stored_var_cols.size())) {
             throw InvalidRecordSizeError(record_size);
         }
-        disk_manager_->create_file(filename);
+        disk_manager_->create_file(filename, compression);
+        // 同名的旧表文件被直接删除时可能残留空闲空间映射和zone map
+        destroy_side_files(filename);
         int fd = disk_manager_->open_file(filename);
 
         // 初始化file header
@@ -43,14 +65,22 @@ class RmManager {
         file_hdr.record_size = record_size;
         file_hdr.num_pages = 1;
         file_hdr.first_free_page_no = RM_NO_PAGE;
-        // We have: sizeof(hdr) + (n + 7) / 8 + n * record_size <= PAGE_SIZE
-        file_hdr.num_records_per_page =
-            (BITMAP_WIDTH * (PAGE_SIZE - 1 - (int)sizeof(RmFileHdr)) + 1) / (1 + record_size * BITMAP_WIDTH);
-        file_hdr.bitmap_size = (file_hdr.num_records_per_page + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        file_hdr.layout = layout;
+        file_hdr.num_var_cols = stored_var_cols.size();
+        if (layout != RM_LAYOUT_SLOTTED) {
+            // We have: sizeof(hdr) + (n + 7) / 8 + n * record_size <= PAGE_SIZE
+            // PAX格式的minipage总长度同样是n * record_size
+            file_hdr.num_records_per_page =
+                (BITMAP_WIDTH * (PAGE_SIZE - 1 - (int)sizeof(RmFileHdr)) + 1) / (1 + record_size * BITMAP_WIDTH);
+            file_hdr.bitmap_size = (file_hdr.num_records_per_page + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        }
 
-        // 将file header写入磁盘文件（名为file name，文件描述符为fd）中的第0页
+        // 将file header及其后的变长字段写入磁盘文件（名为file name，文件描述符为fd）中的第0页
         // head page直接写入磁盘，没有经过缓冲区的NewPage，那么也就不需要FlushPage
-        disk_manager_->write_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
+        std::vector<char> hdr_page(sizeof(file_hdr) + stored_var_cols.size() * sizeof(RmVarCol));
+        memcpy(hdr_page.data(), &file_hdr, sizeof(file_hdr));
+        memcpy(hdr_page.data() + sizeof(file_hdr), stored_var_cols.data(), stored_var_cols.size() * sizeof(RmVarCol));
+        disk_manager_->write_page(fd, RM_FILE_HDR_PAGE, hdr_page.data(), hdr_page.size());
         disk_manager_->close_file(fd);
     }
 
@@ -58,17 +88,21 @@ class RmManager {
      * @description: 删除表的数据文件
      * @param {string&} filename 要删除的文件名称
      */
-    void destroy_file(const std::string &filename) { disk_manager_->destroy_file(filename); }
+    void destroy_file(const std::string &filename) {
+        disk_manager_->destroy_file(filename);
+        destroy_side_files(filename);
+    }
 
     // 注意这里打开文件，创建并返回了record file handle的指针
     /**
      * @description: 打开表的数据文件，并返回文件句柄
      * @param {string&} filename 要打开的文件名称
+     * @param {vector<RmZoneCol>} zone_cols 需要维护zone map的INT和FLOAT字段，为空时不建立zone map
      * @return {unique_ptr<RmFileHandle>} 文件句柄的指针
      */
-    std::unique_ptr<RmFileHandle> open_file(const std::string &filename) {
+    std::unique_ptr<RmFileHandle> open_file(const std::string &filename, std::vector<RmZoneCol> zone_cols = {}) {
         int fd = disk_manager_->open_file(filename);
-        return std::make_unique<RmFileHandle>(disk_manager_, buffer_pool_manager_, fd);
+        return std::make_unique<RmFileHandle>(disk_manager_, buffer_pool_manager_, fd, std::move(zone_cols));
     }
     /**
      * @description: 关闭表的数据文件
@@ -79,6 +113,22 @@ class RmManager {
                                   sizeof(file_handle->file_hdr_));
         // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file前面
         buffer_pool_manager_->flush_all_pages(file_handle->fd_);
+        // 数据页全部写回后再保存空闲空间映射和zone map
+        file_handle->save_free_space_map();
+        file_handle->save_zone_map();
         disk_manager_->close_file(file_handle->fd_);
     }
+
+   private:
+    /**
+     * @description: 删除表文件对应的空闲空间映射和zone map文件
+     * @param {string&} filename 表文件名称
+     */
+    void destroy_side_files(const std::string &filename) {
+        for (auto &suffix : {RM_FSM_FILE_SUFFIX, RM_ZONE_MAP_FILE_SUFFIX}) {
+            if (disk_manager_->is_file(filename + suffix)) {
+                disk_manager_->destroy_file(filename + suffix);
+            }
+        }
+    }
 };
@@ -10,6 +10,8 @@ See the Mulan PSL v2 for more details. */
 
 #include "rm_scan.h"
 
+#include <algorithm>
+
 #include "rm_file_handle.h"
 
 /**
@@ -30,10 +32,16 @@ void RmScan::next() {
     // Todo:
     // 找到文件中下一个存放了记录的非空闲位置，用rid_来指向这个位置
     while (rid_.page_no < file_handle_->file_hdr_.num_pages) {
+        if (rid_.slot_no == -1) {
+            read_ahead(rid_.page_no);
+        }
         RmPageHandle page_handle = file_handle_->fetch_page_handle(rid_.page_no);
-        rid_.slot_no =
-            Bitmap::next_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page, rid_.slot_no);
-        if (rid_.slot_no < file_handle_->file_hdr_.num_records_per_page) {
+        {
+            std::scoped_lock lock{file_handle_->get_page_latch(rid_.page_no)};
+            rid_.slot_no = page_handle.next_record(rid_.slot_no);
+        }
+        file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        if (rid_.slot_no != -1) {
             return;
         }
         rid_.page_no++;
@@ -43,8 +51,39 @@ void RmScan::next() {
 }
 
 /**
- * @brief ​ 判断是否到达文件末尾
+ * @description: RmScan和RmBatchScan共用的顺序预读：按预读窗口的判断异步预读文件中的后续页面
+ * @param {int} num_pages 文件的页面数，预读不超过文件末尾
+ * @param {ReadAheadWindow*} window 扫描持有的预读窗口
+ * @param {int} page_no 即将访问的页号
+ */
+static void read_ahead_pages(BufferPoolManager *bpm, int fd, int num_pages, ReadAheadWindow *window, int page_no) {
+    size_t begin;
+    size_t count = window->on_access(page_no, &begin);
+    if (count == 0) {
+        return;
+    }
+    size_t end = std::min(begin + count, static_cast<size_t>(num_pages));
+    if (end < begin + count) {
+        window->truncate(std::max(begin, end));
+    }
+    std::vector<page_id_t> page_nos;
+    for (size_t i = begin; i < end; i++) {
+        page_nos.push_back(static_cast<page_id_t>(i));
+    }
+    if (!page_nos.empty()) {
+        bpm->prefetch_pages(fd, page_nos);
+    }
+}
+
+/**
+ * @description: 扫描进入page_no页时调用，检测到顺序访问后通过缓冲池异步预读后续页面
+ * @param {int} page_no 即将访问的页号
  */
+void RmScan::read_ahead(int page_no) {
+    read_ahead_pages(file_handle_->buffer_pool_manager_, file_handle_->fd_, file_handle_->file_hdr_.num_pages,
+                     &read_ahead_, page_no);
+}
+
 bool RmScan::is_end() const {
     // Todo: 修改返回值
 
@@ -54,4 +93,119 @@ bool RmScan::is_end() const {
 /**
  * @brief RmScan内部存放的rid
  */
-Rid RmScan::rid() const { return rid_; }
\ No newline at end of file
+Rid RmScan::rid() const { return rid_; }
+
+/**
+ * @param {RmFileHandle*} file_handle 表的数据文件句柄
+ * @param {vector<RmVarCol>} read_cols PAX格式下需要取出的字段，为空时取出所有字段，其他格式下忽略
+ * @param {vector<RmZonePredicate>} preds 扫描条件中字段与常量比较的谓词，用于跳过不可能有满足条件的记录的页面
+ */
+RmBatchScan::RmBatchScan(const RmFileHandle *file_handle, std::vector<RmVarCol> read_cols,
+                         std::vector<RmZonePredicate> preds)
+    : file_handle_(file_handle),
+      page_no_(RM_FIRST_RECORD_PAGE - 1),
+      read_cols_(std::move(read_cols)),
+      preds_(std::move(preds)) {
+    if (read_cols_.empty()) {
+        read_cols_ = file_handle_->var_cols_;
+    }
+}
+
+/**
+ * @description: unpin当前批次的页面，清空批次
+ */
+void RmBatchScan::release() {
+    if (page_ != nullptr) {
+        file_handle_->buffer_pool_manager_->unpin_page(page_->get_page_id(), false);
+        page_ = nullptr;
+    }
+    rids_.clear();
+    records_.clear();
+}
+
+/**
+ * @description: 释放当前批次，移到下一个含有记录的页面并取出其中的所有记录
+ * @return {bool} 是否取到了新的批次，为false时扫描结束
+ */
+bool RmBatchScan::next_batch() {
+    release();
+    if (page_no_ == -1) {
+        return false;
+    }
+    int record_size = file_handle_->file_hdr_.record_size;
+    while (++page_no_ < file_handle_->file_hdr_.num_pages) {
+        if (!file_handle_->page_may_match(page_no_, preds_)) {
+            continue;
+        }
+        read_ahead_pages(file_handle_->buffer_pool_manager_, file_handle_->fd_, file_handle_->file_hdr_.num_pages,
+                         &read_ahead_, page_no_);
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no_);
+        std::vector<std::pair<size_t, Rid>> forwarded;  // 被移到其他页面的记录在批次中的位置和新的Rid
+        {
+            std::scoped_lock lock{file_handle_->get_page_latch(page_no_)};
+            if (page_handle.is_pax()) {
+                Bitmap::for_each_set_bit(page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page,
+                                         [&](int slot_no) { rids_.push_back(Rid{page_no_, slot_no}); });
+                decoded_.resize(rids_.size() * record_size);
+                // 按字段逐个minipage拷贝，没有用到的字段不会被读取
+                for (const RmVarCol &col : read_cols_) {
+                    for (size_t i = 0; i < rids_.size(); i++) {
+                        memcpy(decoded_.data() + i * record_size + col.offset,
+                               page_handle.get_field(col, rids_[i].slot_no), col.len);
+                    }
+                }
+                for (size_t i = 0; i < rids_.size(); i++) {
+                    records_.push_back(decoded_.data() + i * record_size);
+                }
+            } else if (!page_handle.is_slotted()) {
+                Bitmap::for_each_set_bit(page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page,
+                                         [&](int slot_no) {
+                                             rids_.push_back(Rid{page_no_, slot_no});
+                                             records_.push_back(page_handle.get_slot(slot_no));
+                                         });
+            } else {
+                RmSlottedPage slotted_page = page_handle.get_slotted_page();
+                decoded_.resize((size_t)slotted_page.get_num_slots() * record_size);
+                for (int slot_no = 0; slot_no < slotted_page.get_num_slots(); slot_no++) {
+                    int len;
+                    char *stored = slotted_page.get_record(slot_no, &len);
+                    if (stored == nullptr || stored[0] == RM_RECORD_MOVED) {
+                        continue;
+                    }
+                    char *record = decoded_.data() + rids_.size() * record_size;
+                    if (stored[0] == RM_RECORD_FORWARD) {
+                        Rid moved_to;
+                        memcpy(&moved_to, stored + 1, sizeof(Rid));
+                        forwarded.emplace_back(rids_.size(), moved_to);
+                    } else {
+                        file_handle_->decode_record(stored + 1, record);
+                    }
+                    rids_.push_back(Rid{page_no_, slot_no});
+                    records_.push_back(record);
+                }
+            }
+        }
+        if (page_handle.is_slotted() || page_handle.is_pax()) {
+            // slotted和PAX格式的记录已经拷贝到批次中，不需要保持页面的pin
+            file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            for (auto &[idx, moved_to] : forwarded) {
+                RmPageHandle moved_handle = file_handle_->fetch_page_handle(moved_to.page_no);
+                {
+                    std::scoped_lock lock{file_handle_->get_page_latch(moved_to.page_no)};
+                    int len;
+                    char *stored = moved_handle.get_slotted_page().get_record(moved_to.slot_no, &len);
+                    file_handle_->decode_record(stored + 1 + sizeof(Rid), records_[idx]);
+                }
+                file_handle_->buffer_pool_manager_->unpin_page(moved_handle.page->get_page_id(), false);
+            }
+        } else {
+            page_ = page_handle.page;
+        }
+        if (!rids_.empty()) {
+            return true;
+        }
+        release();
+    }
+    page_no_ = -1;
+    return false;
+}
\ No newline at end of file
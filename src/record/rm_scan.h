@@ -10,13 +10,18 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <vector>
+
 #include "rm_defs.h"
+#include "rm_zone_map.h"
+#include "storage/read_ahead.h"
 
 class RmFileHandle;
 
 class RmScan : public RecScan {
     const RmFileHandle *file_handle_;
     Rid rid_;
+    ReadAheadWindow read_ahead_;    // 顺序扫描时预读后续页面
 public:
     RmScan(const RmFileHandle *file_handle);
 
@@ -25,4 +30,52 @@ public:
     bool is_end() const override;
 
     Rid rid() const override;
+
+private:
+    void read_ahead(int page_no);
+};
+
+/**
+ * @description: 按页批量扫描表文件。每个批次pin住一个含有记录的页面，一次取出页面中所有记录的rid和记录指针，
+ * 整个页面只经过一次fetch_page和unpin，并且只加一次页面latch。定长格式下记录指针直接指向页面中的slot，
+ * slotted格式下指向批次内解码后的副本。PAX格式下只从页面中取出read_cols中的字段，逐个minipage拷贝到批次内的副本中，
+ * 副本中其他字段的内容未定义。给出preds时，zone map表明没有记录能满足preds的页面被整页跳过，不会被读取。
+ * 记录指针在调用next_batch之前一直有效
+ */
+class RmBatchScan {
+    const RmFileHandle *file_handle_;
+    int page_no_;                       // 当前批次所在的页号
+    Page *page_ = nullptr;              // 当前批次pin住的页面
+    std::vector<Rid> rids_;             // 当前批次中的记录号
+    std::vector<char *> records_;       // 当前批次中的记录，与rids_一一对应
+    std::vector<char> decoded_;         // slotted格式下解码后的记录，PAX格式下取出的记录
+    std::vector<RmVarCol> read_cols_;   // PAX格式下需要取出的字段
+    std::vector<RmZonePredicate> preds_;    // 用于跳过页面的谓词，页面中的记录仍需由调用者逐条判断
+    ReadAheadWindow read_ahead_;        // 顺序扫描时预读后续页面
+
+   public:
+    explicit RmBatchScan(const RmFileHandle *file_handle, std::vector<RmVarCol> read_cols = {},
+                         std::vector<RmZonePredicate> preds = {});
+
+    RmBatchScan(const RmBatchScan &) = delete;
+    RmBatchScan &operator=(const RmBatchScan &) = delete;
+
+    ~RmBatchScan() { release(); }
+
+    bool next_batch();
+
+    bool is_end() const { return page_no_ == -1; }
+
+    int size() const { return static_cast<int>(rids_.size()); }
+
+    const Rid &rid(int i) const { return rids_[i]; }
+
+    char *record(int i) const { return records_[i]; }
+
+    const std::vector<Rid> &rids() const { return rids_; }
+
+    const std::vector<char *> &records() const { return records_; }
+
+   private:
+    void release();
 };
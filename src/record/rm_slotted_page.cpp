@@ -0,0 +1,159 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_slotted_page.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+/**
+ * @description: 初始化一个空的slotted页面
+ */
+void RmSlottedPage::init() {
+    page_hdr_->next_free_page_no = RM_NO_PAGE;
+    page_hdr_->num_records = 0;
+    hdr_->num_slots = 0;
+    hdr_->data_offset = PAGE_SIZE;
+    hdr_->free_space = PAGE_SIZE - SLOT_DIR_OFFSET;
+    hdr_->reserved = 0;
+}
+
+/**
+ * @description: 获取slot中存放的记录
+ * @return {char*} 记录在页面中的地址，slot为空时返回nullptr
+ * @param {int} slot_no slot号
+ * @param {int*} len 返回记录的长度
+ */
+char *RmSlottedPage::get_record(int slot_no, int *len) const {
+    if (!is_used(slot_no)) {
+        return nullptr;
+    }
+    *len = slots_[slot_no].length;
+    return data_ + slots_[slot_no].offset;
+}
+
+/**
+ * @description: 查找插入长度为len的记录时使用的slot：优先复用第一个空slot，没有空slot时在目录末尾追加
+ * @return {int} slot号，页面空闲空间（包括碎片）不足时返回-1
+ * @param {int} len 记录的长度
+ */
+int RmSlottedPage::find_free_slot(int len) const {
+    for (int slot_no = 0; slot_no < hdr_->num_slots; slot_no++) {
+        if (slots_[slot_no].offset == 0) {
+            return hdr_->free_space >= len ? slot_no : -1;
+        }
+    }
+    return hdr_->free_space >= len + (int)sizeof(RmSlot) ? hdr_->num_slots : -1;
+}
+
+/**
+ * @description: 将记录插入find_free_slot返回的slot中，连续的空闲区域不够时先压缩整理页面
+ * @param {int} slot_no find_free_slot返回的slot号
+ * @param {char*} buf 记录的数据
+ * @param {int} len 记录的长度
+ */
+void RmSlottedPage::insert(int slot_no, const char *buf, int len) {
+    assert(slot_no <= hdr_->num_slots && !is_used(slot_no));
+    if (slot_no == hdr_->num_slots) {
+        if (get_contiguous_space() < (int)sizeof(RmSlot)) {
+            compact();
+        }
+        slots_[slot_no] = RmSlot{0, 0};
+        hdr_->num_slots++;
+        hdr_->free_space -= sizeof(RmSlot);
+    }
+    place(slot_no, buf, len);
+    page_hdr_->num_records++;
+}
+
+/**
+ * @description: 原地更新slot中的记录。新记录不长于旧记录时直接覆盖，否则在本页面中重新存放，必要时压缩整理页面
+ * @return {bool} 是否更新成功，页面空闲空间不足时返回false，此时页面不变
+ * @param {int} slot_no slot号
+ * @param {char*} buf 新记录的数据，不能指向本页面
+ * @param {int} len 新记录的长度
+ */
+bool RmSlottedPage::update(int slot_no, const char *buf, int len) {
+    assert(is_used(slot_no));
+    RmSlot &slot = slots_[slot_no];
+    if (len <= slot.length) {
+        memcpy(data_ + slot.offset, buf, len);
+        hdr_->free_space += slot.length - len;
+        slot.length = len;
+        return true;
+    }
+    if (hdr_->free_space + slot.length < len) {
+        return false;
+    }
+    hdr_->free_space += slot.length;
+    slot = RmSlot{0, 0};
+    place(slot_no, buf, len);
+    return true;
+}
+
+/**
+ * @description: 删除slot中的记录，目录末尾的空slot被回收
+ * @param {int} slot_no slot号
+ */
+void RmSlottedPage::erase(int slot_no) {
+    assert(is_used(slot_no));
+    RmSlot &slot = slots_[slot_no];
+    if (slot.offset == hdr_->data_offset) {
+        hdr_->data_offset += slot.length;
+    }
+    hdr_->free_space += slot.length;
+    slot = RmSlot{0, 0};
+    page_hdr_->num_records--;
+    while (hdr_->num_slots > 0 && slots_[hdr_->num_slots - 1].offset == 0) {
+        hdr_->num_slots--;
+        hdr_->free_space += sizeof(RmSlot);
+    }
+    if (hdr_->num_slots == 0) {
+        hdr_->data_offset = PAGE_SIZE;
+    }
+}
+
+/**
+ * @description: 压缩整理页面：把所有记录紧密地移到页尾，消除记录之间的碎片，slot号不变
+ */
+void RmSlottedPage::compact() {
+    std::vector<int> used;
+    for (int slot_no = 0; slot_no < hdr_->num_slots; slot_no++) {
+        if (slots_[slot_no].offset != 0) {
+            used.push_back(slot_no);
+        }
+    }
+    // 按偏移量从大到小依次后移，每条记录的目标位置都不小于原位置，memmove不会覆盖尚未移动的记录
+    std::sort(used.begin(), used.end(), [&](int a, int b) { return slots_[a].offset > slots_[b].offset; });
+    int offset = PAGE_SIZE;
+    for (int slot_no : used) {
+        RmSlot &slot = slots_[slot_no];
+        offset -= slot.length;
+        memmove(data_ + offset, data_ + slot.offset, slot.length);
+        slot.offset = offset;
+    }
+    hdr_->data_offset = offset;
+    assert(get_contiguous_space() == hdr_->free_space);
+}
+
+/**
+ * @description: 在连续空闲区域的末尾存放记录并设置slot，空间已由调用者检查过，不包括slot目录项本身
+ */
+void RmSlottedPage::place(int slot_no, const char *buf, int len) {
+    if (get_contiguous_space() < len) {
+        compact();
+    }
+    hdr_->data_offset -= len;
+    memcpy(data_ + hdr_->data_offset, buf, len);
+    slots_[slot_no] = RmSlot{hdr_->data_offset, static_cast<uint16_t>(len)};
+    hdr_->free_space -= len;
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+
+#include "rm_defs.h"
+
+/* slotted页面在RmPageHdr之后的页头 */
+struct RmSlottedPageHdr {
+    uint16_t num_slots;     // slot目录的项数，包括空slot
+    uint16_t data_offset;   // 记录数据区的起点，记录从页尾向前存放
+    uint16_t free_space;    // 页面中的空闲字节数，包括记录之间因删除和更新留下的碎片
+    uint16_t reserved;
+};
+
+/* slot目录项，offset为0表示空slot */
+struct RmSlot {
+    uint16_t offset;
+    uint16_t length;
+};
+
+/**
+ * @description: 对slotted格式的页面数据进行操作，不持有页面，调用者负责pin页面和加latch。
+ * 页面依次为页头、向后增长的slot目录、空闲区域和向前增长的记录数据区，
+ * 记录的slot号在页面内压缩整理后保持不变，因此Rid始终有效
+ */
+class RmSlottedPage {
+   public:
+    static constexpr int SLOT_DIR_OFFSET =
+        Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr) + sizeof(RmSlottedPageHdr);
+
+    // 一条记录最多能占用的字节数，即空页面上除去一个slot目录项后的全部空间
+    static constexpr int MAX_RECORD_SIZE = PAGE_SIZE - SLOT_DIR_OFFSET - sizeof(RmSlot);
+
+    explicit RmSlottedPage(char *data)
+        : page_hdr_(reinterpret_cast<RmPageHdr *>(data + Page::OFFSET_PAGE_HDR)),
+          hdr_(reinterpret_cast<RmSlottedPageHdr *>(data + Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr))),
+          slots_(reinterpret_cast<RmSlot *>(data + SLOT_DIR_OFFSET)),
+          data_(data) {}
+
+    void init();
+
+    int get_num_slots() const { return hdr_->num_slots; }
+
+    int get_free_space() const { return hdr_->free_space; }
+
+    bool is_used(int slot_no) const { return slot_no >= 0 && slot_no < hdr_->num_slots && slots_[slot_no].offset != 0; }
+
+    char *get_record(int slot_no, int *len) const;
+
+    int find_free_slot(int len) const;
+
+    void insert(int slot_no, const char *buf, int len);
+
+    bool update(int slot_no, const char *buf, int len);
+
+    void erase(int slot_no);
+
+    void compact();
+
+   private:
+    int get_contiguous_space() const { return hdr_->data_offset - SLOT_DIR_OFFSET - hdr_->num_slots * (int)sizeof(RmSlot); }
+
+    void place(int slot_no, const char *buf, int len);
+
+    RmPageHdr *page_hdr_;
+    RmSlottedPageHdr *hdr_;
+    RmSlot *slots_;
+    char *data_;
+};
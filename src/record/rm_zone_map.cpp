@@ -0,0 +1,180 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_zone_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include "errors.h"
+
+static constexpr double ZONE_INF = std::numeric_limits<double>::infinity();
+
+/**
+ * @description: 设置建立zone map的字段，只在打开表文件时调用一次
+ * @param {vector<RmZoneCol>} cols INT和FLOAT字段
+ */
+void RmZoneMap::init(std::vector<RmZoneCol> cols) { cols_ = std::move(cols); }
+
+/**
+ * @description: 清空zone map，文件中有num_pages个页面，所有页面上都没有记录
+ * @param {int} num_pages 页面个数
+ */
+void RmZoneMap::reset(int num_pages) {
+    std::scoped_lock lock{latch_};
+    num_pages_ = 0;
+    zones_.clear();
+    grow(num_pages);
+}
+
+/**
+ * @description: 插入或更新记录时调用，把记录中每个字段的值并入页面的范围。
+ * FLOAT的NaN与任何值比较都不满足大小关系，出现NaN的页面不再被跳过
+ * @param {int} page_no 记录的rid所在的页面
+ * @param {char*} record 定长记录
+ */
+void RmZoneMap::update(int page_no, const char *record) {
+    std::scoped_lock lock{latch_};
+    grow(page_no + 1);
+    Zone *zones = zones_.data() + (size_t)page_no * cols_.size();
+    for (size_t i = 0; i < cols_.size(); i++) {
+        double value;
+        if (cols_[i].type == TYPE_INT) {
+            value = *reinterpret_cast<const int *>(record + cols_[i].offset);
+        } else {
+            value = *reinterpret_cast<const float *>(record + cols_[i].offset);
+        }
+        if (std::isnan(value)) {
+            zones[i] = {-ZONE_INF, ZONE_INF};
+            continue;
+        }
+        zones[i].min = std::min(zones[i].min, value);
+        zones[i].max = std::max(zones[i].max, value);
+    }
+}
+
+/**
+ * @description: 判断page_no页上是否可能有满足所有谓词的记录。谓词的字段没有建立zone map时不能据此跳过页面
+ * @return {bool} 为false时页面上一定没有满足条件的记录
+ * @param {int} page_no 页面号
+ * @param {vector<RmZonePredicate>&} preds 扫描条件中字段与常量比较的谓词
+ */
+bool RmZoneMap::may_match(int page_no, const std::vector<RmZonePredicate> &preds) const {
+    if (cols_.empty()) {
+        return true;
+    }
+    std::scoped_lock lock{latch_};
+    if (page_no >= num_pages_) {
+        return false;
+    }
+    const Zone *zones = zones_.data() + (size_t)page_no * cols_.size();
+    for (auto &pred : preds) {
+        for (size_t i = 0; i < cols_.size(); i++) {
+            if (cols_[i].offset == pred.offset && !may_match(zones[i], pred)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @description: 范围为zone的字段上是否可能有值满足pred，空的范围不满足任何谓词
+ */
+bool RmZoneMap::may_match(const Zone &zone, const RmZonePredicate &pred) {
+    if (zone.min > zone.max) {
+        return false;
+    }
+    switch (pred.op) {
+        case OP_EQ:
+            return zone.min <= pred.value && pred.value <= zone.max;
+        case OP_NE:
+            return !(zone.min == pred.value && zone.max == pred.value);
+        case OP_LT:
+            return zone.min < pred.value;
+        case OP_GT:
+            return zone.max > pred.value;
+        case OP_LE:
+            return zone.min <= pred.value;
+        case OP_GE:
+            return zone.max >= pred.value;
+    }
+    return true;
+}
+
+/**
+ * @description: 从文件中读取close时保存的zone map。文件不存在、已损坏，或者页面个数、字段与表文件不一致时返回false
+ * @return {bool} 是否读取成功
+ * @param {string&} path zone map文件的路径
+ * @param {int} num_pages 表文件当前的页面个数
+ */
+bool RmZoneMap::load(const std::string &path, int num_pages) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    uint32_t magic = 0;
+    int saved_pages = -1;
+    int num_cols = -1;
+    ifs.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    ifs.read(reinterpret_cast<char *>(&saved_pages), sizeof(saved_pages));
+    ifs.read(reinterpret_cast<char *>(&num_cols), sizeof(num_cols));
+    if (!ifs || magic != FILE_MAGIC || saved_pages != num_pages || num_cols != (int)cols_.size()) {
+        return false;
+    }
+    std::vector<RmZoneCol> cols(num_cols);
+    ifs.read(reinterpret_cast<char *>(cols.data()), num_cols * sizeof(RmZoneCol));
+    for (int i = 0; ifs && i < num_cols; i++) {
+        if (cols[i].offset != cols_[i].offset || cols[i].type != cols_[i].type) {
+            return false;
+        }
+    }
+    std::vector<Zone> zones((size_t)num_pages * num_cols);
+    ifs.read(reinterpret_cast<char *>(zones.data()), zones.size() * sizeof(Zone));
+    if (!ifs || ifs.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+
+    std::scoped_lock lock{latch_};
+    num_pages_ = num_pages;
+    zones_ = std::move(zones);
+    return true;
+}
+
+/**
+ * @description: 将zone map保存到文件中，下一次打开表文件时无需重新扫描所有页面
+ * @param {string&} path zone map文件的路径
+ */
+void RmZoneMap::save(const std::string &path) const {
+    std::scoped_lock lock{latch_};
+    int num_cols = cols_.size();
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+    ofs.write(reinterpret_cast<const char *>(&num_pages_), sizeof(num_pages_));
+    ofs.write(reinterpret_cast<const char *>(&num_cols), sizeof(num_cols));
+    ofs.write(reinterpret_cast<const char *>(cols_.data()), num_cols * sizeof(RmZoneCol));
+    ofs.write(reinterpret_cast<const char *>(zones_.data()), zones_.size() * sizeof(Zone));
+    if (!ofs) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 将页面个数扩展到num_pages，新页面的范围为空，调用者需持有latch_
+ */
+void RmZoneMap::grow(int num_pages) {
+    if (num_pages <= num_pages_) {
+        return;
+    }
+    zones_.resize((size_t)num_pages * cols_.size(), Zone{ZONE_INF, -ZONE_INF});
+    num_pages_ = num_pages;
+}
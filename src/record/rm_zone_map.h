@@ -0,0 +1,70 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/common.h"
+
+/* zone map记录其取值范围的字段，只支持INT和FLOAT */
+struct RmZoneCol {
+    int offset;     // 字段在记录中的偏移量
+    ColType type;   // TYPE_INT或TYPE_FLOAT
+};
+
+/* 可以用zone map判断的谓词：offset处的字段 op value */
+struct RmZonePredicate {
+    int offset;     // 字段在记录中的偏移量
+    CompOp op;      // 比较运算符
+    double value;   // INT和FLOAT的值都能精确地表示为double
+};
+
+/**
+ * @description: 表数据文件每个页面上INT和FLOAT字段的最小值和最大值。记录插入和更新时扩大所在页面的范围，删除时不缩小，
+ * 因此范围总是包含页面中现存的所有值。顺序扫描时范围与谓词不相交的页面可以整页跳过，不需要读取页面。
+ * slotted格式下被移到其他页面的记录计入其rid所在的页面，与批量扫描中记录出现的页面一致
+ */
+class RmZoneMap {
+   public:
+    void init(std::vector<RmZoneCol> cols);
+
+    bool empty() const { return cols_.empty(); }
+
+    void reset(int num_pages);
+
+    void update(int page_no, const char *record);
+
+    bool may_match(int page_no, const std::vector<RmZonePredicate> &preds) const;
+
+    bool load(const std::string &path, int num_pages);
+
+    void save(const std::string &path) const;
+
+   private:
+    struct Zone {
+        double min;
+        double max;
+    };
+
+    void grow(int num_pages);
+
+    static bool may_match(const Zone &zone, const RmZonePredicate &pred);
+
+    static constexpr uint32_t FILE_MAGIC = 0x50414d5a;  // "ZMAP"
+
+    mutable std::mutex latch_;
+    std::vector<RmZoneCol> cols_;   // 建立zone map的字段，打开表文件后不再改变
+    int num_pages_ = 0;
+    std::vector<Zone> zones_;       // zones_[page_no * cols_.size() + i]为页面上第i个字段的范围，min > max表示页面上没有记录
+};
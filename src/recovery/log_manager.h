@@ -24,7 +24,8 @@ enum LogType: int {
     DELETE,
     begin,
     commit,
-    ABORT
+    ABORT,
+    BULK_LOAD
 };
 static std::string LogTypeStr[] = {
     "UPDATE",
@@ -32,7 +33,8 @@ static std::string LogTypeStr[] = {
     "DELETE",
     "BEGIN",
     "COMMIT",
-    "ABORT"
+    "ABORT",
+    "BULK_LOAD"
 };
 
 class LogRecord {
@@ -189,6 +191,75 @@ class UpdateLogRecord: public LogRecord {
 
 };
 
+/**
+ * 批量装载的日志记录：装载只向新分配的页面写入记录，这些页面在写日志之前已经刷到磁盘，
+ * 因此不需要逐条记录插入的数据，只记录装载的表和页面范围，恢复时据此判断这些页面是否属于未提交的事务
+*/
+class BulkLoadLogRecord: public LogRecord {
+public:
+    BulkLoadLogRecord() {
+        log_type_ = LogType::BULK_LOAD;
+        lsn_ = INVALID_LSN;
+        log_tot_len_ = LOG_HEADER_SIZE;
+        log_tid_ = INVALID_TXN_ID;
+        prev_lsn_ = INVALID_LSN;
+        first_page_no_ = last_page_no_ = INVALID_PAGE_ID;
+        num_records_ = 0;
+    }
+    BulkLoadLogRecord(txn_id_t txn_id, const std::string& table_name, page_id_t first_page_no, page_id_t last_page_no,
+                      int num_records)
+        : BulkLoadLogRecord() {
+        log_tid_ = txn_id;
+        table_name_ = table_name;
+        first_page_no_ = first_page_no;
+        last_page_no_ = last_page_no;
+        num_records_ = num_records;
+        log_tot_len_ += sizeof(size_t) + table_name_.size();
+        log_tot_len_ += sizeof(page_id_t) * 2 + sizeof(int);
+    }
+
+    // 把bulk load日志记录序列化到dest中
+    void serialize(char* dest) const override {
+        LogRecord::serialize(dest);
+        int offset = OFFSET_LOG_DATA;
+        size_t table_name_size = table_name_.size();
+        memcpy(dest + offset, &table_name_size, sizeof(size_t));
+        offset += sizeof(size_t);
+        memcpy(dest + offset, table_name_.data(), table_name_size);
+        offset += table_name_size;
+        memcpy(dest + offset, &first_page_no_, sizeof(page_id_t));
+        offset += sizeof(page_id_t);
+        memcpy(dest + offset, &last_page_no_, sizeof(page_id_t));
+        offset += sizeof(page_id_t);
+        memcpy(dest + offset, &num_records_, sizeof(int));
+    }
+    // 从src中反序列化出一条bulk load日志记录
+    void deserialize(const char* src) override {
+        LogRecord::deserialize(src);
+        int offset = OFFSET_LOG_DATA;
+        size_t table_name_size = *reinterpret_cast<const size_t*>(src + offset);
+        offset += sizeof(size_t);
+        table_name_.assign(src + offset, table_name_size);
+        offset += table_name_size;
+        first_page_no_ = *reinterpret_cast<const page_id_t*>(src + offset);
+        offset += sizeof(page_id_t);
+        last_page_no_ = *reinterpret_cast<const page_id_t*>(src + offset);
+        offset += sizeof(page_id_t);
+        num_records_ = *reinterpret_cast<const int*>(src + offset);
+    }
+    void format_print() override {
+        printf("bulk load\n");
+        LogRecord::format_print();
+        printf("table name: %s\n", table_name_.c_str());
+        printf("pages: [%d, %d], records: %d\n", first_page_no_, last_page_no_, num_records_);
+    }
+
+    std::string table_name_;    // 装载的表名称
+    page_id_t first_page_no_;   // 装载写入的第一个页面
+    page_id_t last_page_no_;    // 装载写入的最后一个页面
+    int num_records_;           // 装载的记录条数
+};
+
 /* 日志缓冲区，只有一个buffer，因此需要阻塞地去把日志写入缓冲区中 */
 
 class LogBuffer {
@@ -218,10 +289,18 @@ public:
 
     LogBuffer* get_log_buffer() { return &log_buffer_; }
 
+    /**
+     * @description: 获取已经持久化到磁盘中的最后一条日志的日志号，后台写回线程只写回页面LSN不超过它的脏页
+     */
+    lsn_t get_persist_lsn() { return persist_lsn_.load(); }
+
 private:    
-    std::atomic<lsn_t> global_lsn_{0};  // 全局lsn，递增，用于为每条记录分发lsn
+    void flush_log_to_disk_without_lock();
+
+    // 全局lsn，递增，用于为每条记录分发lsn。lsn从1开始，页面LSN为0表示该页面读入缓冲池后尚未被任何日志记录修改过
+    std::atomic<lsn_t> global_lsn_{1};
     std::mutex latch_;                  // 用于对log_buffer_的互斥访问
     LogBuffer log_buffer_;              // 日志缓冲区
-    lsn_t persist_lsn_;                 // 记录已经持久化到磁盘中的最后一条日志的日志号
+    std::atomic<lsn_t> persist_lsn_{0}; // 记录已经持久化到磁盘中的最后一条日志的日志号
     DiskManager* disk_manager_;
 }; 
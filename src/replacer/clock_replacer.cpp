@@ -0,0 +1,92 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "clock_replacer.h"
+
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : in_replacer_(num_pages, false), ref_bits_(num_pages, false), max_size_(num_pages) {}
+
+ClockReplacer::~ClockReplacer() = default;
+
+/**
+ * @description: 使用CLOCK策略选择一个victim frame：时钟指针循环扫描可淘汰的frame，
+ * 引用位为1的frame获得第二次机会（引用位清零），遇到引用位为0的frame即将其淘汰
+ * @param {frame_id_t*} frame_id 被移除的frame的id
+ * @return {bool} 如果成功淘汰了一个页面则返回true，否则返回false
+ */
+bool ClockReplacer::victim(frame_id_t* frame_id) {
+    std::scoped_lock lock{latch_};
+
+    if (size_ == 0) {
+        return false;
+    }
+    // 至多扫描两圈：第一圈清除引用位，第二圈必然能找到引用位为0的frame
+    while (true) {
+        size_t curr = hand_;
+        hand_ = (hand_ + 1) % max_size_;
+        if (!in_replacer_[curr]) {
+            continue;
+        }
+        if (ref_bits_[curr]) {
+            ref_bits_[curr] = false;
+            continue;
+        }
+        in_replacer_[curr] = false;
+        size_--;
+        *frame_id = static_cast<frame_id_t>(curr);
+        return true;
+    }
+}
+
+/**
+ * @description: 固定指定的frame，即该页面无法被淘汰
+ * @param {frame_id_t} 需要固定的frame的id
+ */
+void ClockReplacer::pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (in_replacer_[frame_id]) {
+        in_replacer_[frame_id] = false;
+        size_--;
+    }
+}
+
+/**
+ * @description: 取消固定一个frame，代表该页面可以被淘汰，同时设置其引用位
+ * @param {frame_id_t} frame_id 取消固定的frame的id
+ */
+void ClockReplacer::unpin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (!in_replacer_[frame_id]) {
+        in_replacer_[frame_id] = true;
+        size_++;
+    }
+    ref_bits_[frame_id] = true;
+}
+
+/**
+ * @description: 移除一个不再存放页面的frame，并清除其引用位
+ * @param {frame_id_t} frame_id 需要移除的frame的id
+ */
+void ClockReplacer::remove(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (in_replacer_[frame_id]) {
+        in_replacer_[frame_id] = false;
+        size_--;
+    }
+    ref_bits_[frame_id] = false;
+}
+
+/**
+ * @description: 获取当前replacer中可以被淘汰的页面数量
+ */
+size_t ClockReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return size_;
+}
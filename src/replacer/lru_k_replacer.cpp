@@ -0,0 +1,179 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "lru_k_replacer.h"
+
+#include <cassert>
+
+// 访问次数达到K次的frame的淘汰优先级位于访问次数不足K次的frame之后
+static constexpr uint64_t LRUK_HOT_TIER = 1ULL << 63;
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : k_(k),
+      max_size_(num_pages),
+      history_(num_pages * k),
+      access_count_(num_pages),
+      keys_(num_pages, 0),
+      heap_pos_(num_pages, -1) {
+    assert(k_ > 0);
+    heap_.reserve(num_pages);
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+/**
+ * @description: 淘汰后向K距离最大的frame，访问次数不足K次的frame中淘汰最早被访问的
+ * @param {frame_id_t*} frame_id 被移除的frame的id
+ * @return {bool} 如果成功淘汰了一个页面则返回true，否则返回false
+ */
+bool LRUKReplacer::victim(frame_id_t* frame_id) {
+    std::scoped_lock lock{latch_};
+
+    if (heap_.empty()) {
+        return false;
+    }
+    *frame_id = heap_[0];
+    heap_remove(0);
+    // frame中将装入新的页面，清空旧页面的访问历史
+    access_count_[*frame_id] = 0;
+    return true;
+}
+
+/**
+ * @description: 固定指定的frame，即该页面无法被淘汰，同时记录一次访问
+ * @param {frame_id_t} 需要固定的frame的id
+ */
+void LRUKReplacer::pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    record_access(frame_id);
+    if (heap_pos_[frame_id] != -1) {
+        heap_remove(heap_pos_[frame_id]);
+    }
+}
+
+/**
+ * @description: 取消固定一个frame，代表该页面可以被淘汰
+ * @param {frame_id_t} frame_id 取消固定的frame的id
+ */
+void LRUKReplacer::unpin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (heap_pos_[frame_id] != -1) {
+        return;
+    }
+    if (access_count_[frame_id] == 0) {
+        // 未经pin直接unpin的frame也视为被访问了一次
+        record_access(frame_id);
+    }
+    keys_[frame_id] = evict_key(frame_id);
+    heap_pos_[frame_id] = static_cast<int>(heap_.size());
+    heap_.push_back(frame_id);
+    sift_up(heap_.size() - 1);
+}
+
+/**
+ * @description: 移除一个不再存放页面的frame（页面被删除或frame被缩容移出），并清空它的访问历史，
+ * 之后装入该frame的页面不会继承旧页面的访问次数
+ * @param {frame_id_t} frame_id 需要移除的frame的id
+ */
+void LRUKReplacer::remove(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (heap_pos_[frame_id] != -1) {
+        heap_remove(heap_pos_[frame_id]);
+    }
+    access_count_[frame_id] = 0;
+}
+
+/**
+ * @description: 获取当前replacer中可以被淘汰的页面数量
+ */
+size_t LRUKReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return heap_.size();
+}
+
+/**
+ * @description: 在frame的访问历史环形缓冲区中记录一次访问。只使用原子操作，缓冲池命中时可以不加锁地调用；
+ * 多个线程同时访问同一frame时各自占用环形缓冲区中的一个位置
+ * @param {frame_id_t} frame_id 被访问的frame的id
+ */
+void LRUKReplacer::record_access(frame_id_t frame_id) {
+    size_t count = access_count_[frame_id].fetch_add(1, std::memory_order_relaxed);
+    uint64_t timestamp = current_timestamp_.fetch_add(1, std::memory_order_relaxed) + 1;
+    history_[frame_id * k_ + count % k_].store(timestamp, std::memory_order_relaxed);
+}
+
+/**
+ * @description: 计算frame的淘汰优先级。访问次数不足K次时以最早一次访问时间排序，
+ * 否则以倒数第K次访问时间排序，并整体排在前者之后
+ * @return {uint64_t} 淘汰优先级，越小越先被淘汰
+ * @param {frame_id_t} frame_id 目标frame的id
+ */
+uint64_t LRUKReplacer::evict_key(frame_id_t frame_id) const {
+    size_t count = access_count_[frame_id];
+    if (count < k_) {
+        return history_[frame_id * k_];
+    }
+    // 环形缓冲区中下一个将被覆盖的位置保存的就是倒数第K次访问
+    return LRUK_HOT_TIER | history_[frame_id * k_ + count % k_];
+}
+
+void LRUKReplacer::heap_swap(size_t i, size_t j) {
+    std::swap(heap_[i], heap_[j]);
+    heap_pos_[heap_[i]] = static_cast<int>(i);
+    heap_pos_[heap_[j]] = static_cast<int>(j);
+}
+
+void LRUKReplacer::sift_up(size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!heap_less(i, parent)) {
+            break;
+        }
+        heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+void LRUKReplacer::sift_down(size_t i) {
+    size_t n = heap_.size();
+    while (true) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < n && heap_less(left, smallest)) {
+            smallest = left;
+        }
+        if (right < n && heap_less(right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+/**
+ * @description: 删除堆中下标为i的frame
+ */
+void LRUKReplacer::heap_remove(size_t i) {
+    frame_id_t frame_id = heap_[i];
+    size_t last = heap_.size() - 1;
+    if (i != last) {
+        heap_swap(i, last);
+    }
+    heap_.pop_back();
+    heap_pos_[frame_id] = -1;
+    if (i < heap_.size()) {
+        sift_down(i);
+        sift_up(i);
+    }
+}
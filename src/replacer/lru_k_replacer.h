@@ -0,0 +1,73 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/*
+LRUKReplacer实现了LRU-K替换策略：淘汰"倒数第K次访问时间"最早的frame。
+访问次数不足K次的frame（例如只被顺序扫描访问过一次的页面）的后向K距离视为无穷大，优先被淘汰，
+因此一次大表扫描不会把反复访问的热点页面挤出缓冲池。
+每次pin以及已被pin的frame上的每次命中（record_access）视为一次访问，record_access不获取互斥锁。
+可淘汰的frame保存在按淘汰优先级排序的索引堆中，所有数组在构造时分配好。
+*/
+class LRUKReplacer : public Replacer {
+   public:
+    /**
+     * @description: 创建一个新的LRUKReplacer
+     * @param {size_t} num_pages LRUKReplacer最多需要存储的page数量
+     * @param {size_t} k 计算后向K距离时使用的访问次数
+     */
+    explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+    ~LRUKReplacer();
+
+    bool victim(frame_id_t *frame_id);
+
+    void pin(frame_id_t frame_id);
+
+    void unpin(frame_id_t frame_id);
+
+    void remove(frame_id_t frame_id);
+
+    size_t Size();
+
+    void record_access(frame_id_t frame_id);
+
+   private:
+    uint64_t evict_key(frame_id_t frame_id) const;
+
+    bool heap_less(size_t i, size_t j) const { return keys_[heap_[i]] < keys_[heap_[j]]; }
+
+    void heap_swap(size_t i, size_t j);
+
+    void sift_up(size_t i);
+
+    void sift_down(size_t i);
+
+    void heap_remove(size_t i);
+
+    std::mutex latch_;                  // 互斥锁
+    size_t k_;                          // LRU-K中的K
+    size_t max_size_;                   // 最大容量（与缓冲池的容量相同）
+    std::atomic<uint64_t> current_timestamp_{0};    // 逻辑时钟，每次访问加一
+    std::vector<std::atomic<uint64_t>> history_;    // 每个frame最近K次访问的时间戳，按frame_id分段的环形缓冲区
+    std::vector<std::atomic<size_t>> access_count_; // 每个frame当前页面被访问的次数
+    std::vector<uint64_t> keys_;        // 每个frame进入堆时的淘汰优先级，越小越先被淘汰
+    std::vector<frame_id_t> heap_;      // 可淘汰frame组成的最小堆
+    std::vector<int> heap_pos_;         // frame在heap_中的下标，-1表示不在堆中（已被pin或已被淘汰）
+};
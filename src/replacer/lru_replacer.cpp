@@ -67,6 +67,12 @@ void LRUReplacer::unpin(frame_id_t frame_id) {
     }
 }
 
+/**
+ * @description: 移除一个不再存放页面的frame，LRU策略不保存额外的访问历史
+ * @param {frame_id_t} frame_id 需要移除的frame的id
+ */
+void LRUReplacer::remove(frame_id_t frame_id) { pin(frame_id); }
+
 /**
  * @description: 获取当前replacer中可以被淘汰的页面数量
  */
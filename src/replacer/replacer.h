@@ -39,6 +39,21 @@ class Replacer {
      */
     virtual void unpin(frame_id_t frame_id) = 0;
 
+    /**
+     * Records an access to a frame that is already pinned. The buffer pool calls it on every hit that does not
+     * pin the frame for the first time, without holding any latch, so implementations must not block. Policies
+     * that only look at the time of the last unpin can ignore it.
+     * @param frame_id the id of the accessed frame
+     */
+    virtual void record_access(__attribute__((unused)) frame_id_t frame_id) {}
+
+    /**
+     * Removes a frame from the replacer and discards its access history. Called when the frame no longer holds
+     * a page (the page was deleted or the frame was retired), so the next page loaded into it starts fresh.
+     * @param frame_id the id of the frame to remove
+     */
+    virtual void remove(frame_id_t frame_id) = 0;
+
     /** @return the number of elements in the replacer that can be victimized */
     virtual size_t Size() = 0;
 };
@@ -8,14 +8,21 @@ EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
 MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
+#include <limits.h>
 #include <netinet/in.h>
 #include <readline/history.h>
 #include <readline/readline.h>
 #include <setjmp.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "analyze/analyze.h"
 #include "errors.h"
@@ -30,25 +37,225 @@ See the Mulan PSL v2 for more details. */
 
 static bool should_exit = false;
 
-// 构建全局所需的管理器对象
-auto disk_manager = std::make_unique<DiskManager>();
-auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
-auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
-auto ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
-auto sm_manager =
-    std::make_unique<SmManager>(disk_manager.get(), buffer_pool_manager.get(), rm_manager.get(), ix_manager.get());
-auto lock_manager = std::make_unique<LockManager>();
-auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), sm_manager.get());
-auto ql_manager = std::make_unique<QlManager>(sm_manager.get(), txn_manager.get());
-auto log_manager = std::make_unique<LogManager>(disk_manager.get());
-auto recovery = std::make_unique<RecoveryManager>(disk_manager.get(), buffer_pool_manager.get(), sm_manager.get());
-auto planner = std::make_unique<Planner>(sm_manager.get());
-auto optimizer = std::make_unique<Optimizer>(sm_manager.get(), planner.get());
-auto portal = std::make_unique<Portal>(sm_manager.get());
-auto analyze = std::make_unique<Analyze>(sm_manager.get());
+// 全局所需的管理器对象，在main()中解析完启动参数后由init_managers()构建
+std::unique_ptr<DiskManager> disk_manager;
+std::unique_ptr<BufferPoolManager> buffer_pool_manager;
+std::unique_ptr<RmManager> rm_manager;
+std::unique_ptr<IxManager> ix_manager;
+std::unique_ptr<SmManager> sm_manager;
+std::unique_ptr<LockManager> lock_manager;
+std::unique_ptr<TransactionManager> txn_manager;
+std::unique_ptr<QlManager> ql_manager;
+std::unique_ptr<LogManager> log_manager;
+std::unique_ptr<RecoveryManager> recovery;
+std::unique_ptr<Planner> planner;
+std::unique_ptr<Optimizer> optimizer;
+std::unique_ptr<Portal> portal;
+std::unique_ptr<Analyze> analyze;
 pthread_mutex_t *buffer_mutex;
 pthread_mutex_t *sockfd_mutex;
 
+// 后台线程：config_reload_loop和stats_dump_loop会访问缓冲池和sm_manager，关闭数据库前由stop_background_threads()通知退出并等待
+std::thread config_reload_thread;
+std::thread stats_dump_thread;
+std::mutex background_mutex;
+std::condition_variable background_cv;
+bool background_stop = false;  // 受background_mutex保护
+
+// 启动参数，可以来自命令行，也可以来自-f指定的配置文件
+struct ServerOptions {
+    size_t buffer_pool_size = BUFFER_POOL_SIZE;                     // 缓冲池的页面个数
+    size_t buffer_pool_max_size = 0;                                // 在线扩容的上限，0表示与buffer_pool_size相同
+    size_t buffer_pool_instances = BUFFER_POOL_INSTANCES;           // 缓冲池的分区个数
+    size_t cleaner_pages_per_second = PAGE_CLEANER_PAGES_PER_SECOND;    // 0表示不启动后台写回线程
+    bool direct_io = DISK_DIRECT_IO;                                // 表和索引文件以O_DIRECT方式读写
+    size_t stats_dump_interval = STATS_DUMP_INTERVAL_S;             // 定期转储统计信息的间隔（秒），0表示不转储
+    std::string config_file;                                        // 配置文件路径，收到SIGHUP时重新读取
+};
+
+/**
+ * @description: 解析缓冲池大小。不带单位时表示页面个数，带K/M/G后缀时表示字节数，按PAGE_SIZE换算成页面个数
+ * @return {bool} 是否为合法的大小
+ * @param {string&} value 如"65536"、"256M"、"1G"
+ * @param {size_t*} num_pages 返回页面个数
+ */
+static bool parse_pool_size(const std::string &value, size_t *num_pages) {
+    char *end = nullptr;
+    unsigned long long number = strtoull(value.c_str(), &end, 10);
+    if (end == value.c_str()) {
+        return false;
+    }
+    std::string unit(end);
+    size_t bytes = 0;
+    if (unit.empty()) {
+        *num_pages = number;
+        return number > 0;
+    } else if (unit == "K" || unit == "k" || unit == "KB") {
+        bytes = number << 10;
+    } else if (unit == "M" || unit == "m" || unit == "MB") {
+        bytes = number << 20;
+    } else if (unit == "G" || unit == "g" || unit == "GB") {
+        bytes = number << 30;
+    } else {
+        return false;
+    }
+    *num_pages = bytes / PAGE_SIZE;
+    return *num_pages > 0;
+}
+
+/**
+ * @description: 读取配置文件，每行为"key = value"，#之后为注释。page_size是磁盘上的页面格式，
+ * 只能在编译时修改，配置文件中的值必须与编译时的PAGE_SIZE一致
+ * @return {bool} 文件是否存在且所有配置项都合法
+ * @param {string&} path 配置文件路径
+ * @param {ServerOptions*} options 读取到的配置项写入这里，其余配置项保持不变
+ */
+static bool load_config_file(const std::string &path, ServerOptions *options) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open config file: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        line = line.substr(0, line.find('#'));
+        size_t eq = line.find('=');
+        std::string key, value;
+        std::istringstream(line.substr(0, eq)) >> key;
+        if (key.empty()) {
+            continue;
+        }
+        if (eq != std::string::npos) {
+            std::istringstream(line.substr(eq + 1)) >> value;
+        }
+        bool valid = true;
+        if (value.empty()) {
+            valid = false;
+        } else if (key == "buffer_pool_size") {
+            valid = parse_pool_size(value, &options->buffer_pool_size);
+        } else if (key == "buffer_pool_max_size") {
+            valid = parse_pool_size(value, &options->buffer_pool_max_size);
+        } else if (key == "buffer_pool_instances") {
+            int n = atoi(value.c_str());
+            valid = n > 0;
+            options->buffer_pool_instances = valid ? n : options->buffer_pool_instances;
+        } else if (key == "page_cleaner_pages_per_second") {
+            int rate = atoi(value.c_str());
+            valid = rate >= 0;
+            options->cleaner_pages_per_second = valid ? rate : options->cleaner_pages_per_second;
+        } else if (key == "direct_io") {
+            valid = value == "on" || value == "off";
+            options->direct_io = valid ? value == "on" : options->direct_io;
+        } else if (key == "stats_dump_interval") {
+            int seconds = atoi(value.c_str());
+            valid = seconds >= 0;
+            options->stats_dump_interval = valid ? seconds : options->stats_dump_interval;
+        } else if (key == "page_size") {
+            valid = atoi(value.c_str()) == PAGE_SIZE;
+            if (!valid) {
+                std::cerr << "page_size is fixed at compile time to " << PAGE_SIZE << std::endl;
+            }
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << path << ":" << line_no << ": invalid config entry: " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @description: 等待SIGHUP，收到后重新读取配置文件，并按其中的buffer_pool_size在线调整缓冲池大小。
+ * 其他配置项只在启动时生效
+ * @param {ServerOptions} options 启动时使用的配置
+ */
+static void config_reload_loop(ServerOptions options) {
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGHUP);
+    int signo;
+    while (sigwait(&sigset, &signo) == 0) {
+        {
+            std::scoped_lock lock{background_mutex};
+            if (background_stop) {
+                return;
+            }
+        }
+        ServerOptions reloaded = options;
+        if (options.config_file.empty() || !load_config_file(options.config_file, &reloaded)) {
+            continue;
+        }
+        size_t old_size = buffer_pool_manager->get_pool_size();
+        size_t new_size = buffer_pool_manager->resize(reloaded.buffer_pool_size);
+        std::cout << "Buffer pool resized from " << old_size << " to " << new_size << " pages (max "
+                  << buffer_pool_manager->get_max_pool_size() << ")" << std::endl;
+    }
+}
+
+/**
+ * @description: 每隔interval秒把SHOW STATS的内容追加到数据库目录下的STATS_DUMP_FILE_NAME中
+ * @param {size_t} interval 转储间隔，单位为秒
+ */
+static void stats_dump_loop(size_t interval) {
+    while (true) {
+        {
+            std::unique_lock lock{background_mutex};
+            if (background_cv.wait_for(lock, std::chrono::seconds(interval), [] { return background_stop; })) {
+                return;
+            }
+        }
+        std::ofstream file(STATS_DUMP_FILE_NAME, std::ios::out | std::ios::app);
+        sm_manager->dump_stats(file);
+    }
+}
+
+/**
+ * @description: 通知后台线程退出并等待它们结束，之后才能关闭数据库、析构管理器对象。可以重复调用
+ */
+static void stop_background_threads() {
+    {
+        std::scoped_lock lock{background_mutex};
+        background_stop = true;
+    }
+    background_cv.notify_all();
+    if (config_reload_thread.joinable()) {
+        // config_reload_loop阻塞在sigwait中，发送SIGHUP唤醒它
+        pthread_kill(config_reload_thread.native_handle(), SIGHUP);
+        config_reload_thread.join();
+    }
+    if (stats_dump_thread.joinable()) {
+        stats_dump_thread.join();
+    }
+}
+
+/**
+ * @description: 构建全局所需的管理器对象
+ * @param {ServerOptions&} options 启动参数
+ */
+void init_managers(const ServerOptions &options) {
+    disk_manager = std::make_unique<DiskManager>(options.direct_io);
+    buffer_pool_manager =
+        std::make_unique<BufferPoolManager>(options.buffer_pool_size, disk_manager.get(), options.buffer_pool_instances,
+                                            options.buffer_pool_max_size);
+    rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+    ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
+    sm_manager =
+        std::make_unique<SmManager>(disk_manager.get(), buffer_pool_manager.get(), rm_manager.get(), ix_manager.get());
+    lock_manager = std::make_unique<LockManager>();
+    txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), sm_manager.get());
+    ql_manager = std::make_unique<QlManager>(sm_manager.get(), txn_manager.get());
+    log_manager = std::make_unique<LogManager>(disk_manager.get());
+    recovery = std::make_unique<RecoveryManager>(disk_manager.get(), buffer_pool_manager.get(), sm_manager.get());
+    planner = std::make_unique<Planner>(sm_manager.get());
+    optimizer = std::make_unique<Optimizer>(sm_manager.get(), planner.get());
+    portal = std::make_unique<Portal>(sm_manager.get());
+    analyze = std::make_unique<Analyze>(sm_manager.get());
+}
+
 static jmp_buf jmpbuf;
 void sigint_handler(int signo) {
     should_exit = true;
@@ -260,17 +467,107 @@ void start_server() {
         printf("%s\n", strerror(errno));
     }
     //    assert(ret != -1);
+    stop_background_threads();
     sm_manager->close_db();
     std::cout << " DB has been closed.\n";
     std::cout << "Server shuts down." << std::endl;
 }
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    // 在创建任何线程之前屏蔽SIGHUP：之后创建的I/O线程、后台写回线程等都继承这个屏蔽字，
+    // SIGHUP只由config_reload_loop通过sigwait接收，用于在线调整缓冲池大小；否则信号可能被递送给
+    // 没有屏蔽它的线程，按默认处理方式终止进程
+    sigset_t sighup_set;
+    sigemptyset(&sighup_set);
+    sigaddset(&sighup_set, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &sighup_set, nullptr);
+
+    // 解析启动参数: rmdb [-f config_file] [-b pool_size] [-B max_pool_size] [-n buffer_pool_instances]
+    //                   [-c cleaner_pages_per_second] [-d] [-s stats_dump_interval] <database>
+    // 参数按出现的顺序生效，-f之后的命令行参数会覆盖配置文件中的同名配置项
+    ServerOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:b:B:n:c:ds:")) != -1) {
+        switch (opt) {
+            case 'f': {
+                options.config_file = optarg;
+                if (!load_config_file(options.config_file, &options)) {
+                    exit(1);
+                }
+                // 之后会切换到数据库目录下，收到SIGHUP时按绝对路径重新读取配置文件
+                char path[PATH_MAX];
+                if (realpath(optarg, path) != nullptr) {
+                    options.config_file = path;
+                }
+                break;
+            }
+            case 'b':
+            case 'B': {
+                size_t num_pages;
+                if (!parse_pool_size(optarg, &num_pages)) {
+                    std::cerr << "Invalid buffer pool size: " << optarg << std::endl;
+                    exit(1);
+                }
+                (opt == 'b' ? options.buffer_pool_size : options.buffer_pool_max_size) = num_pages;
+                break;
+            }
+            case 'n': {
+                int n = atoi(optarg);
+                if (n <= 0) {
+                    std::cerr << "Invalid number of buffer pool instances: " << optarg << std::endl;
+                    exit(1);
+                }
+                options.buffer_pool_instances = n;
+                break;
+            }
+            case 'c': {
+                int rate = atoi(optarg);
+                if (rate < 0) {
+                    std::cerr << "Invalid page cleaner rate: " << optarg << std::endl;
+                    exit(1);
+                }
+                options.cleaner_pages_per_second = rate;  // 0表示不启动后台写回线程
+                break;
+            }
+            case 'd':
+                options.direct_io = true;  // 表和索引文件以O_DIRECT方式读写
+                break;
+            case 's': {
+                int seconds = atoi(optarg);
+                if (seconds < 0) {
+                    std::cerr << "Invalid stats dump interval: " << optarg << std::endl;
+                    exit(1);
+                }
+                options.stats_dump_interval = seconds;
+                break;
+            }
+            default:
+                optind = argc + 1;  // 参数错误，打印用法后退出
+                break;
+        }
+    }
+    if (optind != argc - 1) {
         // 需要指定数据库名称
-        std::cerr << "Usage: " << argv[0] << " <database>" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [-f config_file] [-b pool_size] [-B max_pool_size] [-n buffer_pool_instances]"
+                     " [-c cleaner_pages_per_second] [-d] [-s stats_dump_interval] <database>"
+                  << std::endl;
         exit(1);
     }
+    if (options.buffer_pool_size < options.buffer_pool_instances) {
+        std::cerr << "Buffer pool size must be at least the number of buffer pool instances" << std::endl;
+        exit(1);
+    }
+    init_managers(options);
+    if (options.cleaner_pages_per_second > 0) {
+        // 后台写回线程只写回日志已经持久化的脏页
+        buffer_pool_manager->start_page_cleaner([] { return log_manager->get_persist_lsn(); },
+                                                options.cleaner_pages_per_second);
+    }
+
+    config_reload_thread = std::thread(config_reload_loop, options);
+    // 其他经exit()退出的路径也要在析构全局的管理器对象之前停止后台线程；atexit注册的函数先于这些对象析构执行
+    std::atexit(stop_background_threads);
 
     signal(SIGINT, sigint_handler);
     try {
@@ -285,7 +582,7 @@ int main(int argc, char **argv) {
                      "Type 'help;' for help.\n"
                      "\n";
         // Database name is passed by args
-        std::string db_name = argv[1];
+        std::string db_name = argv[optind];
         if (!sm_manager->is_dir(db_name)) {
             // Database not found, create a new one
             sm_manager->create_db(db_name);
@@ -298,6 +595,10 @@ int main(int argc, char **argv) {
         recovery->redo();
         recovery->undo();
 
+        if (options.stats_dump_interval > 0) {
+            stats_dump_thread = std::thread(stats_dump_loop, options.stats_dump_interval);
+        }
+
         // 开启服务端，开始接受客户端连接
         start_server();
     } catch (RMDBError &e) {
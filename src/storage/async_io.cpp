@@ -0,0 +1,408 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/async_io.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+/**
+ * @description: 根据ASYNC_IO_BACKEND创建后端，内核不支持io_uring时退回线程池实现
+ * @return {unique_ptr<AsyncIoBackend>} 创建的后端
+ * @param {DiskManager*} disk_manager 线程池后端通过它完成实际的读写，io_uring后端把请求延迟记录到它的直方图中
+ */
+std::unique_ptr<AsyncIoBackend> AsyncIoBackend::create(DiskManager *disk_manager) {
+    if (ASYNC_IO_BACKEND == "io_uring" && IoUringBackend::is_supported()) {
+        return std::make_unique<IoUringBackend>(disk_manager);
+    }
+    return std::make_unique<ThreadPoolIoBackend>(disk_manager);
+}
+
+/* ---------------------------------------- ThreadPoolIoBackend ---------------------------------------- */
+
+ThreadPoolIoBackend::ThreadPoolIoBackend(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+    for (size_t i = 0; i < num_workers; i++) {
+        workers_.emplace_back(&ThreadPoolIoBackend::worker, this);
+    }
+}
+
+ThreadPoolIoBackend::~ThreadPoolIoBackend() {
+    {
+        std::scoped_lock lock{latch_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * @description: 将批内每个请求放入队列，由空闲的工作线程并发执行
+ * @param {shared_ptr<IoBatch>} batch 要提交的请求批次
+ */
+void ThreadPoolIoBackend::submit(std::shared_ptr<IoBatch> batch) {
+    if (!batch->start()) {
+        return;
+    }
+    std::vector<size_t> indices(batch->requests_.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = i;
+    }
+    enqueue(batch, indices);
+}
+
+/**
+ * @description: 将已经start()的批次中的部分请求放入队列，供其他后端转交自己不能处理的请求
+ * @param {shared_ptr<IoBatch>&} batch 请求所在的批次
+ * @param {vector<size_t>&} indices 请求在批次中的下标
+ */
+void ThreadPoolIoBackend::enqueue(const std::shared_ptr<IoBatch> &batch, const std::vector<size_t> &indices) {
+    {
+        std::scoped_lock lock{latch_};
+        for (size_t i : indices) {
+            queue_.emplace_back(batch, i);
+        }
+    }
+    if (indices.size() == 1) {
+        cv_.notify_one();
+    } else {
+        cv_.notify_all();
+    }
+}
+
+/**
+ * @description: 工作线程主循环，停止时先处理完队列中剩余的请求
+ */
+void ThreadPoolIoBackend::worker() {
+    while (true) {
+        std::pair<std::shared_ptr<IoBatch>, size_t> task;
+        {
+            std::unique_lock lock{latch_};
+            cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        IoRequest &request = task.first->requests_[task.second];
+        bool success = true;
+        try {
+            if (request.is_write) {
+                disk_manager_->write_page(request.fd, request.page_no, request.data, request.num_bytes);
+            } else {
+                disk_manager_->read_page(request.fd, request.page_no, request.data, request.num_bytes);
+            }
+        } catch (RMDBError &e) {
+            success = false;
+        }
+        task.first->complete(success);
+    }
+}
+
+/* ---------------------------------------- IoUringBackend ---------------------------------------- */
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// 收割线程退出时使用的NOP请求标识，正常请求的user_data为Inflight指针，不会为0
+static constexpr uint64_t IO_URING_STOP_TAG = 0;
+
+bool IoUringBackend::is_supported() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = io_uring_setup(1, &params);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+IoUringBackend::IoUringBackend(DiskManager *disk_manager, unsigned queue_depth) : disk_manager_(disk_manager) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = io_uring_setup(queue_depth, &params);
+    if (ring_fd_ < 0) {
+        throw UnixError();
+    }
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+
+    // 映射SQ环、CQ环和SQE数组，内核支持IORING_FEAT_SINGLE_MMAP时SQ环与CQ环共用一次映射
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        close(ring_fd_);
+        throw UnixError();
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_size_);
+            close(ring_fd_);
+            throw UnixError();
+        }
+    }
+    sqes_ = mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        if (!single_mmap) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        munmap(sq_ring_, sq_ring_size_);
+        close(ring_fd_);
+        throw UnixError();
+    }
+
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+
+    reaper_thread_ = std::thread(&IoUringBackend::reaper, this);
+}
+
+IoUringBackend::~IoUringBackend() {
+    {
+        // 等待所有在途请求完成后，提交一个NOP请求唤醒收割线程使其退出
+        // 收割线程出错时已经退出，并且已将在途请求全部以失败结束
+        std::unique_lock lock{sq_latch_};
+        sq_cv_.wait(lock, [&] { return inflight_.empty(); });
+        stop_ = true;
+        if (ring_error_ == 0) {
+            push_sqe(IORING_OP_NOP, -1, 0, nullptr, 0, IO_URING_STOP_TAG);
+            while (io_uring_enter(ring_fd_, 1, 0, 0) < 0 && errno == EINTR) {
+            }
+        }
+    }
+    reaper_thread_.join();
+    munmap(sqes_, sq_entries_ * sizeof(struct io_uring_sqe));
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+/**
+ * @description: 向SQ环尾部写入一个SQE，调用者需持有sq_latch_
+ * @return {bool} SQ环已满时返回false
+ */
+bool IoUringBackend::push_sqe(uint8_t opcode, int fd, uint64_t offset, char *data, unsigned len,
+                              uint64_t user_data) {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sq_tail_;
+    if (tail - head >= sq_entries_) {
+        return false;
+    }
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe = static_cast<struct io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @description: 获取处理需要通过DiskManager完成的请求的线程池，第一次调用时创建
+ */
+ThreadPoolIoBackend *IoUringBackend::fallback() {
+    std::call_once(fallback_once_, [&] { fallback_ = std::make_unique<ThreadPoolIoBackend>(disk_manager_); });
+    return fallback_.get();
+}
+
+/**
+ * @description: 撤回SQ环中已写入但尚未被内核取走的SQE，并将对应的请求移出在途集合，调用者需持有sq_latch_
+ * @param {vector<Inflight *>} *retracted 被撤回的请求
+ */
+void IoUringBackend::retract_sqes(std::vector<Inflight *> *retracted) {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sq_tail_;
+    for (unsigned i = head; i != tail; i++) {
+        struct io_uring_sqe *sqe = static_cast<struct io_uring_sqe *>(sqes_) + sq_array_[i & *sq_mask_];
+        auto *inflight = reinterpret_cast<Inflight *>(sqe->user_data);
+        inflight_.erase(inflight);
+        retracted->push_back(inflight);
+    }
+    __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * @description: 将批内请求写入SQ环并通知内核。在途请求数受CQ环大小限制，超出时等待收割线程腾出空间。
+ *               通知内核失败时，未被内核取走的请求和尚未写入的请求都以该错误码失败，由等待批次的调用者抛出
+ * @param {shared_ptr<IoBatch>} batch 要提交的请求批次
+ */
+void IoUringBackend::submit(std::shared_ptr<IoBatch> batch) {
+    if (!batch->start()) {
+        return;
+    }
+    // 与DiskManager::read_page/write_page使用同样的判断，需要特殊处理的请求交给线程池
+    std::vector<size_t> indices;
+    std::vector<size_t> sync_indices;
+    for (size_t i = 0; i < batch->requests_.size(); i++) {
+        IoRequest &request = batch->requests_[i];
+        bool sync = disk_manager_->is_compressed(request.fd) ||
+                    disk_manager_->needs_bounce(request.fd, request.data, request.num_bytes);
+        (sync ? sync_indices : indices).push_back(i);
+    }
+    if (!sync_indices.empty()) {
+        fallback()->enqueue(batch, sync_indices);
+    }
+    std::unique_lock lock{sq_latch_};
+    size_t next = 0;
+    int error = ring_error_;
+    std::vector<Inflight *> retracted;
+    while (next < indices.size() && error == 0) {
+        unsigned to_submit = 0;
+        while (next < indices.size() && inflight_.size() < cq_entries_) {
+            IoRequest &request = batch->requests_[indices[next]];
+            auto *inflight = new Inflight{batch, &request, std::chrono::steady_clock::now(),
+                                          disk_manager_->is_direct(request.fd)};
+            uint64_t offset = static_cast<uint64_t>(request.page_no) * PAGE_SIZE;
+            if (!push_sqe(request.is_write ? IORING_OP_WRITE : IORING_OP_READ, request.fd, offset, request.data,
+                          request.num_bytes, reinterpret_cast<uint64_t>(inflight))) {
+                delete inflight;
+                break;
+            }
+            inflight_.insert(inflight);
+            to_submit++;
+            next++;
+        }
+        while (to_submit > 0) {
+            int ret = io_uring_enter(ring_fd_, to_submit, 0, 0);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                error = errno;
+                retract_sqes(&retracted);
+                break;
+            }
+            to_submit -= ret;
+        }
+        if (error == 0 && next < indices.size()) {
+            sq_cv_.wait(lock, [&] { return inflight_.size() < cq_entries_ || ring_error_ != 0; });
+            error = ring_error_;
+        }
+    }
+    if (error == 0) {
+        return;
+    }
+    sq_cv_.notify_all();
+    lock.unlock();
+    for (Inflight *inflight : retracted) {
+        inflight->batch->complete(false, error);
+        delete inflight;
+    }
+    for (; next < indices.size(); next++) {
+        batch->complete(false, error);
+    }
+}
+
+/**
+ * @description: 收割线程主循环：阻塞等待完成事件，逐个通知对应的批次。
+ *               等待完成事件出错时不抛出异常（会终止进程），而是记录错误码，将所有在途请求以该错误码失败后退出
+ */
+void IoUringBackend::reaper() {
+    while (true) {
+        int ret = io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            int error = errno;
+            std::vector<Inflight *> failed;
+            {
+                std::scoped_lock lock{sq_latch_};
+                ring_error_ = error;
+                failed.assign(inflight_.begin(), inflight_.end());
+                inflight_.clear();
+                sq_cv_.notify_all();
+            }
+            for (Inflight *inflight : failed) {
+                inflight->batch->complete(false, error);
+                delete inflight;
+            }
+            return;
+        }
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        std::vector<std::pair<Inflight *, int>> reaped;
+        bool stop = false;
+        while (head != tail) {
+            struct io_uring_cqe *cqe = static_cast<struct io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+            if (cqe->user_data == IO_URING_STOP_TAG) {
+                stop = true;
+            } else {
+                reaped.emplace_back(reinterpret_cast<Inflight *>(cqe->user_data), cqe->res);
+            }
+            head++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        if (!reaped.empty()) {
+            // 先移出在途集合再释放，避免新请求复用同一地址后被误删
+            std::scoped_lock lock{sq_latch_};
+            for (auto &[inflight, res] : reaped) {
+                inflight_.erase(inflight);
+            }
+            sq_cv_.notify_all();
+        }
+        for (auto &[inflight, res] : reaped) {
+            if (res == -EINVAL && inflight->direct) {
+                // 文件系统在读写时才拒绝O_DIRECT，由DiskManager去掉文件的O_DIRECT标志后重试
+                size_t index = inflight->request - inflight->batch->requests_.data();
+                fallback()->enqueue(inflight->batch, {index});
+                delete inflight;
+                continue;
+            }
+            LatencyHistogram &latency = inflight->request->is_write ? disk_manager_->get_write_latency()
+                                                                    : disk_manager_->get_read_latency();
+            latency.record(std::chrono::steady_clock::now() - inflight->start);
+            if (res < 0) {
+                inflight->batch->complete(false, -res);
+            } else {
+                inflight->batch->complete(res == inflight->request->num_bytes);
+            }
+            delete inflight;
+        }
+        if (stop && stop_) {
+            return;
+        }
+    }
+}
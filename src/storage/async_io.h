@@ -0,0 +1,259 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "disk_manager.h"
+#include "errors.h"
+
+/**
+ * @description: 一个页面I/O请求，读写位置由(fd, page_no)确定，与DiskManager::read_page/write_page一致
+ */
+struct IoRequest {
+    bool is_write;
+    int fd;
+    page_id_t page_no;
+    char *data;
+    int num_bytes;
+};
+
+/**
+ * @description: 一批页面I/O请求。提交给AsyncIoBackend后，批内请求并发执行，
+ * 全部完成后唤醒wait()的调用者，并在完成线程中调用可选的完成回调
+ */
+class IoBatch {
+    friend class ThreadPoolIoBackend;
+    friend class IoUringBackend;
+
+   public:
+    IoBatch() = default;
+
+    void add_read(int fd, page_id_t page_no, char *data, int num_bytes) {
+        requests_.push_back({false, fd, page_no, data, num_bytes});
+    }
+
+    void add_write(int fd, page_id_t page_no, const char *data, int num_bytes) {
+        requests_.push_back({true, fd, page_no, const_cast<char *>(data), num_bytes});
+    }
+
+    /**
+     * @description: 设置完成回调，批内所有请求完成后在I/O完成线程中调用，参数表示是否全部成功
+     */
+    void set_callback(std::function<void(bool)> callback) { callback_ = std::move(callback); }
+
+    size_t size() const { return requests_.size(); }
+
+    bool empty() const { return requests_.empty(); }
+
+    /**
+     * @description: 阻塞等待批内所有请求完成。若有请求失败，带有错误码时抛出对应的UnixError，否则抛出InternalError
+     */
+    void wait() {
+        std::unique_lock lock{latch_};
+        cv_.wait(lock, [&] { return done_; });
+        if (failed_) {
+            if (error_ != 0) {
+                throw UnixError(error_);
+            }
+            throw InternalError("AsyncIoBackend: page I/O failed");
+        }
+    }
+
+   private:
+    /**
+     * @description: 提交前由后端调用，返回false表示批次为空、已经直接完成
+     */
+    bool start() {
+        pending_ = requests_.size();
+        if (pending_ == 0) {
+            finish();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @description: 记录一个请求的完成情况，最后一个请求完成时调用回调并唤醒等待者
+     * @param {bool} success 请求是否成功
+     * @param {int} error 请求失败时的错误码，为0表示没有错误码（如读写的字节数不足）
+     */
+    void complete(bool success, int error = 0) {
+        {
+            std::scoped_lock lock{latch_};
+            if (!success) {
+                failed_ = true;
+                if (error_ == 0) {
+                    error_ = error;
+                }
+            }
+            if (--pending_ != 0) {
+                return;
+            }
+        }
+        finish();
+    }
+
+    /**
+     * @description: 先调用回调再唤醒等待者，保证wait()返回时回调中的状态更新已经完成
+     */
+    void finish() {
+        if (callback_) {
+            callback_(!failed_);
+        }
+        std::scoped_lock lock{latch_};
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    std::vector<IoRequest> requests_;
+    std::function<void(bool)> callback_;
+    std::mutex latch_;
+    std::condition_variable cv_;
+    size_t pending_ = 0;
+    bool failed_ = false;
+    int error_ = 0;     // 第一个带有错误码的失败请求的错误码
+    bool done_ = false;
+};
+
+/**
+ * @description: 异步页面I/O后端。BufferPoolManager通过它批量提交缺页读取和脏页写回，
+ * 调用线程可以在不持有缓冲池latch的情况下等待I/O完成
+ */
+class AsyncIoBackend {
+   public:
+    virtual ~AsyncIoBackend() = default;
+
+    /**
+     * @description: 提交一批I/O请求，立即返回。空批次会直接完成
+     * @param {shared_ptr<IoBatch>} batch 要提交的请求批次，后端在完成前持有其引用
+     */
+    virtual void submit(std::shared_ptr<IoBatch> batch) = 0;
+
+    virtual std::string name() const = 0;
+
+    /**
+     * @description: 提交并等待一批I/O请求完成
+     */
+    void submit_and_wait(std::shared_ptr<IoBatch> batch) {
+        submit(batch);
+        batch->wait();
+    }
+
+    /**
+     * @description: 根据ASYNC_IO_BACKEND创建后端，内核不支持io_uring时退回线程池实现
+     */
+    static std::unique_ptr<AsyncIoBackend> create(DiskManager *disk_manager);
+};
+
+/**
+ * @description: 基于线程池的后端：若干工作线程从队列中取出请求，调用DiskManager的pread/pwrite完成I/O
+ */
+class ThreadPoolIoBackend : public AsyncIoBackend {
+   public:
+    ThreadPoolIoBackend(DiskManager *disk_manager, size_t num_workers = ASYNC_IO_WORKERS);
+
+    ~ThreadPoolIoBackend();
+
+    void submit(std::shared_ptr<IoBatch> batch) override;
+
+    void enqueue(const std::shared_ptr<IoBatch> &batch, const std::vector<size_t> &indices);
+
+    std::string name() const override { return "thread_pool"; }
+
+   private:
+    void worker();
+
+    DiskManager *disk_manager_;
+    std::vector<std::thread> workers_;
+    std::deque<std::pair<std::shared_ptr<IoBatch>, size_t>> queue_;  // (批次, 请求下标)
+    std::mutex latch_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+/**
+ * @description: 基于io_uring的后端：提交线程把请求写入SQ环并调用io_uring_enter，
+ * 一个收割线程阻塞等待CQ环上的完成事件。压缩文件上的页面不在固定偏移处，O_DIRECT文件上未对齐的请求需要经过中转缓冲区，
+ * 文件系统拒绝O_DIRECT（返回EINVAL）的请求需要去掉O_DIRECT后重试，这些请求都交给线程池通过DiskManager完成
+ */
+class IoUringBackend : public AsyncIoBackend {
+   public:
+    explicit IoUringBackend(DiskManager *disk_manager, unsigned queue_depth = ASYNC_IO_QUEUE_DEPTH);
+
+    ~IoUringBackend();
+
+    /**
+     * @description: 判断当前内核是否允许创建io_uring实例
+     */
+    static bool is_supported();
+
+    void submit(std::shared_ptr<IoBatch> batch) override;
+
+    std::string name() const override { return "io_uring"; }
+
+   private:
+    struct Inflight {
+        std::shared_ptr<IoBatch> batch;
+        IoRequest *request;
+        std::chrono::steady_clock::time_point start;    // 提交时间，完成时记录到DiskManager的延迟直方图中
+        bool direct;    // 提交时文件是否以O_DIRECT方式打开
+    };
+
+    ThreadPoolIoBackend *fallback();
+
+    bool push_sqe(uint8_t opcode, int fd, uint64_t offset, char *data, unsigned len, uint64_t user_data);
+
+    void retract_sqes(std::vector<Inflight *> *retracted);
+
+    void reaper();
+
+    DiskManager *disk_manager_;
+    int ring_fd_ = -1;
+    unsigned sq_entries_ = 0;
+    unsigned cq_entries_ = 0;
+    // SQ环
+    void *sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_mask_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    void *sqes_ = nullptr;
+    // CQ环
+    void *cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned *cq_mask_ = nullptr;
+    void *cqes_ = nullptr;
+
+    std::mutex sq_latch_;                   // 保护SQ环，多个线程可能同时提交
+    std::condition_variable sq_cv_;         // SQ环或在途请求数已满时等待
+    std::unordered_set<Inflight *> inflight_;   // 已写入SQ环但尚未收割的请求，个数不超过cq_entries_
+    int ring_error_ = 0;                    // 收割线程等待完成事件失败时的错误码，此后的请求直接以该错误失败
+    std::thread reaper_thread_;
+    std::atomic<bool> stop_{false};
+
+    std::unique_ptr<ThreadPoolIoBackend> fallback_;    // 第一次遇到需要通过DiskManager完成的请求时创建
+    std::once_flag fallback_once_;
+};
@@ -0,0 +1,709 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "buffer_pool_instance.h"
+
+#include <thread>
+
+// 脏页写回时使用的缓冲区。换出的脏页先复制到这里，再与新页面的读取一起提交，
+// 调用线程在I/O完成前不会返回，因此每个线程一个缓冲区即可
+alignas(PAGE_SIZE) static thread_local char writeback_buf[PAGE_SIZE];
+
+/**
+ * @description: 从free_list或replacer中得到可淘汰帧页的 *frame_id
+ * @return {bool} true: 可替换帧查找成功 , false: 可替换帧查找失败
+ * @param {frame_id_t*} frame_id 帧页id指针,返回成功找到的可替换帧id
+ */
+bool BufferPoolInstance::find_victim_page(frame_id_t* frame_id) {
+    // Todo:
+    // 1 使用BufferPoolInstance::free_list_判断缓冲池是否已满需要淘汰页面
+    // 1.1 未满获得frame
+    // 1.2 已满使用lru_replacer中的方法选择淘汰页面
+
+    if (!free_list_.empty()) {
+        *frame_id = free_list_.front();
+        free_list_.pop_front();
+        return true;
+    }
+    while (replacer_->victim(frame_id)) {
+        // 把pin_count_从0改为-1后该帧不能再被无锁地pin住。正在被批量写回或刚被无锁pin住的帧
+        // 可能仍留在replacer中，跳过它们，pin_count_回到0时会重新加入replacer
+        // 正在缩容移出的帧由resize负责腾空
+        if (static_cast<size_t>(*frame_id) >= retire_from_) {
+            continue;
+        }
+        int expected = 0;
+        if (pages_[*frame_id].pin_count_.compare_exchange_strong(expected, -1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @description: 把一个pin_count_为-1、不含有效页面的帧放回free_list_，正在被缩容移出的帧直接标记为已移出。
+ * 帧同时从replacer中移除并清空访问历史，从free_list_取出该帧时不经过replacer的victim。调用者需持有latch_
+ * @param {frame_id_t} frame_id 目标帧
+ */
+void BufferPoolInstance::free_frame(frame_id_t frame_id) {
+    replacer_->remove(frame_id);
+    if (static_cast<size_t>(frame_id) >= retire_from_) {
+        retired_[frame_id] = true;
+    } else {
+        free_list_.push_back(frame_id);
+    }
+}
+
+/**
+ * @description: 命中缓冲池时记录一次访问。帧第一次被pin时从replacer中移出（pin本身记为一次访问），
+ * 已被pin的帧只通知replacer记录访问，不获取任何锁，因此无锁路径和加锁路径对访问的记录方式相同
+ * @param {frame_id_t} frame_id 命中的帧
+ * @param {int} pin_count 本次pin之前帧的pin_count_
+ */
+void BufferPoolInstance::record_hit(frame_id_t frame_id, int pin_count) {
+    if (pin_count == 0) {
+        replacer_->pin(frame_id);
+    } else {
+        replacer_->record_access(frame_id);
+    }
+}
+
+/**
+ * @description: 释放latch_下持有的一个pin。帧中的页面已失效（预读失败）时，最后一个pin释放后把帧放回free_list_，
+ * 否则pin_count_归零时把帧加入replacer。调用者需持有latch_
+ * @param {frame_id_t} frame_id 目标帧
+ */
+void BufferPoolInstance::release_pin(frame_id_t frame_id) {
+    Page* page = &pages_[frame_id];
+    if (page->id_.page_no == INVALID_PAGE_ID) {
+        int expected = 1;
+        if (page->pin_count_.compare_exchange_strong(expected, -1)) {
+            free_frame(frame_id);
+            return;
+        }
+    }
+    if (--page->pin_count_ == 0) {
+        replacer_->unpin(frame_id);
+    }
+}
+
+/**
+ * @description: 更新page元数据(data, is_dirty, page_id)和page table，将frame切换为新页面。
+ * 如果旧页面为脏页，则把它的数据复制到writeback_buf中并登记到writeback_pages_，由调用者在释放latch后写回磁盘，
+ * 写回完成前其他线程读取该页面会等待
+ * @return {bool} 旧页面是否需要写回
+ * @param {Page*} page 写回页指针
+ * @param {PageId} new_page_id 新的page_id
+ * @param {frame_id_t} new_frame_id 新的帧frame_id
+ * @param {PageId*} old_page_id 返回旧页面的page_id
+ */
+bool BufferPoolInstance::update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id, PageId* old_page_id) {
+    *old_page_id = page->id_;
+    bool need_writeback = page->is_dirty() && page->id_.page_no != INVALID_PAGE_ID;
+    if (page->id_.page_no != INVALID_PAGE_ID && new_page_id.page_no != INVALID_PAGE_ID) {
+        count_event(page->id_, BP_EVICTION);
+    }
+    if (need_writeback) {
+        count_event(page->id_, BP_DIRTY_WRITEBACK);
+        memcpy(writeback_buf, page->get_data(), PAGE_SIZE);
+        writeback_pages_.insert(page->id_);
+        page->is_dirty_ = false;
+        cleaner_counters_.foreground_writebacks++;
+    } else if (page->cleaned_) {
+        cleaner_counters_.stalls_avoided++;
+    }
+    page->cleaned_ = false;
+
+    page_table_.erase(page->id_);
+    if (new_page_id.page_no != INVALID_PAGE_ID) {
+        page_table_.insert(new_page_id, new_frame_id);
+    }
+
+    page->reset_memory();
+    page->set_page_lsn(0);
+    page->id_ = new_page_id;
+    return need_writeback;
+}
+
+/**
+ * @description: 旧页面写回完成后，将其从writeback_pages_中移除并唤醒等待的线程，调用者需持有latch_
+ * @param {PageId} old_page_id 写回完成的页面
+ */
+void BufferPoolInstance::finish_writeback(PageId old_page_id) {
+    writeback_pages_.erase(old_page_id);
+    io_cv_.notify_all();
+}
+
+/**
+ * @description: 在不持有latch_的情况下写回update_page换出的脏页，完成后重新获得latch_
+ * @param {unique_lock<mutex>&} lock 持有latch_的锁
+ * @param {PageId} old_page_id 被换出的脏页，其数据已复制到writeback_buf中
+ */
+void BufferPoolInstance::write_back(std::unique_lock<std::mutex>& lock, PageId old_page_id) {
+    lock.unlock();
+    auto batch = std::make_shared<IoBatch>();
+    batch->add_write(old_page_id.fd, old_page_id.page_no, writeback_buf, PAGE_SIZE);
+    bool success = true;
+    try {
+        io_backend_->submit_and_wait(batch);
+    } catch (RMDBError& e) {
+        success = false;
+    }
+    lock.lock();
+    finish_writeback(old_page_id);
+    if (!success) {
+        throw InternalError("BufferPoolInstance::write_back Error");
+    }
+}
+
+/**
+ * @description: 等待目标页面上正在进行的读取完成，调用者需持有latch_且已经pin住该页面
+ * @param {unique_lock<mutex>&} lock 持有latch_的锁，等待期间会被释放
+ * @param {Page*} page 目标页面
+ */
+void BufferPoolInstance::wait_for_io(std::unique_lock<std::mutex>& lock, Page* page) {
+    if (page->io_pending_) {
+        count_event(page->id_, BP_PIN_WAIT);
+    }
+    io_cv_.wait(lock, [&] { return !page->io_pending_; });
+}
+
+/**
+ * @description: fetch_page的快速路径：不加latch_查找页表，通过CAS增加pin_count_后确认帧中确实是目标页面。
+ * 页面不在页表中、帧正在被替换或CAS期间帧被换成其他页面时返回nullptr，由调用者在latch_下重新获取
+ * @return {Page*} 命中时返回已pin住的页面，否则返回nullptr
+ * @param {PageId} page_id 需要获取的页的PageId
+ */
+Page* BufferPoolInstance::try_fetch_page(PageId page_id) {
+    frame_id_t frame_id = page_table_.find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+        return nullptr;
+    }
+    Page* page = &pages_[frame_id];
+    int pin_count = page->pin_count_.load();
+    do {
+        if (pin_count < 0) {
+            return nullptr;
+        }
+    } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+
+    // 持有pin之后帧中的页面不会再被替换，此时再检查页面是否正是目标页面
+    if (page->id_ == page_id && !page->io_pending_) {
+        record_hit(frame_id, pin_count);
+        count_event(page_id, BP_HIT);
+        return page;
+    }
+    std::unique_lock lock{latch_};
+    wait_for_io(lock, page);
+    if (page->id_ == page_id) {
+        record_hit(frame_id, pin_count);
+        count_event(page_id, BP_HIT);
+        return page;
+    }
+    release_pin(frame_id);
+    return nullptr;
+}
+
+/**
+ * @description: 从buffer pool获取需要的页。
+ *              如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。命中时通常不需要获取latch_。
+ *              如果页表不存在page_id（说明该page在磁盘中），则找缓冲池victim
+ * page，将其替换为磁盘中读取的page，pin_count置1。
+ *              磁盘读写在释放latch_之后进行，期间其他线程可以继续访问该分区中的其他页面
+ * @return {Page*} 若获得了需要的页则将其返回，否则返回nullptr
+ * @param {PageId} page_id 需要获取的页的PageId
+ */
+Page* BufferPoolInstance::fetch_page(PageId page_id) {
+    // Todo:
+    //  0.     不加锁查找页表并尝试pin住目标页，成功则直接返回
+    //  1.     从page_table_中搜寻目标页
+    //  1.1    若目标页有被page_table_记录，则将其所在frame固定(pin)，等待其上的读取完成后返回目标页。
+    //  1.2    否则，尝试调用find_victim_page获得一个可用的frame，若失败则返回nullptr
+    //  2.     调用update_page切换frame，若frame存储的为dirty page，则在释放latch后将其写回到磁盘
+    //  3.     释放latch，通过io_backend_读取目标页到frame
+    //  4.     固定目标页，更新pin_count_
+    //  5.     返回目标页
+    if (Page* page = try_fetch_page(page_id)) {
+        return page;
+    }
+
+    std::unique_lock lock{latch_};
+
+    while (true) {
+        frame_id_t frame_id = page_table_.find(page_id);
+        if (frame_id != INVALID_FRAME_ID) {
+            Page* page = &pages_[frame_id];
+            record_hit(frame_id, page->pin_count_++);
+            wait_for_io(lock, page);
+            if (page->id_ == page_id) {
+                count_event(page_id, BP_HIT);
+                return page;
+            }
+            // 该页面的预读失败，帧已被腾空，释放pin后重新读取
+            release_pin(frame_id);
+            continue;
+        }
+        if (writeback_pages_.count(page_id) == 0) {
+            break;
+        }
+        // 该页面的旧版本正在写回，等写回完成后再从磁盘读取
+        count_event(page_id, BP_PIN_WAIT);
+        io_cv_.wait(lock);
+    }
+
+    frame_id_t frame_id;
+    if (!find_victim_page(&frame_id)) {
+        return nullptr;
+    }
+
+    count_event(page_id, BP_MISS);
+    Page* page = &pages_[frame_id];
+    // 帧的pin_count_为-1，此时还不能被无锁地pin住。在页面进入页表、pin_count_变为1之前先标记读取未完成，
+    // 否则try_fetch_page可能在这两步之间pin住该帧并读到尚未读入的数据
+    page->io_pending_ = true;
+    PageId old_page_id;
+    bool need_writeback = update_page(page, page_id, frame_id, &old_page_id);
+    replacer_->pin(frame_id);
+    page->pin_count_ = 1;
+    lock.unlock();
+
+    auto batch = std::make_shared<IoBatch>();
+    if (need_writeback) {
+        batch->add_write(old_page_id.fd, old_page_id.page_no, writeback_buf, PAGE_SIZE);
+    }
+    batch->add_read(page_id.fd, page_id.page_no, page->get_data(), PAGE_SIZE);
+    bool success = true;
+    try {
+        io_backend_->submit_and_wait(batch);
+    } catch (RMDBError& e) {
+        success = false;
+    }
+
+    lock.lock();
+    if (need_writeback) {
+        finish_writeback(old_page_id);
+    }
+    page->io_pending_ = false;
+    io_cv_.notify_all();
+    if (!success) {
+        // 与同步读取时的行为一致：页面留在缓冲池中，释放本线程的pin后抛出异常
+        if (--page->pin_count_ == 0) {
+            replacer_->unpin(frame_id);
+        }
+        throw InternalError("BufferPoolInstance::fetch_page Error");
+    }
+    return page;
+}
+
+/**
+ * @description: 为预读准备一个帧：目标页面不在缓冲池中时，取一个空闲帧或干净的可淘汰帧，
+ * 把读请求加入batch。预读不会为了腾出帧而写回脏页，可淘汰的帧是脏页时放弃本次预读。
+ * 读取完成前该帧由预读持有一个pin，其他线程访问该页面时会等待读取完成
+ * @return {bool} 是否为该页面发起了预读
+ * @param {PageId} page_id 需要预读的页面
+ * @param {IoBatch*} batch 读请求加入的批次
+ * @param {frame_id_t*} frame_id 返回为该页面准备的帧，读取完成后需调用finish_prefetch
+ */
+bool BufferPoolInstance::prepare_prefetch(PageId page_id, IoBatch* batch, frame_id_t* frame_id) {
+    std::scoped_lock lock{latch_};
+
+    if (page_table_.count(page_id) != 0 || writeback_pages_.count(page_id) != 0) {
+        return false;
+    }
+    if (!find_victim_page(frame_id)) {
+        return false;
+    }
+    Page* page = &pages_[*frame_id];
+    if (page->is_dirty_) {
+        // 放回replacer，由前台淘汰或后台写回线程处理
+        page->pin_count_ = 0;
+        replacer_->unpin(*frame_id);
+        return false;
+    }
+    // 与fetch_page相同，在页面对无锁路径可见之前标记读取未完成
+    page->io_pending_ = true;
+    PageId old_page_id;
+    update_page(page, page_id, *frame_id, &old_page_id);
+    // 帧已经不在replacer中，这里不调用replacer_->pin，预读本身不计为一次访问
+    page->pin_count_ = 1;
+    batch->add_read(page_id.fd, page_id.page_no, page->get_data(), PAGE_SIZE);
+    return true;
+}
+
+/**
+ * @description: 预读完成后在I/O完成线程中调用，释放预读持有的pin。
+ * 读取失败时把页面移出页表，等待该页面的线程会发现帧已被腾空并重新读取
+ * @param {frame_id_t} frame_id prepare_prefetch返回的帧
+ * @param {bool} success 读取是否成功
+ */
+void BufferPoolInstance::finish_prefetch(frame_id_t frame_id, bool success) {
+    std::scoped_lock lock{latch_};
+
+    Page* page = &pages_[frame_id];
+    page->io_pending_ = false;
+    if (!success) {
+        page_table_.erase(page->id_);
+        page->id_.page_no = INVALID_PAGE_ID;
+    }
+    release_pin(frame_id);
+    io_cv_.notify_all();
+}
+
+/**
+ * @description: 取消固定pin_count>0的在缓冲池中的page
+ * @return {bool} 如果目标页的pin_count<=0则返回false，否则返回true
+ * @param {PageId} page_id 目标page的page_id
+ * @param {bool} is_dirty 若目标page应该被标记为dirty则为true，否则为false
+ */
+bool BufferPoolInstance::unpin_page(PageId page_id, bool is_dirty) {
+    // Todo:
+    // 1. 尝试在page_table_中搜寻page_id对应的页P，无锁查找未命中时在latch_下再查找一次
+    // 1.1 P在页表中不存在 return false
+    // 1.2 P在页表中存在，根据参数is_dirty，更改P的is_dirty_
+    // 2.1 若pin_count_已经小于等于0，则返回false
+    // 2.2 若pin_count_大于0，则通过CAS使pin_count_自减一
+    // 2.2.1 若自减后等于0，则调用replacer_的Unpin
+    frame_id_t frame_id = page_table_.find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+        std::scoped_lock lock{latch_};
+        frame_id = page_table_.find(page_id);
+        if (frame_id == INVALID_FRAME_ID) {
+            return false;
+        }
+    }
+
+    // 调用者持有pin，页面不会被替换。脏标记必须在释放pin之前设置，否则页面可能在标记前被当作干净页换出
+    Page* page = &pages_[frame_id];
+    if (is_dirty) {
+        page->is_dirty_ = true;
+    }
+    int pin_count = page->pin_count_.load();
+    do {
+        if (pin_count <= 0) {
+            return false;
+        }
+    } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+    if (pin_count == 1) {
+        replacer_->unpin(frame_id);
+    }
+    return true;
+}
+
+/**
+ * @description: 将目标页写回磁盘，不考虑当前页面是否正在被使用。写回通过io_backend_在释放latch_之后进行
+ * @return {bool} 成功则返回true，否则返回false(只有page_table_中没有目标页时)
+ * @param {PageId} page_id 目标页的page_id，不能为INVALID_PAGE_ID
+ */
+bool BufferPoolInstance::flush_page(PageId page_id) {
+    // Todo:
+    // 0. lock latch
+    // 1. 查找页表,尝试获取目标页P
+    // 1.1 目标页P没有被page_table_记录 ，返回false
+    // 2. 无论P是否为脏都将其写回磁盘。
+    // 3. 更新P的is_dirty_
+
+    std::unique_lock lock{latch_};
+
+    frame_id_t frame_id;
+    while (true) {
+        frame_id = page_table_.find(page_id);
+        if (frame_id == INVALID_FRAME_ID) {
+            return false;
+        }
+        Page* page = &pages_[frame_id];
+        if (!page->io_pending_ && !page->flushing_) {
+            break;
+        }
+        // 等待期间没有pin住该帧，帧可能被换成其他页面，唤醒后重新查找页表
+        io_cv_.wait(lock);
+    }
+    flush_frames(lock, {frame_id}, false);
+    return true;
+}
+
+/**
+ * @description: 创建一个新的page，即从磁盘中移动一个新建的空page到缓冲池某个位置。
+ * @return {Page*} 返回新创建的page，若创建失败则返回nullptr
+ * @param {PageId*} page_id 当成功创建一个新的page时存储其page_id
+ */
+Page* BufferPoolInstance::new_page(PageId* page_id) {
+    // 1.   获得一个可用的frame，若无法获得则返回nullptr
+    // 2.   在fd对应的文件分配一个新的page_id
+    // 3.   将frame的数据写回磁盘
+    // 4.   固定frame，更新pin_count_
+    // 5.   返回获得的page
+    std::unique_lock lock{latch_};
+
+    frame_id_t frame_id;
+    if (!find_victim_page(&frame_id)) {
+        return nullptr;
+    }
+
+    page_id->page_no = disk_manager_->allocate_page(page_id->fd);
+    count_event(*page_id, BP_NEW_PAGE);
+    Page* page = &pages_[frame_id];
+    PageId old_page_id;
+    bool need_writeback = update_page(page, *page_id, frame_id, &old_page_id);
+    replacer_->pin(frame_id);
+    page->pin_count_ = 1;
+
+    if (need_writeback) {
+        write_back(lock, old_page_id);
+    }
+    return page;
+}
+
+/**
+ * @description: 从buffer_pool删除目标页
+ * @return {bool} 如果目标页不存在于buffer_pool或者成功被删除则返回true，若其存在于buffer_pool但无法删除则返回false
+ * @param {PageId} page_id 目标页
+ */
+bool BufferPoolInstance::delete_page(PageId page_id) {
+    // 1.   在page_table_中查找目标页，若不存在返回true
+    // 2.   若目标页的pin_count不为0，则返回false
+    // 3.   将目标页数据写回磁盘，从页表中删除目标页，重置其元数据，将其加入free_list_，返回true
+
+    std::unique_lock lock{latch_};
+
+    frame_id_t frame_id = page_table_.find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+        return true;
+    }
+
+    // 与find_victim_page相同，把pin_count_从0改为-1，防止其他线程无锁地pin住该页面
+    Page* page = &pages_[frame_id];
+    int expected = 0;
+    if (!page->pin_count_.compare_exchange_strong(expected, -1)) {
+        return false;
+    }
+    disk_manager_->deallocate_page(page_id.fd);
+    PageId new_page_id = page->id_;
+    new_page_id.page_no = INVALID_PAGE_ID;
+    PageId old_page_id;
+    bool need_writeback = update_page(page, new_page_id, frame_id, &old_page_id);
+    free_frame(frame_id);
+
+    if (need_writeback) {
+        write_back(lock, old_page_id);
+    }
+    return true;
+}
+
+/**
+ * @description: 将buffer_pool中的所有页写回到磁盘。写回期间这些页面被pin住，写请求作为一个批次并发提交
+ * @param {int} fd 文件句柄
+ */
+void BufferPoolInstance::flush_all_pages(int fd) {
+    std::unique_lock lock{latch_};
+
+    // 等待后台写回线程正在写回的该文件页面完成，避免两次写回的顺序颠倒
+    io_cv_.wait(lock, [&] {
+        for (size_t i = 0; i < pool_size_; i++) {
+            if (pages_[i].flushing_ && pages_[i].id_.fd == fd) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    std::vector<frame_id_t> frames;
+    for (size_t i = 0; i < pool_size_; i++) {
+        Page* page = &pages_[i];
+        PageId page_id = page->get_page_id();
+        // 正在读取中的页面与磁盘上的内容一致，不需要写回
+        if (page_id.fd == fd && page_id.page_no != INVALID_PAGE_ID && !page->io_pending_) {
+            frames.push_back(i);
+        }
+    }
+    flush_frames(lock, frames, false);
+}
+
+/**
+ * @description: 后台写回：当该分区中空闲帧与干净的可淘汰帧少于low_water个时，从上次的位置开始按时钟顺序扫描，
+ * 写回至多max_pages个未被pin住的脏页。开启WAL检查时，页面LSN大于durable_lsn的脏页会被跳过
+ * @return {size_t} 写回的页面数
+ * @param {size_t} low_water 希望保持的空闲帧与干净可淘汰帧的最少个数
+ * @param {size_t} max_pages 本轮最多写回的页面数
+ * @param {bool} check_wal 是否检查页面LSN
+ * @param {lsn_t} durable_lsn 已持久化到磁盘的最大日志LSN
+ */
+size_t BufferPoolInstance::clean_pages(size_t low_water, size_t max_pages, bool check_wal, lsn_t durable_lsn) {
+    std::unique_lock lock{latch_};
+
+    if (free_list_.size() >= low_water) {
+        return 0;
+    }
+    // 从cleaner_hand_开始扫描一整圈，统计干净的可淘汰帧，同时按顺序记录可以写回的脏页
+    size_t clean = free_list_.size();
+    std::vector<frame_id_t> candidates;
+    for (size_t i = 0; i < pool_size_; i++) {
+        frame_id_t frame_id = static_cast<frame_id_t>((cleaner_hand_ + i) % pool_size_);
+        Page* page = &pages_[frame_id];
+        if (page->id_.page_no == INVALID_PAGE_ID || page->pin_count_ > 0 || page->io_pending_) {
+            continue;
+        }
+        if (!page->is_dirty_) {
+            clean++;
+        } else if (check_wal && page->get_page_lsn() > durable_lsn) {
+            cleaner_counters_.wal_deferred++;
+        } else if (candidates.size() < max_pages) {
+            candidates.push_back(frame_id);
+        }
+    }
+    if (clean >= low_water) {
+        return 0;
+    }
+    std::vector<frame_id_t> frames(candidates.begin(),
+                                   candidates.begin() + std::min(candidates.size(), low_water - clean));
+    if (!frames.empty()) {
+        cleaner_hand_ = (frames.back() + 1) % pool_size_;
+    }
+    flush_frames(lock, frames, true);
+    cleaner_counters_.pages_flushed += frames.size();
+    return frames.size();
+}
+
+/**
+ * @description: 在不持有latch_的情况下把一批帧写回磁盘。写回期间这些帧被临时pin住（不经过replacer，
+ * 以免改变它们的淘汰顺序），写回前先清除脏标记，写回期间再次被修改的页面会重新被标记为脏页
+ * @param {unique_lock<mutex>&} lock 持有latch_的锁
+ * @param {vector<frame_id_t>&} frames 需要写回的帧
+ * @param {bool} by_cleaner 是否由后台写回线程发起
+ */
+void BufferPoolInstance::flush_frames(std::unique_lock<std::mutex>& lock, const std::vector<frame_id_t>& frames,
+                                      bool by_cleaner) {
+    if (frames.empty()) {
+        return;
+    }
+    auto batch = std::make_shared<IoBatch>();
+    for (frame_id_t frame_id : frames) {
+        Page* page = &pages_[frame_id];
+        page->pin_count_++;
+        page->flushing_ = true;
+        if (page->is_dirty_) {
+            count_event(page->id_, BP_DIRTY_WRITEBACK);
+        }
+        page->is_dirty_ = false;
+        batch->add_write(page->id_.fd, page->id_.page_no, page->get_data(), PAGE_SIZE);
+    }
+    lock.unlock();
+
+    bool success = true;
+    try {
+        io_backend_->submit_and_wait(batch);
+    } catch (RMDBError& e) {
+        success = false;
+    }
+
+    lock.lock();
+    for (frame_id_t frame_id : frames) {
+        Page* page = &pages_[frame_id];
+        page->flushing_ = false;
+        if (!success) {
+            page->is_dirty_ = true;
+        } else if (by_cleaner && !page->is_dirty_) {
+            page->cleaned_ = true;
+        }
+        if (--page->pin_count_ == 0) {
+            // 写回期间该帧可能已被find_victim_page从replacer中取出并跳过，这里重新加入
+            replacer_->unpin(frame_id);
+        }
+    }
+    io_cv_.notify_all();
+    if (!success) {
+        throw InternalError("BufferPoolInstance::flush_frames Error");
+    }
+}
+
+/**
+ * @description: 在线调整该分区的帧数。扩容时把新增的帧加入free_list_；缩容时腾空编号不小于new_size的帧：
+ * 空闲帧直接移出，未被pin住的帧先换出（脏页写回磁盘），被pin住的帧等待其释放后再换出，超过timeout仍未释放时
+ * 只缩小到最后一个仍被pin住的帧之后。被移出的帧的物理内存归还给操作系统
+ * @return {size_t} 调整后的帧数
+ * @param {size_t} new_size 目标帧数，会被限制在[1, max_pool_size_]之间
+ * @param {milliseconds} timeout 缩容时等待被pin住的帧释放的最长时间
+ */
+size_t BufferPoolInstance::resize(size_t new_size, std::chrono::milliseconds timeout) {
+    std::scoped_lock resize_lock{resize_latch_};
+    std::unique_lock lock{latch_};
+
+    new_size = std::clamp<size_t>(new_size, 1, max_pool_size_);
+    size_t old_size = pool_size_;
+    if (new_size >= old_size) {
+        for (size_t i = old_size; i < new_size; i++) {
+            free_list_.push_back(static_cast<frame_id_t>(i));
+        }
+        pool_size_ = new_size;
+        retire_from_ = new_size;
+        return new_size;
+    }
+
+    // 此后find_victim_page不再选择这些帧，被释放的帧也不会回到free_list_
+    retire_from_ = new_size;
+    free_list_.remove_if([&](frame_id_t frame_id) {
+        if (static_cast<size_t>(frame_id) < new_size) {
+            return false;
+        }
+        retired_[frame_id] = true;
+        return true;
+    });
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        bool all_retired = true;
+        for (size_t i = new_size; i < old_size; i++) {
+            if (retired_[i]) {
+                continue;
+            }
+            // 与find_victim_page相同，把pin_count_从0改为-1后该帧不能再被pin住
+            Page* page = &pages_[i];
+            int expected = 0;
+            if (!page->pin_count_.compare_exchange_strong(expected, -1)) {
+                all_retired = false;
+                continue;
+            }
+            if (page->id_.page_no != INVALID_PAGE_ID) {
+                count_event(page->id_, BP_EVICTION);
+            }
+            PageId new_page_id = page->id_;
+            new_page_id.page_no = INVALID_PAGE_ID;
+            PageId old_page_id;
+            bool need_writeback = update_page(page, new_page_id, static_cast<frame_id_t>(i), &old_page_id);
+            replacer_->remove(static_cast<frame_id_t>(i));
+            retired_[i] = true;
+            if (need_writeback) {
+                write_back(lock, old_page_id);
+            }
+        }
+        if (all_retired || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        lock.lock();
+    }
+
+    // 仍被pin住的帧不能移出，只缩小到最后一个这样的帧之后，其余已腾空的帧放回free_list_
+    size_t achieved = old_size;
+    while (achieved > new_size && retired_[achieved - 1]) {
+        achieved--;
+    }
+    for (size_t i = new_size; i < old_size; i++) {
+        if (retired_[i] && i < achieved) {
+            free_list_.push_back(static_cast<frame_id_t>(i));
+        }
+        retired_[i] = false;
+    }
+    pool_size_ = achieved;
+    retire_from_ = achieved;
+    lock.unlock();
+
+    frames_.release(achieved, old_size);
+    return achieved;
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "async_io.h"
+#include "disk_manager.h"
+#include "errors.h"
+#include "frame_region.h"
+#include "page.h"
+#include "page_cleaner.h"
+#include "page_table.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/lru_replacer.h"
+#include "replacer/replacer.h"
+#include "stats.h"
+
+/**
+ * @description: 缓冲池的一个分区。每个分区拥有独立的帧数组、页表、空闲链表、置换器和锁，
+ * 由BufferPoolManager根据PageId的哈希值将页面分配到某个分区，不同分区之间的操作互不阻塞。
+ * 帧的个数可以在运行时通过resize在[1, max_pool_size_]之间调整
+ */
+class BufferPoolInstance {
+   private:
+    std::atomic<size_t> pool_size_; // 该分区当前可容纳页面的个数，即正在使用的帧的个数
+    size_t max_pool_size_;  // 该分区最多可以增长到的帧数，帧内存、元数据和页表都按它预留
+    size_t retire_from_;    // 编号不小于它的帧正在被缩容移出，不再分配给新页面；不缩容时等于pool_size_
+    FrameRegion frames_;    // 该分区的帧内存，按页对齐的一整块内存
+    Page *pages_;           // 该分区中帧的元数据数组，在构造函数中申请内存空间，在析构函数中释放，大小为max_pool_size_
+    PageTable page_table_;  // 帧号和页面号的映射哈希表，用于根据页面的PageId定位该页面的帧编号，命中时可以不加锁查找
+    std::list<frame_id_t> free_list_;   // 空闲帧编号的链表
+    std::vector<bool> retired_;         // 缩容过程中已经移出的帧
+    DiskManager *disk_manager_;
+    AsyncIoBackend *io_backend_;    // 缺页读取和脏页写回通过它在释放latch_之后进行
+    Replacer *replacer_;    // 该分区的置换策略，由REPLACER_TYPE选择LRU、CLOCK或LRU-K
+    std::mutex latch_;      // 用于该分区内共享数据结构的并发控制
+    std::mutex resize_latch_;   // 串行化对该分区的扩容和缩容
+    std::condition_variable io_cv_; // 页面读取或写回完成时通知等待的线程
+    std::unordered_set<PageId, PageIdHash> writeback_pages_;    // 已被换出、正在写回磁盘的脏页
+    size_t cleaner_hand_ = 0;       // 后台写回线程的扫描位置
+    PageCleanerCounters cleaner_counters_;  // 后台写回相关的计数器
+    BufferPoolCounters counters_;   // 命中、缺页、换出等事件的分片计数器
+
+   public:
+    /**
+     * @param {size_t} pool_size 初始帧数
+     * @param {size_t} max_pool_size 通过resize最多可以增长到的帧数，为0时等于pool_size
+     */
+    BufferPoolInstance(size_t pool_size, DiskManager *disk_manager, AsyncIoBackend *io_backend, int numa_node = -1,
+                       size_t max_pool_size = 0)
+        : pool_size_(pool_size),
+          max_pool_size_(std::max(pool_size, max_pool_size)),
+          retire_from_(pool_size),
+          frames_(max_pool_size_, BUFFER_POOL_HUGE_PAGES, numa_node),
+          page_table_(max_pool_size_),
+          retired_(max_pool_size_, false),
+          disk_manager_(disk_manager),
+          io_backend_(io_backend) {
+        // 为该分区分配一块连续的内存空间，元数据与帧数据分开存放
+        pages_ = new Page[max_pool_size_];
+        for (size_t i = 0; i < max_pool_size_; ++i) {
+            pages_[i].data_ = frames_.get_frame(i);
+            pages_[i].pin_count_ = -1;
+        }
+        // 可以被Replacer改变
+        if (REPLACER_TYPE == "CLOCK")
+            replacer_ = new ClockReplacer(max_pool_size_);
+        else if (REPLACER_TYPE == "LRU-K")
+            replacer_ = new LRUKReplacer(max_pool_size_);
+        else {
+            replacer_ = new LRUReplacer(max_pool_size_);
+        }
+        // 初始化时，所有的page都在free_list_中
+        for (size_t i = 0; i < pool_size; ++i) {
+            free_list_.emplace_back(static_cast<frame_id_t>(i));  // static_cast转换数据类型
+        }
+    }
+
+    ~BufferPoolInstance() {
+        delete[] pages_;
+        delete replacer_;
+    }
+
+    size_t get_pool_size() const { return pool_size_; }
+
+    size_t get_max_pool_size() const { return max_pool_size_; }
+
+    const FrameRegion& get_frame_region() const { return frames_; }
+
+    const PageCleanerCounters& get_cleaner_counters() const { return cleaner_counters_; }
+
+    BufferPoolStats get_stats() const { return {counters_.snapshot()}; }
+
+    Page* fetch_page(PageId page_id);
+
+    bool unpin_page(PageId page_id, bool is_dirty);
+
+    bool flush_page(PageId page_id);
+
+    Page* new_page(PageId* page_id);
+
+    bool delete_page(PageId page_id);
+
+    void flush_all_pages(int fd);
+
+    size_t clean_pages(size_t low_water, size_t max_pages, bool check_wal, lsn_t durable_lsn);
+
+    bool prepare_prefetch(PageId page_id, IoBatch* batch, frame_id_t* frame_id);
+
+    void finish_prefetch(frame_id_t frame_id, bool success);
+
+    size_t resize(size_t new_size, std::chrono::milliseconds timeout);
+
+   private:
+    Page* try_fetch_page(PageId page_id);
+
+    void release_pin(frame_id_t frame_id);
+
+    void record_hit(frame_id_t frame_id, int pin_count);
+
+    /**
+     * @description: 同时记录到该分区和页面所属文件的计数器中
+     */
+    void count_event(PageId page_id, BufferPoolEvent event, uint64_t value = 1) {
+        counters_.add(event, value);
+        if (BufferPoolCounters* file_counters = disk_manager_->get_file_counters(page_id.fd)) {
+            file_counters->add(event, value);
+        }
+    }
+
+    void free_frame(frame_id_t frame_id);
+
+    bool find_victim_page(frame_id_t* frame_id);
+
+    bool update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id, PageId* old_page_id);
+
+    void write_back(std::unique_lock<std::mutex>& lock, PageId old_page_id);
+
+    void finish_writeback(PageId old_page_id);
+
+    void wait_for_io(std::unique_lock<std::mutex>& lock, Page* page);
+
+    void flush_frames(std::unique_lock<std::mutex>& lock, const std::vector<frame_id_t>& frames, bool by_cleaner);
+};
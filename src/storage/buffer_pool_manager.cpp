@@ -11,90 +11,11 @@ See the Mulan PSL v2 for more details. */
 #include "buffer_pool_manager.h"
 
 /**
- * @description: 从free_list或replacer中得到可淘汰帧页的 *frame_id
- * @return {bool} true: 可替换帧查找成功 , false: 可替换帧查找失败
- * @param {frame_id_t*} frame_id 帧页id指针,返回成功找到的可替换帧id
- */
-bool BufferPoolManager::find_victim_page(frame_id_t* frame_id) {
-    // Todo:
-    // 1 使用BufferPoolManager::free_list_判断缓冲池是否已满需要淘汰页面
-    // 1.1 未满获得frame
-    // 1.2 已满使用lru_replacer中的方法选择淘汰页面
-
-    if (!free_list_.empty()) {
-        *frame_id = free_list_.front();
-        free_list_.pop_front();
-        return true;
-    } else {
-        return replacer_->victim(frame_id);
-    }
-}
-
-/**
- * @description: 更新页面数据, 如果为脏页则需写入磁盘，再更新为新页面，更新page元数据(data, is_dirty, page_id)和page
- * table
- * @param {Page*} page 写回页指针
- * @param {PageId} new_page_id 新的page_id
- * @param {frame_id_t} new_frame_id 新的帧frame_id
- */
-void BufferPoolManager::update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id) {
-    // Todo:
-    // 1 如果是脏页，写回磁盘，并且把dirty置为false
-    // 2 更新page table
-    // 3 重置page的data，更新page id
-    if (page->is_dirty()) {
-        disk_manager_->write_page(page->id_.fd, page->id_.page_no, page->get_data(), PAGE_SIZE);
-        page->is_dirty_ = false;
-    }
-
-    page_table_.erase(page->id_);
-    if (new_page_id.page_no != INVALID_PAGE_ID) {
-        page_table_[new_page_id] = new_frame_id;
-    }
-
-    page->reset_memory();
-    page->id_ = new_page_id;
-}
-
-/**
- * @description: 从buffer pool获取需要的页。
- *              如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。
- *              如果页表不存在page_id（说明该page在磁盘中），则找缓冲池victim
- * page，将其替换为磁盘中读取的page，pin_count置1。
+ * @description: 从页面所属的分区中获取需要的页
  * @return {Page*} 若获得了需要的页则将其返回，否则返回nullptr
  * @param {PageId} page_id 需要获取的页的PageId
  */
-Page* BufferPoolManager::fetch_page(PageId page_id) {
-    // Todo:
-    //  1.     从page_table_中搜寻目标页
-    //  1.1    若目标页有被page_table_记录，则将其所在frame固定(pin)，并返回目标页。
-    //  1.2    否则，尝试调用find_victim_page获得一个可用的frame，若失败则返回nullptr
-    //  2.     若获得的可用frame存储的为dirty page，则须调用updata_page将page写回到磁盘
-    //  3.     调用disk_manager_的read_page读取目标页到frame
-    //  4.     固定目标页，更新pin_count_
-    //  5.     返回目标页
-    std::scoped_lock lock{latch_};
-
-    if (page_table_.find(page_id) != page_table_.end()) {
-        frame_id_t frame_id = page_table_[page_id];
-        replacer_->pin(frame_id);
-        Page* page = &pages_[frame_id];
-        page->pin_count_++;
-        return page;
-    }
-
-    frame_id_t frame_id;
-    if (!find_victim_page(&frame_id)) {
-        return nullptr;
-    }
-
-    Page* page = &pages_[frame_id];
-    update_page(page, page_id, frame_id);
-    disk_manager_->read_page(page_id.fd, page_id.page_no, page->get_data(), PAGE_SIZE);
-    replacer_->pin(frame_id);
-    page->pin_count_ = 1;
-    return page;
-}
+Page* BufferPoolManager::fetch_page(PageId page_id) { return get_instance(page_id)->fetch_page(page_id); }
 
 /**
  * @description: 取消固定pin_count>0的在缓冲池中的page
@@ -103,35 +24,7 @@ Page* BufferPoolManager::fetch_page(PageId page_id) {
  * @param {bool} is_dirty 若目标page应该被标记为dirty则为true，否则为false
  */
 bool BufferPoolManager::unpin_page(PageId page_id, bool is_dirty) {
-    // Todo:
-    // 0. lock latch
-    // 1. 尝试在page_table_中搜寻page_id对应的页P
-    // 1.1 P在页表中不存在 return false
-    // 1.2 P在页表中存在，获取其pin_count_
-    // 2.1 若pin_count_已经等于0，则返回false
-    // 2.2 若pin_count_大于0，则pin_count_自减一
-    // 2.2.1 若自减后等于0，则调用replacer_的Unpin
-    // 3 根据参数is_dirty，更改P的is_dirty_
-    std::scoped_lock lock{latch_};
-
-    if (page_table_.find(page_id) == page_table_.end()) {
-        return false;
-    }
-
-    frame_id_t frame_id = page_table_[page_id];
-    Page* page = &pages_[frame_id];
-    if (page->pin_count_ == 0) {
-        return false;
-    }
-    page->pin_count_--;
-    if (page->pin_count_ == 0) {
-        replacer_->unpin(frame_id);
-    }
-
-    if (is_dirty) {
-        page->is_dirty_ = true;
-    }
-    return true;
+    return get_instance(page_id)->unpin_page(page_id, is_dirty);
 }
 
 /**
@@ -139,51 +32,20 @@ bool BufferPoolManager::unpin_page(PageId page_id, bool is_dirty) {
  * @return {bool} 成功则返回true，否则返回false(只有page_table_中没有目标页时)
  * @param {PageId} page_id 目标页的page_id，不能为INVALID_PAGE_ID
  */
-bool BufferPoolManager::flush_page(PageId page_id) {
-    // Todo:
-    // 0. lock latch
-    // 1. 查找页表,尝试获取目标页P
-    // 1.1 目标页P没有被page_table_记录 ，返回false
-    // 2. 无论P是否为脏都将其写回磁盘。
-    // 3. 更新P的is_dirty_
-
-    std::scoped_lock lock{latch_};
-
-    if (page_table_.find(page_id) == page_table_.end()) {
-        return false;
-    }
-
-    frame_id_t frame_id = page_table_[page_id];
-    Page* page = &pages_[frame_id];
-    disk_manager_->write_page(page->id_.fd, page->id_.page_no, page->get_data(), PAGE_SIZE);
-    page->is_dirty_ = false;
-
-    return true;
-}
+bool BufferPoolManager::flush_page(PageId page_id) { return get_instance(page_id)->flush_page(page_id); }
 
 /**
- * @description: 创建一个新的page，即从磁盘中移动一个新建的空page到缓冲池某个位置。
+ * @description: 创建一个新的page。新页面的page_no由DiskManager顺序分配，
+ * 需要先根据即将分配的page_no选定分区，再由该分区完成分配，因此整个过程在new_page_latch_下串行执行
  * @return {Page*} 返回新创建的page，若创建失败则返回nullptr
  * @param {PageId*} page_id 当成功创建一个新的page时存储其page_id
  */
 Page* BufferPoolManager::new_page(PageId* page_id) {
-    // 1.   获得一个可用的frame，若无法获得则返回nullptr
-    // 2.   在fd对应的文件分配一个新的page_id
-    // 3.   将frame的数据写回磁盘
-    // 4.   固定frame，更新pin_count_
-    // 5.   返回获得的page
-    std::scoped_lock lock{latch_};
-
-    frame_id_t frame_id;
-    if (!find_victim_page(&frame_id)) {
-        return nullptr;
-    }
+    std::scoped_lock lock{new_page_latch_};
 
-    page_id->page_no = disk_manager_->allocate_page(page_id->fd);
-    Page* page = &pages_[frame_id];
-    update_page(page, *page_id, frame_id);
-    replacer_->pin(frame_id);
-    page->pin_count_ = 1;
+    PageId next_page_id{page_id->fd, disk_manager_->get_fd2pageno(page_id->fd)};
+    Page* page = get_instance(next_page_id)->new_page(page_id);
+    assert(page == nullptr || *page_id == next_page_id);
     return page;
 }
 
@@ -192,44 +54,128 @@ Page* BufferPoolManager::new_page(PageId* page_id) {
  * @return {bool} 如果目标页不存在于buffer_pool或者成功被删除则返回true，若其存在于buffer_pool但无法删除则返回false
  * @param {PageId} page_id 目标页
  */
-bool BufferPoolManager::delete_page(PageId page_id) {
-    // 1.   在page_table_中查找目标页，若不存在返回true
-    // 2.   若目标页的pin_count不为0，则返回false
-    // 3.   将目标页数据写回磁盘，从页表中删除目标页，重置其元数据，将其加入free_list_，返回true
+bool BufferPoolManager::delete_page(PageId page_id) { return get_instance(page_id)->delete_page(page_id); }
+
+/**
+ * @description: 将buffer_pool中属于fd的所有页写回到磁盘
+ * @param {int} fd 文件句柄
+ */
+void BufferPoolManager::flush_all_pages(int fd) {
+    for (auto& instance : instances_) {
+        instance->flush_all_pages(fd);
+    }
+}
 
-    std::scoped_lock lock{latch_};
+/**
+ * @description: 异步预读fd中的若干页面，立即返回。已在缓冲池中的页面和找不到干净空闲帧的页面会被跳过，
+ * 其余页面的读请求作为一个批次提交，读取完成后页面处于未pin状态，之后的fetch_page直接命中
+ * @return {size_t} 实际发起预读的页面数
+ * @param {int} fd 文件句柄
+ * @param {vector<page_id_t>&} page_nos 需要预读的页号
+ */
+size_t BufferPoolManager::prefetch_pages(int fd, const std::vector<page_id_t>& page_nos) {
+    auto batch = std::make_shared<IoBatch>();
+    std::vector<std::pair<BufferPoolInstance*, frame_id_t>> frames;
+    for (page_id_t page_no : page_nos) {
+        PageId page_id{fd, page_no};
+        BufferPoolInstance* instance = get_instance(page_id);
+        frame_id_t frame_id;
+        if (instance->prepare_prefetch(page_id, batch.get(), &frame_id)) {
+            frames.emplace_back(instance, frame_id);
+        }
+    }
+    if (frames.empty()) {
+        return 0;
+    }
+
+    {
+        std::scoped_lock lock{prefetch_latch_};
+        prefetch_inflight_++;
+    }
+    batch->set_callback([this, frames](bool success) {
+        for (auto& [instance, frame_id] : frames) {
+            instance->finish_prefetch(frame_id, success);
+        }
+        std::scoped_lock lock{prefetch_latch_};
+        if (--prefetch_inflight_ == 0) {
+            prefetch_cv_.notify_all();
+        }
+    });
+    // 提交时不持有任何分区的latch_，完成回调会获取分区latch_
+    io_backend_->submit(batch);
+    return frames.size();
+}
+
+/**
+ * @description: 等待所有已提交的预读完成
+ */
+void BufferPoolManager::wait_for_prefetch() {
+    std::unique_lock lock{prefetch_latch_};
+    prefetch_cv_.wait(lock, [&] { return prefetch_inflight_ == 0; });
+}
 
-    if (page_table_.find(page_id) == page_table_.end()) {
-        return true;
+/**
+ * @description: 启动后台写回线程，若已经启动则先停止旧的线程
+ * @param {function<lsn_t()>} durable_lsn 返回已持久化的最大日志LSN，用于保证WAL规则，为空时不做检查
+ * @param {size_t} pages_per_second 每秒最多写回的页面数
+ */
+void BufferPoolManager::start_page_cleaner(std::function<lsn_t()> durable_lsn, size_t pages_per_second) {
+    std::vector<BufferPoolInstance*> instances;
+    for (auto& instance : instances_) {
+        instances.push_back(instance.get());
     }
+    page_cleaner_.reset();
+    page_cleaner_ = std::make_unique<PageCleaner>(std::move(instances), std::move(durable_lsn), pages_per_second);
+}
 
-    frame_id_t frame_id = page_table_[page_id];
-    Page* page = &pages_[frame_id];
-    if (page->pin_count_ != 0) {
-        return false;
+/**
+ * @description: 停止后台写回线程，等待正在进行的一轮写回结束
+ */
+void BufferPoolManager::stop_page_cleaner() { page_cleaner_.reset(); }
+
+/**
+ * @description: 汇总各个分区的后台写回计数器
+ * @return {PageCleanerStats} 计数器快照
+ */
+PageCleanerStats BufferPoolManager::get_cleaner_stats() {
+    PageCleanerStats stats;
+    for (auto& instance : instances_) {
+        const PageCleanerCounters& counters = instance->get_cleaner_counters();
+        stats.pages_flushed += counters.pages_flushed;
+        stats.stalls_avoided += counters.stalls_avoided;
+        stats.foreground_writebacks += counters.foreground_writebacks;
+        stats.wal_deferred += counters.wal_deferred;
     }
-    disk_manager_->deallocate_page(page_id.fd);
-    PageId new_page_id = page->id_;
-    new_page_id.page_no = INVALID_PAGE_ID;
-    update_page(page, new_page_id, frame_id);
-    free_list_.push_back(frame_id);
+    return stats;
+}
 
-    return true;
+/**
+ * @description: 汇总各个分区的命中、缺页、换出等计数器
+ * @return {BufferPoolStats} 计数器快照
+ */
+BufferPoolStats BufferPoolManager::get_stats() {
+    BufferPoolStats stats;
+    for (auto& instance : instances_) {
+        stats += instance->get_stats();
+    }
+    return stats;
 }
 
 /**
- * @description: 将buffer_pool中的所有页写回到磁盘
- * @param {int} fd 文件句柄
+ * @description: 在线调整缓冲池的大小，按构造时相同的方式把帧平均分给各个分区，再逐个调整各个分区。
+ * 缩容时被pin住的页面不能移出，等待超过timeout后对应的分区只缩小到能达到的大小
+ * @return {size_t} 调整后缓冲池的实际大小
+ * @param {size_t} new_pool_size 目标页面个数，会被限制在[num_instances_, max_pool_size_]之间
+ * @param {milliseconds} timeout 每个分区缩容时等待被pin住的页面释放的最长时间
  */
-void BufferPoolManager::flush_all_pages(int fd) {
-    std::scoped_lock lock{latch_};
-
-    for (size_t i = 0; i < pool_size_; i++) {
-        Page* page = &pages_[i];
-        PageId page_id = page->get_page_id();
-        if (page_id.fd == fd && page_id.page_no != INVALID_PAGE_ID) {
-            disk_manager_->write_page(page_id.fd, page_id.page_no, page->get_data(), PAGE_SIZE);
-            page->is_dirty_ = false;
-        }
+size_t BufferPoolManager::resize(size_t new_pool_size, std::chrono::milliseconds timeout) {
+    std::scoped_lock lock{resize_latch_};
+
+    new_pool_size = std::clamp(new_pool_size, num_instances_, max_pool_size_);
+    size_t pool_size = 0;
+    for (size_t i = 0; i < num_instances_; ++i) {
+        pool_size += instances_[i]->resize(get_instance_size(new_pool_size, i), timeout);
     }
+    pool_size_ = pool_size;
+    return pool_size;
 }
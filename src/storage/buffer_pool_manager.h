@@ -9,52 +9,71 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #pragma once
-#include <fcntl.h>
-#include <unistd.h>
-
-#include <cassert>
-#include <list>
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "buffer_pool_instance.h"
 #include "disk_manager.h"
 #include "errors.h"
 #include "page.h"
-#include "replacer/lru_replacer.h"
-#include "replacer/replacer.h"
 
+/**
+ * @description: 缓冲池管理器。内部由num_instances_个互相独立的BufferPoolInstance组成，
+ * 每个页面根据其PageId的哈希值固定映射到其中一个分区，从而把单一的全局latch拆分为多个分区latch，
+ * 多线程访问不同页面时不再相互阻塞。对外接口与单分区时保持一致。
+ * 缓冲池的大小可以通过resize在线调整，每个分区按比例扩容或缩容，页面到分区的映射保持不变。
+ */
 class BufferPoolManager {
    private:
-    size_t pool_size_;      // buffer_pool中可容纳页面的个数，即帧的个数
-    Page *pages_;           // buffer_pool中的Page对象数组，在构造空间中申请内存空间，在析构函数中释放，大小为BUFFER_POOL_SIZE
-    std::unordered_map<PageId, frame_id_t, PageIdHash> page_table_; // 帧号和页面号的映射哈希表，用于根据页面的PageId定位该页面的帧编号
-    std::list<frame_id_t> free_list_;   // 空闲帧编号的链表
+    std::atomic<size_t> pool_size_; // buffer_pool中可容纳页面的个数，即所有分区的帧数之和
+    size_t max_pool_size_;      // 通过resize最多可以增长到的页面个数
+    size_t num_instances_;      // 分区个数
     DiskManager *disk_manager_;
-    Replacer *replacer_;    // buffer_pool的置换策略，当前赛题中为LRU置换策略
-    std::mutex latch_;      // 用于共享数据结构的并发控制
+    std::unique_ptr<AsyncIoBackend> io_backend_;    // 各分区共用的异步I/O后端
+    std::vector<std::unique_ptr<BufferPoolInstance>> instances_;    // 各个分区
+    std::mutex new_page_latch_; // 串行化新页面的分配，保证分配到的page_no与事先选定的分区一致
+    std::mutex resize_latch_;   // 串行化resize
+    std::unique_ptr<PageCleaner> page_cleaner_; // 后台写回线程，未启动时为空
+    std::mutex prefetch_latch_;
+    std::condition_variable prefetch_cv_;
+    size_t prefetch_inflight_ = 0;  // 尚未完成的预读批次数，析构前需等待其归零
 
    public:
-    BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-        : pool_size_(pool_size), disk_manager_(disk_manager) {
-        // 为buffer pool分配一块连续的内存空间
-        pages_ = new Page[pool_size_];
-        // 可以被Replacer改变
-        if (REPLACER_TYPE.compare("LRU"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else if (REPLACER_TYPE.compare("CLOCK"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else {
-            replacer_ = new LRUReplacer(pool_size_);
-        }
-        // 初始化时，所有的page都在free_list_中
-        for (size_t i = 0; i < pool_size_; ++i) {
-            free_list_.emplace_back(static_cast<frame_id_t>(i));  // static_cast转换数据类型
+    /**
+     * @param {size_t} pool_size 初始页面个数
+     * @param {size_t} num_instances 分区个数
+     * @param {size_t} max_pool_size 通过resize最多可以增长到的页面个数，为0时等于pool_size，即不能扩容
+     */
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = BUFFER_POOL_INSTANCES,
+                      size_t max_pool_size = 0)
+        : pool_size_(pool_size),
+          max_pool_size_(std::max(pool_size, max_pool_size)),
+          num_instances_(num_instances),
+          disk_manager_(disk_manager),
+          io_backend_(AsyncIoBackend::create(disk_manager)) {
+        assert(num_instances_ > 0 && pool_size_ >= num_instances_);
+        // 将帧平均分配给各个分区，余数分给前面的分区
+        for (size_t i = 0; i < num_instances_; ++i) {
+            int numa_node = BUFFER_POOL_NUMA_NODE == BUFFER_POOL_NUMA_SPREAD
+                                ? static_cast<int>(i % FrameRegion::get_num_numa_nodes())
+                                : BUFFER_POOL_NUMA_NODE;
+            instances_.emplace_back(std::make_unique<BufferPoolInstance>(get_instance_size(pool_size_, i), disk_manager_,
+                                                                         io_backend_.get(), numa_node,
+                                                                         get_instance_size(max_pool_size_, i)));
         }
     }
 
     ~BufferPoolManager() {
-        delete[] pages_;
-        delete replacer_;
+        // 后台写回线程依赖各个分区，分区析构前后端必须仍然有效，因此按顺序显式释放
+        page_cleaner_.reset();
+        wait_for_prefetch();
+        instances_.clear();
     }
 
     /**
@@ -63,6 +82,16 @@ class BufferPoolManager {
      */
     static void mark_dirty(Page* page) { page->is_dirty_ = true; }
 
+    size_t get_pool_size() const { return pool_size_; }
+
+    size_t get_max_pool_size() const { return max_pool_size_; }
+
+    size_t get_num_instances() const { return num_instances_; }
+
+    BufferPoolInstance* get_instance_at(size_t index) { return instances_[index].get(); }
+
+    AsyncIoBackend* get_io_backend() { return io_backend_.get(); }
+
    public: 
     Page* fetch_page(PageId page_id);
 
@@ -76,8 +105,37 @@ class BufferPoolManager {
 
     void flush_all_pages(int fd);
 
+    size_t prefetch_pages(int fd, const std::vector<page_id_t>& page_nos);
+
+    void wait_for_prefetch();
+
+    void start_page_cleaner(std::function<lsn_t()> durable_lsn,
+                            size_t pages_per_second = PAGE_CLEANER_PAGES_PER_SECOND);
+
+    void stop_page_cleaner();
+
+    PageCleanerStats get_cleaner_stats();
+
+    BufferPoolStats get_stats();
+
+    size_t resize(size_t new_pool_size,
+                  std::chrono::milliseconds timeout = std::chrono::milliseconds(BUFFER_POOL_RESIZE_TIMEOUT_MS));
+
    private:
-    bool find_victim_page(frame_id_t* frame_id);
+    /**
+     * @description: 把pool_size个帧平均分给各个分区时，第index个分区分到的帧数
+     */
+    size_t get_instance_size(size_t pool_size, size_t index) const {
+        return pool_size / num_instances_ + (index < pool_size % num_instances_ ? 1 : 0);
+    }
 
-    void update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id);
+    /**
+     * @description: 根据PageId计算页面所属的分区。同一文件中相邻的页面落在不同的分区，顺序扫描时负载更均衡
+     * @return {BufferPoolInstance*} 页面所属的分区
+     * @param {PageId} page_id 目标页面
+     */
+    BufferPoolInstance* get_instance(PageId page_id) {
+        size_t hash = static_cast<size_t>(page_id.fd) * 0x9E3779B1u + static_cast<size_t>(page_id.page_no);
+        return instances_[hash % num_instances_].get();
+    }
 };
\ No newline at end of file
@@ -11,13 +11,91 @@ See the Mulan PSL v2 for more details. */
 #include "storage/disk_manager.h"
 
 #include <assert.h>    // for assert
+#include <errno.h>     // for errno
 #include <string.h>    // for memset
 #include <sys/stat.h>  // for stat
 #include <unistd.h>    // for lseek
 
 #include "defs.h"
 
-DiskManager::DiskManager() { memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char))); }
+// O_DIRECT要求缓冲区地址、文件偏移和读写长度按逻辑块大小对齐，这里统一按页对齐
+static constexpr size_t DIRECT_IO_ALIGNMENT = PAGE_SIZE;
+
+DiskManager::DiskManager(bool direct_io) : direct_io_(direct_io) {
+    memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char)));
+}
+
+/**
+ * @description: 判断一次读写能否直接以O_DIRECT方式进行
+ */
+static bool is_direct_aligned(const char *buf, int num_bytes) {
+    return reinterpret_cast<uintptr_t>(buf) % DIRECT_IO_ALIGNMENT == 0 && num_bytes == PAGE_SIZE;
+}
+
+/**
+ * @description: 以O_DIRECT方式打开的文件上，缓冲区或长度不满足对齐要求的读写需要经过对齐的中转缓冲区。
+ *               异步I/O后端据此把这类请求交给read_page/write_page完成
+ * @return {bool} 是否需要经过中转缓冲区
+ * @param {int} fd 文件句柄
+ * @param {char} *buf 读写的内存缓冲区
+ * @param {int} num_bytes 读写的数据量大小
+ */
+bool DiskManager::needs_bounce(int fd, const char *buf, int num_bytes) const {
+    return is_direct(fd) && num_bytes <= PAGE_SIZE && !is_direct_aligned(buf, num_bytes);
+}
+
+/**
+ * @description: 文件系统在读写时才拒绝O_DIRECT（返回EINVAL）时，去掉文件的O_DIRECT标志，之后以普通方式读写
+ * @return {bool} 是否成功退回普通读写
+ * @param {int} fd 文件句柄
+ */
+bool DiskManager::disable_direct_io(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+        return false;
+    }
+    direct_fds_[fd] = false;
+    return true;
+}
+
+/**
+ * @description: 以O_DIRECT方式打开的文件上的非对齐写：先读出整页到对齐的缓冲区，覆盖前num_bytes个字节后写回整页
+ */
+void DiskManager::bounce_write(int fd, page_id_t page_no, const char *offset, int num_bytes) {
+    alignas(DIRECT_IO_ALIGNMENT) static thread_local char bounce_buf[PAGE_SIZE];
+    off_t offset_in_file = static_cast<off_t>(page_no) * PAGE_SIZE;
+    if (num_bytes < PAGE_SIZE) {
+        ssize_t bytes_read = pread(fd, bounce_buf, PAGE_SIZE, offset_in_file);
+        if (bytes_read == -1) {
+            throw UnixError();
+        }
+        memset(bounce_buf + bytes_read, 0, PAGE_SIZE - bytes_read);
+    }
+    memcpy(bounce_buf, offset, num_bytes);
+    ssize_t bytes_written = pwrite(fd, bounce_buf, PAGE_SIZE, offset_in_file);
+    if (bytes_written == -1) {
+        throw UnixError();
+    }
+    if (bytes_written != PAGE_SIZE) {
+        throw InternalError("DiskManager::write_page Error");
+    }
+}
+
+/**
+ * @description: 以O_DIRECT方式打开的文件上的非对齐读：整页读到对齐的缓冲区后复制前num_bytes个字节
+ */
+void DiskManager::bounce_read(int fd, page_id_t page_no, char *offset, int num_bytes) {
+    alignas(DIRECT_IO_ALIGNMENT) static thread_local char bounce_buf[PAGE_SIZE];
+    off_t offset_in_file = static_cast<off_t>(page_no) * PAGE_SIZE;
+    ssize_t bytes_read = pread(fd, bounce_buf, PAGE_SIZE, offset_in_file);
+    if (bytes_read == -1) {
+        throw UnixError();
+    }
+    if (bytes_read < num_bytes) {
+        throw InternalError("DiskManager::read_page Error");
+    }
+    memcpy(offset, bounce_buf, num_bytes);
+}
 
 /**
  * @description: 将数据写入文件的指定磁盘页面中
@@ -27,16 +105,24 @@ DiskManager::DiskManager() { memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<
  * @param {int} num_bytes 要写入磁盘的数据大小
  */
 void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int num_bytes) {
-    // Todo:
-    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
-    // 2.调用write()函数
-    // 注意write返回值与num_bytes不等时 throw InternalError("DiskManager::write_page Error");
-    off_t offset_in_file = page_no * PAGE_SIZE;
-    off_t seek_result = lseek(fd, offset_in_file, SEEK_SET);
-    if (seek_result == -1) {
+    ScopedLatency latency(write_latency_);
+    if (is_compressed(fd)) {
+        compressed_files_[fd]->write_page(page_no, offset, num_bytes);
+        return;
+    }
+    // 使用pwrite()按偏移量直接写入，不修改文件的读写位置，多个缓冲池分区可以并发地访问同一文件
+    if (needs_bounce(fd, offset, num_bytes)) {
+        bounce_write(fd, page_no, offset, num_bytes);
+        return;
+    }
+    off_t offset_in_file = static_cast<off_t>(page_no) * PAGE_SIZE;
+    ssize_t bytes_written = pwrite(fd, offset, num_bytes, offset_in_file);
+    if (bytes_written == -1 && errno == EINVAL && is_direct(fd) && disable_direct_io(fd)) {
+        bytes_written = pwrite(fd, offset, num_bytes, offset_in_file);
+    }
+    if (bytes_written == -1) {
         throw UnixError();
     }
-    ssize_t bytes_written = write(fd, offset, num_bytes);
     if (bytes_written != num_bytes) {
         throw InternalError("DiskManager::write_page Error");
     }
@@ -50,16 +136,24 @@ void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int
  * @param {int} num_bytes 读取的数据量大小
  */
 void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_bytes) {
-    // Todo:
-    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
-    // 2.调用read()函数
-    // 注意read返回值与num_bytes不等时，throw InternalError("DiskManager::read_page Error");
-    off_t offset_in_file = page_no * PAGE_SIZE;
-    off_t seek_result = lseek(fd, offset_in_file, SEEK_SET);
-    if (seek_result == -1) {
+    ScopedLatency latency(read_latency_);
+    if (is_compressed(fd)) {
+        compressed_files_[fd]->read_page(page_no, offset, num_bytes);
+        return;
+    }
+    // 使用pread()按偏移量直接读取，不修改文件的读写位置，多个缓冲池分区可以并发地访问同一文件
+    if (needs_bounce(fd, offset, num_bytes)) {
+        bounce_read(fd, page_no, offset, num_bytes);
+        return;
+    }
+    off_t offset_in_file = static_cast<off_t>(page_no) * PAGE_SIZE;
+    ssize_t bytes_read = pread(fd, offset, num_bytes, offset_in_file);
+    if (bytes_read == -1 && errno == EINVAL && is_direct(fd) && disable_direct_io(fd)) {
+        bytes_read = pread(fd, offset, num_bytes, offset_in_file);
+    }
+    if (bytes_read == -1) {
         throw UnixError();
     }
-    ssize_t bytes_read = read(fd, offset, num_bytes);
     if (bytes_read != num_bytes) {
         throw InternalError("DiskManager::read_page Error");
     }
@@ -78,6 +172,21 @@ page_id_t DiskManager::allocate_page(int fd) {
 
 void DiskManager::deallocate_page(__attribute__((unused)) page_id_t page_id) {}
 
+/**
+ * @description: 把文件截断为num_pages个页面，之后从num_pages开始分配页号。被截掉的页面不能在缓冲池中
+ * @param {int} fd 指定文件的文件句柄
+ * @param {int} num_pages 截断后的页面个数
+ */
+void DiskManager::truncate_file(int fd, int num_pages) {
+    assert(fd >= 0 && fd < MAX_FD);
+    if (is_compressed(fd)) {
+        compressed_files_[fd]->truncate(num_pages);
+    } else if (ftruncate(fd, static_cast<off_t>(num_pages) * PAGE_SIZE) < 0) {
+        throw UnixError();
+    }
+    fd2pageno_[fd] = num_pages;
+}
+
 bool DiskManager::is_dir(const std::string &path) {
     struct stat st;
     return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
@@ -113,19 +222,25 @@ bool DiskManager::is_file(const std::string &path) {
  * @description: 用于创建指定路径文件
  * @return {*}
  * @param {string} &path
+ * @param {PageCompression} compression 页面压缩方式，不为PAGE_COMPRESSION_NONE时创建压缩的页面文件
  */
-void DiskManager::create_file(const std::string &path) {
+void DiskManager::create_file(const std::string &path, PageCompression compression) {
     // Todo:
     // 调用open()函数，使用O_CREAT模式
     // 注意不能重复创建相同文件
     if (is_file(path)) {
         throw FileExistsError(path);
     }
-    int fd = open(path.c_str(), O_CREAT, 0600);  // 权限
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, 0600);  // 权限
     if (fd == -1) {
         throw UnixError();
     }
+    if (compression != PAGE_COMPRESSION_NONE) {
+        CompressedPageFile::init_file(fd, compression);
+    }
     close(fd);
+    // 同名文件残留的页面映射不属于新文件
+    unlink((path + PAGE_MAP_FILE_SUFFIX).c_str());
 }
 
 /**
@@ -146,6 +261,7 @@ void DiskManager::destroy_file(const std::string &path) {
     if (fd == -1) {
         throw UnixError();
     }
+    unlink((path + PAGE_MAP_FILE_SUFFIX).c_str());
 }
 
 /**
@@ -164,12 +280,41 @@ int DiskManager::open_file(const std::string &path) {
         // throw FileNotClosedError(path);
         return path2fd_[path];
     }
-    int fd = open(path.c_str(), O_RDWR);
+    // 日志文件按字节追加写入，始终使用普通读写；压缩文件按块读写变长的extent，也不使用O_DIRECT
+    bool compressed = path != LOG_FILE_NAME && CompressedPageFile::is_compressed(path);
+    bool direct = direct_io_ && path != LOG_FILE_NAME && !compressed;
+    int fd = direct ? open(path.c_str(), O_RDWR | O_DIRECT) : -1;
+    if (fd == -1) {
+        // 不支持O_DIRECT的文件系统（如tmpfs）在open时返回EINVAL，退回普通读写
+        direct = false;
+        fd = open(path.c_str(), O_RDWR);
+    }
     if (fd == -1) {
         throw UnixError();
     }
+    assert(fd < MAX_FD);
+    if (compressed) {
+        try {
+            compressed_files_[fd] = std::make_unique<CompressedPageFile>(fd, path);
+        } catch (RMDBError &e) {
+            close(fd);
+            throw;
+        }
+    }
+    compressed_fds_[fd] = compressed;
+    direct_fds_[fd] = direct;
     fd2path_[fd] = path;
     path2fd_[path] = fd;
+    {
+        std::scoped_lock lock{file_stats_latch_};
+        if (file_stats_[fd] == nullptr) {
+            file_stats_[fd] = std::make_unique<FileStats>();
+        } else {
+            file_stats_[fd]->counters.reset();
+        }
+        file_stats_[fd]->path = path;
+        file_stats_[fd]->is_open = true;
+    }
     return fd;
 }
 
@@ -187,9 +332,34 @@ void DiskManager::close_file(int fd) {
     std::string path = fd2path_[fd];
     fd2path_.erase(fd);
     path2fd_.erase(path);
+    direct_fds_[fd] = false;
+    if (compressed_fds_[fd]) {
+        compressed_fds_[fd] = false;
+        compressed_files_[fd]->save_map();
+        compressed_files_[fd].reset();
+    }
+    {
+        std::scoped_lock lock{file_stats_latch_};
+        file_stats_[fd]->is_open = false;
+    }
     close(fd);
 }
 
+/**
+ * @description: 所有已打开的表和索引文件的缓冲池计数器快照
+ * @return {vector<pair<string, BufferPoolStats>>} (文件路径, 计数器快照)
+ */
+std::vector<std::pair<std::string, BufferPoolStats>> DiskManager::get_file_stats() {
+    std::vector<std::pair<std::string, BufferPoolStats>> stats;
+    std::scoped_lock lock{file_stats_latch_};
+    for (int fd = 0; fd < MAX_FD; fd++) {
+        if (file_stats_[fd] != nullptr && file_stats_[fd]->is_open && file_stats_[fd]->path != LOG_FILE_NAME) {
+            stats.push_back({file_stats_[fd]->path, {file_stats_[fd]->counters.snapshot()}});
+        }
+    }
+    return stats;
+}
+
 /**
  * @description: 获得文件的大小
  * @return {int} 文件的大小
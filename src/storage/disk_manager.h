@@ -17,18 +17,25 @@ See the Mulan PSL v2 for more details. */
 #include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "errors.h"  
+#include "page_compression.h"
+#include "stats.h"
+
 
 /**
  * @description: DiskManager的作用主要是根据上层的需要对磁盘文件进行操作
  */
 class DiskManager {
    public:
-    explicit DiskManager();
+    explicit DiskManager(bool direct_io = DISK_DIRECT_IO);
 
     ~DiskManager() = default;
 
@@ -40,6 +47,8 @@ class DiskManager {
 
     void deallocate_page(page_id_t page_id);
 
+    void truncate_file(int fd, int num_pages);
+
     /*目录操作*/
     bool is_dir(const std::string &path);
 
@@ -50,7 +59,7 @@ class DiskManager {
     /*文件操作*/
     bool is_file(const std::string &path);
 
-    void create_file(const std::string &path);
+    void create_file(const std::string &path, PageCompression compression = PAGE_COMPRESSION_NONE);
 
     void destroy_file(const std::string &path);
 
@@ -87,6 +96,38 @@ class DiskManager {
      */
     page_id_t get_fd2pageno(int fd) { return fd2pageno_[fd]; }
 
+    /**
+     * @description: 之后打开的表和索引文件是否使用O_DIRECT，已经打开的文件不受影响
+     */
+    void set_direct_io(bool direct_io) { direct_io_ = direct_io; }
+
+    bool get_direct_io() const { return direct_io_; }
+
+    /**
+     * @description: 文件当前是否以O_DIRECT方式读写
+     */
+    bool is_direct(int fd) const { return fd >= 0 && fd < MAX_FD && direct_fds_[fd]; }
+
+    /**
+     * @description: 文件是否为压缩的页面文件，其页面不在page_no * PAGE_SIZE处，只能通过read_page/write_page读写
+     */
+    bool is_compressed(int fd) const { return fd >= 0 && fd < MAX_FD && compressed_fds_[fd]; }
+
+    bool needs_bounce(int fd, const char *buf, int num_bytes) const;
+
+    /**
+     * @description: 文件对应的缓冲池计数器，文件从未被打开过时返回nullptr。同一fd被重新打开时计数器清零
+     */
+    BufferPoolCounters *get_file_counters(int fd) {
+        return fd >= 0 && fd < MAX_FD && file_stats_[fd] != nullptr ? &file_stats_[fd]->counters : nullptr;
+    }
+
+    std::vector<std::pair<std::string, BufferPoolStats>> get_file_stats();
+
+    LatencyHistogram &get_read_latency() { return read_latency_; }
+
+    LatencyHistogram &get_write_latency() { return write_latency_; }
+
     static constexpr int MAX_FD = 8192;
 
    private:
@@ -94,6 +135,27 @@ class DiskManager {
     std::unordered_map<std::string, int> path2fd_;  //<Page文件磁盘路径,Page fd>哈希表
     std::unordered_map<int, std::string> fd2path_;  //<Page fd,Page文件磁盘路径>哈希表
 
+    bool disable_direct_io(int fd);
+
+    void bounce_write(int fd, page_id_t page_no, const char *offset, int num_bytes);
+
+    void bounce_read(int fd, page_id_t page_no, char *offset, int num_bytes);
+
+    bool direct_io_;                              // 是否以O_DIRECT方式打开表和索引文件
     int log_fd_ = -1;                             // WAL日志文件的文件句柄，默认为-1，代表未打开日志文件
     std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 文件中已经分配的页面个数，初始值为0
+    std::atomic<bool> direct_fds_[MAX_FD]{};      // 文件是否以O_DIRECT方式打开
+    std::atomic<bool> compressed_fds_[MAX_FD]{};  // 文件是否为压缩的页面文件
+    std::unique_ptr<CompressedPageFile> compressed_files_[MAX_FD];  // 压缩文件的页面映射，打开时创建，关闭时保存并释放
+
+    // 每个fd对应的缓冲池计数器，fd第一次被打开时创建，之后不再释放，缓冲池可以不加锁地访问
+    struct FileStats {
+        std::string path;
+        bool is_open = false;
+        BufferPoolCounters counters;
+    };
+    std::unique_ptr<FileStats> file_stats_[MAX_FD];
+    std::mutex file_stats_latch_;                 // 保护FileStats的path和is_open
+    LatencyHistogram read_latency_;               // read_page的延迟
+    LatencyHistogram write_latency_;              // write_page的延迟
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/frame_region.h"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#include "errors.h"
+
+static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+FrameRegion::FrameRegion(size_t num_frames, bool huge_pages, int numa_node) : num_frames_(num_frames) {
+    size_t size = num_frames_ * PAGE_SIZE;
+    void *addr = MAP_FAILED;
+    if (huge_pages) {
+        mapped_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        addr = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge_page_backed_ = addr != MAP_FAILED;
+    }
+    if (addr == MAP_FAILED) {
+        mapped_size_ = size;
+        addr = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1,
+                    0);
+        if (addr == MAP_FAILED) {
+            throw UnixError();
+        }
+        if (huge_pages) {
+            // 没有预留大页时退回透明大页，内核不支持时忽略
+            madvise(addr, mapped_size_, MADV_HUGEPAGE);
+        }
+    }
+    base_ = static_cast<char *>(addr);
+
+    // 在第一次访问之前绑定NUMA结点，之后缺页时物理页从该结点分配
+    if (numa_node >= 0 && numa_node < get_num_numa_nodes()) {
+        unsigned long nodemask = 1UL << numa_node;
+        if (syscall(SYS_mbind, base_, mapped_size_, MPOL_BIND, &nodemask, sizeof(nodemask) * 8, 0) == 0) {
+            numa_node_ = numa_node;
+        }
+    }
+}
+
+FrameRegion::~FrameRegion() {
+    if (base_ != nullptr) {
+        munmap(base_, mapped_size_);
+    }
+}
+
+/**
+ * @description: 缓冲池缩小后，把[first_frame, last_frame)这些帧占用的物理内存还给操作系统，虚拟地址仍然保留，
+ * 之后缓冲池再次增长时重新访问这些帧即可。大页映射只能按整个大页释放，不完整的大页会被保留
+ * @param {size_t} first_frame 第一个被释放的帧
+ * @param {size_t} last_frame 最后一个被释放的帧的下一帧
+ */
+void FrameRegion::release(size_t first_frame, size_t last_frame) {
+    size_t begin = first_frame * PAGE_SIZE;
+    size_t end = std::min(last_frame * PAGE_SIZE, mapped_size_);
+    if (huge_page_backed_) {
+        begin = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        end = last_frame >= num_frames_ ? mapped_size_ : end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    if (begin < end) {
+        madvise(base_ + begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+int FrameRegion::get_num_numa_nodes() {
+    static const int num_nodes = [] {
+        int count = 0;
+        DIR *dir = opendir("/sys/devices/system/node");
+        if (dir == nullptr) {
+            return 1;
+        }
+        while (struct dirent *entry = readdir(dir)) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4])) {
+                count++;
+            }
+        }
+        closedir(dir);
+        return count > 0 ? count : 1;
+    }();
+    return num_nodes;
+}
@@ -0,0 +1,57 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * @description: 缓冲池分区的帧内存。所有帧的数据放在一块按页对齐的连续内存中，
+ * 第i帧的数据位于base + i * PAGE_SIZE，帧的元数据（Page对象）另外存放，不与数据共用cache line。
+ * 内存通过mmap申请：开启huge_pages时优先使用2MB的大页（MAP_HUGETLB），系统没有预留大页时
+ * 退回普通页并通过madvise建议内核使用透明大页；numa_node不小于0时把内存绑定到该NUMA结点。
+ * num_frames是缓冲池可能增长到的最大帧数，普通页映射不预留物理内存，只有被访问过的帧才会占用内存
+ */
+class FrameRegion {
+   public:
+    FrameRegion(size_t num_frames, bool huge_pages = BUFFER_POOL_HUGE_PAGES, int numa_node = -1);
+
+    ~FrameRegion();
+
+    FrameRegion(const FrameRegion &) = delete;
+    FrameRegion &operator=(const FrameRegion &) = delete;
+
+    char *get_frame(size_t frame_id) const { return base_ + frame_id * PAGE_SIZE; }
+
+    void release(size_t first_frame, size_t last_frame);
+
+    size_t get_num_frames() const { return num_frames_; }
+
+    /**
+     * @description: 是否由预留的2MB大页支撑（不包括透明大页）
+     */
+    bool is_huge_page_backed() const { return huge_page_backed_; }
+
+    int get_numa_node() const { return numa_node_; }
+
+    /**
+     * @description: 系统中NUMA结点的个数，无法获取时返回1
+     */
+    static int get_num_numa_nodes();
+
+   private:
+    char *base_ = nullptr;
+    size_t num_frames_;
+    size_t mapped_size_ = 0;
+    bool huge_page_backed_ = false;
+    int numa_node_ = -1;    // 绑定的NUMA结点，-1表示未绑定
+};
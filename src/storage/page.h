@@ -10,6 +10,12 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <shared_mutex>
+#include <thread>
+
 #include "common/config.h"
 
 /**
@@ -35,8 +41,11 @@ struct PageId {
 };
 
 // PageId的自定义哈希算法, 用于构建unordered_map<PageId, frame_id_t, PageIdHash>
+// fd和page_no各占32位后再做混合，页号超过65536时不同文件的页面也不会冲突
 struct PageIdHash {
-    size_t operator()(const PageId &x) const { return (x.fd << 16) | x.page_no; }
+    size_t operator()(const PageId &x) const {
+        return std::hash<int64_t>()(static_cast<int64_t>(x.fd) << 32 | static_cast<uint32_t>(x.page_no));
+    }
 };
 
 template <>
@@ -46,14 +55,16 @@ struct std::hash<PageId> {
 
 /**
  * @description: Page类声明, Page是RMDB数据块的单位、是负责数据操作Record模块的操作对象，
- * Page对象在磁盘上有文件存储, 若在Buffer中则有帧偏移, 并非特指Buffer或Disk上的数据
+ * Page对象在磁盘上有文件存储, 若在Buffer中则有帧偏移, 并非特指Buffer或Disk上的数据。
+ * Page对象只保存帧的元数据，按cache line对齐，页面数据位于缓冲池分区按页对齐的帧内存(FrameRegion)中
  */
-class Page {
+class alignas(64) Page {
     friend class BufferPoolManager;
+    friend class BufferPoolInstance;
 
    public:
     
-    Page() { reset_memory(); }
+    Page() = default;
 
     ~Page() = default;
 
@@ -67,9 +78,42 @@ class Page {
     static constexpr size_t OFFSET_LSN = 0;
     static constexpr size_t OFFSET_PAGE_HDR = 4;
 
-    inline lsn_t get_page_lsn() { return *reinterpret_cast<lsn_t *>(get_data() + OFFSET_LSN) ; }
+    /** 页面LSN：最近一条修改该页面的日志记录的LSN。索引页和文件头页没有预留LSN字段，因此保存在帧的元数据中，
+     *  不写入页面数据，页面重新读入缓冲池时为0。后台写回线程只写回页面LSN不超过已持久化日志LSN的脏页 */
+    inline lsn_t get_page_lsn() const { return lsn_.load(std::memory_order_acquire); }
+
+    inline void set_page_lsn(lsn_t page_lsn) { lsn_.store(page_lsn, std::memory_order_release); }
+
+    /** 页面数据的读写锁，B+树按latch crabbing的方式自上而下对结点加锁。
+     *  加写锁和释放写锁时各把版本号加1，持有写锁期间版本号为奇数 */
+    void rlatch() { rwlatch_.lock_shared(); }
+
+    void runlatch() { rwlatch_.unlock_shared(); }
+
+    void wlatch() {
+        rwlatch_.lock();
+        version_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void wunlatch() {
+        version_.fetch_add(1, std::memory_order_release);
+        rwlatch_.unlock();
+    }
+
+    /** 乐观读：等待写锁释放后返回当前版本号，读完页面后用validate()检查期间没有被加过写锁 */
+    uint64_t read_version() const {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        while (version & 1) {
+            std::this_thread::yield();
+            version = version_.load(std::memory_order_acquire);
+        }
+        return version;
+    }
 
-    inline void set_page_lsn(lsn_t page_lsn) { memcpy(get_data() + OFFSET_LSN, &page_lsn, sizeof(lsn_t)); }
+    bool validate(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
 
    private:
     void reset_memory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }  // 将data_的PAGE_SIZE个字节填充为0
@@ -78,13 +122,32 @@ class Page {
     PageId id_;
 
     /** The actual data that is stored within a page.
-     *  该页面在bufferPool中的偏移地址
+     *  该页面在bufferPool中的地址，指向所在帧，按PAGE_SIZE对齐，由BufferPoolInstance在构造时设置
      */
-    char data_[PAGE_SIZE] = {};
+    char *data_ = nullptr;
 
     /** 脏页判断 */
-    bool is_dirty_ = false;
+    std::atomic<bool> is_dirty_{false};
+
+    /** The pin count of this page.
+     *  缓冲池命中时不持有latch_，通过CAS增加pin_count_；-1表示帧空闲或正在被替换，此时不能被pin */
+    std::atomic<int> pin_count_{0};
+
+    /** 页面数据正在从磁盘读入，读取完成前其他线程不能访问data_ */
+    std::atomic<bool> io_pending_{false};
+
+    /** 页面LSN，帧被分配给新页面时清零 */
+    std::atomic<lsn_t> lsn_{0};
+
+    /** 页面正在被批量写回（后台写回线程或flush_all_pages），写回期间被临时pin住 */
+    bool flushing_ = false;
+
+    /** 页面最近一次由后台写回线程写回，此后未再被修改 */
+    bool cleaned_ = false;
+
+    /** 保护页面数据的读写锁，与pin_count_无关，由使用页面的上层模块按需加锁 */
+    std::shared_mutex rwlatch_;
 
-    /** The pin count of this page. */
-    int pin_count_ = 0;
+    /** 页面数据的版本号，供不加锁的乐观读者校验。单独占一个cache line，不随rwlatch_和pin_count_的修改失效 */
+    alignas(64) std::atomic<uint64_t> version_{0};
 };
\ No newline at end of file
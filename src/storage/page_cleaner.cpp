@@ -0,0 +1,63 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/page_cleaner.h"
+
+#include <algorithm>
+
+#include "storage/buffer_pool_instance.h"
+
+PageCleaner::PageCleaner(std::vector<BufferPoolInstance *> instances, std::function<lsn_t()> durable_lsn,
+                         size_t pages_per_second)
+    : instances_(std::move(instances)), durable_lsn_(std::move(durable_lsn)), pages_per_second_(pages_per_second) {
+    thread_ = std::thread(&PageCleaner::run, this);
+}
+
+PageCleaner::~PageCleaner() {
+    {
+        std::scoped_lock lock{latch_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+/**
+ * @description: 后台写回线程主循环。每一轮的写回预算由写回速率折算，并平均分给各个分区
+ */
+void PageCleaner::run() {
+    const auto interval = std::chrono::milliseconds(PAGE_CLEANER_INTERVAL_MS);
+    std::unique_lock lock{latch_};
+    while (!stop_) {
+        cv_.wait_for(lock, interval, [&] { return stop_; });
+        if (stop_) {
+            break;
+        }
+        lock.unlock();
+
+        size_t budget = pages_per_second_ * PAGE_CLEANER_INTERVAL_MS / 1000;
+        size_t per_instance = std::max<size_t>(1, budget / instances_.size());
+        if (budget > 0) {
+            bool check_wal = static_cast<bool>(durable_lsn_);
+            lsn_t durable_lsn = check_wal ? durable_lsn_() : INVALID_LSN;
+            for (BufferPoolInstance *instance : instances_) {
+                size_t low_water = std::max<size_t>(
+                    1, static_cast<size_t>(instance->get_pool_size() * PAGE_CLEANER_LOW_WATER_RATIO));
+                try {
+                    instance->clean_pages(low_water, per_instance, check_wal, durable_lsn);
+                } catch (RMDBError &e) {
+                    // 写回失败的页面仍保持脏页状态，之后由前台淘汰或下一轮重试
+                }
+            }
+        }
+
+        lock.lock();
+    }
+}
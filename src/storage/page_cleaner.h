@@ -0,0 +1,77 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+class BufferPoolInstance;
+
+/**
+ * @description: 后台写回相关的计数器，每个缓冲池分区各有一份
+ */
+struct PageCleanerCounters {
+    std::atomic<uint64_t> pages_flushed{0};         // 后台写回线程写回的页面数
+    std::atomic<uint64_t> stalls_avoided{0};        // 前台淘汰的页面已被后台写回、因而无需同步写回的次数
+    std::atomic<uint64_t> foreground_writebacks{0}; // 前台淘汰脏页时仍需同步写回的次数
+    std::atomic<uint64_t> wal_deferred{0};          // 因日志尚未持久化到页面LSN而推迟写回的次数
+};
+
+/**
+ * @description: PageCleanerCounters在某一时刻的快照，BufferPoolManager把各分区的计数器相加后返回
+ */
+struct PageCleanerStats {
+    uint64_t pages_flushed = 0;
+    uint64_t stalls_avoided = 0;
+    uint64_t foreground_writebacks = 0;
+    uint64_t wal_deferred = 0;
+};
+
+/**
+ * @description: 后台写回线程。每隔interval_ms毫秒检查一次各缓冲池分区，
+ * 当空闲帧与干净的可淘汰帧少于low_water_ratio比例时，提前写回未被pin住的脏页，
+ * 使前台淘汰页面时不必同步等待写回。
+ * 遵循WAL规则：只有页面LSN不超过已持久化日志LSN的脏页才会被写回
+ */
+class PageCleaner {
+   public:
+    /**
+     * @param {vector<BufferPoolInstance*>} instances 需要维护的缓冲池分区
+     * @param {function<lsn_t()>} durable_lsn 返回已持久化到磁盘的最大日志LSN，为空时不做WAL检查
+     * @param {size_t} pages_per_second 每秒最多写回的页面数，即写回速率
+     */
+    PageCleaner(std::vector<BufferPoolInstance *> instances, std::function<lsn_t()> durable_lsn,
+                size_t pages_per_second = PAGE_CLEANER_PAGES_PER_SECOND);
+
+    ~PageCleaner();
+
+    void set_pages_per_second(size_t pages_per_second) { pages_per_second_ = pages_per_second; }
+
+    size_t get_pages_per_second() const { return pages_per_second_; }
+
+   private:
+    void run();
+
+    std::vector<BufferPoolInstance *> instances_;
+    std::function<lsn_t()> durable_lsn_;
+    std::atomic<size_t> pages_per_second_;
+    std::mutex latch_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,498 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/page_compression.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "errors.h"
+
+/**
+ * @description: 压缩一个页面
+ * @return {size_t} 压缩后的长度，压缩结果超过capacity时返回0
+ * @param {char*} src 长度为PAGE_SIZE的页面
+ * @param {char*} dst 压缩结果
+ * @param {size_t} capacity dst的大小
+ */
+size_t ZeroRunCodec::compress(const char *src, char *dst, size_t capacity) {
+    size_t out = 0;
+    size_t lit_start = 0;
+    // 输出一段：[lit_start, lit_end)为字面量，[lit_end, zero_end)为零字节
+    auto emit = [&](size_t lit_end, size_t zero_end) {
+        uint16_t lit_len = lit_end - lit_start;
+        uint16_t zero_len = zero_end - lit_end;
+        if (out + 2 * sizeof(uint16_t) + lit_len > capacity) {
+            return false;
+        }
+        memcpy(dst + out, &lit_len, sizeof(lit_len));
+        memcpy(dst + out + sizeof(lit_len), &zero_len, sizeof(zero_len));
+        out += 2 * sizeof(uint16_t);
+        memcpy(dst + out, src + lit_start, lit_len);
+        out += lit_len;
+        lit_start = zero_end;
+        return true;
+    };
+    size_t pos = 0;
+    while (pos < PAGE_SIZE) {
+        auto *zero = static_cast<const char *>(memchr(src + pos, 0, PAGE_SIZE - pos));
+        if (zero == nullptr) {
+            break;
+        }
+        size_t start = zero - src;
+        size_t end = start + 1;
+        while (end < PAGE_SIZE && src[end] == 0) {
+            end++;
+        }
+        if ((end - start >= ZERO_RUN_MIN_LEN || end == PAGE_SIZE) && !emit(start, end)) {
+            return 0;
+        }
+        pos = end;
+    }
+    if (lit_start < PAGE_SIZE && !emit(PAGE_SIZE, PAGE_SIZE)) {
+        return 0;
+    }
+    return out;
+}
+
+/**
+ * @description: 解压一个页面
+ * @return {bool} 压缩数据不完整或解压后的长度不是PAGE_SIZE时返回false
+ * @param {char*} src 压缩数据
+ * @param {size_t} len 压缩数据的长度
+ * @param {char*} dst 长度为PAGE_SIZE的页面
+ */
+bool ZeroRunCodec::decompress(const char *src, size_t len, char *dst) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < len) {
+        uint16_t lit_len;
+        uint16_t zero_len;
+        if (len - in < 2 * sizeof(uint16_t)) {
+            return false;
+        }
+        memcpy(&lit_len, src + in, sizeof(lit_len));
+        memcpy(&zero_len, src + in + sizeof(lit_len), sizeof(zero_len));
+        in += 2 * sizeof(uint16_t);
+        if (lit_len > len - in || out + lit_len + zero_len > PAGE_SIZE) {
+            return false;
+        }
+        memcpy(dst + out, src + in, lit_len);
+        in += lit_len;
+        out += lit_len;
+        memset(dst + out, 0, zero_len);
+        out += zero_len;
+    }
+    return out == PAGE_SIZE;
+}
+
+/**
+ * @description: 打开压缩的页面文件，读取上次关闭时保存的页面映射，不存在或与文件不一致时扫描文件重建
+ * @param {int} fd 已打开的文件句柄
+ * @param {string&} path 文件路径
+ */
+CompressedPageFile::CompressedPageFile(int fd, const std::string &path)
+    : fd_(fd), map_path_(path + PAGE_MAP_FILE_SUFFIX) {
+    FileHdr file_hdr;
+    if (pread(fd_, &file_hdr, sizeof(file_hdr), 0) != sizeof(file_hdr) || file_hdr.magic != FILE_MAGIC) {
+        throw InternalError("CompressedPageFile: invalid file header");
+    }
+    compression_ = static_cast<PageCompression>(file_hdr.compression);
+    if (!load_map()) {
+        rebuild_map();
+    }
+    // 页面映射只在正常关闭时保存，异常退出后下次打开会重新扫描文件
+    unlink(map_path_.c_str());
+}
+
+/**
+ * @description: 判断文件是否为压缩的页面文件，打开文件时据此决定读写方式
+ */
+bool CompressedPageFile::is_compressed(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    FileHdr file_hdr;
+    bool compressed = pread(fd, &file_hdr, sizeof(file_hdr), 0) == sizeof(file_hdr) &&
+                      file_hdr.magic == FILE_MAGIC && file_hdr.version == FILE_VERSION;
+    close(fd);
+    return compressed;
+}
+
+/**
+ * @description: 在新建的空文件中写入文件头
+ * @param {int} fd 文件句柄
+ * @param {PageCompression} compression 之后写入页面时使用的压缩方式
+ */
+void CompressedPageFile::init_file(int fd, PageCompression compression) {
+    char block[BLOCK_SIZE] = {};
+    FileHdr file_hdr{FILE_MAGIC, FILE_VERSION, static_cast<uint32_t>(compression)};
+    memcpy(block, &file_hdr, sizeof(file_hdr));
+    if (pwrite(fd, block, BLOCK_SIZE, 0) != BLOCK_SIZE) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 读取并解压页面的前num_bytes个字节
+ */
+void CompressedPageFile::read_page(page_id_t page_no, char *data, int num_bytes) {
+    if (num_bytes == PAGE_SIZE) {
+        read_full_page(page_no, data);
+        return;
+    }
+    char page[PAGE_SIZE];
+    read_full_page(page_no, page);
+    memcpy(data, page, num_bytes);
+}
+
+/**
+ * @description: 压缩并写入页面。只写前num_bytes个字节时先读出页面的其余部分，页面不存在时其余部分为0
+ */
+void CompressedPageFile::write_page(page_id_t page_no, const char *data, int num_bytes) {
+    char page[PAGE_SIZE];
+    if (num_bytes < PAGE_SIZE) {
+        bool exists;
+        {
+            std::scoped_lock lock{latch_};
+            exists = pages_.count(page_no) != 0;
+        }
+        if (exists) {
+            read_full_page(page_no, page);
+        } else {
+            memset(page, 0, PAGE_SIZE);
+        }
+        memcpy(page, data, num_bytes);
+        data = page;
+    }
+
+    alignas(8) static thread_local char buf[MAX_EXTENT_BLOCKS * BLOCK_SIZE];
+    auto *hdr = reinterpret_cast<ExtentHdr *>(buf);
+    char *payload = buf + sizeof(ExtentHdr);
+    hdr->compression = PAGE_COMPRESSION_NONE;
+    size_t len = 0;
+    if (compression_ == PAGE_COMPRESSION_ZERO_RUN) {
+        // 压缩后至少要少占用一个块，否则保存原始页面，读取时不需要解压
+        size_t capacity = (MAX_EXTENT_BLOCKS - 1) * BLOCK_SIZE - sizeof(ExtentHdr);
+        len = ZeroRunCodec::compress(data, payload, capacity);
+        if (len != 0) {
+            hdr->compression = PAGE_COMPRESSION_ZERO_RUN;
+        }
+    }
+    if (hdr->compression == PAGE_COMPRESSION_NONE) {
+        len = PAGE_SIZE;
+        memcpy(payload, data, PAGE_SIZE);
+    }
+    int num_blocks = (sizeof(ExtentHdr) + len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    memset(payload + len, 0, num_blocks * BLOCK_SIZE - sizeof(ExtentHdr) - len);
+
+    // 总是写到新的extent，写入完成前页面映射仍指向旧版本，旧extent不会被其他页面复用。
+    // 写入中途异常退出时，新extent的校验和不正确，重建页面映射时仍能找到旧版本
+    Extent extent;
+    {
+        std::scoped_lock lock{latch_};
+        extent = allocate_extent(num_blocks);
+        extent.seq = ++seq_;
+    }
+    hdr->magic = EXTENT_MAGIC;
+    hdr->page_no = page_no;
+    hdr->seq = extent.seq;
+    hdr->checksum = checksum(payload, len);
+    hdr->len = len;
+    hdr->num_blocks = extent.num_blocks;
+    ssize_t bytes_written = pwrite(fd_, buf, num_blocks * BLOCK_SIZE, static_cast<off_t>(extent.block) * BLOCK_SIZE);
+    if (bytes_written != num_blocks * BLOCK_SIZE) {
+        std::scoped_lock lock{latch_};
+        free_extent(extent);
+        if (bytes_written == -1) {
+            throw UnixError();
+        }
+        throw InternalError("DiskManager::write_page Error");
+    }
+
+    // 新版本写入完成后才切换页面映射并释放旧extent。同一页面的并发写入以seq较大的为准
+    std::scoped_lock lock{latch_};
+    auto it = pages_.find(page_no);
+    if (it == pages_.end()) {
+        pages_[page_no] = extent;
+    } else if (it->second.seq < extent.seq) {
+        free_extent(it->second);
+        it->second = extent;
+    } else {
+        free_extent(extent);
+    }
+}
+
+/**
+ * @description: 删除编号不小于num_pages的页面，并截掉文件末尾的空闲extent。
+ * 空闲extent的头部被标记为空闲，重建页面映射时不会把被删除的页面或页面的旧版本当作有效页面。
+ * 由于写入总是使用新的extent，文件末尾可能是仍然有效的页面，此时把它复制到前面相同大小的空闲extent中再截断
+ * @param {int} num_pages 截断后的页面个数
+ */
+void CompressedPageFile::truncate(int num_pages) {
+    std::scoped_lock lock{latch_};
+    for (auto it = pages_.begin(); it != pages_.end();) {
+        if (it->first >= num_pages) {
+            free_extent(it->second);
+            it = pages_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::map<int, int> free_blocks;  // 起始块号 -> 块数
+    for (auto &[size, blocks] : free_extents_) {
+        for (int block : blocks) {
+            free_blocks[block] = size;
+            ExtentHdr hdr{EXTENT_MAGIC, INVALID_PAGE_ID, 0, checksum(nullptr, 0), 0, static_cast<uint8_t>(size),
+                          PAGE_COMPRESSION_NONE};
+            if (pwrite(fd_, &hdr, sizeof(hdr), static_cast<off_t>(block) * BLOCK_SIZE) != sizeof(hdr)) {
+                throw UnixError();
+            }
+        }
+    }
+    std::map<int, page_id_t> live_blocks;  // 起始块号 -> 页面号
+    for (auto &[page_no, extent] : pages_) {
+        live_blocks[extent.block] = page_no;
+    }
+    alignas(8) static thread_local char buf[MAX_EXTENT_BLOCKS * BLOCK_SIZE];
+    while (!free_blocks.empty()) {
+        auto last = std::prev(free_blocks.end());
+        if (last->first + last->second == end_block_) {
+            end_block_ = last->first;
+            free_extents_[last->second].erase(last->first);
+            free_blocks.erase(last);
+            continue;
+        }
+        // 文件末尾的extent属于有效页面，找一个更靠前的相同大小的空闲extent
+        if (live_blocks.empty()) {
+            break;
+        }
+        page_id_t page_no = std::prev(live_blocks.end())->second;
+        Extent &extent = pages_[page_no];
+        auto &candidates = free_extents_[extent.num_blocks];
+        if (extent.block + extent.num_blocks != end_block_ || candidates.empty() ||
+            *candidates.begin() > extent.block) {
+            break;
+        }
+        // 复制后两个extent的内容和seq相同，复制完成前异常退出时重建页面映射得到的仍是同一版本
+        int to = *candidates.begin();
+        ssize_t size = extent.num_blocks * BLOCK_SIZE;
+        if (pread(fd_, buf, size, static_cast<off_t>(extent.block) * BLOCK_SIZE) != size ||
+            pwrite(fd_, buf, size, static_cast<off_t>(to) * BLOCK_SIZE) != size) {
+            throw UnixError();
+        }
+        candidates.erase(candidates.begin());
+        free_blocks.erase(to);
+        live_blocks.erase(extent.block);
+        live_blocks[to] = page_no;
+        end_block_ = extent.block;
+        extent.block = to;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(end_block_) * BLOCK_SIZE) < 0) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 将页面映射和空闲链表保存到.pmap文件中，关闭文件时调用，此时文件上没有进行中的读写
+ */
+void CompressedPageFile::save_map() {
+    std::scoped_lock lock{latch_};
+    std::vector<int> entries;
+    for (auto &[page_no, extent] : pages_) {
+        entries.insert(entries.end(), {page_no, extent.block, extent.num_blocks});
+    }
+    for (auto &[size, blocks] : free_extents_) {
+        for (int block : blocks) {
+            entries.insert(entries.end(), {INVALID_PAGE_ID, block, size});
+        }
+    }
+    int num_entries = entries.size() / 3;
+    std::ofstream ofs(map_path_, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&MAP_FILE_MAGIC), sizeof(MAP_FILE_MAGIC));
+    ofs.write(reinterpret_cast<const char *>(&seq_), sizeof(seq_));
+    ofs.write(reinterpret_cast<const char *>(&end_block_), sizeof(end_block_));
+    ofs.write(reinterpret_cast<const char *>(&num_entries), sizeof(num_entries));
+    ofs.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(int));
+    if (!ofs) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @description: 压缩数据的校验和，按8字节一组做FNV-1a式的乘法散列，不足8字节的尾部逐字节处理
+ */
+uint32_t CompressedPageFile::checksum(const char *data, size_t len) {
+    uint64_t hash = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < len; i++) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+/**
+ * @description: 读取.pmap文件。文件不存在、已损坏，或者记录的文件末尾与实际文件大小不一致时返回false
+ */
+bool CompressedPageFile::load_map() {
+    std::ifstream ifs(map_path_, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    uint32_t magic = 0;
+    uint64_t seq = 0;
+    int end_block = -1;
+    int num_entries = -1;
+    ifs.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    ifs.read(reinterpret_cast<char *>(&seq), sizeof(seq));
+    ifs.read(reinterpret_cast<char *>(&end_block), sizeof(end_block));
+    ifs.read(reinterpret_cast<char *>(&num_entries), sizeof(num_entries));
+    struct stat st;
+    if (!ifs || magic != MAP_FILE_MAGIC || num_entries < 0 || fstat(fd_, &st) != 0 ||
+        st.st_size != static_cast<off_t>(end_block) * BLOCK_SIZE) {
+        return false;
+    }
+    std::vector<int> entries((size_t)num_entries * 3);
+    ifs.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(int));
+    if (!ifs || ifs.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+    for (size_t i = 0; i < entries.size(); i += 3) {
+        Extent extent{entries[i + 1], entries[i + 2]};
+        if (extent.block < 1 || extent.num_blocks < 1 || extent.block + extent.num_blocks > end_block) {
+            pages_.clear();
+            free_extents_.clear();
+            return false;
+        }
+        if (entries[i] == INVALID_PAGE_ID) {
+            free_extents_[extent.num_blocks].insert(extent.block);
+        } else {
+            pages_[entries[i]] = extent;
+        }
+    }
+    seq_ = seq;
+    end_block_ = end_block;
+    return true;
+}
+
+/**
+ * @description: 顺序扫描文件中的extent重建页面映射。同一页面的多个extent中seq最大的为当前版本，
+ * 其余extent以及校验和不正确的extent视为空闲。无法识别的块（写入时异常退出留下的）被跳过，不再使用
+ */
+void CompressedPageFile::rebuild_map() {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        throw UnixError();
+    }
+    int file_blocks = (st.st_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<char> buf(MAX_EXTENT_BLOCKS * BLOCK_SIZE);
+    int block = 1;
+    while (block < file_blocks) {
+        ssize_t bytes_read = pread(fd_, buf.data(), buf.size(), static_cast<off_t>(block) * BLOCK_SIZE);
+        if (bytes_read == -1) {
+            throw UnixError();
+        }
+        ExtentHdr hdr;
+        memcpy(&hdr, buf.data(), sizeof(hdr));
+        if (bytes_read < (ssize_t)sizeof(hdr) || hdr.magic != EXTENT_MAGIC || hdr.num_blocks < 1 ||
+            hdr.num_blocks > MAX_EXTENT_BLOCKS || block + hdr.num_blocks > file_blocks) {
+            block++;
+            continue;
+        }
+        Extent extent{block, hdr.num_blocks};
+        block += hdr.num_blocks;
+        bool valid = hdr.page_no != INVALID_PAGE_ID && hdr.len <= hdr.num_blocks * BLOCK_SIZE - sizeof(hdr) &&
+                     checksum(buf.data() + sizeof(hdr), hdr.len) == hdr.checksum;
+        seq_ = std::max(seq_, hdr.seq);
+        if (!valid) {
+            free_extent(extent);
+            continue;
+        }
+        extent.seq = hdr.seq;
+        auto it = pages_.find(hdr.page_no);
+        if (it != pages_.end() && it->second.seq > hdr.seq) {
+            free_extent(extent);
+            continue;
+        }
+        if (it != pages_.end()) {
+            free_extent(it->second);
+        }
+        pages_[hdr.page_no] = extent;
+    }
+    end_block_ = std::max(block, 1);
+}
+
+/**
+ * @description: 将extent放入空闲链表，调用者需持有latch_
+ */
+void CompressedPageFile::free_extent(const Extent &extent) { free_extents_[extent.num_blocks].insert(extent.block); }
+
+/**
+ * @description: 分配num_blocks个块的extent：优先复用相同大小的空闲extent，否则在文件末尾分配。调用者需持有latch_
+ */
+CompressedPageFile::Extent CompressedPageFile::allocate_extent(int num_blocks) {
+    auto it = free_extents_.find(num_blocks);
+    if (it != free_extents_.end() && !it->second.empty()) {
+        int block = *it->second.begin();
+        it->second.erase(it->second.begin());
+        return {block, num_blocks};
+    }
+    Extent extent{end_block_, num_blocks};
+    end_block_ += num_blocks;
+    return extent;
+}
+
+/**
+ * @description: 读取页面所在的extent并解压出完整的页面，页面不存在或数据损坏时抛出InternalError
+ */
+void CompressedPageFile::read_full_page(page_id_t page_no, char *page) {
+    Extent extent;
+    {
+        std::scoped_lock lock{latch_};
+        auto it = pages_.find(page_no);
+        if (it == pages_.end()) {
+            throw InternalError("DiskManager::read_page Error");
+        }
+        extent = it->second;
+    }
+    alignas(8) static thread_local char buf[MAX_EXTENT_BLOCKS * BLOCK_SIZE];
+    ssize_t size = extent.num_blocks * BLOCK_SIZE;
+    ssize_t bytes_read = pread(fd_, buf, size, static_cast<off_t>(extent.block) * BLOCK_SIZE);
+    if (bytes_read == -1) {
+        throw UnixError();
+    }
+    ExtentHdr hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    const char *payload = buf + sizeof(hdr);
+    if (bytes_read < (ssize_t)sizeof(hdr) || hdr.magic != EXTENT_MAGIC || hdr.page_no != page_no ||
+        hdr.len > bytes_read - (ssize_t)sizeof(hdr) || checksum(payload, hdr.len) != hdr.checksum) {
+        throw InternalError("DiskManager::read_page Error");
+    }
+    if (hdr.compression == PAGE_COMPRESSION_ZERO_RUN) {
+        if (!ZeroRunCodec::decompress(payload, hdr.len, page)) {
+            throw InternalError("DiskManager::read_page Error");
+        }
+    } else if (hdr.len == PAGE_SIZE) {
+        memcpy(page, payload, PAGE_SIZE);
+    } else {
+        throw InternalError("DiskManager::read_page Error");
+    }
+}
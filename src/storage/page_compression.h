@@ -0,0 +1,115 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+
+/* 表文件的页面压缩方式，建表时确定，之后写入的每个页面都按此方式压缩 */
+enum PageCompression { PAGE_COMPRESSION_NONE = 0, PAGE_COMPRESSION_ZERO_RUN = 1 };
+
+const std::string PAGE_MAP_FILE_SUFFIX = ".pmap";
+
+/**
+ * @description: 零值游程编码。页面被编码为若干段，每段为[u16 字面量长度][u16 零字节个数][字面量]，
+ * 短于ZERO_RUN_MIN_LEN的零字节并入字面量。用零填充的CHAR字段和页面尾部的空闲空间都被压缩为一个段
+ */
+class ZeroRunCodec {
+   public:
+    static constexpr size_t ZERO_RUN_MIN_LEN = 8;
+
+    static size_t compress(const char *src, char *dst, size_t capacity);
+
+    static bool decompress(const char *src, size_t len, char *dst);
+};
+
+/**
+ * @description: 压缩的页面文件。文件按BLOCK_SIZE划分为块，第0块为文件头，之后每个页面占用连续的若干块（一个extent），
+ * extent以ExtentHdr开头，后面是压缩后的页面。内存中的页面映射记录每个页面所在的extent：
+ * 每次写入都写到新的extent（copy-on-write），写入完成后原extent才放入按大小组织的空闲链表供之后的页面复用。
+ * 关闭文件时页面映射保存到<文件名>.pmap中，打开时读取后立即删除；异常退出后.pmap不存在，按extent头重建页面映射，
+ * 同一页面的多个extent中seq最大的为最新版本
+ */
+class CompressedPageFile {
+   public:
+    static constexpr int BLOCK_SIZE = 512;
+
+    CompressedPageFile(int fd, const std::string &path);
+
+    static bool is_compressed(const std::string &path);
+
+    static void init_file(int fd, PageCompression compression);
+
+    void read_page(page_id_t page_no, char *data, int num_bytes);
+
+    void write_page(page_id_t page_no, const char *data, int num_bytes);
+
+    void truncate(int num_pages);
+
+    void save_map();
+
+   private:
+    struct FileHdr {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t compression;
+    };
+
+    struct ExtentHdr {
+        uint32_t magic;
+        page_id_t page_no;      // 页面号，-1表示空闲的extent
+        uint64_t seq;           // 写入序号，重建页面映射时用于区分同一页面的新旧版本
+        uint32_t checksum;      // 压缩数据的校验和
+        uint16_t len;           // 压缩数据的长度
+        uint8_t num_blocks;     // extent占用的块数
+        uint8_t compression;    // 压缩方式，页面无法压缩时为PAGE_COMPRESSION_NONE
+    };
+
+    struct Extent {
+        int block;
+        int num_blocks;
+        uint64_t seq = 0;       // 写入该extent时的序号，从.pmap读出的extent为0
+    };
+
+    static constexpr uint32_t FILE_MAGIC = 0x5a475052;      // "RPGZ"
+    static constexpr uint32_t EXTENT_MAGIC = 0x54585045;    // "EPXT"
+    static constexpr uint32_t MAP_FILE_MAGIC = 0x50414d50;  // "PMAP"
+    static constexpr uint32_t FILE_VERSION = 1;
+    static constexpr int MAX_EXTENT_BLOCKS = (sizeof(ExtentHdr) + PAGE_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    static uint32_t checksum(const char *data, size_t len);
+
+    bool load_map();
+
+    void rebuild_map();
+
+    void free_extent(const Extent &extent);
+
+    Extent allocate_extent(int num_blocks);
+
+    void read_full_page(page_id_t page_no, char *page);
+
+    int fd_;
+    std::string map_path_;
+    PageCompression compression_;
+    std::mutex latch_;                                  // 保护以下成员，读写extent时不持有
+    std::unordered_map<page_id_t, Extent> pages_;       // 页面号 -> 页面当前所在的extent
+    std::map<int, std::set<int>> free_extents_;         // 块数 -> 该大小的空闲extent的起始块号
+    int end_block_ = 1;                                 // 文件末尾的块号
+    uint64_t seq_ = 0;                                  // 最近一次写入的序号
+};
@@ -0,0 +1,94 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/page_table.h"
+
+#include <cassert>
+
+#include "errors.h"
+
+PageTable::PageTable(size_t num_frames) {
+    assert(num_frames <= MAX_FRAMES);
+    size_t capacity = 16;
+    while (capacity < num_frames * 2) {
+        capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @description: 插入或覆盖一个映射，调用者需持有分区的latch_
+ * @param {PageId} page_id 页面
+ * @param {frame_id_t} frame_id 页面所在的帧
+ */
+void PageTable::insert(PageId page_id, frame_id_t frame_id) {
+    if (!is_encodable(page_id)) {
+        throw InternalError("PageTable::insert: page id out of range " + page_id.toString());
+    }
+    assert(static_cast<uint64_t>(frame_id) <= FRAME_MASK);
+    uint64_t key = make_key(page_id);
+    uint64_t slot_value = key << FRAME_BITS | static_cast<uint64_t>(frame_id);
+    for (size_t pos = home(key);; pos = (pos + 1) & mask_) {
+        uint64_t slot = slots_[pos].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT) {
+            // 装填因子不超过1/2，总能找到空槽位
+            size_++;
+            slots_[pos].store(slot_value, std::memory_order_release);
+            return;
+        }
+        if ((slot >> FRAME_BITS) == key) {
+            slots_[pos].store(slot_value, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+/**
+ * @description: 删除一个映射，调用者需持有分区的latch_。
+ * 采用后移删除（backward shift）而不是墓碑，删除后探测链仍然紧凑，长时间运行后查找长度不会退化
+ * @param {PageId} page_id 页面，不存在时什么也不做
+ */
+void PageTable::erase(PageId page_id) {
+    if (!is_encodable(page_id)) {
+        return;
+    }
+    uint64_t key = make_key(page_id);
+    size_t hole = home(key);
+    while (true) {
+        uint64_t slot = slots_[hole].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT) {
+            return;
+        }
+        if ((slot >> FRAME_BITS) == key) {
+            break;
+        }
+        hole = (hole + 1) & mask_;
+    }
+    size_--;
+
+    // 把hole之后、初始位置不在(hole, pos]之间的槽位依次前移填补空洞
+    for (size_t pos = (hole + 1) & mask_;; pos = (pos + 1) & mask_) {
+        uint64_t slot = slots_[pos].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT) {
+            break;
+        }
+        size_t slot_home = home(slot >> FRAME_BITS);
+        bool movable = hole <= pos ? (slot_home <= hole || slot_home > pos) : (slot_home <= hole && slot_home > pos);
+        if (movable) {
+            slots_[hole].store(slot, std::memory_order_release);
+            hole = pos;
+        }
+    }
+    slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "page.h"
+
+/**
+ * @description: 缓冲池分区的页表，记录PageId到帧号的映射。
+ * 容量在构造时按帧数确定（不小于帧数的两倍的2的幂），采用开放定址和线性探测，插入和删除不申请内存。
+ * 每个槽位是一个64位原子变量，同时存放(fd, page_no)和帧号，读者总能看到某一时刻完整的映射。
+ * 插入和删除由调用者串行化（持有分区的latch_），查找不加锁，可以与插入、删除并发进行：
+ * 并发查找可能因删除时的后移操作而漏掉一个存在的页面，但不会返回从未存在过的映射，
+ * 因此无锁查找未命中时调用者需要在latch_下重新查找
+ */
+class PageTable {
+   public:
+    explicit PageTable(size_t num_frames);
+
+    /**
+     * @description: 查找页面所在的帧，不加锁
+     * @return {frame_id_t} 页面所在的帧号，不存在时返回INVALID_FRAME_ID
+     * @param {PageId} page_id 目标页面
+     */
+    frame_id_t find(PageId page_id) const {
+        uint64_t key = make_key(page_id);
+        for (size_t pos = home(key);; pos = (pos + 1) & mask_) {
+            uint64_t slot = slots_[pos].load(std::memory_order_acquire);
+            if (slot == EMPTY_SLOT) {
+                return INVALID_FRAME_ID;
+            }
+            if ((slot >> FRAME_BITS) == key) {
+                return static_cast<frame_id_t>(slot & FRAME_MASK);
+            }
+        }
+    }
+
+    size_t count(PageId page_id) const { return find(page_id) == INVALID_FRAME_ID ? 0 : 1; }
+
+    void insert(PageId page_id, frame_id_t frame_id);
+
+    void erase(PageId page_id);
+
+    size_t size() const { return size_; }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    /**
+     * @description: 判断PageId能否编码进槽位，fd和page_no超出编码范围的页面不能进入缓冲池
+     */
+    static bool is_encodable(PageId page_id) {
+        return page_id.fd >= 0 && static_cast<uint64_t>(page_id.fd) < MAX_FD && page_id.page_no >= 0;
+    }
+
+    static constexpr size_t MAX_FRAMES = size_t{1} << 21;  // 单个分区最多的帧数
+
+   private:
+    // 槽位编码：高43位为key = (fd + 1) << 31 | page_no，低21位为帧号，全0表示空槽位
+    static constexpr int FRAME_BITS = 21;
+    static constexpr uint64_t FRAME_MASK = (uint64_t{1} << FRAME_BITS) - 1;
+    static constexpr uint64_t MAX_FD = (uint64_t{1} << 12) - 1;
+    static constexpr uint64_t EMPTY_SLOT = 0;
+
+    static uint64_t make_key(PageId page_id) {
+        return (static_cast<uint64_t>(page_id.fd) + 1) << 31 | static_cast<uint32_t>(page_id.page_no);
+    }
+
+    /**
+     * @description: key的初始探测位置，使用64位整数的混合函数，使同一文件中相邻的页面分散到整个表中
+     */
+    size_t home(uint64_t key) const {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key) & mask_;
+    }
+
+    size_t mask_;
+    size_t size_ = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
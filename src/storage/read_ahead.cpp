@@ -0,0 +1,45 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/read_ahead.h"
+
+#include <algorithm>
+
+size_t ReadAheadWindow::on_access(size_t pos, size_t *begin) {
+    if (started_ && pos == last_ + 1) {
+        seq_run_++;
+    } else {
+        // 随机访问或重新开始扫描，窗口清零
+        seq_run_ = 0;
+        window_ = 0;
+        issued_ = 0;
+        next_ = pos + 1;
+    }
+    started_ = true;
+    last_ = pos;
+
+    if (seq_run_ < READ_AHEAD_TRIGGER) {
+        return 0;
+    }
+    if (window_ == 0) {
+        window_ = min_window_;
+    }
+    next_ = std::max(next_, pos + 1);
+    // 已预读但尚未访问的页面多于上一批的一半，暂不发起新的预读
+    if (next_ - pos - 1 > issued_ / 2) {
+        return 0;
+    }
+    *begin = next_;
+    size_t count = window_;
+    next_ += count;
+    issued_ = count;
+    window_ = std::min(window_ * 2, max_window_);
+    return count;
+}
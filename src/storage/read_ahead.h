@@ -0,0 +1,55 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * @description: 顺序预读窗口，由RmScan和IxScan各自持有一个。
+ * 扫描按逻辑位置（表文件中的页号，或叶子链上的第几个叶子）依次访问页面，
+ * 连续READ_AHEAD_TRIGGER次顺序访问后开始预读，每当已预读而未访问的页面不超过上一批的一半时发起下一批预读，
+ * 窗口从min_window开始每批翻倍，直到max_window。访问不连续时窗口清零，重新检测顺序模式
+ */
+class ReadAheadWindow {
+   public:
+    explicit ReadAheadWindow(size_t min_window = READ_AHEAD_MIN_WINDOW, size_t max_window = READ_AHEAD_MAX_WINDOW)
+        : min_window_(min_window), max_window_(max_window) {}
+
+    /**
+     * @description: 记录一次对逻辑位置pos的访问
+     * @return {size_t} 需要预读的页面个数，为0表示本次不需要预读
+     * @param {size_t} pos 本次访问的逻辑位置
+     * @param {size_t*} begin 需要预读的第一个逻辑位置
+     */
+    size_t on_access(size_t pos, size_t *begin);
+
+    /**
+     * @description: 调用者实际只预读到end（不含）时调用，例如到达文件末尾，之后从end继续预读
+     */
+    void truncate(size_t end) {
+        issued_ = end - (next_ - issued_);
+        next_ = end;
+    }
+
+    size_t get_window() const { return window_; }
+
+   private:
+    size_t min_window_;
+    size_t max_window_;
+    bool started_ = false;  // 是否已经访问过页面
+    size_t last_ = 0;       // 上一次访问的逻辑位置
+    size_t seq_run_ = 0;    // 连续顺序访问的次数
+    size_t window_ = 0;     // 下一批预读的页面数，为0表示尚未检测到顺序访问
+    size_t issued_ = 0;     // 上一批预读的页面数
+    size_t next_ = 0;       // 下一批预读的起始位置，即已预读部分的末尾
+};
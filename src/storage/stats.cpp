@@ -0,0 +1,109 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/stats.h"
+
+#include <algorithm>
+
+/**
+ * @description: 计算延迟所在的桶：小于SUB_BUCKETS纳秒的延迟每纳秒一个桶，
+ * 其余延迟按最高位所在的2的幂区间和紧随其后的两位划分
+ * @return {size_t} 桶的下标
+ * @param {uint64_t} ns 延迟，单位为纳秒
+ */
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+    if (ns < SUB_BUCKETS) {
+        return ns;
+    }
+    size_t exponent = 63 - __builtin_clzll(ns);
+    size_t sub = (ns >> (exponent - 2)) & (SUB_BUCKETS - 1);
+    return std::min((exponent - 1) * SUB_BUCKETS + sub, NUM_BUCKETS - 1);
+}
+
+/**
+ * @description: 桶中最小的延迟，与bucket_of互逆
+ * @return {uint64_t} 延迟，单位为纳秒
+ * @param {size_t} bucket 桶的下标
+ */
+uint64_t LatencyHistogram::bucket_lower_bound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t exponent = bucket / SUB_BUCKETS + 1;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << (exponent - 2);
+}
+
+/**
+ * @description: 记录一次延迟，只修改当前线程的分片
+ * @param {nanoseconds} latency 延迟
+ */
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    uint64_t ns = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+    Shard &shard = shards_[get_stats_shard()];
+    shard.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max_ns = shard.max_ns.load(std::memory_order_relaxed);
+    while (ns > max_ns && !shard.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @description: 合并所有分片，计算次数、平均值、中位数、99分位数和最大值。分位数取所在桶的中点
+ * @return {LatencySummary} 汇总结果
+ */
+LatencySummary LatencyHistogram::summarize() const {
+    uint64_t buckets[NUM_BUCKETS] = {};
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0;
+    LatencySummary summary;
+    for (const auto &shard : shards_) {
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+        max_ns = std::max(max_ns, shard.max_ns.load(std::memory_order_relaxed));
+    }
+    for (uint64_t count : buckets) {
+        summary.count += count;
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    auto percentile = [&](double p) {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * summary.count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t upper = i + 1 < NUM_BUCKETS ? bucket_lower_bound(i + 1) : max_ns + 1;
+                double mid = (bucket_lower_bound(i) + static_cast<double>(upper - 1)) / 2;
+                return std::min(mid, static_cast<double>(max_ns)) / 1000;
+            }
+        }
+        return max_ns / 1000.0;
+    };
+    summary.mean_us = static_cast<double>(sum_ns) / summary.count / 1000;
+    summary.p50_us = percentile(0.5);
+    summary.p99_us = percentile(0.99);
+    summary.max_us = max_ns / 1000.0;
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto &shard : shards_) {
+        for (auto &bucket : shard.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard.sum_ns.store(0, std::memory_order_relaxed);
+        shard.max_ns.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,158 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * @description: 当前线程使用的计数器分片。线程第一次计数时按顺序分配，之后固定不变
+ */
+inline size_t get_stats_shard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % STATS_COUNTER_SHARDS;
+    return shard;
+}
+
+/**
+ * @description: 分片计数器组。每个分片独占一个cache line，线程只修改自己的分片，
+ * 计数时不会与其他线程争用同一cache line；读取时把所有分片相加，读到的是近似的快照
+ * @tparam N 计数器的个数
+ */
+template <size_t N>
+class ShardedCounters {
+   public:
+    void add(size_t index, uint64_t value = 1) {
+        shards_[get_stats_shard()].values[index].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t get(size_t index) const {
+        uint64_t sum = 0;
+        for (const auto &shard : shards_) {
+            sum += shard.values[index].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    std::array<uint64_t, N> snapshot() const {
+        std::array<uint64_t, N> values{};
+        for (size_t i = 0; i < N; i++) {
+            values[i] = get(i);
+        }
+        return values;
+    }
+
+    void reset() {
+        for (auto &shard : shards_) {
+            for (auto &value : shard.values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> values[N]{};
+    };
+    Shard shards_[STATS_COUNTER_SHARDS];
+};
+
+// 缓冲池中统计的事件
+enum BufferPoolEvent : size_t {
+    BP_HIT,              // fetch_page命中缓冲池
+    BP_MISS,             // fetch_page需要从磁盘读取
+    BP_EVICTION,         // 帧中的有效页面被换出
+    BP_DIRTY_WRITEBACK,  // 脏页被写回磁盘（换出、后台写回或flush）
+    BP_PIN_WAIT,         // pin住页面后需要等待其上的读取或写回完成
+    BP_NEW_PAGE,         // new_page分配的新页面
+    BP_NUM_EVENTS
+};
+
+using BufferPoolCounters = ShardedCounters<BP_NUM_EVENTS>;
+
+/**
+ * @description: 缓冲池计数器的快照
+ */
+struct BufferPoolStats {
+    std::array<uint64_t, BP_NUM_EVENTS> events{};
+
+    uint64_t get(BufferPoolEvent event) const { return events[event]; }
+
+    double hit_ratio() const {
+        uint64_t accesses = events[BP_HIT] + events[BP_MISS];
+        return accesses == 0 ? 0 : static_cast<double>(events[BP_HIT]) / accesses;
+    }
+
+    BufferPoolStats &operator+=(const BufferPoolStats &other) {
+        for (size_t i = 0; i < BP_NUM_EVENTS; i++) {
+            events[i] += other.events[i];
+        }
+        return *this;
+    }
+};
+
+/**
+ * @description: 延迟直方图的汇总结果，单位为微秒
+ */
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+};
+
+/**
+ * @description: 分片的延迟直方图。桶按2的幂划分，每个2的幂区间再分为4个子桶，相对误差不超过25%
+ */
+class LatencyHistogram {
+   public:
+    static constexpr size_t SUB_BUCKETS = 4;
+    static constexpr size_t NUM_BUCKETS = 40 * SUB_BUCKETS;    // 最大约2^40纳秒，更大的延迟计入最后一个桶
+
+    void record(std::chrono::nanoseconds latency);
+
+    LatencySummary summarize() const;
+
+    void reset();
+
+    static size_t bucket_of(uint64_t ns);
+
+    static uint64_t bucket_lower_bound(size_t bucket);
+
+   private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[NUM_BUCKETS]{};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+    Shard shards_[STATS_COUNTER_SHARDS];
+};
+
+/**
+ * @description: 在析构时把从构造开始经过的时间记录到直方图中
+ */
+class ScopedLatency {
+   public:
+    explicit ScopedLatency(LatencyHistogram &histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+
+   private:
+    LatencyHistogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
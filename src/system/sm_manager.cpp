@@ -19,6 +19,21 @@ See the Mulan PSL v2 for more details. */
 #include "record/rm.h"
 #include "record_printer.h"
 
+/**
+ * @description: 表中需要维护zone map的字段，即所有INT和FLOAT字段
+ * @return {vector<RmZoneCol>} 字段的偏移量和类型
+ * @param {TabMeta&} tab 表的元数据
+ */
+static std::vector<RmZoneCol> get_zone_cols(const TabMeta& tab) {
+    std::vector<RmZoneCol> zone_cols;
+    for (auto& col : tab.cols) {
+        if (col.type == TYPE_INT || col.type == TYPE_FLOAT) {
+            zone_cols.push_back(RmZoneCol{col.offset, col.type});
+        }
+    }
+    return zone_cols;
+}
+
 /**
  * @description: 判断是否为一个文件夹
  * @return {bool} 返回是否为一个文件夹
@@ -94,7 +109,7 @@ void SmManager::open_db(const std::string& db_name) {
         ifs.close();
         for (auto& entry : db_.tabs_) {
             auto& tab = entry.second;
-            fhs_.emplace(tab.name, rm_manager_->open_file(tab.name));
+            fhs_.emplace(tab.name, rm_manager_->open_file(tab.name, get_zone_cols(tab)));
             for (auto index : tab.indexes) {
                 ihs_.emplace(ix_manager_->get_index_name(tab.name, index.cols),
                              ix_manager_->open_index(tab.name, index.cols));
@@ -159,6 +174,106 @@ void SmManager::show_tables(Context* context) {
     outfile.close();
 }
 
+// SHOW STATS输出的两张表的表头
+static const std::vector<std::string> POOL_STATS_CAPTIONS = {"Scope",      "Hits",      "Misses",    "Hit ratio",
+                                                             "Evictions",  "Writebacks", "Pin waits", "New pages"};
+static const std::vector<std::string> IO_STATS_CAPTIONS = {"I/O", "Count", "Avg(us)", "p50(us)", "p99(us)", "Max(us)"};
+
+/**
+ * @description: 把缓冲池计数器快照格式化为一行
+ */
+static std::vector<std::string> format_pool_stats(const std::string& scope, const BufferPoolStats& stats) {
+    char hit_ratio[32];
+    snprintf(hit_ratio, sizeof(hit_ratio), "%.2f%%", stats.hit_ratio() * 100);
+    return {scope,
+            std::to_string(stats.get(BP_HIT)),
+            std::to_string(stats.get(BP_MISS)),
+            hit_ratio,
+            std::to_string(stats.get(BP_EVICTION)),
+            std::to_string(stats.get(BP_DIRTY_WRITEBACK)),
+            std::to_string(stats.get(BP_PIN_WAIT)),
+            std::to_string(stats.get(BP_NEW_PAGE))};
+}
+
+/**
+ * @description: 把延迟直方图的汇总结果格式化为一行
+ */
+static std::vector<std::string> format_latency(const std::string& name, const LatencySummary& summary) {
+    auto format_us = [](double us) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", us);
+        return std::string(buf);
+    };
+    return {name,
+            std::to_string(summary.count),
+            format_us(summary.mean_us),
+            format_us(summary.p50_us),
+            format_us(summary.p99_us),
+            format_us(summary.max_us)};
+}
+
+/**
+ * @description: 收集缓冲池整体和每个已打开文件的计数器，以及页面读写的延迟分布
+ * @param {vector<vector<string>>*} pool_rows 缓冲池计数器，第一行为整个缓冲池，之后每个文件一行
+ * @param {vector<vector<string>>*} io_rows 页面读、写的延迟分布
+ */
+void SmManager::collect_stats(std::vector<std::vector<std::string>>* pool_rows,
+                              std::vector<std::vector<std::string>>* io_rows) {
+    pool_rows->push_back(format_pool_stats("<buffer pool>", buffer_pool_manager_->get_stats()));
+    for (auto& [path, stats] : disk_manager_->get_file_stats()) {
+        pool_rows->push_back(format_pool_stats(path, stats));
+    }
+    io_rows->push_back(format_latency("read_page", disk_manager_->get_read_latency().summarize()));
+    io_rows->push_back(format_latency("write_page", disk_manager_->get_write_latency().summarize()));
+}
+
+/**
+ * @description: 显示缓冲池的命中、缺页、换出等计数器以及页面读写的延迟分布
+ * @param {Context*} context
+ */
+void SmManager::show_stats(Context* context) {
+    std::vector<std::vector<std::string>> pool_rows, io_rows;
+    collect_stats(&pool_rows, &io_rows);
+    for (auto* table : {&pool_rows, &io_rows}) {
+        const auto& captions = table == &pool_rows ? POOL_STATS_CAPTIONS : IO_STATS_CAPTIONS;
+        RecordPrinter printer(captions.size());
+        printer.print_separator(context);
+        printer.print_record(captions, context);
+        printer.print_separator(context);
+        for (auto& row : *table) {
+            printer.print_record(row, context);
+        }
+        printer.print_separator(context);
+    }
+}
+
+/**
+ * @description: 以与output.txt相同的格式把SHOW STATS的内容追加到os中，用于定期转储
+ * @param {ostream&} os 输出流
+ */
+void SmManager::dump_stats(std::ostream& os) {
+    std::vector<std::vector<std::string>> pool_rows, io_rows;
+    collect_stats(&pool_rows, &io_rows);
+    time_t now = time(nullptr);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%F %T", localtime(&now));
+    os << "# " << timestamp << "\n";
+    auto print_row = [&](const std::vector<std::string>& row) {
+        os << "|";
+        for (auto& col : row) {
+            os << " " << col << " |";
+        }
+        os << "\n";
+    };
+    for (auto* table : {&pool_rows, &io_rows}) {
+        print_row(table == &pool_rows ? POOL_STATS_CAPTIONS : IO_STATS_CAPTIONS);
+        for (auto& row : *table) {
+            print_row(row);
+        }
+    }
+    os.flush();
+}
+
 /**
  * @description: 显示表的元数据
  * @param {string&} tab_name 表名称
@@ -175,7 +290,8 @@ void SmManager::desc_table(const std::string& tab_name, Context* context) {
     printer.print_separator(context);
     // Print fields
     for (auto& col : tab.cols) {
-        std::vector<std::string> field_info = {col.name, coltype2str(col.type), col.index ? "YES" : "NO"};
+        std::vector<std::string> field_info = {col.name, col.var_len ? "VARCHAR" : coltype2str(col.type),
+                                               col.index ? "YES" : "NO"};
         printer.print_record(field_info, context);
     }
     // Print footer
@@ -187,8 +303,11 @@ void SmManager::desc_table(const std::string& tab_name, Context* context) {
  * @param {string&} tab_name 表的名称
  * @param {vector<ColDef>&} col_defs 表的字段
  * @param {Context*} context
+ * @param {RmLayout} layout 表文件的页面格式，VARCHAR字段只有在slotted格式中才按实际长度存放，PAX格式按字段分别存放
+ * @param {PageCompression} compression 表文件的页面压缩方式，打开表文件时根据文件头识别，不需要记录在元数据中
  */
-void SmManager::create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context) {
+void SmManager::create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context,
+                             RmLayout layout, PageCompression compression) {
     if (db_.is_table(tab_name)) {
         throw TableExistsError(tab_name);
     }
@@ -196,22 +315,27 @@ void SmManager::create_table(const std::string& tab_name, const std::vector<ColD
     int curr_offset = 0;
     TabMeta tab;
     tab.name = tab_name;
+    std::vector<RmVarCol> var_cols;
     for (auto& col_def : col_defs) {
         ColMeta col = {.tab_name = tab_name,
                        .name = col_def.name,
                        .type = col_def.type,
                        .len = col_def.len,
                        .offset = curr_offset,
-                       .index = false};
+                       .index = false,
+                       .var_len = col_def.var_len};
+        if (col_def.var_len || layout == RM_LAYOUT_PAX) {
+            var_cols.push_back(RmVarCol{static_cast<int16_t>(curr_offset), static_cast<int16_t>(col_def.len)});
+        }
         curr_offset += col_def.len;
         tab.cols.push_back(col);
     }
     // Create & open record file
     int record_size = curr_offset;  // record_size就是col meta所占的大小（表的元数据也是以记录的形式进行存储的）
-    rm_manager_->create_file(tab_name, record_size);
+    rm_manager_->create_file(tab_name, record_size, layout, var_cols, compression);
     db_.tabs_[tab_name] = tab;
     // fhs_[tab_name] = rm_manager_->open_file(tab_name);
-    fhs_.emplace(tab_name, rm_manager_->open_file(tab_name));
+    fhs_.emplace(tab_name, rm_manager_->open_file(tab_name, get_zone_cols(tab)));
 
     // 申请表级写锁
     if (context) {
@@ -252,36 +376,51 @@ void SmManager::drop_table(const std::string& tab_name, Context* context) {
  * @param {string&} tab_name 表的名称
  * @param {vector<string>&} col_names 索引包含的字段名称
  * @param {Context*} context
+ * @param {IxLatchMode} latch_mode 索引的并发控制方式
+ * @param {double} fill_factor 结点填到的比例
+ * @note 扫描表得到所有键值对，排序（超出内存时写入临时文件归并）后自底向上批量构建，而不是逐条插入
  */
-void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
+void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                             IxLatchMode latch_mode, double fill_factor) {
     TabMeta& tab = db_.get_table(tab_name);
     if (ix_manager_->exists(tab_name, col_names)) {
         throw IndexExistsError(tab_name, col_names);
     }
     // 申请表级读锁
-    context->lock_mgr_->lock_shared_on_table(context->txn_, fhs_[tab_name]->GetFd());
+    if (context) {
+        context->lock_mgr_->lock_shared_on_table(context->txn_, fhs_[tab_name]->GetFd());
+    }
 
     std::vector<ColMeta> cols;
     for (auto& col_name : col_names) {
         cols.push_back(*tab.get_col(col_name));
     }
-    ix_manager_->create_index(tab_name, cols);
+    ix_manager_->create_index(tab_name, cols, latch_mode);
     std::unique_ptr<IxIndexHandle> ih = ix_manager_->open_index(tab_name, cols);
     int col_tot_len = 0;
+    std::vector<ColType> col_types;
+    std::vector<int> col_lens;
     for (ColMeta& col : cols) {
         col_tot_len += col.len;
+        col_types.push_back(col.type);
+        col_lens.push_back(col.len);
     }
     RmFileHandle* file_handle = fhs_.at(tab_name).get();
+    IxSorter sorter(col_types, col_lens);
     char key[col_tot_len];
-    for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
-        std::unique_ptr<RmRecord> record = file_handle->get_record(scan.rid(), context);
-        int offset = 0;
-        for (size_t i = 0; i < cols.size(); ++i) {
-            memcpy(key + offset, record.get()->data + cols[i].offset, cols[i].len);
-            offset += cols[i].len;
+    for (RmBatchScan scan(file_handle); scan.next_batch();) {
+        for (int r = 0; r < scan.size(); ++r) {
+            int offset = 0;
+            for (size_t i = 0; i < cols.size(); ++i) {
+                memcpy(key + offset, scan.record(r) + cols[i].offset, cols[i].len);
+                offset += cols[i].len;
+            }
+            sorter.add(key, scan.rid(r));
         }
-        ih->insert_entry(key, scan.rid(), context->txn_);
     }
+    // 新建的索引一定为空，构建写入的都是新页面，直接写回磁盘
+    ih->bulk_load(&sorter, fill_factor);
+    buffer_pool_manager_->flush_all_pages(ih->GetFd());
     tab.indexes.push_back(IndexMeta{tab_name, col_tot_len, (int)cols.size(), cols});
     ihs_.emplace(ix_manager_->get_index_name(tab_name, col_names), std::move(ih));
 
@@ -296,7 +435,9 @@ void SmManager::create_index(const std::string& tab_name, const std::vector<std:
  */
 void SmManager::drop_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
     // 申请表级读锁
-    context->lock_mgr_->lock_shared_on_table(context->txn_, fhs_[tab_name]->GetFd());
+    if (context) {
+        context->lock_mgr_->lock_shared_on_table(context->txn_, fhs_[tab_name]->GetFd());
+    }
 
     if (!ix_manager_->exists(tab_name, col_names)) {
         throw IndexNotFoundError(tab_name, col_names);
@@ -325,4 +466,52 @@ void SmManager::drop_index(const std::string& tab_name, const std::vector<ColMet
         col_names.push_back(col.name);
     }
     drop_index(tab_name, col_names, context);
+}
+
+/**
+ * @description: 整理表的数据文件：把记录移到文件前部紧密排列，把索引中指向被移动记录的项改为新的rid并写回索引，
+ * 最后写回数据页并截掉末尾的空页面。整理期间持有表级写锁。
+ * 整理不写日志：索引写回之后、数据页写回之前崩溃，或移动过程中缓冲池提前换出了部分数据页，
+ * 磁盘上的索引和数据文件可能不一致；更新索引时抛出异常，尚未更新的索引项仍指向已被移走的位置
+ * @param {string&} tab_name 表的名称
+ * @param {Context*} context
+ */
+void SmManager::vacuum_table(const std::string& tab_name, Context* context) {
+    if (!db_.is_table(tab_name)) {
+        throw TableNotFoundError(tab_name);
+    }
+
+    // 申请表级写锁
+    if (context) {
+        context->lock_mgr_->lock_exclusive_on_table(context->txn_, fhs_[tab_name]->GetFd());
+    }
+
+    TabMeta& tab = db_.get_table(tab_name);
+    RmFileHandle* file_handle = fhs_.at(tab_name).get();
+    std::vector<std::pair<Rid, Rid>> moves;
+    file_handle->compact(&moves);
+
+    Transaction* txn = context ? context->txn_ : nullptr;
+    // 截断文件之前先更新并写回索引，被截掉的页面上不会再有索引项指向的记录
+    for (IndexMeta& index : tab.indexes) {
+        IxIndexHandle* ih = ihs_.at(ix_manager_->get_index_name(tab_name, index.cols)).get();
+        char key[index.col_tot_len];
+        std::vector<Rid> result;
+        for (auto& [from, to] : moves) {
+            auto record = file_handle->get_record(to, nullptr);
+            int offset = 0;
+            for (auto& col : index.cols) {
+                memcpy(key + offset, record->data + col.offset, col.len);
+                offset += col.len;
+            }
+            // 重复的键值在索引中只有一项，可能指向其他记录
+            result.clear();
+            if (ih->get_value(key, &result, txn) && result.front() == from) {
+                ih->delete_entry(key, txn);
+                ih->insert_entry(key, to, txn);
+            }
+        }
+        buffer_pool_manager_->flush_all_pages(ih->GetFd());
+    }
+    file_handle->truncate_empty_pages();
 }
\ No newline at end of file
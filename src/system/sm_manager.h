@@ -22,6 +22,7 @@ struct ColDef {
     std::string name;  // Column name
     ColType type;      // Type of column
     int len;           // Length of column
+    bool var_len = false;   // VARCHAR字段，slotted格式的表中只存放实际长度
 };
 
 /* 系统管理器，负责元数据管理和DDL语句的执行 */
@@ -38,6 +39,9 @@ class SmManager {
     RmManager* rm_manager_;
     IxManager* ix_manager_;
 
+    void collect_stats(std::vector<std::vector<std::string>>* pool_rows,
+                       std::vector<std::vector<std::string>>* io_rows);
+
    public:
     SmManager(DiskManager* disk_manager, BufferPoolManager* buffer_pool_manager, RmManager* rm_manager,
               IxManager* ix_manager)
@@ -70,13 +74,21 @@ class SmManager {
 
     void desc_table(const std::string& tab_name, Context* context);
 
-    void create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context);
+    void show_stats(Context* context);
+
+    void dump_stats(std::ostream& os);
+
+    void create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context,
+                      RmLayout layout = RM_LAYOUT_FIXED, PageCompression compression = PAGE_COMPRESSION_NONE);
 
     void drop_table(const std::string& tab_name, Context* context);
 
-    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
+    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                      IxLatchMode latch_mode = IX_LATCH_CRABBING, double fill_factor = IX_BULK_FILL_FACTOR);
 
     void drop_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
 
     void drop_index(const std::string& tab_name, const std::vector<ColMeta>& col_names, Context* context);
+
+    void vacuum_table(const std::string& tab_name, Context* context);
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+constexpr int BENCH_NUM_KEYS = 1 << 20;         // 索引中的键值个数
+constexpr size_t BENCH_POOL_SIZE = 16384;       // 缓冲池能放下整棵树
+constexpr size_t BENCH_SPILL_MEMORY = 4 << 20;  // 外部排序时内存中的键值对最多占用的字节数
+const std::string BENCH_DB_NAME = "BPlusTreeBulkLoadBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+/**
+ * @brief 为随机顺序的键值对建索引：逐条insert_entry，与排序后自底向上批量构建（全部在内存中排序，
+ * 以及限制内存、写出多个run后归并）相比较，打印耗时和建成的树的叶子结点数、树高
+ */
+class BPlusTreeBulkLoadBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 用三种方式分别为make_key(i)生成的key（按随机顺序给出）建索引，每种方式打印一行结果
+     */
+    void run(const char *name, const std::vector<ColMeta> &index_cols, const std::function<void(int, char *)> &make_key) {
+        std::vector<ColType> col_types;
+        std::vector<int> col_lens;
+        int key_len = 0;
+        for (auto &col : index_cols) {
+            col_types.push_back(col.type);
+            col_lens.push_back(col.len);
+            key_len += col.len;
+        }
+        std::vector<char> keys((size_t)BENCH_NUM_KEYS * key_len);
+        std::vector<int> order(BENCH_NUM_KEYS);
+        for (int i = 0; i < BENCH_NUM_KEYS; i++) {
+            make_key(i, keys.data() + (size_t)i * key_len);
+            order[i] = i;
+        }
+        std::mt19937 rng(2023);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        for (const char *method : {"insert", "sort+build", "spill+build"}) {
+            // 每次使用新的缓冲池，重新创建的索引文件可能复用上一次的fd
+            buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+            ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+            ix_manager_->create_index(BENCH_FILE_NAME, index_cols);
+            auto ih = ix_manager_->open_index(BENCH_FILE_NAME, index_cols);
+
+            int num_runs = 0;
+            auto start = std::chrono::steady_clock::now();
+            if (method[0] == 'i') {
+                for (int i : order) {
+                    ih->insert_entry(keys.data() + (size_t)i * key_len, Rid{i, 0}, nullptr);
+                }
+            } else {
+                IxSorter sorter(col_types, col_lens, method[1] == 'o' ? IX_SORT_MEMORY : BENCH_SPILL_MEMORY);
+                for (int i : order) {
+                    sorter.add(keys.data() + (size_t)i * key_len, Rid{i, 0});
+                }
+                num_runs = sorter.num_runs();
+                EXPECT_TRUE(ih->bulk_load(&sorter, 1.0));
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            int height = 1;
+            for (IxNodeHandle *node = ih->fetch_node(ih->file_hdr_->root_page_);;) {
+                bool leaf = node->is_leaf_page();
+                page_id_t child = leaf ? IX_NO_PAGE : node->value_at(0);
+                buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+                delete node;
+                if (leaf) {
+                    break;
+                }
+                node = ih->fetch_node(child);
+                height++;
+            }
+            int num_leaves = 0;
+            for (page_id_t page_no = ih->file_hdr_->first_leaf_; page_no != IX_LEAF_HEADER_PAGE; num_leaves++) {
+                IxNodeHandle *leaf = ih->fetch_node(page_no);
+                page_no = leaf->get_next_leaf();
+                buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+                delete leaf;
+            }
+
+            printf("%-10s %-12s %8d %10.3f %12.2f %8d %8d\n", name, method, num_runs, elapsed.count(),
+                   BENCH_NUM_KEYS / elapsed.count() / 1e6, num_leaves, height);
+            fflush(stdout);
+            ix_manager_->close_index(ih.get());
+            ix_manager_->destroy_index(BENCH_FILE_NAME, index_cols);
+        }
+    }
+};
+
+TEST_F(BPlusTreeBulkLoadBench, BuildIndex) {
+    printf("%-10s %-12s %8s %10s %12s %8s %8s\n", "key", "method", "runs", "seconds", "Mkeys/s", "leaves", "height");
+    run("int", {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0}}, [](int i, char *key) { memcpy(key, &i, sizeof(i)); });
+    run("char(32)", {{BENCH_FILE_NAME, "col1", TYPE_STRING, 32, 0}}, [](int i, char *key) {
+        memset(key, 0, 32);
+        snprintf(key, 32, "order/%02d/%010d", i % 64, i);
+    });
+}
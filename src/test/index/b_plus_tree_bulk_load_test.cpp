@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+#include "execution/executor_load.h"
+#include "record/rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "system/sm.h"
+#include "transaction/transaction_manager.h"
+
+const std::string TEST_DB_NAME = "BPlusTreeBulkLoadTest_db";
+const std::string TEST_FILE_NAME = "table1";
+const std::vector<std::string> TEST_COL = {"col1"};
+
+class BPlusTreeBulkLoadTests : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<RmManager> rm_;
+    std::unique_ptr<SmManager> sm_;
+    std::unique_ptr<LockManager> lock_mgr_;
+    std::unique_ptr<Transaction> txn_;
+    std::unique_ptr<Context> context_;
+    IxIndexHandle *ih_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        rm_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        sm_ = std::make_unique<SmManager>(disk_manager_.get(), buffer_pool_manager_.get(), rm_.get(), ix_manager_.get());
+        lock_mgr_ = std::make_unique<LockManager>();
+        txn_ = std::make_unique<Transaction>(0);
+        context_ = std::make_unique<Context>(lock_mgr_.get(), nullptr, txn_.get());
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        sm_->create_db(TEST_DB_NAME);
+        sm_->open_db(TEST_DB_NAME);
+        std::vector<ColDef> coldef;
+        coldef.push_back({"col1", TYPE_INT, 4});
+        coldef.push_back({"col2", TYPE_STRING, 16});
+        sm_->create_table(TEST_FILE_NAME, coldef, context_.get());
+        sm_->create_index(TEST_FILE_NAME, TEST_COL, context_.get());
+        ih_ = sm_->ihs_.at(ix_manager_->get_index_name(TEST_FILE_NAME, TEST_COL)).get();
+    }
+
+    void TearDown() override {
+        sm_->close_db();
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    /**
+     * @brief 沿叶子链扫描整棵树，检查键值严格递增，返回所有键值
+     */
+    std::vector<int> scan_keys() {
+        std::vector<int> keys;
+        IxScan scan(ih_, ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get());
+        for (; !scan.is_end(); scan.next()) {
+            auto node = ih_->fetch_node(scan.iid().page_no);
+            keys.push_back(*reinterpret_cast<int *>(node->get_key(scan.iid().slot_no)));
+            buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+            delete node;
+        }
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+        EXPECT_EQ(std::adjacent_find(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    /**
+     * @brief 沿叶子链得到每个叶子结点中键值对的数量和它能存放的数量
+     */
+    std::vector<std::pair<int, int>> leaf_sizes(IxIndexHandle *ih) {
+        std::vector<std::pair<int, int>> sizes;
+        for (page_id_t page_no = ih->file_hdr_->first_leaf_; page_no != IX_LEAF_HEADER_PAGE;) {
+            IxNodeHandle *leaf = ih->fetch_node(page_no);
+            sizes.emplace_back(leaf->get_size(), leaf->get_max_size());
+            page_no = leaf->get_next_leaf();
+            buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+            delete leaf;
+        }
+        return sizes;
+    }
+};
+
+/**
+ * @brief 从排序好的键值自底向上构建B+树，构建后的树可以正常查找、扫描、插入和删除；非空的树不能再批量构建
+ */
+TEST_F(BPlusTreeBulkLoadTests, BuildFromSortedKeys) {
+    constexpr int NUM_KEYS = 10000;
+    std::vector<int> keys;
+    std::vector<Rid> rids;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        keys.push_back(2 * i);
+        rids.push_back(Rid{i / 100 + 1, i % 100});
+    }
+    ASSERT_TRUE(ih_->bulk_load(reinterpret_cast<const char *>(keys.data()), rids.data(), NUM_KEYS));
+    EXPECT_NE(ih_->file_hdr_->root_page_, IX_INIT_ROOT_PAGE);
+
+    std::vector<Rid> result;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        result.clear();
+        ASSERT_TRUE(ih_->get_value(reinterpret_cast<const char *>(&keys[i]), &result, nullptr));
+        EXPECT_EQ(result.front(), rids[i]);
+    }
+    int odd = 1;
+    result.clear();
+    EXPECT_FALSE(ih_->get_value(reinterpret_cast<const char *>(&odd), &result, nullptr));
+    EXPECT_EQ(scan_keys(), keys);
+
+    // 已有数据的树上不能批量构建，树保持不变
+    EXPECT_FALSE(ih_->bulk_load(reinterpret_cast<const char *>(&odd), rids.data(), 1));
+
+    // 批量构建后的结点满足B+树的大小约束，随机的插入和删除会正常地分裂和合并结点
+    std::set<int> expected(keys.begin(), keys.end());
+    std::mt19937 rng(2023);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int key = rng() % (2 * NUM_KEYS + 100);
+        if (rng() % 2 == 0) {
+            ih_->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, nullptr);
+            expected.insert(key);
+        } else if (expected.count(key)) {
+            ih_->delete_entry(reinterpret_cast<const char *>(&key), nullptr);
+            expected.erase(key);
+        }
+    }
+    EXPECT_EQ(scan_keys(), std::vector<int>(expected.begin(), expected.end()));
+}
+
+/**
+ * @brief 多行insert和COPY FROM把记录装入连续的新页面并构建索引，重复的键值只在索引中出现一次
+ */
+TEST_F(BPlusTreeBulkLoadTests, LoadExecutor) {
+    constexpr int NUM_ROWS = 5000;
+    {
+        std::ofstream out("data.csv");
+        out << "col1,col2\r\n";
+        for (int i = NUM_ROWS - 1; i >= 0; i--) {
+            out << i << ",name" << i << "\r\n";
+        }
+    }
+    LoadExecutor copy(sm_.get(), TEST_FILE_NAME, "data.csv", context_.get());
+    copy.Next();
+
+    std::vector<std::vector<Value>> rows(2, std::vector<Value>(2));
+    rows[0][0].set_int(NUM_ROWS);
+    rows[0][1].set_str("last");
+    rows[1][0].set_int(0);
+    rows[1][1].set_str("duplicate");
+    LoadExecutor insert(sm_.get(), TEST_FILE_NAME, rows, context_.get());
+    insert.Next();
+
+    auto fh = sm_->fhs_.at(TEST_FILE_NAME).get();
+    int num_records = 0;
+    for (RmScan scan(fh); !scan.is_end(); scan.next()) {
+        num_records++;
+    }
+    EXPECT_EQ(num_records, NUM_ROWS + 2);
+    EXPECT_EQ(txn_->get_write_set()->size(), (size_t)NUM_ROWS + 2);
+    int min_pages = (NUM_ROWS + 2 + fh->get_file_hdr().num_records_per_page - 1) / fh->get_file_hdr().num_records_per_page;
+    // 每个批次只有最后一个页面可能未满：COPY分两批写入，多行insert写入一批
+    EXPECT_LE(fh->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE, min_pages + 2);
+
+    std::vector<int> keys = scan_keys();
+    ASSERT_EQ((int)keys.size(), NUM_ROWS + 1);
+    for (int i = 0; i <= NUM_ROWS; i++) {
+        EXPECT_EQ(keys[i], i);
+        std::vector<Rid> result;
+        ASSERT_TRUE(ih_->get_value(reinterpret_cast<const char *>(&i), &result, nullptr));
+        auto rec = fh->get_record(result.front(), nullptr);
+        EXPECT_EQ(*reinterpret_cast<int *>(rec->data), i);
+        EXPECT_EQ(std::string(rec->data + 4), i == NUM_ROWS ? "last" : "name" + std::to_string(i));
+    }
+
+    // 格式错误的行报告所在的行号
+    {
+        std::ofstream out("bad.csv");
+        out << "1,a\nx,b\n";
+    }
+    LoadExecutor bad(sm_.get(), TEST_FILE_NAME, "bad.csv", nullptr);
+    EXPECT_THROW(bad.Next(), LoadDataError);
+    LoadExecutor missing(sm_.get(), TEST_FILE_NAME, "missing.csv", nullptr);
+    EXPECT_THROW(missing.Next(), FileNotFoundError);
+}
+
+/**
+ * @brief 装载中途失败时，已写入数据文件的记录被删除，不登记写操作，已有记录的索引项不受影响；
+ * 事务回滚装载的记录时，因键值重复而没有写入索引的记录不会删掉已有记录的索引项
+ */
+TEST_F(BPlusTreeBulkLoadTests, LoadFailureRollsBack) {
+    constexpr int NUM_ROWS = 100;
+    std::vector<std::vector<Value>> rows(NUM_ROWS, std::vector<Value>(2));
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i][0].set_int(i);
+        rows[i][1].set_str("old" + std::to_string(i));
+    }
+    LoadExecutor insert(sm_.get(), TEST_FILE_NAME, rows, context_.get());
+    insert.Next();
+    auto fh = sm_->fhs_.at(TEST_FILE_NAME).get();
+    auto check_table = [&]() {
+        int num_records = 0;
+        for (RmScan scan(fh); !scan.is_end(); scan.next()) {
+            num_records++;
+        }
+        EXPECT_EQ(num_records, NUM_ROWS);
+        std::vector<int> keys = scan_keys();
+        ASSERT_EQ((int)keys.size(), NUM_ROWS);
+        for (int i = 0; i < NUM_ROWS; i++) {
+            EXPECT_EQ(keys[i], i);
+            std::vector<Rid> result;
+            ASSERT_TRUE(ih_->get_value(reinterpret_cast<const char *>(&i), &result, nullptr));
+            auto rec = fh->get_record(result.front(), nullptr);
+            EXPECT_EQ(std::string(rec->data + 4), "old" + std::to_string(i));
+        }
+    };
+
+    // 第一批记录写入数据文件之后才遇到格式错误的行，其中包含与已有记录键值相同的行
+    {
+        std::ofstream out("partial.csv");
+        out << "7,duplicate\n";
+        for (int i = 0; i < 5000; i++) {
+            out << NUM_ROWS + i << ",new" << i << "\n";
+        }
+        out << "x,bad\n";
+    }
+    size_t num_writes = txn_->get_write_set()->size();
+    LoadExecutor partial(sm_.get(), TEST_FILE_NAME, "partial.csv", context_.get());
+    EXPECT_THROW(partial.Next(), LoadDataError);
+    EXPECT_EQ(txn_->get_write_set()->size(), num_writes);
+    check_table();
+
+    // 提交已有记录后，回滚另一个装载了重复键值的事务
+    TransactionManager txn_manager(lock_mgr_.get(), sm_.get());
+    txn_manager.commit(txn_.get(), nullptr);
+    Transaction txn(1);
+    Context context(lock_mgr_.get(), nullptr, &txn);
+    std::vector<std::vector<Value>> new_rows(2, std::vector<Value>(2));
+    new_rows[0][0].set_int(7);
+    new_rows[0][1].set_str("duplicate");
+    new_rows[1][0].set_int(NUM_ROWS);
+    new_rows[1][1].set_str("new");
+    LoadExecutor load(sm_.get(), TEST_FILE_NAME, new_rows, &context);
+    load.Next();
+    txn_manager.abort(&txn, nullptr);
+    check_table();
+}
+
+/**
+ * @brief 内存放不下时排序器写出多个run再归并：输出按key升序，重复的key只保留最先加入的键值对
+ */
+TEST_F(BPlusTreeBulkLoadTests, SorterSpillsRuns) {
+    IxSorter sorter({TYPE_INT}, {4}, 1000);
+    std::mt19937 rng(2023);
+    std::map<int, Rid> first;
+    for (int i = 0; i < 5000; i++) {
+        int key = rng() % 2000;
+        sorter.add(reinterpret_cast<const char *>(&key), Rid{i, 0});
+        first.emplace(key, Rid{i, 0});
+    }
+    EXPECT_GT(sorter.num_runs(), 1);
+
+    std::vector<std::pair<int, Rid>> sorted;
+    const char *keys;
+    const Rid *rids;
+    for (int n; (n = sorter.next_batch(&keys, &rids)) > 0;) {
+        for (int i = 0; i < n; i++) {
+            sorted.emplace_back(reinterpret_cast<const int *>(keys)[i], rids[i]);
+        }
+    }
+    std::vector<std::pair<int, Rid>> expected(first.begin(), first.end());
+    EXPECT_EQ(sorted, expected);
+}
+
+/**
+ * @brief 从排序器按批取出键值对构建B+树：跨越多个批次时除最后两个叶子结点外每个叶子结点都被填满
+ */
+TEST_F(BPlusTreeBulkLoadTests, BuildFromSorter) {
+    constexpr int NUM_KEYS = 100000;
+    std::vector<int> keys(NUM_KEYS);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        keys[i] = i;
+    }
+    std::mt19937 rng(2023);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    IxSorter sorter({TYPE_INT}, {4}, 1 << 16);
+    for (int key : keys) {
+        sorter.add(reinterpret_cast<const char *>(&key), Rid{key, 0});
+    }
+    ASSERT_TRUE(ih_->bulk_load(&sorter, 1.0));
+
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(scan_keys(), keys);
+    for (int key = 0; key < NUM_KEYS; key += 97) {
+        std::vector<Rid> result;
+        ASSERT_TRUE(ih_->get_value(reinterpret_cast<const char *>(&key), &result, nullptr));
+        EXPECT_EQ(result.front(), (Rid{key, 0}));
+    }
+    auto sizes = leaf_sizes(ih_);
+    ASSERT_GT(sizes.size(), 2);
+    for (size_t i = 0; i + 2 < sizes.size(); i++) {
+        EXPECT_EQ(sizes[i].first, ih_->file_hdr_->btree_order_);
+    }
+    EXPECT_GE(sizes[sizes.size() - 2].first, (ih_->file_hdr_->btree_order_ + 1) / 2);
+    EXPECT_GE(sizes.back().first, (ih_->file_hdr_->btree_order_ + 1) / 2);
+}
+
+/**
+ * @brief 在已有数据的表上建索引时批量构建：结果与逐条插入相同，重复的键值只保留第一条记录；
+ * 叶子结点按fill factor留出空间，装载时构建的索引使用默认的IX_BULK_FILL_FACTOR
+ */
+TEST_F(BPlusTreeBulkLoadTests, CreateIndexOnExistingTable) {
+    constexpr int NUM_ROWS = 20000;
+    std::vector<std::vector<Value>> rows(NUM_ROWS, std::vector<Value>(2));
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i][0].set_int(i);
+        rows[i][1].set_str("customer-" + std::to_string(1000000 + i % (NUM_ROWS / 2)));
+    }
+    LoadExecutor insert(sm_.get(), TEST_FILE_NAME, rows, context_.get());
+    insert.Next();
+    auto sizes = leaf_sizes(ih_);
+    ASSERT_GT(sizes.size(), 2);
+    for (size_t i = 0; i + 2 < sizes.size(); i++) {
+        EXPECT_EQ(sizes[i].first, (int)std::ceil(ih_->file_hdr_->btree_order_ * IX_BULK_FILL_FACTOR));
+    }
+
+    const std::vector<std::string> col2 = {"col2"};
+    sm_->create_index(TEST_FILE_NAME, col2, context_.get(), IX_LATCH_CRABBING, 0.7);
+    IxIndexHandle *ih = sm_->ihs_.at(ix_manager_->get_index_name(TEST_FILE_NAME, col2)).get();
+    EXPECT_EQ(ih->file_hdr_->format_version_, IX_FORMAT_PREFIX);
+    int count = 0;
+    for (IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get()); !scan.is_end(); scan.next()) {
+        count++;
+    }
+    EXPECT_EQ(count, NUM_ROWS / 2);
+    auto fh = sm_->fhs_.at(TEST_FILE_NAME).get();
+    for (int i = 0; i < NUM_ROWS / 2; i += 31) {
+        char key[16] = {};
+        std::string str = "customer-" + std::to_string(1000000 + i);
+        memcpy(key, str.data(), str.size());
+        std::vector<Rid> result;
+        ASSERT_TRUE(ih->get_value(key, &result, nullptr));
+        auto rec = fh->get_record(result.front(), nullptr);
+        EXPECT_EQ(*reinterpret_cast<int *>(rec->data), i);
+    }
+    sizes = leaf_sizes(ih);
+    ASSERT_GT(sizes.size(), 2);
+    for (size_t i = 0; i + 2 < sizes.size(); i++) {
+        EXPECT_LE(sizes[i].first, (int)std::ceil(sizes[i].second * 0.7));
+        EXPECT_GE(sizes[i].first, (ih->file_hdr_->btree_order_ + 1) / 2);
+    }
+}
@@ -0,0 +1,134 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/ix.h"
+
+constexpr int BENCH_NUM_KEYS = 1 << 18;         // 每轮插入的键值个数，约800个叶子结点
+constexpr size_t BENCH_POOL_SIZE = 4096;        // 缓冲池能放下整棵树，只测量结点上的锁竞争
+const std::string BENCH_DB_NAME = "BPlusTreeConcurrentBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+/**
+ * @brief B+树并发吞吐量基准测试：多个线程各自处理键值的一部分，测量插入、查找、混合读写的吞吐量随线程数的变化
+ */
+class BPlusTreeConcurrentBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::vector<ColMeta> index_cols_ = {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0}};
+    std::vector<int> keys_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        for (int key = 0; key < BENCH_NUM_KEYS; key++) {
+            keys_.push_back(key);
+        }
+        std::shuffle(keys_.begin(), keys_.end(), std::mt19937(2023));
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief num_threads个线程分别对keys_中下标模num_threads余tid的键值执行op，返回每秒完成的操作数
+     */
+    double run(int num_threads, const std::function<void(Transaction *, int)> &op) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                Transaction txn(tid);  // 每个线程使用自己的事务记录加锁的结点
+                for (size_t i = tid; i < keys_.size(); i += num_threads) {
+                    op(&txn, keys_[i]);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return keys_.size() / elapsed.count();
+    }
+
+    /**
+     * @brief 沿叶子链扫描整棵树，返回键值对个数
+     */
+    int count_entries(IxIndexHandle *ih) {
+        int num_entries = 0;
+        for (IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+             scan.next()) {
+            num_entries++;
+        }
+        return num_entries;
+    }
+};
+
+/**
+ * @brief 每轮新建索引：并发插入所有键值，再并发查找所有键值，最后混合读写
+ * （每个键值查找一次，每4个键值中删除一个并插入一个新键值）
+ */
+TEST_F(BPlusTreeConcurrentBench, Scaling) {
+    const std::vector<int> thread_counts = {1, 2, 4, 8, 16, 32};
+    printf("%-8s %14s %14s %14s   (Kops/s)\n", "threads", "insert", "lookup", "mixed");
+    for (int num_threads : thread_counts) {
+        // 每轮使用新的缓冲池，重新创建的索引文件可能复用上一轮的fd
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        ix_manager_->create_index(BENCH_FILE_NAME, index_cols_);
+        auto ih = ix_manager_->open_index(BENCH_FILE_NAME, index_cols_);
+
+        double insert_ops = run(num_threads, [&](Transaction *txn, int key) {
+            ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, txn);
+        });
+        double lookup_ops = run(num_threads, [&](Transaction *txn, int key) {
+            std::vector<Rid> result;
+            ih->get_value(reinterpret_cast<const char *>(&key), &result, txn);
+            EXPECT_EQ(result.size(), 1);
+        });
+        double mixed_ops = run(num_threads, [&](Transaction *txn, int key) {
+            std::vector<Rid> result;
+            ih->get_value(reinterpret_cast<const char *>(&key), &result, txn);
+            if (key % 4 == 0) {
+                ih->delete_entry(reinterpret_cast<const char *>(&key), txn);
+                int new_key = key + BENCH_NUM_KEYS;
+                ih->insert_entry(reinterpret_cast<const char *>(&new_key), Rid{new_key, 0}, txn);
+            }
+        });
+        EXPECT_EQ(count_entries(ih.get()), BENCH_NUM_KEYS);
+        printf("%-8d %14.1f %14.1f %14.1f\n", num_threads, insert_ops / 1e3, lookup_ops / 1e3, mixed_ops / 1e3);
+        fflush(stdout);
+
+        ix_manager_->close_index(ih.get());
+        ix_manager_->destroy_index(BENCH_FILE_NAME, index_cols_);
+    }
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+constexpr int BENCH_NUM_KEYS = 1 << 18;         // 索引中的键值个数
+constexpr int BENCH_NUM_PROBES = 1 << 20;       // 每项测量的查找次数
+constexpr size_t BENCH_POOL_SIZE = 8192;        // 缓冲池能放下整棵树
+const std::string BENCH_DB_NAME = "BPlusTreeKeySearchBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+/**
+ * @brief 每种索引键（INT、FLOAT、CHAR(16)、INT+CHAR(8)）的查找吞吐量：结点内查找分别使用逐字段比较的二分查找
+ * 和按键的形式特化的无分支二分查找，以及通过get_value()在整棵树中查找
+ */
+class BPlusTreeKeySearchBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 特化之前的结点内查找：二分查找，每次比较都调用逐字段判断类型的ix_compare()
+     */
+    static int generic_lower_bound(const IxNodeHandle &node, const char *target) {
+        int l = 0, r = node.page_hdr->num_key;
+        while (l < r) {
+            int mid = (l + r) >> 1;
+            if (ix_compare(target, node.get_key(mid), node.file_hdr->col_types_, node.file_hdr->col_lens_) > 0) {
+                l = mid + 1;
+            } else {
+                r = mid;
+            }
+        }
+        return l;
+    }
+
+    /**
+     * @brief 执行BENCH_NUM_PROBES次op，返回每秒完成的次数
+     */
+    static double measure(const std::function<void(int)> &op) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_NUM_PROBES; i++) {
+            op(i);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BENCH_NUM_PROBES / elapsed.count();
+    }
+
+    /**
+     * @brief 用make_key(i)生成的第i个key（按i递增）批量导入新索引，测量查找吞吐量并打印一行结果
+     */
+    void run(const char *name, const std::vector<ColMeta> &index_cols, const std::function<void(int, char *)> &make_key) {
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        // generic_lower_bound()直接比较结点中存储的key，使用不压缩的格式
+        ix_manager_->create_index(BENCH_FILE_NAME, index_cols, IX_LATCH_CRABBING, IX_FORMAT_FIXED);
+        auto ih = ix_manager_->open_index(BENCH_FILE_NAME, index_cols);
+        int key_len = ih->file_hdr_->col_tot_len_;
+        std::vector<char> keys((size_t)BENCH_NUM_KEYS * key_len);
+        std::vector<Rid> rids;
+        for (int i = 0; i < BENCH_NUM_KEYS; i++) {
+            make_key(i, keys.data() + (size_t)i * key_len);
+            rids.push_back(Rid{i, 0});
+        }
+        EXPECT_TRUE(ih->bulk_load(keys.data(), rids.data(), BENCH_NUM_KEYS));
+
+        // 结点内查找：在第一个叶子结点中查找它的key
+        IxNodeHandle *leaf = ih->fetch_node(IX_INIT_ROOT_PAGE);
+        std::mt19937 rng(2023);
+        std::vector<int> leaf_probes(BENCH_NUM_PROBES);
+        for (int &probe : leaf_probes) {
+            probe = rng() % leaf->get_size();
+        }
+        long checksum = 0;
+        double generic_ops = measure([&](int i) {
+            checksum += generic_lower_bound(*leaf, keys.data() + (size_t)leaf_probes[i] * key_len);
+        });
+        double specialized_ops = measure([&](int i) {
+            checksum -= leaf->lower_bound(keys.data() + (size_t)leaf_probes[i] * key_len);
+        });
+        EXPECT_EQ(checksum, 0);
+        buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+        delete leaf;
+
+        // 整棵树的点查询
+        std::vector<int> tree_probes(BENCH_NUM_PROBES);
+        for (int &probe : tree_probes) {
+            probe = rng() % BENCH_NUM_KEYS;
+        }
+        double tree_ops = measure([&](int i) {
+            std::vector<Rid> result;
+            ih->get_value(keys.data() + (size_t)tree_probes[i] * key_len, &result, nullptr);
+            EXPECT_EQ(result.size(), 1);
+        });
+
+        printf("%-12s %12.2f %12.2f %12.2f\n", name, generic_ops / 1e6, specialized_ops / 1e6, tree_ops / 1e6);
+        fflush(stdout);
+        ix_manager_->close_index(ih.get());
+        ix_manager_->destroy_index(BENCH_FILE_NAME, index_cols);
+    }
+};
+
+TEST_F(BPlusTreeKeySearchBench, Lookup) {
+    printf("%-12s %12s %12s %12s   (Mlookups/s)\n", "key", "node generic", "node special", "tree");
+    run("int", {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0}}, [](int i, char *key) {
+        int value = 2 * i;
+        memcpy(key, &value, sizeof(value));
+    });
+    run("float", {{BENCH_FILE_NAME, "col1", TYPE_FLOAT, 4, 0}}, [](int i, char *key) {
+        float value = i * 0.5f;
+        memcpy(key, &value, sizeof(value));
+    });
+    run("char(16)", {{BENCH_FILE_NAME, "col1", TYPE_STRING, 16, 0}}, [](int i, char *key) {
+        char buf[17];
+        snprintf(buf, sizeof(buf), "key%013d", i);
+        memcpy(key, buf, 16);
+    });
+    run("int+char(8)", {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0}, {BENCH_FILE_NAME, "col2", TYPE_STRING, 8, 4}},
+        [](int i, char *key) {
+            int value = i / 256;
+            char buf[9];
+            snprintf(buf, sizeof(buf), "s%07d", i % 256);
+            memcpy(key, &value, sizeof(value));
+            memcpy(key + sizeof(value), buf, 8);
+        });
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/ix.h"
+
+const std::string TEST_DB_NAME = "BPlusTreeKeySearchTest_db";
+const std::string TEST_FILE_NAME = "table1";
+
+class BPlusTreeKeySearchTests : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    static IxFileHdr make_file_hdr(const std::vector<ColType> &col_types, const std::vector<int> &col_lens) {
+        IxFileHdr file_hdr;
+        file_hdr.col_num_ = col_types.size();
+        file_hdr.col_types_ = col_types;
+        file_hdr.col_lens_ = col_lens;
+        file_hdr.col_tot_len_ = 0;
+        for (int len : col_lens) {
+            file_hdr.col_tot_len_ += len;
+        }
+        file_hdr.update_key_kind();
+        return file_hdr;
+    }
+
+    /**
+     * @brief 随机生成一个字段的值，取值范围很小，使有序的key中出现重复
+     */
+    static void random_field(char *dest, ColType type, int len, std::mt19937 &rng) {
+        switch (type) {
+            case TYPE_INT: {
+                int value = static_cast<int>(rng() % 64) - 32;
+                memcpy(dest, &value, sizeof(value));
+                break;
+            }
+            case TYPE_FLOAT: {
+                float value = (static_cast<int>(rng() % 64) - 32) * 0.5f;
+                memcpy(dest, &value, sizeof(value));
+                break;
+            }
+            case TYPE_STRING:
+                for (int i = 0; i < len; i++) {
+                    // 包含大于127的字节，检查按无符号字节比较
+                    dest[i] = static_cast<char>("a\x80z"[rng() % 3]);
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief 对n个有序key和若干随机target，比较特化的ix_node_search()与用ix_compare()顺序查找的结果
+     */
+    template <IxKeyKind kind>
+    void check_search(const IxFileHdr &file_hdr, std::mt19937 &rng) {
+        ASSERT_EQ(file_hdr.key_kind_, kind);
+        int key_len = file_hdr.col_tot_len_;
+        for (int n = 0; n <= 40; n++) {
+            std::vector<std::vector<char>> sorted(n, std::vector<char>(key_len));
+            for (auto &key : sorted) {
+                for (int i = 0, offset = 0; i < file_hdr.col_num_; offset += file_hdr.col_lens_[i], i++) {
+                    random_field(key.data() + offset, file_hdr.col_types_[i], file_hdr.col_lens_[i], rng);
+                }
+            }
+            std::sort(sorted.begin(), sorted.end(), [&](const std::vector<char> &a, const std::vector<char> &b) {
+                return ix_compare(a.data(), b.data(), file_hdr.col_types_, file_hdr.col_lens_) < 0;
+            });
+            std::vector<char> keys;
+            for (auto &key : sorted) {
+                keys.insert(keys.end(), key.begin(), key.end());
+            }
+            for (int round = 0; round < 20; round++) {
+                std::vector<char> target(key_len);
+                if (n > 0 && round % 2 == 0) {
+                    target = sorted[rng() % n];
+                } else {
+                    for (int i = 0, offset = 0; i < file_hdr.col_num_; offset += file_hdr.col_lens_[i], i++) {
+                        random_field(target.data() + offset, file_hdr.col_types_[i], file_hdr.col_lens_[i], rng);
+                    }
+                }
+                int lower = 0;
+                while (lower < n && ix_compare(sorted[lower].data(), target.data(), file_hdr.col_types_,
+                                               file_hdr.col_lens_) < 0) {
+                    lower++;
+                }
+                int upper = lower;
+                while (upper < n && ix_compare(sorted[upper].data(), target.data(), file_hdr.col_types_,
+                                               file_hdr.col_lens_) == 0) {
+                    upper++;
+                }
+                EXPECT_EQ((ix_node_search<kind, false>(keys.data(), n, target.data(), &file_hdr)), lower);
+                EXPECT_EQ((ix_node_search<kind, true>(keys.data(), n, target.data(), &file_hdr)), upper);
+            }
+        }
+    }
+};
+
+/**
+ * @brief 每种键的特化查找与逐字段比较的结果一致，包括空结点、重复的key和所有key都小于或大于target的情况
+ */
+TEST_F(BPlusTreeKeySearchTests, NodeSearchMatchesCompare) {
+    std::mt19937 rng(2023);
+    check_search<IX_KEY_INT>(make_file_hdr({TYPE_INT}, {4}), rng);
+    check_search<IX_KEY_FLOAT>(make_file_hdr({TYPE_FLOAT}, {4}), rng);
+    check_search<IX_KEY_STRING>(make_file_hdr({TYPE_STRING}, {3}), rng);
+    check_search<IX_KEY_COMPOSITE>(make_file_hdr({TYPE_INT, TYPE_STRING, TYPE_FLOAT}, {4, 2, 4}), rng);
+}
+
+/**
+ * @brief 叶子结点的upper_bound从第0个key开始查找：小于所有key的target得到第一个位置，空树得到leaf_end()
+ */
+TEST_F(BPlusTreeKeySearchTests, UpperBoundBeforeFirstKey) {
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+    auto ix_manager = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager.get());
+    std::vector<ColMeta> index_cols = {{TEST_FILE_NAME, "col1", TYPE_INT, 4, 0}};
+    ix_manager->create_index(TEST_FILE_NAME, index_cols);
+    auto ih = ix_manager->open_index(TEST_FILE_NAME, index_cols);
+
+    int below = 0;
+    EXPECT_EQ(ih->upper_bound(reinterpret_cast<const char *>(&below)), ih->leaf_end());
+    for (int key = 10; key < 20; key++) {
+        ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, nullptr);
+    }
+    EXPECT_EQ(ih->upper_bound(reinterpret_cast<const char *>(&below)), ih->leaf_begin());
+    int first = 10, second = 11;
+    EXPECT_EQ(ih->upper_bound(reinterpret_cast<const char *>(&first)),
+              ih->lower_bound(reinterpret_cast<const char *>(&second)));
+    ix_manager->close_index(ih.get());
+}
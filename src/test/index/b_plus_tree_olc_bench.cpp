@@ -0,0 +1,138 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/ix.h"
+
+constexpr int BENCH_NUM_KEYS = 1 << 18;         // 索引中的键值个数，树高为3
+constexpr int BENCH_OPS_PER_THREAD = 1 << 17;   // 每个线程执行的操作数
+constexpr size_t BENCH_POOL_SIZE = 4096;        // 缓冲池能放下整棵树，只测量结点上的同步开销
+const std::string BENCH_DB_NAME = "BPlusTreeOlcBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+/**
+ * @brief 读多写少的索引：比较latch crabbing和乐观锁耦合两种并发控制方式下，点查询吞吐量随线程数的变化
+ */
+class BPlusTreeOlcBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::vector<ColMeta> index_cols_ = {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0}};
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 新建指定并发控制方式的索引，批量导入偶数键值0, 2, ..., 2 * (BENCH_NUM_KEYS - 1)
+     */
+    std::unique_ptr<IxIndexHandle> build(IxLatchMode latch_mode) {
+        // 每次使用新的缓冲池，重新创建的索引文件可能复用上一次的fd
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        ix_manager_->create_index(BENCH_FILE_NAME, index_cols_, latch_mode);
+        auto ih = ix_manager_->open_index(BENCH_FILE_NAME, index_cols_);
+        std::vector<int> keys;
+        std::vector<Rid> rids;
+        for (int i = 0; i < BENCH_NUM_KEYS; i++) {
+            keys.push_back(2 * i);
+            rids.push_back(Rid{2 * i, 0});
+        }
+        EXPECT_TRUE(ih->bulk_load(reinterpret_cast<const char *>(keys.data()), rids.data(), BENCH_NUM_KEYS));
+        return ih;
+    }
+
+    void destroy(IxIndexHandle *ih) {
+        ix_manager_->close_index(ih);
+        ix_manager_->destroy_index(BENCH_FILE_NAME, index_cols_);
+    }
+
+    /**
+     * @brief num_threads个线程各执行BENCH_OPS_PER_THREAD次op，op的参数为随机数，返回每秒完成的操作数
+     */
+    double run(int num_threads, const std::function<void(Transaction *, uint32_t)> &op) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                Transaction txn(tid);
+                std::mt19937 rng(tid);
+                for (int i = 0; i < BENCH_OPS_PER_THREAD; i++) {
+                    op(&txn, rng());
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return (double)num_threads * BENCH_OPS_PER_THREAD / elapsed.count();
+    }
+};
+
+/**
+ * @brief 每种并发控制方式下：只读的点查询，以及每32次操作中有1次插入新键值（奇数）的读多写少负载
+ */
+TEST_F(BPlusTreeOlcBench, PointLookup) {
+    const std::vector<int> thread_counts = {1, 2, 4, 8, 16, 32};
+    const std::vector<std::pair<const char *, IxLatchMode>> modes = {{"crabbing", IX_LATCH_CRABBING},
+                                                                     {"optimistic", IX_LATCH_OPTIMISTIC}};
+    printf("%-12s %-8s %14s %14s   (Kops/s)\n", "latch", "threads", "lookup", "read-mostly");
+    for (auto &[name, latch_mode] : modes) {
+        for (int num_threads : thread_counts) {
+            auto ih = build(latch_mode);
+            double lookup_ops = run(num_threads, [&](Transaction *txn, uint32_t r) {
+                int key = 2 * (r % BENCH_NUM_KEYS);
+                std::vector<Rid> result;
+                ih->get_value(reinterpret_cast<const char *>(&key), &result, txn);
+                EXPECT_EQ(result.size(), 1);
+            });
+            double mixed_ops = run(num_threads, [&](Transaction *txn, uint32_t r) {
+                int key = 2 * (r % BENCH_NUM_KEYS);
+                if (r % 32 == 0) {
+                    key += 1;
+                    ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, txn);
+                } else {
+                    std::vector<Rid> result;
+                    ih->get_value(reinterpret_cast<const char *>(&key), &result, txn);
+                    EXPECT_EQ(result.size(), 1);
+                }
+            });
+            printf("%-12s %-8d %14.1f %14.1f\n", name, num_threads, lookup_ops / 1e3, mixed_ops / 1e3);
+            fflush(stdout);
+            destroy(ih.get());
+        }
+    }
+}
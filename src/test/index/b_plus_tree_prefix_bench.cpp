@@ -0,0 +1,151 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+constexpr int BENCH_NUM_KEYS = 1 << 17;         // 索引中的键值个数
+constexpr int BENCH_NUM_PROBES = 1 << 19;       // 点查询的次数
+constexpr size_t BENCH_POOL_SIZE = 16384;       // 缓冲池能放下整棵树
+const std::string BENCH_DB_NAME = "BPlusTreePrefixBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+/**
+ * @brief 以字符串开头的索引键：比较定长格式（IX_FORMAT_FIXED）和前缀压缩格式（IX_FORMAT_PREFIX）下
+ * 随机插入建成的树的扇出、树高、页面数，以及点查询吞吐量
+ */
+class BPlusTreePrefixBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 执行BENCH_NUM_PROBES次op，返回每秒完成的次数
+     */
+    static double measure(const std::function<void(int)> &op) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_NUM_PROBES; i++) {
+            op(i);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BENCH_NUM_PROBES / elapsed.count();
+    }
+
+    /**
+     * @brief 按随机顺序插入make_key(i)生成的key，统计树的形状并测量点查询，每种格式打印一行结果
+     */
+    void run(const char *name, const std::vector<ColMeta> &index_cols, const std::function<void(int, char *)> &make_key) {
+        for (IxFormatVersion format : {IX_FORMAT_FIXED, IX_FORMAT_PREFIX}) {
+            // 每次使用新的缓冲池，重新创建的索引文件可能复用上一次的fd
+            buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+            ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+            ix_manager_->create_index(BENCH_FILE_NAME, index_cols, IX_LATCH_CRABBING, format);
+            auto ih = ix_manager_->open_index(BENCH_FILE_NAME, index_cols);
+            int key_len = ih->file_hdr_->col_tot_len_;
+            std::vector<char> keys((size_t)BENCH_NUM_KEYS * key_len);
+            std::vector<int> order(BENCH_NUM_KEYS);
+            for (int i = 0; i < BENCH_NUM_KEYS; i++) {
+                make_key(i, keys.data() + (size_t)i * key_len);
+                order[i] = i;
+            }
+            std::mt19937 rng(2023);
+            std::shuffle(order.begin(), order.end(), rng);
+            for (int i : order) {
+                ih->insert_entry(keys.data() + (size_t)i * key_len, Rid{i, 0}, nullptr);
+            }
+
+            // 沿最左边的路径得到树高，沿叶子链得到叶子结点数
+            int height = 1;
+            IxNodeHandle *node = ih->fetch_node(ih->file_hdr_->root_page_);
+            int root_size = node->get_size();
+            while (!node->is_leaf_page()) {
+                IxNodeHandle *child = ih->fetch_node(node->value_at(0));
+                buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+                delete node;
+                node = child;
+                height++;
+            }
+            buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+            delete node;
+            int num_leaves = 0;
+            for (page_id_t page_no = ih->file_hdr_->first_leaf_; page_no != IX_LEAF_HEADER_PAGE; num_leaves++) {
+                IxNodeHandle *leaf = ih->fetch_node(page_no);
+                page_no = leaf->get_next_leaf();
+                buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+                delete leaf;
+            }
+
+            std::vector<int> probes(BENCH_NUM_PROBES);
+            for (int &probe : probes) {
+                probe = rng() % BENCH_NUM_KEYS;
+            }
+            double lookup_ops = measure([&](int i) {
+                std::vector<Rid> result;
+                ih->get_value(keys.data() + (size_t)probes[i] * key_len, &result, nullptr);
+                EXPECT_EQ(result.size(), 1);
+            });
+
+            printf("%-18s %-8s %8d %8.1f %8d %8d %10d %12.2f\n", name, format == IX_FORMAT_FIXED ? "fixed" : "prefix",
+                   ih->file_hdr_->btree_order_, (double)BENCH_NUM_KEYS / num_leaves, height, root_size,
+                   ih->file_hdr_->num_pages_, lookup_ops / 1e6);
+            fflush(stdout);
+            ix_manager_->close_index(ih.get());
+            ix_manager_->destroy_index(BENCH_FILE_NAME, index_cols);
+        }
+    }
+};
+
+TEST_F(BPlusTreePrefixBench, ShapeAndLookup) {
+    printf("%-18s %-8s %8s %8s %8s %8s %10s %12s   (Mlookups/s)\n", "key", "format", "order", "leaf fan", "height",
+           "root", "pages", "lookup");
+    run("char(64)+int",
+        {{BENCH_FILE_NAME, "col1", TYPE_STRING, 64, 0}, {BENCH_FILE_NAME, "col2", TYPE_INT, 4, 64}},
+        [](int i, char *key) {
+            memset(key, 0, 68);
+            snprintf(key, 64, "customer/region-%02d/account-%08d", i % 16, i / 16);
+            int value = i % 4;
+            memcpy(key + 64, &value, sizeof(value));
+        });
+    run("char(200) url", {{BENCH_FILE_NAME, "col1", TYPE_STRING, 200, 0}}, [](int i, char *key) {
+        memset(key, 0, 200);
+        snprintf(key, 200, "https://www.example.com/catalog/%s/item/%09d", i % 2 ? "books" : "music", i);
+    });
+}
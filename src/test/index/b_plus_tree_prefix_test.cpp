@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "index/ix.h"
+#undef private
+
+const std::string TEST_DB_NAME = "BPlusTreePrefixTest_db";
+const std::string TEST_FILE_NAME = "table1";
+
+class BPlusTreePrefixTests : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        reset_buffer_pool();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    /**
+     * @brief 每次新建索引前使用新的缓冲池，重新创建的索引文件可能复用上一次的fd
+     */
+    void reset_buffer_pool() {
+        ix_manager_.reset();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    }
+
+    /**
+     * @brief (CHAR(str_len), INT)的索引字段
+     */
+    static std::vector<ColMeta> make_cols(int str_len) {
+        return {{TEST_FILE_NAME, "col1", TYPE_STRING, str_len, 0}, {TEST_FILE_NAME, "col2", TYPE_INT, 4, str_len}};
+    }
+
+    /**
+     * @brief 第id个key：字符串部分有很长的公共前缀，部分key带有随机的长后缀；INT部分有一部分取INT_MIN
+     */
+    static std::vector<char> make_key(int id, int str_len) {
+        std::vector<char> key(str_len + sizeof(int), 0);
+        std::string str = "warehouse/" + std::string(1, 'a' + id % 3) + "/item-" + std::to_string(1000000 + id / 3);
+        memcpy(key.data(), str.data(), std::min<int>(str.size(), str_len));
+        if (id % 4 == 1) {
+            std::mt19937 rng(id);
+            for (int i = str.size(); i < str_len && rng() % 8 != 0; i++) {
+                key[i] = static_cast<char>('a' + rng() % 26);
+            }
+        }
+        int value = id % 3 == 0 ? INT_MIN : id % 3;
+        memcpy(key.data() + str_len, &value, sizeof(value));
+        return key;
+    }
+
+    /**
+     * @brief 检查以page_no为根的子树并返回其中的键值对数量：结点大小、key有序且位于[lower, upper)中；
+     * 内部结点的第一个key等于它在父结点中的分隔键
+     */
+    int check_subtree(IxIndexHandle *ih, page_id_t page_no, bool is_root, const char *lower, const char *upper,
+                      int depth, int *leaf_depth) {
+        const IxFileHdr *file_hdr = ih->file_hdr_;
+        int len = file_hdr->col_tot_len_;
+        IxNodeHandle *node = ih->fetch_node(page_no);
+        int size = node->get_size();
+        if (!is_root) {
+            EXPECT_GE(size, node->get_min_size());
+        }
+        EXPECT_LT(size, node->get_max_size());
+        std::vector<char> keys((size + 1) * len);
+        std::vector<Rid> rids(size + 1);
+        node->copy_pairs(0, size, keys.data(), rids.data());
+        auto compare = [&](const char *a, const char *b) {
+            return ix_compare(a, b, file_hdr->col_types_, file_hdr->col_lens_);
+        };
+        for (int i = 1; i < size; i++) {
+            EXPECT_LT(compare(keys.data() + (i - 1) * len, keys.data() + i * len), 0);
+        }
+        int count = 0;
+        if (node->is_leaf_page()) {
+            if (*leaf_depth < 0) {
+                *leaf_depth = depth;
+            }
+            EXPECT_EQ(depth, *leaf_depth);
+            for (int i = 0; i < size; i++) {
+                EXPECT_TRUE(lower == nullptr || compare(keys.data() + i * len, lower) >= 0);
+                EXPECT_TRUE(upper == nullptr || compare(keys.data() + i * len, upper) < 0);
+            }
+            count = size;
+        } else {
+            EXPECT_TRUE(lower == nullptr || compare(keys.data(), lower) == 0);
+            for (int i = 0; i < size; i++) {
+                const char *child_lower = i > 0 ? keys.data() + i * len : lower;
+                const char *child_upper = i + 1 < size ? keys.data() + (i + 1) * len : upper;
+                count += check_subtree(ih, rids[i].page_no, false, child_lower, child_upper, depth + 1, leaf_depth);
+            }
+        }
+        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        delete node;
+        return count;
+    }
+
+    /**
+     * @brief 检查整棵树的结构，并且按叶子链扫描得到的rid依次是ids（已按key排序）
+     * @return 树高
+     */
+    int check_tree(IxIndexHandle *ih, const std::vector<int> &ids) {
+        int leaf_depth = -1;
+        EXPECT_EQ(check_subtree(ih, ih->file_hdr_->root_page_, true, nullptr, nullptr, 0, &leaf_depth), (int)ids.size());
+        std::vector<int> scanned;
+        for (IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get()); !scan.is_end(); scan.next()) {
+            scanned.push_back(scan.rid().page_no);
+        }
+        EXPECT_EQ(scanned, ids);
+        return leaf_depth + 1;
+    }
+
+    /**
+     * @brief 把ids按key排序
+     */
+    static std::vector<int> sorted_ids(const std::set<int> &ids, const std::vector<ColMeta> &cols) {
+        std::vector<ColType> types;
+        std::vector<int> lens;
+        for (auto &col : cols) {
+            types.push_back(col.type);
+            lens.push_back(col.len);
+        }
+        std::vector<int> sorted(ids.begin(), ids.end());
+        std::sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+            return ix_compare(make_key(a, cols[0].len).data(), make_key(b, cols[0].len).data(), types, lens) < 0;
+        });
+        return sorted;
+    }
+};
+
+/**
+ * @brief 以字符串开头的索引默认使用IX_FORMAT_PREFIX，格式写入文件头，重新打开后不变；
+ * 旧版本的文件头中没有这个字段，按IX_FORMAT_FIXED读取
+ */
+TEST_F(BPlusTreePrefixTests, FormatVersionInFileHeader) {
+    auto cols = make_cols(32);
+    ix_manager_->create_index(TEST_FILE_NAME, cols);
+    auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+    EXPECT_EQ(ih->file_hdr_->format_version_, IX_FORMAT_PREFIX);
+    EXPECT_EQ(ih->file_hdr_->prefix_max_len_, 32);
+    ix_manager_->close_index(ih.get());
+    ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+    EXPECT_EQ(ih->file_hdr_->format_version_, IX_FORMAT_PREFIX);
+
+    char buf[PAGE_SIZE];
+    ih->file_hdr_->serialize(buf);
+    int old_len = ih->file_hdr_->tot_len_ - sizeof(IxFormatVersion);
+    memcpy(buf, &old_len, sizeof(old_len));
+    IxFileHdr old_hdr;
+    old_hdr.deserialize(buf);
+    EXPECT_EQ(old_hdr.format_version_, IX_FORMAT_FIXED);
+    ix_manager_->close_index(ih.get());
+
+    std::vector<ColMeta> int_cols = {{TEST_FILE_NAME, "col2", TYPE_INT, 4, 0}};
+    reset_buffer_pool();
+    ix_manager_->create_index(TEST_FILE_NAME, int_cols);
+    auto int_ih = ix_manager_->open_index(TEST_FILE_NAME, int_cols);
+    EXPECT_EQ(int_ih->file_hdr_->format_version_, IX_FORMAT_FIXED);
+    ix_manager_->close_index(int_ih.get());
+}
+
+/**
+ * @brief 截短的分隔键在两个key之间：保留到第一个不同的字段，字符串字段只保留到第一个不同的字节
+ */
+TEST_F(BPlusTreePrefixTests, SeparatorBetweenKeys) {
+    IxFileHdr file_hdr;
+    file_hdr.col_num_ = 2;
+    file_hdr.col_types_ = {TYPE_STRING, TYPE_INT};
+    file_hdr.col_lens_ = {8, 4};
+    file_hdr.col_tot_len_ = 12;
+    file_hdr.update_key_kind();
+    auto key = [](const char *str, int value) {
+        std::vector<char> key(12, 0);
+        memcpy(key.data(), str, strlen(str));
+        memcpy(key.data() + 8, &value, sizeof(value));
+        return key;
+    };
+    std::vector<char> sep(12);
+    auto left = key("apple", 7), right = key("apricot", 3);
+    ix_separator(left.data(), right.data(), sep.data(), &file_hdr);
+    EXPECT_EQ(sep, key("apr", INT_MIN));
+    EXPECT_EQ(ix_key_trim_len(sep.data(), &file_hdr), 3);
+
+    left = key("apple", 7), right = key("apple", 9);
+    ix_separator(left.data(), right.data(), sep.data(), &file_hdr);
+    EXPECT_EQ(sep, right);
+}
+
+/**
+ * @brief 单线程随机插入、删除和查找，与std::set的结果一致，每一轮之后检查树的结构
+ */
+TEST_F(BPlusTreePrefixTests, RandomInsertDelete) {
+    for (int str_len : {64, 400}) {
+        auto cols = make_cols(str_len);
+        reset_buffer_pool();
+        ix_manager_->create_index(TEST_FILE_NAME, cols);
+        auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+        std::mt19937 rng(str_len);
+        std::set<int> ids;
+        for (int round = 0; round < 4; round++) {
+            for (int i = 0; i < 3000; i++) {
+                int id = rng() % 4000;
+                auto key = make_key(id, str_len);
+                if (rng() % 3 != 0) {
+                    ih->insert_entry(key.data(), Rid{id, 0}, nullptr);
+                    ids.insert(id);
+                } else {
+                    EXPECT_EQ(ih->delete_entry(key.data(), nullptr), ids.erase(id) == 1);
+                }
+            }
+            for (int id = 0; id < 4000; id += 7) {
+                std::vector<Rid> result;
+                EXPECT_EQ(ih->get_value(make_key(id, str_len).data(), &result, nullptr), ids.count(id) == 1);
+            }
+            check_tree(ih.get(), sorted_ids(ids, cols));
+        }
+        ix_manager_->close_index(ih.get());
+        ix_manager_->destroy_index(TEST_FILE_NAME, cols);
+    }
+}
+
+/**
+ * @brief 同样的key在IX_FORMAT_PREFIX下占用更少的叶子结点，树更矮
+ */
+TEST_F(BPlusTreePrefixTests, PrefixTreeIsSmaller) {
+    auto cols = make_cols(200);
+    std::set<int> ids;
+    for (int id = 0; id < 6000; id++) {
+        ids.insert(id);
+    }
+    std::vector<int> sorted = sorted_ids(ids, cols);
+    int heights[2], leaves[2];
+    for (IxFormatVersion format : {IX_FORMAT_FIXED, IX_FORMAT_PREFIX}) {
+        reset_buffer_pool();
+        ix_manager_->create_index(TEST_FILE_NAME, cols, IX_LATCH_CRABBING, format);
+        auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+        std::mt19937 rng(format);
+        std::vector<int> order = sorted;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int id : order) {
+            ih->insert_entry(make_key(id, 200).data(), Rid{id, 0}, nullptr);
+        }
+        heights[format] = check_tree(ih.get(), sorted);
+        leaves[format] = 0;
+        for (page_id_t page_no = ih->file_hdr_->first_leaf_; page_no != IX_LEAF_HEADER_PAGE; leaves[format]++) {
+            IxNodeHandle *leaf = ih->fetch_node(page_no);
+            page_no = leaf->get_next_leaf();
+            buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+            delete leaf;
+        }
+        ix_manager_->close_index(ih.get());
+        ix_manager_->destroy_index(TEST_FILE_NAME, cols);
+    }
+    EXPECT_LT(heights[IX_FORMAT_PREFIX], heights[IX_FORMAT_FIXED]);
+    EXPECT_LT(leaves[IX_FORMAT_PREFIX], leaves[IX_FORMAT_FIXED]);
+}
+
+/**
+ * @brief 批量导入尽量填满每个结点，之后的插入和删除在截短的分隔键下仍然正确
+ */
+TEST_F(BPlusTreePrefixTests, BulkLoadThenModify) {
+    auto cols = make_cols(64);
+    ix_manager_->create_index(TEST_FILE_NAME, cols);
+    auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+    std::set<int> ids;
+    for (int id = 0; id < 20000; id += 2) {
+        ids.insert(id);
+    }
+    std::vector<int> sorted = sorted_ids(ids, cols);
+    std::vector<char> keys;
+    std::vector<Rid> rids;
+    for (int id : sorted) {
+        auto key = make_key(id, 64);
+        keys.insert(keys.end(), key.begin(), key.end());
+        rids.push_back(Rid{id, 0});
+    }
+    EXPECT_TRUE(ih->bulk_load(keys.data(), rids.data(), sorted.size()));
+    check_tree(ih.get(), sorted);
+
+    for (int id = 1; id < 20000; id += 4) {
+        ih->insert_entry(make_key(id, 64).data(), Rid{id, 0}, nullptr);
+        ids.insert(id);
+    }
+    for (int id = 0; id < 20000; id += 6) {
+        EXPECT_TRUE(ih->delete_entry(make_key(id, 64).data(), nullptr));
+        ids.erase(id);
+    }
+    check_tree(ih.get(), sorted_ids(ids, cols));
+    ix_manager_->close_index(ih.get());
+}
+
+/**
+ * @brief 两种并发控制方式下多个线程并发插入、删除和查找各自的key，结束后检查树的结构
+ */
+TEST_F(BPlusTreePrefixTests, ConcurrentInsertDelete) {
+    const int num_threads = 4;
+    auto cols = make_cols(64);
+    for (IxLatchMode latch_mode : {IX_LATCH_CRABBING, IX_LATCH_OPTIMISTIC}) {
+        reset_buffer_pool();
+        ix_manager_->create_index(TEST_FILE_NAME, cols, latch_mode);
+        auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+        std::vector<std::set<int>> ids(num_threads);
+        std::vector<std::thread> threads;
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                Transaction txn(tid);
+                std::mt19937 rng(tid);
+                for (int i = 0; i < 5000; i++) {
+                    int id = (rng() % 2000) * num_threads + tid;
+                    auto key = make_key(id, 64);
+                    int op = rng() % 3;
+                    if (op == 0) {
+                        ih->insert_entry(key.data(), Rid{id, 0}, &txn);
+                        ids[tid].insert(id);
+                    } else if (op == 1) {
+                        EXPECT_EQ(ih->delete_entry(key.data(), &txn), ids[tid].erase(id) == 1);
+                    } else {
+                        std::vector<Rid> result;
+                        EXPECT_EQ(ih->get_value(key.data(), &result, &txn), ids[tid].count(id) == 1);
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::set<int> all;
+        for (auto &thread_ids : ids) {
+            all.insert(thread_ids.begin(), thread_ids.end());
+        }
+        check_tree(ih.get(), sorted_ids(all, cols));
+        ix_manager_->close_index(ih.get());
+        ix_manager_->destroy_index(TEST_FILE_NAME, cols);
+    }
+}
+
+/**
+ * @brief IX_LATCH_OPTIMISTIC下根结点被替换后，旧的根结点页面在乐观查找都结束后被unpin，而不是一直pin到索引关闭
+ */
+TEST_F(BPlusTreePrefixTests, OptimisticOldRootsUnpinned) {
+    auto cols = make_cols(64);
+    reset_buffer_pool();
+    ix_manager_->create_index(TEST_FILE_NAME, cols, IX_LATCH_OPTIMISTIC);
+    auto ih = ix_manager_->open_index(TEST_FILE_NAME, cols);
+    std::set<page_id_t> roots = {ih->file_hdr_->root_page_};
+    std::atomic<bool> stop{false};
+    std::thread reader([&]() {
+        Transaction txn(1);
+        for (int i = 0; !stop; i++) {
+            std::vector<Rid> result;
+            ih->get_value(make_key(i % 20000, 64).data(), &result, &txn);
+        }
+    });
+    Transaction txn(0);
+    for (int id = 0; id < 20000; id++) {
+        ih->insert_entry(make_key(id, 64).data(), Rid{id, 0}, &txn);
+        roots.insert(ih->file_hdr_->root_page_);
+    }
+    stop = true;
+    reader.join();
+    // 没有并发的写操作时，查找结束就会unpin剩下的旧根结点页面
+    std::vector<Rid> result;
+    EXPECT_TRUE(ih->get_value(make_key(0, 64).data(), &result, &txn));
+    EXPECT_GT(roots.size(), 2u);
+    EXPECT_TRUE(ih->olc_retired_roots_.empty());
+    for (page_id_t page_no : roots) {
+        Page *page = buffer_pool_manager_->fetch_page(PageId{ih->fd_, page_no});
+        EXPECT_EQ(page->pin_count_, page_no == ih->file_hdr_->root_page_ ? 2 : 1);
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+    ix_manager_->close_index(ih.get());
+    ix_manager_->destroy_index(TEST_FILE_NAME, cols);
+}
@@ -0,0 +1,109 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/async_io.h"
+
+constexpr int BENCH_NUM_PAGES = 32768;      // 测试文件大小为128MB
+constexpr int BENCH_NUM_READS = 20000;      // 每种方式执行的随机读取次数
+constexpr int BENCH_BATCH_SIZE = 32;        // 异步后端每批提交的请求个数
+const std::string BENCH_DB_NAME = "AsyncIoBench_db";
+const std::string BENCH_FILE_NAME = "bench_file";
+
+/**
+ * @brief 随机4KB读取的IOPS基准测试：比较同步的DiskManager::read_page与两种异步后端
+ */
+class AsyncIoBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    int fd_ = -1;
+    std::vector<page_id_t> page_nos_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        disk_manager_->create_file(BENCH_FILE_NAME);
+        fd_ = disk_manager_->open_file(BENCH_FILE_NAME);
+        std::vector<char> buf(PAGE_SIZE, 'x');
+        for (int page_no = 0; page_no < BENCH_NUM_PAGES; page_no++) {
+            disk_manager_->write_page(fd_, page_no, buf.data(), PAGE_SIZE);
+        }
+        fsync(fd_);
+        std::mt19937 rng(0);
+        for (int i = 0; i < BENCH_NUM_READS; i++) {
+            page_nos_.push_back(rng() % BENCH_NUM_PAGES);
+        }
+    }
+
+    void TearDown() override {
+        disk_manager_->close_file(fd_);
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 将测试文件从操作系统页缓存中清除，使读取真正落到磁盘上
+     */
+    void drop_cache() { posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED); }
+
+    double sync_iops() {
+        drop_cache();
+        std::vector<char> buf(PAGE_SIZE);
+        auto start = std::chrono::steady_clock::now();
+        for (page_id_t page_no : page_nos_) {
+            disk_manager_->read_page(fd_, page_no, buf.data(), PAGE_SIZE);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BENCH_NUM_READS / elapsed.count();
+    }
+
+    double async_iops(AsyncIoBackend *backend) {
+        drop_cache();
+        std::vector<char> bufs(static_cast<size_t>(BENCH_BATCH_SIZE) * PAGE_SIZE);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_NUM_READS; i += BENCH_BATCH_SIZE) {
+            auto batch = std::make_shared<IoBatch>();
+            for (int j = 0; j < BENCH_BATCH_SIZE && i + j < BENCH_NUM_READS; j++) {
+                batch->add_read(fd_, page_nos_[i + j], bufs.data() + j * PAGE_SIZE, PAGE_SIZE);
+            }
+            backend->submit_and_wait(batch);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BENCH_NUM_READS / elapsed.count();
+    }
+};
+
+TEST_F(AsyncIoBench, RandomReadIops) {
+    printf("%-24s %12s\n", "path", "IOPS");
+    printf("%-24s %12.0f\n", "sync read_page", sync_iops());
+    ThreadPoolIoBackend thread_pool(disk_manager_.get());
+    printf("%-24s %12.0f\n", "thread_pool (batch 32)", async_iops(&thread_pool));
+    if (IoUringBackend::is_supported()) {
+        IoUringBackend io_uring(disk_manager_.get());
+        printf("%-24s %12.0f\n", "io_uring (batch 32)", async_iops(&io_uring));
+    }
+}
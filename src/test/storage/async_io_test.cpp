@@ -0,0 +1,143 @@
+#include "storage/async_io.h"
+
+#include <cstring>
+#include <random>
+
+#include "gtest/gtest.h"
+
+const std::string TEST_DB_NAME = "AsyncIoTest_db";
+const std::string TEST_FILE_NAME = "async_io_file";
+constexpr int TEST_NUM_PAGES = 512;
+
+class AsyncIoTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    int fd_ = -1;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        disk_manager_->create_file(TEST_FILE_NAME);
+        fd_ = disk_manager_->open_file(TEST_FILE_NAME);
+    }
+
+    void TearDown() override {
+        disk_manager_->close_file(fd_);
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    /**
+     * @brief 通过后端批量写入所有页面，再批量读回并与写入的数据比较
+     */
+    void check_round_trip(AsyncIoBackend *backend) {
+        std::vector<std::vector<char>> pages(TEST_NUM_PAGES, std::vector<char>(PAGE_SIZE));
+        std::mt19937 rng(0);
+        auto write_batch = std::make_shared<IoBatch>();
+        for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+            for (auto &ch : pages[page_no]) {
+                ch = static_cast<char>(rng());
+            }
+            write_batch->add_write(fd_, page_no, pages[page_no].data(), PAGE_SIZE);
+        }
+        backend->submit_and_wait(write_batch);
+
+        std::vector<std::vector<char>> result(TEST_NUM_PAGES, std::vector<char>(PAGE_SIZE));
+        bool callback_called = false;
+        auto read_batch = std::make_shared<IoBatch>();
+        for (int page_no = TEST_NUM_PAGES - 1; page_no >= 0; page_no--) {
+            read_batch->add_read(fd_, page_no, result[page_no].data(), PAGE_SIZE);
+        }
+        read_batch->set_callback([&](bool success) { callback_called = success; });
+        backend->submit_and_wait(read_batch);
+        EXPECT_TRUE(callback_called);
+        for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+            EXPECT_EQ(0, memcmp(pages[page_no].data(), result[page_no].data(), PAGE_SIZE));
+        }
+
+        // 读取文件末尾之后的页面会失败
+        char buf[PAGE_SIZE];
+        auto bad_batch = std::make_shared<IoBatch>();
+        bad_batch->add_read(fd_, TEST_NUM_PAGES + 10, buf, PAGE_SIZE);
+        EXPECT_THROW(backend->submit_and_wait(bad_batch), InternalError);
+
+        // 空批次立即完成
+        auto empty_batch = std::make_shared<IoBatch>();
+        backend->submit_and_wait(empty_batch);
+    }
+};
+
+TEST_F(AsyncIoTest, ThreadPoolBackend) {
+    ThreadPoolIoBackend backend(disk_manager_.get(), 4);
+    check_round_trip(&backend);
+}
+
+TEST_F(AsyncIoTest, IoUringBackend) {
+    if (!IoUringBackend::is_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    // 队列深度小于批次大小，覆盖提交时等待完成队列腾出空间的路径
+    IoUringBackend backend(disk_manager_.get(), 32);
+    check_round_trip(&backend);
+
+    // 内核返回的错误码由等待批次的调用者以UnixError抛出，失败的请求不会残留在在途集合中
+    char buf[PAGE_SIZE];
+    auto bad_fd_batch = std::make_shared<IoBatch>();
+    bad_fd_batch->add_read(-1, 0, buf, PAGE_SIZE);
+    bad_fd_batch->add_write(-1, 1, buf, PAGE_SIZE);
+    EXPECT_THROW(backend.submit_and_wait(bad_fd_batch), UnixError);
+}
+
+TEST_F(AsyncIoTest, IoUringDirectIo) {
+    if (!IoUringBackend::is_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    const std::string filename = "async_io_direct_file";
+    disk_manager_->set_direct_io(true);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    disk_manager_->set_direct_io(false);
+    printf("O_DIRECT %s on this file system\n", disk_manager_->is_direct(fd) ? "enabled" : "rejected, buffered I/O");
+
+    // 对齐的整页请求直接提交给io_uring，未对齐的缓冲区和不足一页的请求与DiskManager一样经过中转缓冲区
+    IoUringBackend backend(disk_manager_.get(), 32);
+    alignas(PAGE_SIZE) static char aligned[2][PAGE_SIZE];
+    std::vector<char> unaligned(PAGE_SIZE + 1);
+    std::mt19937 rng(0);
+    for (auto &ch : aligned[0]) {
+        ch = static_cast<char>(rng());
+    }
+    for (auto &ch : unaligned) {
+        ch = static_cast<char>(rng());
+    }
+    auto write_batch = std::make_shared<IoBatch>();
+    write_batch->add_write(fd, 0, aligned[0], PAGE_SIZE);
+    write_batch->add_write(fd, 1, unaligned.data() + 1, PAGE_SIZE);
+    write_batch->add_write(fd, 2, unaligned.data() + 1, 100);
+    backend.submit_and_wait(write_batch);
+
+    std::vector<char> result(PAGE_SIZE + 1);
+    auto read_batch = std::make_shared<IoBatch>();
+    read_batch->add_read(fd, 0, aligned[1], PAGE_SIZE);
+    read_batch->add_read(fd, 1, result.data() + 1, PAGE_SIZE);
+    backend.submit_and_wait(read_batch);
+    EXPECT_EQ(0, memcmp(aligned[0], aligned[1], PAGE_SIZE));
+    EXPECT_EQ(0, memcmp(unaligned.data() + 1, result.data() + 1, PAGE_SIZE));
+
+    auto partial_batch = std::make_shared<IoBatch>();
+    partial_batch->add_read(fd, 2, result.data() + 1, 100);
+    backend.submit_and_wait(partial_batch);
+    EXPECT_EQ(0, memcmp(unaligned.data() + 1, result.data() + 1, 100));
+
+    disk_manager_->close_file(fd);
+}
@@ -0,0 +1,92 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/bitmap.h"
+
+constexpr int BENCH_BITS = 1 << 24;     // 每组测试扫描的总位数，分摊到多个位图上
+
+/**
+ * @brief 原来的逐位查找，作为对比的基准
+ */
+static int bit_loop_next_bit(bool bit, const char *bm, int max_n, int curr) {
+    for (int i = curr + 1; i < max_n; i++) {
+        if (Bitmap::is_set(bm, i) == bit) {
+            return i;
+        }
+    }
+    return max_n;
+}
+
+template <typename F>
+static double measure_ns_per_bitmap(int rounds, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        f();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / rounds;
+}
+
+/**
+ * @brief 不同位图长度（每页的slot数）和填充率下，遍历位图中所有为1的位（扫描）以及查找第一个为0的位（插入）的耗时，
+ * 比较逐位循环、按字扫描的next_bit和一次取出所有位的for_each_set_bit
+ */
+TEST(BitmapBench, Scan) {
+    printf("%-8s %-8s %12s %12s %12s %12s %12s\n", "bits", "fill%", "loop ns", "next_bit ns", "for_each ns",
+           "loop free ns", "free ns");
+    std::mt19937 rng(2023);
+    for (int max_n : {64, 512, 4096, 32768}) {
+        for (int fill : {1, 50, 90, 100}) {
+            std::vector<char> bm((max_n + 7) / 8);
+            Bitmap::init(bm.data(), bm.size());
+            for (int i = 0; i < max_n; i++) {
+                if ((int)(rng() % 100) < fill) {
+                    Bitmap::set(bm.data(), i);
+                }
+            }
+            int rounds = BENCH_BITS / max_n;
+            volatile int sink = 0;
+            double loop_ns = measure_ns_per_bitmap(rounds, [&]() {
+                int sum = 0;
+                for (int i = bit_loop_next_bit(true, bm.data(), max_n, -1); i < max_n;
+                     i = bit_loop_next_bit(true, bm.data(), max_n, i)) {
+                    sum += i;
+                }
+                sink = sum;
+            });
+            double next_ns = measure_ns_per_bitmap(rounds, [&]() {
+                int sum = 0;
+                for (int i = Bitmap::first_bit(true, bm.data(), max_n); i < max_n;
+                     i = Bitmap::next_bit(true, bm.data(), max_n, i)) {
+                    sum += i;
+                }
+                sink = sum;
+            });
+            double for_each_ns = measure_ns_per_bitmap(rounds, [&]() {
+                int sum = 0;
+                Bitmap::for_each_set_bit(bm.data(), max_n, [&](int i) { sum += i; });
+                sink = sum;
+            });
+            double loop_free_ns =
+                measure_ns_per_bitmap(rounds, [&]() { sink = bit_loop_next_bit(false, bm.data(), max_n, -1); });
+            double free_ns =
+                measure_ns_per_bitmap(rounds, [&]() { sink = Bitmap::first_bit(false, bm.data(), max_n); });
+            (void)sink;
+            printf("%-8d %-8d %12.1f %12.1f %12.1f %12.1f %12.1f\n", max_n, fill, loop_ns, next_ns, for_each_ns,
+                   loop_free_ns, free_ns);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include "record/bitmap.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 逐位查找的参考实现
+ */
+static int reference_next_bit(bool bit, const char *bm, int max_n, int curr) {
+    for (int i = curr + 1; i < max_n; i++) {
+        if (Bitmap::is_set(bm, i) == bit) {
+            return i;
+        }
+    }
+    return max_n;
+}
+
+/**
+ * @brief 不同长度和密度的随机位图上，按字扫描（以及长位图上的AVX2路径）的结果与逐位查找一致
+ */
+TEST(BitmapTest, MatchesBitLoop) {
+    std::mt19937 rng(2023);
+    for (int max_n : {1, 7, 8, 63, 64, 65, 200, 511, 512, 1000, 4096, 5003}) {
+        for (int density : {0, 1, 50, 99, 100}) {
+            // 位图末尾多留一些字节并填满1，检查max_n之后的位不会被读到
+            std::vector<char> bm((max_n + 7) / 8 + 8, static_cast<char>(0xff));
+            Bitmap::init(bm.data(), (max_n + 7) / 8);
+            int expected_count = 0;
+            std::vector<int> expected_bits;
+            for (int i = 0; i < max_n; i++) {
+                if ((int)(rng() % 100) < density) {
+                    Bitmap::set(bm.data(), i);
+                    expected_count++;
+                    expected_bits.push_back(i);
+                }
+            }
+            for (int curr = -1; curr < max_n; curr++) {
+                for (bool bit : {false, true}) {
+                    ASSERT_EQ(Bitmap::next_bit(bit, bm.data(), max_n, curr),
+                              reference_next_bit(bit, bm.data(), max_n, curr))
+                        << "max_n=" << max_n << " density=" << density << " curr=" << curr << " bit=" << bit;
+                }
+            }
+            EXPECT_EQ(Bitmap::count(bm.data(), max_n), expected_count);
+            std::vector<int> bits;
+            Bitmap::for_each_set_bit(bm.data(), max_n, [&](int pos) { bits.push_back(pos); });
+            EXPECT_EQ(bits, expected_bits);
+        }
+    }
+}
+
+/**
+ * @brief 长位图中只有一位不同时，AVX2跳过前面的整块后仍能找到这一位
+ */
+TEST(BitmapTest, LongUniformRuns) {
+    constexpr int max_n = 8192;
+    std::vector<char> bm(max_n / 8);
+    for (int pos : {max_n - 1, max_n - 200, 300, 0}) {
+        Bitmap::init(bm.data(), max_n / 8);
+        Bitmap::set(bm.data(), pos);
+        EXPECT_EQ(Bitmap::first_bit(true, bm.data(), max_n), pos);
+        memset(bm.data(), 0xff, max_n / 8);
+        Bitmap::reset(bm.data(), pos);
+        EXPECT_EQ(Bitmap::first_bit(false, bm.data(), max_n), pos);
+        EXPECT_EQ(Bitmap::next_bit(false, bm.data(), max_n, pos), max_n);
+    }
+}
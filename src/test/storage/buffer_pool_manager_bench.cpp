@@ -0,0 +1,109 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/buffer_pool_manager.h"
+
+constexpr int BENCH_NUM_PAGES = 4096;               // 测试文件中的页面个数
+constexpr int BENCH_OPS_PER_THREAD = 200000;        // 每个线程执行的fetch/unpin次数
+const std::string BENCH_DB_NAME = "BufferPoolManagerBench_db";
+const std::string BENCH_FILE_NAME = "bench_file";
+
+/**
+ * @brief 缓冲池多线程fetch/unpin吞吐量基准测试，比较不同分区个数下吞吐量随线程数的变化
+ */
+class BufferPoolManagerBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    int fd_ = -1;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        // 预先写好所有页面，保证基准测试中读到的都是已存在的页面
+        disk_manager_->create_file(BENCH_FILE_NAME);
+        fd_ = disk_manager_->open_file(BENCH_FILE_NAME);
+        char buf[PAGE_SIZE] = {};
+        for (int page_no = 0; page_no < BENCH_NUM_PAGES; page_no++) {
+            disk_manager_->write_page(fd_, page_no, buf, PAGE_SIZE);
+        }
+        disk_manager_->set_fd2pageno(fd_, BENCH_NUM_PAGES);
+    }
+
+    void TearDown() override {
+        disk_manager_->close_file(fd_);
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 多个线程随机fetch/unpin页面，返回每秒完成的操作数
+     */
+    double run(BufferPoolManager *bpm, int num_threads) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([bpm, tid, this]() {
+                std::mt19937 rng(tid);
+                std::uniform_int_distribution<int> dist(0, BENCH_NUM_PAGES - 1);
+                for (int i = 0; i < BENCH_OPS_PER_THREAD; i++) {
+                    PageId page_id = {.fd = fd_, .page_no = dist(rng)};
+                    Page *page = bpm->fetch_page(page_id);
+                    ASSERT_NE(page, nullptr);
+                    bpm->unpin_page(page_id, false);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(num_threads) * BENCH_OPS_PER_THREAD / elapsed.count();
+    }
+};
+
+/**
+ * @brief 所有页面都能放入缓冲池，测量命中路径上的锁竞争
+ */
+TEST_F(BufferPoolManagerBench, FetchUnpinScaling) {
+    const std::vector<size_t> instance_counts = {1, 4, 16};
+    const std::vector<int> thread_counts = {1, 2, 4, 8, 16};
+    printf("%-12s", "instances");
+    for (int num_threads : thread_counts) {
+        printf("%10d thr", num_threads);
+    }
+    printf("   (Mops/s)\n");
+    for (size_t num_instances : instance_counts) {
+        printf("%-12zu", num_instances);
+        for (int num_threads : thread_counts) {
+            auto bpm = std::make_unique<BufferPoolManager>(BENCH_NUM_PAGES, disk_manager_.get(), num_instances);
+            run(bpm.get(), 1);  // 预热，将所有页面读入缓冲池
+            printf("%14.2f", run(bpm.get(), num_threads) / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+}
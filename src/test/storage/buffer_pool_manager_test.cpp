@@ -1,6 +1,9 @@
 #include "storage/buffer_pool_manager.h"
+#include "storage/read_ahead.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <ctime>
 #include <string>
@@ -427,3 +430,442 @@ TEST_F(BufferPoolManagerTest, ConcurrencyTest) {
 
     disk_manager_->close_file(fd);
 }
+
+/**
+ * @brief 测试后台写回线程：只写回页面LSN不超过已持久化LSN的脏页，且被写回的页面在淘汰时无需同步写回
+ */
+TEST_F(BufferPoolManagerTest, PageCleanerTest) {
+    const std::string filename = "page_cleaner_test";
+    const size_t buffer_pool_size = 20;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager, 1);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    // 填满缓冲池，第i个页面的LSN为i+1
+    PageId tmp_page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        Page *page = bpm->new_page(&tmp_page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->get_data(), PAGE_SIZE, "page %zu", i);
+        page->set_page_lsn(static_cast<lsn_t>(i + 1));
+    }
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        EXPECT_TRUE(bpm->unpin_page(PageId{fd, static_cast<page_id_t>(i)}, true));
+    }
+
+    // 日志尚未持久化，所有脏页都必须推迟写回
+    std::atomic<lsn_t> durable_lsn{0};
+    bpm->start_page_cleaner([&] { return durable_lsn.load(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * PAGE_CLEANER_INTERVAL_MS));
+    PageCleanerStats stats = bpm->get_cleaner_stats();
+    EXPECT_EQ(0, stats.pages_flushed);
+    EXPECT_GT(stats.wal_deferred, 0);
+
+    // 前10个页面的日志已持久化，后台写回线程写回其中的若干页，使干净帧达到低水位
+    durable_lsn = 10;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * PAGE_CLEANER_INTERVAL_MS));
+    bpm->stop_page_cleaner();
+    stats = bpm->get_cleaner_stats();
+    size_t low_water = std::max<size_t>(1, buffer_pool_size * PAGE_CLEANER_LOW_WATER_RATIO);
+    EXPECT_EQ(low_water, stats.pages_flushed);
+
+    // 磁盘上只有LSN不超过10的页面可能已被写回
+    char buf[PAGE_SIZE];
+    size_t on_disk = 0;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        memset(buf, 0, PAGE_SIZE);
+        try {
+            disk_manager_->read_page(fd, i, buf, PAGE_SIZE);
+        } catch (RMDBError &e) {
+            continue;
+        }
+        char expected[PAGE_SIZE] = {};
+        snprintf(expected, PAGE_SIZE, "page %zu", i);
+        if (strcmp(buf, expected) == 0) {
+            EXPECT_LE(i + 1, 10);
+            on_disk++;
+        }
+    }
+    EXPECT_EQ(stats.pages_flushed, on_disk);
+
+    // 淘汰最早被unpin的页面（即已被后台写回的页面）时不需要同步写回
+    for (size_t i = 0; i < low_water; ++i) {
+        EXPECT_NE(nullptr, bpm->new_page(&tmp_page_id));
+    }
+    stats = bpm->get_cleaner_stats();
+    EXPECT_EQ(low_water, stats.stalls_avoided);
+    EXPECT_EQ(0, stats.foreground_writebacks);
+    EXPECT_NE(nullptr, bpm->new_page(&tmp_page_id));
+    EXPECT_EQ(1, bpm->get_cleaner_stats().foreground_writebacks);
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试预读：预读的页面读取完成后处于未pin状态，之后的fetch_page直接命中且内容正确
+ */
+TEST_F(BufferPoolManagerTest, PrefetchTest) {
+    const std::string filename = "prefetch_test";
+    const size_t buffer_pool_size = 16;
+    const int num_pages = 64;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager, 2);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    char buf[PAGE_SIZE] = {};
+    for (int i = 0; i < num_pages; ++i) {
+        snprintf(buf, PAGE_SIZE, "page %d", i);
+        disk_manager_->write_page(fd, i, buf, PAGE_SIZE);
+    }
+
+    std::vector<page_id_t> page_nos;
+    for (int i = 0; i < 8; ++i) {
+        page_nos.push_back(i);
+    }
+    EXPECT_EQ(8, bpm->prefetch_pages(fd, page_nos));
+    bpm->wait_for_prefetch();
+    // 已在缓冲池中的页面不会再次预读
+    EXPECT_EQ(0, bpm->prefetch_pages(fd, page_nos));
+
+    // 预读不会使用被pin住的帧
+    std::vector<Page *> pinned;
+    for (int i = 0; i < 8; ++i) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        snprintf(buf, PAGE_SIZE, "page %d", i);
+        EXPECT_STREQ(buf, page->get_data());
+        pinned.push_back(page);
+    }
+    page_nos.clear();
+    for (int i = 8; i < num_pages; ++i) {
+        page_nos.push_back(i);
+    }
+    EXPECT_EQ(buffer_pool_size - 8, bpm->prefetch_pages(fd, page_nos));
+    // 不等待预读完成直接访问，fetch_page会等待读取完成
+    for (int i = 8; i < 16; ++i) {
+        Page *page = bpm->fetch_page(PageId{fd, i});
+        ASSERT_NE(nullptr, page);
+        snprintf(buf, PAGE_SIZE, "page %d", i);
+        EXPECT_STREQ(buf, page->get_data());
+        EXPECT_TRUE(bpm->unpin_page(PageId{fd, i}, false));
+    }
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(bpm->unpin_page(PageId{fd, i}, false));
+    }
+
+    // 预读不会为腾出帧而写回脏页
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_NE(nullptr, bpm->fetch_page(PageId{fd, i}));
+        EXPECT_TRUE(bpm->unpin_page(PageId{fd, i}, true));
+    }
+    EXPECT_EQ(0, bpm->prefetch_pages(fd, {32, 33, 34}));
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 每次读取前先等待一段时间的I/O后端，用于放大读取进行中的时间窗口
+ */
+class SlowReadIoBackend : public AsyncIoBackend {
+   public:
+    SlowReadIoBackend(DiskManager *disk_manager, std::chrono::microseconds delay)
+        : backend_(disk_manager), delay_(delay) {}
+
+    void submit(std::shared_ptr<IoBatch> batch) override {
+        std::this_thread::sleep_for(delay_);
+        backend_.submit(std::move(batch));
+    }
+
+    std::string name() const override { return "slow_read"; }
+
+   private:
+    ThreadPoolIoBackend backend_;
+    std::chrono::microseconds delay_;
+};
+
+/**
+ * @brief 测试无锁命中路径与缺页读取并发：读取完成之前其他线程不能通过try_fetch_page拿到该页面
+ */
+TEST_F(BufferPoolManagerTest, FetchDuringReadTest) {
+    const std::string filename = "fetch_during_read_test";
+    // 每个线程至多pin住一个页面，帧数不少于线程数时fetch_page总能找到可用的帧
+    const int num_threads = 4;
+    const size_t buffer_pool_size = num_threads;
+    const int num_pages = 2 * num_threads;
+    const int num_fetches = 2000;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    char buf[PAGE_SIZE] = {};
+    for (int i = 0; i < num_pages; ++i) {
+        snprintf(buf, PAGE_SIZE, "page %d", i);
+        disk_manager_->write_page(fd, i, buf, PAGE_SIZE);
+    }
+
+    SlowReadIoBackend backend(disk_manager, std::chrono::microseconds(20));
+    BufferPoolInstance instance(buffer_pool_size, disk_manager, &backend);
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&] {
+            char expected[PAGE_SIZE];
+            // 各线程按相同的顺序访问页面，同一页面上的缺页读取和其他线程的无锁命中同时发生
+            for (int i = 0; i < num_fetches; ++i) {
+                int page_no = i % num_pages;
+                Page *page = instance.fetch_page(PageId{fd, page_no});
+                if (page == nullptr) {
+                    mismatches++;
+                    continue;
+                }
+                snprintf(expected, PAGE_SIZE, "page %d", page_no);
+                if (strcmp(expected, page->get_data()) != 0) {
+                    mismatches++;
+                }
+                instance.unpin_page(PageId{fd, page_no}, false);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, mismatches);
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试预读窗口：顺序访问一段时间后开始预读，窗口逐批翻倍直到上限，随机访问时窗口清零
+ */
+TEST(ReadAheadWindowTest, SequentialPattern) {
+    ReadAheadWindow window(4, 16);
+    size_t begin = 0;
+    EXPECT_EQ(0, window.on_access(0, &begin));
+    EXPECT_EQ(0, window.on_access(1, &begin));
+    // 第READ_AHEAD_TRIGGER次顺序访问后开始预读
+    ASSERT_EQ(4, window.on_access(2, &begin));
+    EXPECT_EQ(3, begin);
+    // 已预读的页面还剩一半以上时不再发起预读
+    EXPECT_EQ(0, window.on_access(3, &begin));
+    ASSERT_EQ(8, window.on_access(4, &begin));
+    EXPECT_EQ(7, begin);
+
+    // 把后续的预读区间拼起来，应当连续且窗口不超过上限
+    size_t next = 15;
+    for (size_t pos = 5; pos < 200; pos++) {
+        size_t count = window.on_access(pos, &begin);
+        if (count > 0) {
+            EXPECT_EQ(next, begin);
+            EXPECT_LE(count, 16);
+            EXPECT_GT(begin, pos);
+            next = begin + count;
+        }
+    }
+    EXPECT_EQ(16, window.get_window());
+
+    // 随机访问后窗口清零
+    EXPECT_EQ(0, window.on_access(1000, &begin));
+    EXPECT_EQ(0, window.get_window());
+    EXPECT_EQ(0, window.on_access(7, &begin));
+}
+
+/**
+ * @brief 测试帧内存布局：页面数据按页对齐且连续存放，元数据按cache line对齐，不与页面数据重叠
+ */
+TEST_F(BufferPoolManagerTest, FrameAlignmentTest) {
+    const std::string filename = "frame_alignment_test";
+    const size_t buffer_pool_size = 64;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager, 2);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    EXPECT_EQ(0, alignof(Page) % 64);
+    EXPECT_EQ(0, sizeof(Page) % 64);
+    for (size_t i = 0; i < bpm->get_num_instances(); ++i) {
+        const FrameRegion &region = bpm->get_instance_at(i)->get_frame_region();
+        EXPECT_EQ(buffer_pool_size / 2, region.get_num_frames());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(region.get_frame(0)) % PAGE_SIZE);
+    }
+
+    PageId tmp_page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        Page *page = bpm->new_page(&tmp_page_id);
+        ASSERT_NE(nullptr, page);
+        char *data = page->get_data();
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data) % PAGE_SIZE);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page) % 64);
+        // 元数据不落在任何帧的数据中
+        EXPECT_TRUE(reinterpret_cast<char *>(page) + sizeof(Page) <= data ||
+                    reinterpret_cast<char *>(page) >= data + PAGE_SIZE);
+        EXPECT_TRUE(bpm->unpin_page(tmp_page_id, true));
+    }
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试在线调整缓冲池大小：扩容后可以同时pin住更多页面；缩容时脏页被写回，
+ * 被pin住的页面不会被移出，释放后可以继续缩容，页面内容在整个过程中保持不变
+ */
+TEST_F(BufferPoolManagerTest, ResizeTest) {
+    const std::string filename = "resize_test";
+    const size_t buffer_pool_size = 16;
+    const size_t max_pool_size = 64;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager, 2, max_pool_size);
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    EXPECT_EQ(max_pool_size, bpm->get_max_pool_size());
+
+    auto write_page = [](Page *page, int page_no) { snprintf(page->get_data(), PAGE_SIZE, "page %d", page_no); };
+    auto check_page = [](Page *page, int page_no) {
+        EXPECT_EQ(std::string(page->get_data()), "page " + std::to_string(page_no));
+    };
+
+    // 初始大小下最多只能同时pin住buffer_pool_size个页面
+    std::vector<PageId> page_ids;
+    PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        Page *page = bpm->new_page(&page_id);
+        ASSERT_NE(nullptr, page);
+        write_page(page, page_id.page_no);
+        page_ids.push_back(page_id);
+    }
+    EXPECT_EQ(nullptr, bpm->new_page(&page_id));
+
+    // 扩容后可以继续分配，超过上限的部分被截断
+    EXPECT_EQ(max_pool_size, bpm->resize(max_pool_size * 2));
+    EXPECT_EQ(max_pool_size, bpm->get_pool_size());
+    for (size_t i = buffer_pool_size; i < max_pool_size; ++i) {
+        Page *page = bpm->new_page(&page_id);
+        ASSERT_NE(nullptr, page);
+        write_page(page, page_id.page_no);
+        page_ids.push_back(page_id);
+    }
+    EXPECT_EQ(nullptr, bpm->new_page(&page_id));
+
+    // 所有页面都被pin住时缩容只能在超时后放弃
+    EXPECT_EQ(max_pool_size, bpm->resize(buffer_pool_size, std::chrono::milliseconds(10)));
+
+    // 释放所有页面（都是脏页）后缩容，被移出的脏页需要写回磁盘
+    for (auto &id : page_ids) {
+        EXPECT_TRUE(bpm->unpin_page(id, true));
+    }
+    EXPECT_EQ(buffer_pool_size, bpm->resize(buffer_pool_size, std::chrono::milliseconds(10)));
+    EXPECT_EQ(buffer_pool_size, bpm->get_pool_size());
+    size_t frames = 0;
+    for (size_t i = 0; i < bpm->get_num_instances(); ++i) {
+        frames += bpm->get_instance_at(i)->get_pool_size();
+    }
+    EXPECT_EQ(buffer_pool_size, frames);
+    for (auto &id : page_ids) {
+        Page *page = bpm->fetch_page(id);
+        ASSERT_NE(nullptr, page);
+        check_page(page, id.page_no);
+        EXPECT_TRUE(bpm->unpin_page(id, false));
+    }
+
+    // 一部分页面被pin住时，缩容等这些页面释放后才能完成
+    EXPECT_EQ(max_pool_size, bpm->resize(max_pool_size));
+    std::vector<Page *> pinned;
+    for (auto &id : page_ids) {
+        pinned.push_back(bpm->fetch_page(id));
+        ASSERT_NE(nullptr, pinned.back());
+    }
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (size_t i = 0; i < page_ids.size(); ++i) {
+            write_page(pinned[i], page_ids[i].page_no);
+            bpm->unpin_page(page_ids[i], true);
+        }
+    });
+    EXPECT_EQ(buffer_pool_size, bpm->resize(buffer_pool_size, std::chrono::seconds(10)));
+    releaser.join();
+    for (auto &id : page_ids) {
+        Page *page = bpm->fetch_page(id);
+        ASSERT_NE(nullptr, page);
+        check_page(page, id.page_no);
+        EXPECT_TRUE(bpm->unpin_page(id, false));
+    }
+
+    bpm->flush_all_pages(fd);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 测试缓冲池计数器：命中、缺页、换出、脏页写回和新页面的次数，以及按文件的统计
+ */
+TEST_F(BufferPoolManagerTest, StatsTest) {
+    const std::string filename0 = "stats_test0";
+    const std::string filename1 = "stats_test1";
+    const size_t buffer_pool_size = 8;
+    auto disk_manager = BufferPoolManagerTest::disk_manager_.get();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager);
+    disk_manager_->create_file(filename0);
+    disk_manager_->create_file(filename1);
+    int fd0 = disk_manager_->open_file(filename0);
+    int fd1 = disk_manager_->open_file(filename1);
+
+    // 在file0中创建buffer_pool_size个脏页，再在file1中创建同样多的页面，把file0的页面全部换出
+    PageId page_id = {.fd = fd0, .page_no = INVALID_PAGE_ID};
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        ASSERT_NE(nullptr, bpm->new_page(&page_id));
+        EXPECT_TRUE(bpm->unpin_page(page_id, true));
+    }
+    page_id.fd = fd1;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+        ASSERT_NE(nullptr, bpm->new_page(&page_id));
+        EXPECT_TRUE(bpm->unpin_page(page_id, false));
+    }
+    // file1的页面都在缓冲池中，命中；file0的页面需要重新读取
+    for (int fd : {fd1, fd0}) {
+        for (int page_no = 0; page_no < 2; ++page_no) {
+            PageId id = {.fd = fd, .page_no = page_no};
+            ASSERT_NE(nullptr, bpm->fetch_page(id));
+            EXPECT_TRUE(bpm->unpin_page(id, false));
+        }
+    }
+
+    BufferPoolStats stats = bpm->get_stats();
+    EXPECT_EQ(2 * buffer_pool_size, stats.get(BP_NEW_PAGE));
+    EXPECT_EQ(buffer_pool_size, stats.get(BP_DIRTY_WRITEBACK));
+    EXPECT_EQ(2u, stats.get(BP_MISS));
+    EXPECT_EQ(buffer_pool_size + 2, stats.get(BP_EVICTION));
+    EXPECT_EQ(2u, stats.get(BP_HIT));
+
+    std::unordered_map<std::string, BufferPoolStats> file_stats;
+    for (auto &[path, file_stat] : disk_manager_->get_file_stats()) {
+        file_stats[path] = file_stat;
+    }
+    ASSERT_EQ(1u, file_stats.count(filename0));
+    ASSERT_EQ(1u, file_stats.count(filename1));
+    EXPECT_EQ(buffer_pool_size, file_stats[filename0].get(BP_EVICTION));
+    EXPECT_EQ(buffer_pool_size, file_stats[filename0].get(BP_DIRTY_WRITEBACK));
+    EXPECT_EQ(2u, file_stats[filename0].get(BP_MISS));
+    EXPECT_EQ(0u, file_stats[filename1].get(BP_MISS));
+    EXPECT_EQ(2u, file_stats[filename1].get(BP_HIT));
+    EXPECT_EQ(2u, file_stats[filename1].get(BP_EVICTION));
+    EXPECT_EQ(stats.get(BP_HIT), file_stats[filename0].get(BP_HIT) + file_stats[filename1].get(BP_HIT));
+    EXPECT_LE(2u, disk_manager_->get_write_latency().summarize().count);
+
+    // 重新打开文件后按文件的计数器清零
+    bpm->flush_all_pages(fd1);
+    bpm->flush_all_pages(fd0);
+    bpm.reset();
+    disk_manager_->close_file(fd0);
+    fd0 = disk_manager_->open_file(filename0);
+    for (auto &[path, file_stat] : disk_manager_->get_file_stats()) {
+        if (path == filename0) {
+            EXPECT_EQ(0u, file_stat.get(BP_EVICTION));
+        }
+    }
+    disk_manager_->close_file(fd0);
+    disk_manager_->close_file(fd1);
+}
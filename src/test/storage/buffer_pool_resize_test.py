@@ -0,0 +1,83 @@
+import os
+import sys
+import time
+import signal
+import subprocess
+
+# 每一轮写入配置文件的buffer_pool_size，依次扩容、缩容
+POOL_SIZES = [4096, 2048, 8192, 1024]
+MAX_POOL_SIZE = 8192
+
+DATABASE_NAME = "buffer_pool_resize_test_db"
+CONFIG_FILE = "buffer_pool_resize_test.conf"
+OUTPUT_FILE = "buffer_pool_resize_test_output.txt"
+
+def build():
+    # root
+    os.chdir("../../../")
+    if os.path.exists("./build"):
+        os.system("rm -rf build")
+    os.mkdir("./build")
+    os.chdir("./build")
+    os.system("cmake ..")
+    os.system("make rmdb -j4")
+    os.chdir("..")
+
+def write_config(pool_size):
+    with open(CONFIG_FILE, "w") as f:
+        f.write("buffer_pool_size = " + str(pool_size) + "\n")
+        f.write("buffer_pool_max_size = " + str(MAX_POOL_SIZE) + "\n")
+
+def wait_for_output(expected, timeout):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        with open(OUTPUT_FILE, "r") as f:
+            if expected in f.read():
+                return True
+        time.sleep(0.1)
+    return False
+
+def run():
+    os.chdir("./build")
+    if os.path.exists(DATABASE_NAME):
+        os.system("rm -rf " + DATABASE_NAME)
+    write_config(POOL_SIZES[-1])
+
+    output = open(OUTPUT_FILE, "w")
+    server = subprocess.Popen(["./bin/rmdb", "-f", CONFIG_FILE, DATABASE_NAME], stdout=output, stderr=output)
+    # The server takes a few seconds to start the buffer pool and background threads.
+    time.sleep(3)
+
+    failed = False
+    old_size = POOL_SIZES[-1]
+    for pool_size in POOL_SIZES:
+        print("-----------Resizing buffer pool to " + str(pool_size) + " pages...-----------")
+        write_config(pool_size)
+        server.send_signal(signal.SIGHUP)
+        expected = "Buffer pool resized from " + str(old_size) + " to " + str(pool_size) + " pages"
+        if not wait_for_output(expected, 5):
+            print("Missing output: " + expected)
+            failed = True
+            break
+        if server.poll() is not None:
+            print("Server exited after SIGHUP with code " + str(server.returncode))
+            failed = True
+            break
+        old_size = pool_size
+
+    # close server
+    if server.poll() is None:
+        server.kill()
+        server.wait()
+    output.close()
+    os.system("rm -rf " + DATABASE_NAME + " " + CONFIG_FILE)
+    os.chdir("..")
+
+    if failed:
+        print("\033[0;31;40mBuffer pool resize test failed, see build/" + OUTPUT_FILE + "\033[0m")
+        sys.exit(1)
+    print("You have passed the buffer pool resize test.")
+
+if __name__ == "__main__":
+    build()
+    run()
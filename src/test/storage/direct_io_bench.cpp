@@ -0,0 +1,144 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/buffer_pool_manager.h"
+
+constexpr int BENCH_NUM_PAGES = 16384;    // 测试文件中的页面个数（64MB）
+constexpr int BENCH_POOL_SIZE = 2048;     // 缓冲池大小，远小于文件，保证大部分fetch都会读盘
+constexpr int BENCH_NUM_OPS = 100000;     // 随机fetch/unpin的次数
+const std::string BENCH_DB_NAME = "DirectIoBench_db";
+const std::string BENCH_FILE_NAME = "bench_file";
+
+/**
+ * @brief 比较数据文件以普通方式和O_DIRECT方式打开时，缓冲池随机读的延迟以及操作系统页缓存的占用
+ */
+class DirectIoBench : public ::testing::Test {
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        DiskManager disk_manager;
+        if (disk_manager.is_dir(BENCH_DB_NAME)) {
+            disk_manager.destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager.create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        disk_manager.create_file(BENCH_FILE_NAME);
+        int fd = disk_manager.open_file(BENCH_FILE_NAME);
+        alignas(PAGE_SIZE) static char buf[PAGE_SIZE];
+        for (int page_no = 0; page_no < BENCH_NUM_PAGES; page_no++) {
+            std::fill(buf, buf + PAGE_SIZE, static_cast<char>(page_no));
+            disk_manager.write_page(fd, page_no, buf, PAGE_SIZE);
+        }
+        fsync(fd);
+        disk_manager.close_file(fd);
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        DiskManager().destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 将文件从操作系统页缓存中清除
+     */
+    static void drop_page_cache(int fd) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    /**
+     * @brief 统计文件在操作系统页缓存中驻留的字节数
+     */
+    static size_t page_cache_resident_bytes() {
+        int fd = open(BENCH_FILE_NAME.c_str(), O_RDONLY);
+        size_t length = static_cast<size_t>(BENCH_NUM_PAGES) * PAGE_SIZE;
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        size_t os_page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        std::vector<unsigned char> vec((length + os_page - 1) / os_page);
+        size_t resident = 0;
+        if (addr != MAP_FAILED && mincore(addr, length, vec.data()) == 0) {
+            for (unsigned char v : vec) {
+                resident += (v & 1) ? os_page : 0;
+            }
+        }
+        if (addr != MAP_FAILED) {
+            munmap(addr, length);
+        }
+        close(fd);
+        return resident;
+    }
+
+    /**
+     * @brief 以给定方式打开文件，通过缓冲池做随机fetch/unpin并输出一行结果
+     * @param direct_io 是否以O_DIRECT方式打开数据文件
+     * @param cold 是否在每次缓冲池缺页前清空页缓存，模拟内存压力下页缓存被回收
+     */
+    static void run(const char *name, bool direct_io, bool cold) {
+        DiskManager disk_manager(direct_io);
+        int fd = disk_manager.open_file(BENCH_FILE_NAME);
+        disk_manager.set_fd2pageno(fd, BENCH_NUM_PAGES);
+        drop_page_cache(fd);
+        std::vector<double> latencies;
+        latencies.reserve(BENCH_NUM_OPS);
+        auto start = std::chrono::steady_clock::now();
+        {
+            BufferPoolManager bpm(BENCH_POOL_SIZE, &disk_manager);
+            std::mt19937 rng(0);
+            std::uniform_int_distribution<int> dist(0, BENCH_NUM_PAGES - 1);
+            for (int i = 0; i < BENCH_NUM_OPS; i++) {
+                if (cold && i % 1024 == 0) {
+                    drop_page_cache(fd);
+                }
+                PageId page_id = {.fd = fd, .page_no = dist(rng)};
+                auto op_start = std::chrono::steady_clock::now();
+                Page *page = bpm.fetch_page(page_id);
+                latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - op_start).count());
+                ASSERT_NE(page, nullptr);
+                ASSERT_EQ(page->get_data()[PAGE_SIZE - 1], static_cast<char>(page_id.page_no));
+                bpm.unpin_page(page_id, false);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::sort(latencies.begin(), latencies.end());
+        printf("%-22s%8s%12.0f%10.1f%10.1f%14.1f\n", name, disk_manager.is_direct(fd) ? "yes" : "no",
+               BENCH_NUM_OPS / elapsed.count(), latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+               page_cache_resident_bytes() / 1048576.0);
+        disk_manager.close_file(fd);
+    }
+};
+
+/**
+ * @brief 随机读：缓冲池只能容纳文件的1/8，大部分访问都需要读盘
+ * @note 普通方式下被缓冲池换出的页面仍留在页缓存中（双重缓存），O_DIRECT下页缓存占用应接近0；
+ *       cold一行在运行中不断清空页缓存，近似内存紧张时页缓存命中率下降的情况
+ */
+TEST_F(DirectIoBench, RandomRead) {
+    printf("file %d MB, pool %d MB, %d random fetches\n", BENCH_NUM_PAGES * PAGE_SIZE / 1048576,
+           BENCH_POOL_SIZE * PAGE_SIZE / 1048576, BENCH_NUM_OPS);
+    printf("%-22s%8s%12s%10s%10s%14s\n", "mode", "direct", "ops/s", "p50(us)", "p99(us)", "pagecache(MB)");
+    run("buffered", false, false);
+    run("buffered, cold cache", false, true);
+    run("O_DIRECT", true, false);
+}
@@ -147,3 +147,48 @@ TEST_F(DiskManagerTest, PageOperation) {
     disk_manager_->destroy_file(filename);
     EXPECT_EQ(disk_manager_->is_file(filename), false);
 }
+
+/**
+ * @brief 测试O_DIRECT模式：对齐与非对齐的读写都能正确完成，文件系统不支持O_DIRECT时退回普通读写
+ */
+TEST_F(DiskManagerTest, DirectIoOperation) {
+    const std::string filename = "DirectIoTestFile";
+    if (disk_manager_->is_file(filename)) {
+        disk_manager_->destroy_file(filename);
+    }
+    disk_manager_->create_file(filename);
+    disk_manager_->set_direct_io(true);
+    int fd = disk_manager_->open_file(filename);
+    disk_manager_->set_direct_io(false);
+    printf("O_DIRECT %s on this file system\n", disk_manager_->is_direct(fd) ? "enabled" : "rejected, buffered I/O");
+
+    // 按页对齐的整页读写
+    alignas(PAGE_SIZE) static char data[PAGE_SIZE];
+    alignas(PAGE_SIZE) static char buf[PAGE_SIZE];
+    std::vector<char> first_page(PAGE_SIZE);
+    for (int page_no = 0; page_no < MAX_PAGES; page_no++) {
+        rand_buf(data, PAGE_SIZE);
+        disk_manager_->write_page(fd, page_no, data, PAGE_SIZE);
+        std::memset(buf, 0, sizeof(buf));
+        disk_manager_->read_page(fd, page_no, buf, PAGE_SIZE);
+        EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+        if (page_no == 0) {
+            std::memcpy(first_page.data(), data, PAGE_SIZE);
+        }
+    }
+
+    // 非对齐的部分页读写（如文件头），只覆盖页面的前若干个字节
+    char header[100];
+    rand_buf(header, sizeof(header));
+    disk_manager_->write_page(fd, 0, header, sizeof(header));
+    char header_read[100] = {};
+    disk_manager_->read_page(fd, 0, header_read, sizeof(header_read));
+    EXPECT_EQ(std::memcmp(header, header_read, sizeof(header)), 0);
+    disk_manager_->read_page(fd, 0, buf, PAGE_SIZE);
+    EXPECT_EQ(std::memcmp(buf, header, sizeof(header)), 0);
+    EXPECT_EQ(std::memcmp(buf + sizeof(header), first_page.data() + sizeof(header), PAGE_SIZE - sizeof(header)), 0);
+
+    disk_manager_->close_file(fd);
+    EXPECT_FALSE(disk_manager_->is_direct(fd));
+    disk_manager_->destroy_file(filename);
+}
@@ -0,0 +1,123 @@
+#include "replacer/lru_k_replacer.h"
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 简单测试LRUKReplacer的基本功能
+ */
+TEST(LRUKReplacerTest, SimpleTest) {
+    LRUKReplacer lru_k_replacer(7, 2);
+
+    // Scenario: access frames 1..6 once, and frame 1 a second time.
+    for (int frame_id = 1; frame_id <= 6; frame_id++) {
+        lru_k_replacer.pin(frame_id);
+        lru_k_replacer.unpin(frame_id);
+    }
+    lru_k_replacer.pin(1);
+    lru_k_replacer.unpin(1);
+    EXPECT_EQ(6, lru_k_replacer.Size());
+
+    // Scenario: frames with fewer than K accesses go first, oldest first. Frame 1 is the only hot frame.
+    int value;
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(2, value);
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(3, value);
+
+    // Scenario: pinned frames cannot be evicted.
+    lru_k_replacer.pin(4);
+    EXPECT_EQ(3, lru_k_replacer.Size());
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(5, value);
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(6, value);
+
+    // Scenario: 4 now has two accesses. Its second most recent access is newer than 1's, so 1 goes first.
+    lru_k_replacer.unpin(4);
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(1, value);
+    lru_k_replacer.victim(&value);
+    EXPECT_EQ(4, value);
+    EXPECT_FALSE(lru_k_replacer.victim(&value));
+}
+
+/**
+ * @brief 一次顺序扫描不应把被反复访问的页面淘汰
+ */
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+    LRUKReplacer lru_k_replacer(8, 2);
+
+    // frames 0..3 are hot: each accessed twice
+    for (int round = 0; round < 2; round++) {
+        for (int frame_id = 0; frame_id < 4; frame_id++) {
+            lru_k_replacer.pin(frame_id);
+            lru_k_replacer.unpin(frame_id);
+        }
+    }
+    // frames 4..7 are touched once by a scan after the hot accesses
+    for (int frame_id = 4; frame_id < 8; frame_id++) {
+        lru_k_replacer.pin(frame_id);
+        lru_k_replacer.unpin(frame_id);
+    }
+    for (int i = 0; i < 4; i++) {
+        int value;
+        ASSERT_TRUE(lru_k_replacer.victim(&value));
+        EXPECT_GE(value, 4);
+    }
+}
+
+/**
+ * @brief 页面被删除后frame的访问历史应被清空，之后装入该frame的页面不能继承旧页面的访问次数
+ */
+TEST(LRUKReplacerTest, DeleteThenReuseTest) {
+    LRUKReplacer lru_k_replacer(4, 2);
+
+    // frame 1 and frame 0 are both hot, frame 1's second most recent access is older
+    for (int frame_id : {1, 1, 0, 0}) {
+        lru_k_replacer.pin(frame_id);
+        lru_k_replacer.unpin(frame_id);
+    }
+    EXPECT_EQ(2, lru_k_replacer.Size());
+
+    // the page in frame 0 is deleted: the frame goes to the free list without going through victim()
+    lru_k_replacer.remove(0);
+    EXPECT_EQ(1, lru_k_replacer.Size());
+
+    // a new page is loaded into frame 0 and accessed once, so it must be evicted before the hot frame 1
+    lru_k_replacer.pin(0);
+    lru_k_replacer.unpin(0);
+    int value;
+    ASSERT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(0, value);
+    ASSERT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(1, value);
+
+    // removing a pinned frame or a frame that is not in the replacer is a no-op apart from dropping its history
+    lru_k_replacer.pin(2);
+    lru_k_replacer.remove(2);
+    lru_k_replacer.remove(3);
+    EXPECT_EQ(0, lru_k_replacer.Size());
+    EXPECT_FALSE(lru_k_replacer.victim(&value));
+}
+
+/**
+ * @brief 已被pin的frame上的命中通过record_access记录，与每次命中都调用pin的效果相同
+ */
+TEST(LRUKReplacerTest, RecordAccessTest) {
+    LRUKReplacer lru_k_replacer(4, 2);
+
+    // frame 0 is pinned once and hit again while still pinned, frame 1 is pinned and unpinned once
+    lru_k_replacer.pin(0);
+    lru_k_replacer.record_access(0);
+    lru_k_replacer.pin(1);
+    lru_k_replacer.unpin(1);
+    lru_k_replacer.unpin(0);
+    EXPECT_EQ(2, lru_k_replacer.Size());
+
+    // frame 0 has reached K accesses, so frame 1 is evicted first even though it was unpinned earlier
+    int value;
+    ASSERT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(1, value);
+    ASSERT_TRUE(lru_k_replacer.victim(&value));
+    EXPECT_EQ(0, value);
+}
@@ -0,0 +1,109 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+constexpr int BENCH_RECORD_SIZE = 128;          // id INT, name CHAR(60), note CHAR(64)，字符串只占字段的一小部分
+constexpr int BENCH_NUM_RECORDS = 1 << 19;      // 未压缩时表文件约17000页，即66MB
+constexpr size_t BENCH_POOL_SIZE = 4096;        // 缓冲池远小于表文件，扫描总是冷读
+const std::string BENCH_DB_NAME = "PageCompressionBench_db";
+
+/**
+ * @brief 用零填充CHAR字段的历史表：比较不压缩与零值游程压缩的文件大小、写入耗时和冷缓存下的全表扫描耗时
+ */
+class PageCompressionBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 插入所有记录并关闭文件，返回耗时（ms），包括关闭时写回所有脏页
+     */
+    double load(const std::string &file_name, PageCompression compression) {
+        auto start = std::chrono::steady_clock::now();
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        rm_manager->create_file(file_name, BENCH_RECORD_SIZE, RM_LAYOUT_FIXED, {}, compression);
+        auto file_handle = rm_manager->open_file(file_name);
+        std::vector<char> record(BENCH_RECORD_SIZE);
+        for (int id = 0; id < BENCH_NUM_RECORDS; id++) {
+            memset(record.data(), 0, BENCH_RECORD_SIZE);
+            memcpy(record.data(), &id, sizeof(id));
+            snprintf(record.data() + 4, 60, "user_%d", id);
+            snprintf(record.data() + 64, 64, "event %d", id % 97);
+            file_handle->insert_record(record.data(), nullptr);
+        }
+        fsync(file_handle->GetFd());
+        rm_manager->close_file(file_handle.get());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() * 1000;
+    }
+
+    /**
+     * @brief 清除文件在操作系统页缓存中的内容后批量扫描整个表，返回耗时（ms）
+     */
+    double scan(const std::string &file_name) {
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        auto file_handle = rm_manager->open_file(file_name);
+        posix_fadvise(file_handle->GetFd(), 0, 0, POSIX_FADV_DONTNEED);
+
+        auto start = std::chrono::steady_clock::now();
+        long num_records = 0;
+        for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+            num_records += scan.size();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(num_records, BENCH_NUM_RECORDS);
+        rm_manager->close_file(file_handle.get());
+        return elapsed.count() * 1000;
+    }
+
+    void run(const char *name, PageCompression compression) {
+        std::string file_name = std::string("history_") + name;
+        double load_ms = load(file_name, compression);
+        double scan_ms = scan(file_name);
+        printf("%-12s %12.1f %12.1f %12.1f\n", name, disk_manager_->get_file_size(file_name) / 1048576.0, load_ms,
+               scan_ms);
+    }
+};
+
+TEST_F(PageCompressionBench, ColdScan) {
+    printf("%-12s %12s %12s %12s\n", "compression", "size (MB)", "load ms", "scan ms");
+    run("none", PAGE_COMPRESSION_NONE);
+    run("zero_run", PAGE_COMPRESSION_ZERO_RUN);
+}
@@ -0,0 +1,257 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+const std::string TEST_DB_NAME = "PageCompressionTest_db";
+const std::string TEST_FILE_NAME = "compressed_table";
+constexpr int TEST_NUM_PAGES = 200;
+
+class PageCompressionTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    /**
+     * @brief 前fill个字节为与page_no和版本有关的非零内容，其余为0，类似只填了一部分的CHAR字段
+     */
+    static std::vector<char> make_page(int page_no, int version, int fill) {
+        std::vector<char> page(PAGE_SIZE, 0);
+        for (int i = 0; i < fill; i++) {
+            page[i] = static_cast<char>(1 + (page_no * 31 + version * 7 + i) % 251);
+        }
+        return page;
+    }
+
+    void check_page(int fd, int page_no, const std::vector<char> &expected) {
+        std::vector<char> page(PAGE_SIZE);
+        disk_manager_->read_page(fd, page_no, page.data(), PAGE_SIZE);
+        EXPECT_EQ(page, expected) << "page " << page_no;
+    }
+
+    /**
+     * @brief 关闭文件，可选地删除页面映射以模拟异常退出，然后重新打开
+     */
+    int reopen(int fd, bool drop_map) {
+        disk_manager_->close_file(fd);
+        EXPECT_TRUE(disk_manager_->is_file(TEST_FILE_NAME + PAGE_MAP_FILE_SUFFIX));
+        if (drop_map) {
+            unlink((TEST_FILE_NAME + PAGE_MAP_FILE_SUFFIX).c_str());
+        }
+        fd = disk_manager_->open_file(TEST_FILE_NAME);
+        EXPECT_TRUE(disk_manager_->is_compressed(fd));
+        EXPECT_FALSE(disk_manager_->is_file(TEST_FILE_NAME + PAGE_MAP_FILE_SUFFIX));
+        return fd;
+    }
+};
+
+/**
+ * @brief 编解码：全零页面、部分填充的页面可以压缩并还原；无法压缩的页面在容量不足时返回0
+ */
+TEST_F(PageCompressionTest, ZeroRunCodec) {
+    std::vector<char> buf(2 * PAGE_SIZE);
+    std::vector<char> out(PAGE_SIZE);
+    std::mt19937 rng(2023);
+    std::vector<char> random_page(PAGE_SIZE);
+    for (auto &c : random_page) {
+        c = static_cast<char>(rng() % 255 + 1);
+    }
+    std::vector<char> sparse_page(PAGE_SIZE, 0);
+    for (int i = 0; i < PAGE_SIZE; i += 100) {
+        sparse_page[i] = 'x';
+        sparse_page[i + 3] = 'y';  // 短的零字节并入字面量
+    }
+    for (auto &page : {make_page(0, 0, 0), make_page(1, 0, 1000), sparse_page, random_page}) {
+        size_t len = ZeroRunCodec::compress(page.data(), buf.data(), buf.size());
+        ASSERT_GT(len, 0);
+        ASSERT_TRUE(ZeroRunCodec::decompress(buf.data(), len, out.data()));
+        EXPECT_EQ(out, page);
+        EXPECT_FALSE(ZeroRunCodec::decompress(buf.data(), len - 1, out.data()));
+    }
+    EXPECT_LT(ZeroRunCodec::compress(make_page(1, 0, 1000).data(), buf.data(), buf.size()), 1100);
+    EXPECT_EQ(ZeroRunCodec::compress(random_page.data(), buf.data(), PAGE_SIZE), 0);
+}
+
+/**
+ * @brief 压缩文件的读写：文件远小于原始大小；页面变大、变小后内容正确；关闭后通过.pmap或扫描文件恢复页面映射
+ */
+TEST_F(PageCompressionTest, ReadWriteAndReopen) {
+    disk_manager_->create_file(TEST_FILE_NAME, PAGE_COMPRESSION_ZERO_RUN);
+    int fd = disk_manager_->open_file(TEST_FILE_NAME);
+    ASSERT_TRUE(disk_manager_->is_compressed(fd));
+    std::vector<std::vector<char>> pages;
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+        pages.push_back(make_page(page_no, 0, 300));
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+    EXPECT_LT(disk_manager_->get_file_size(TEST_FILE_NAME), TEST_NUM_PAGES * PAGE_SIZE / 4);
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+        check_page(fd, page_no, pages[page_no]);
+    }
+
+    // 页面变大时移到新的extent，变小时原地重写，原extent被之后的页面复用
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no += 3) {
+        pages[page_no] = make_page(page_no, 1, PAGE_SIZE);
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no += 6) {
+        pages[page_no] = make_page(page_no, 2, 10);
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+    int file_size = disk_manager_->get_file_size(TEST_FILE_NAME);
+    for (int page_no = TEST_NUM_PAGES; page_no < TEST_NUM_PAGES + 10; page_no++) {
+        pages.push_back(make_page(page_no, 0, 300));
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+    EXPECT_EQ(disk_manager_->get_file_size(TEST_FILE_NAME), file_size);
+
+    for (bool drop_map : {false, true}) {
+        fd = reopen(fd, drop_map);
+        for (int page_no = 0; page_no < (int)pages.size(); page_no++) {
+            check_page(fd, page_no, pages[page_no]);
+        }
+    }
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 只写页面的前几个字节时保留页面其余内容；截断后被删除的页面不会在重建页面映射后重新出现
+ */
+TEST_F(PageCompressionTest, PartialWriteAndTruncate) {
+    disk_manager_->create_file(TEST_FILE_NAME, PAGE_COMPRESSION_ZERO_RUN);
+    int fd = disk_manager_->open_file(TEST_FILE_NAME);
+    int header = 12345;
+    disk_manager_->write_page(fd, 0, reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<char> expected(PAGE_SIZE, 0);
+    memcpy(expected.data(), &header, sizeof(header));
+    check_page(fd, 0, expected);
+    int read_header = 0;
+    disk_manager_->read_page(fd, 0, reinterpret_cast<char *>(&read_header), sizeof(read_header));
+    EXPECT_EQ(read_header, header);
+
+    std::vector<std::vector<char>> pages(TEST_NUM_PAGES);
+    for (int page_no = 1; page_no < TEST_NUM_PAGES; page_no++) {
+        pages[page_no] = make_page(page_no, 0, page_no * 20);
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+    header = 678;
+    disk_manager_->write_page(fd, 0, reinterpret_cast<const char *>(&header), sizeof(header));
+    memcpy(expected.data(), &header, sizeof(header));
+    check_page(fd, 0, expected);
+
+    int file_size = disk_manager_->get_file_size(TEST_FILE_NAME);
+    disk_manager_->truncate_file(fd, TEST_NUM_PAGES / 2);
+    EXPECT_LT(disk_manager_->get_file_size(TEST_FILE_NAME), file_size);
+    EXPECT_THROW(check_page(fd, TEST_NUM_PAGES / 2, pages[TEST_NUM_PAGES / 2]), InternalError);
+
+    fd = reopen(fd, true);
+    check_page(fd, 0, expected);
+    for (int page_no = 1; page_no < TEST_NUM_PAGES / 2; page_no++) {
+        check_page(fd, page_no, pages[page_no]);
+    }
+    for (int page_no = TEST_NUM_PAGES / 2; page_no < TEST_NUM_PAGES; page_no++) {
+        EXPECT_THROW(check_page(fd, page_no, pages[page_no]), InternalError);
+    }
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 写入页面的新版本时异常退出（新extent只写了一部分）：重建页面映射后页面仍为上一个版本，其他页面不受影响
+ */
+TEST_F(PageCompressionTest, TornWriteKeepsPreviousVersion) {
+    disk_manager_->create_file(TEST_FILE_NAME, PAGE_COMPRESSION_ZERO_RUN);
+    int fd = disk_manager_->open_file(TEST_FILE_NAME);
+    std::vector<std::vector<char>> pages(TEST_NUM_PAGES);
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+        pages[page_no] = make_page(page_no, 0, 1000);
+        disk_manager_->write_page(fd, page_no, pages[page_no].data(), PAGE_SIZE);
+    }
+
+    // 新版本与旧版本占用相同的块数，也不会覆盖旧版本，而是写到文件末尾的新extent
+    constexpr int TORN_PAGE = 5;
+    int file_size = disk_manager_->get_file_size(TEST_FILE_NAME);
+    auto new_version = make_page(TORN_PAGE, 1, 1000);
+    disk_manager_->write_page(fd, TORN_PAGE, new_version.data(), PAGE_SIZE);
+    int new_size = disk_manager_->get_file_size(TEST_FILE_NAME);
+    ASSERT_GT(new_size, file_size);
+    check_page(fd, TORN_PAGE, new_version);
+
+    // 模拟写入新extent时异常退出：extent的后半部分没有写入
+    disk_manager_->close_file(fd);
+    int raw_fd = open(TEST_FILE_NAME.c_str(), O_WRONLY);
+    ASSERT_NE(raw_fd, -1);
+    std::vector<char> garbage((new_size - file_size) / 2, 0x5a);
+    ASSERT_EQ(pwrite(raw_fd, garbage.data(), garbage.size(), new_size - garbage.size()), (ssize_t)garbage.size());
+    close(raw_fd);
+    unlink((TEST_FILE_NAME + PAGE_MAP_FILE_SUFFIX).c_str());
+    fd = disk_manager_->open_file(TEST_FILE_NAME);
+    for (int page_no = 0; page_no < TEST_NUM_PAGES; page_no++) {
+        check_page(fd, page_no, pages[page_no]);
+    }
+
+    // 损坏的extent被回收，之后的写入和重建页面映射不受影响
+    disk_manager_->write_page(fd, TORN_PAGE, new_version.data(), PAGE_SIZE);
+    EXPECT_EQ(disk_manager_->get_file_size(TEST_FILE_NAME), new_size);
+    fd = reopen(fd, true);
+    check_page(fd, TORN_PAGE, new_version);
+    check_page(fd, TORN_PAGE + 1, pages[TORN_PAGE + 1]);
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 压缩的表文件经过缓冲池读写：缓冲池远小于表文件，插入时淘汰的脏页压缩写回，批量扫描的预读通过异步I/O后端解压读取
+ */
+TEST_F(PageCompressionTest, TableThroughBufferPool) {
+    constexpr int RECORD_SIZE = 200;
+    constexpr int NUM_RECORDS = 20000;
+    auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager_.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+    rm_manager->create_file(TEST_FILE_NAME, RECORD_SIZE, RM_LAYOUT_FIXED, {}, PAGE_COMPRESSION_ZERO_RUN);
+    auto file_handle = rm_manager->open_file(TEST_FILE_NAME);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        std::vector<char> record(RECORD_SIZE, 0);
+        memcpy(record.data(), &i, sizeof(i));
+        snprintf(record.data() + sizeof(i), RECORD_SIZE - sizeof(i), "name%d", i);
+        file_handle->insert_record(record.data(), nullptr);
+    }
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    rm_manager->close_file(file_handle.get());
+    EXPECT_LT(disk_manager_->get_file_size(TEST_FILE_NAME), num_pages * PAGE_SIZE / 4);
+
+    bpm = std::make_unique<BufferPoolManager>(64, disk_manager_.get());
+    rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+    file_handle = rm_manager->open_file(TEST_FILE_NAME);
+    std::vector<bool> seen(NUM_RECORDS, false);
+    for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+        for (int i = 0; i < scan.size(); i++) {
+            int id = *reinterpret_cast<const int *>(scan.record(i));
+            ASSERT_TRUE(id >= 0 && id < NUM_RECORDS && !seen[id]);
+            EXPECT_EQ(std::string(scan.record(i) + sizeof(id)), "name" + std::to_string(id));
+            seen[id] = true;
+        }
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), true), NUM_RECORDS);
+    rm_manager->close_file(file_handle.get());
+}
@@ -0,0 +1,171 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page_table.h"
+
+constexpr int BENCH_NUM_FILES = 4;                  // 页面分布在4个文件中
+constexpr int BENCH_OPS_PER_THREAD = 1000000;       // 每个读线程执行的查找次数
+constexpr int BENCH_SAMPLE_EVERY = 8;               // 每8次查找记录一次延迟
+
+// 原页表使用的哈希函数，页号超过65536后不同文件的页面会冲突
+struct LegacyPageIdHash {
+    size_t operator()(const PageId &x) const { return (x.fd << 16) | x.page_no; }
+};
+
+/**
+ * @brief 原页表的做法：unordered_map由分区latch_保护，查找和修改都需要加锁
+ */
+template <typename Hash>
+class LockedMapTable {
+   public:
+    explicit LockedMapTable(size_t num_frames) { map_.reserve(num_frames); }
+
+    frame_id_t find(PageId page_id) {
+        std::scoped_lock lock{latch_};
+        auto iter = map_.find(page_id);
+        return iter == map_.end() ? INVALID_FRAME_ID : iter->second;
+    }
+
+    void replace(PageId old_page_id, PageId new_page_id, frame_id_t frame_id) {
+        std::scoped_lock lock{latch_};
+        map_.erase(old_page_id);
+        map_[new_page_id] = frame_id;
+    }
+
+   private:
+    std::mutex latch_;
+    std::unordered_map<PageId, frame_id_t, Hash> map_;
+};
+
+/**
+ * @brief PageTable：修改在latch_下进行，查找不加锁
+ */
+class LockFreeTable {
+   public:
+    explicit LockFreeTable(size_t num_frames) : table_(num_frames) {}
+
+    frame_id_t find(PageId page_id) { return table_.find(page_id); }
+
+    void replace(PageId old_page_id, PageId new_page_id, frame_id_t frame_id) {
+        std::scoped_lock lock{latch_};
+        table_.erase(old_page_id);
+        table_.insert(new_page_id, frame_id);
+    }
+
+   private:
+    std::mutex latch_;
+    PageTable table_;
+};
+
+struct BenchResult {
+    double mops;
+    double p50_ns;
+    double p99_ns;
+    double p999_ns;
+};
+
+/**
+ * @brief 页表查找的吞吐量和延迟基准测试。页表装满num_frames个页面，若干读线程随机查找驻留的页面，
+ * 同时一个写线程不断把某个帧中的页面替换为新页面，模拟缓冲池的页面淘汰
+ */
+template <typename Table>
+BenchResult run_bench(size_t num_frames, int num_threads) {
+    Table table(num_frames);
+    // 第i帧存放文件i % BENCH_NUM_FILES的第i / BENCH_NUM_FILES页
+    std::vector<PageId> resident(num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        resident[i] = PageId{static_cast<int>(i % BENCH_NUM_FILES), static_cast<page_id_t>(i / BENCH_NUM_FILES)};
+        table.replace(PageId{0, INVALID_PAGE_ID}, resident[i], static_cast<frame_id_t>(i));
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        std::mt19937 rng(1234);
+        page_id_t next_page_no = static_cast<page_id_t>(num_frames / BENCH_NUM_FILES);
+        while (!stop) {
+            // 替换读线程不会访问的后半部分帧，读线程查找的页面始终驻留
+            size_t frame = num_frames / 2 + rng() % (num_frames / 2);
+            PageId new_page_id{resident[frame].fd, next_page_no++};
+            table.replace(resident[frame], new_page_id, static_cast<frame_id_t>(frame));
+            resident[frame] = new_page_id;
+        }
+    });
+
+    std::vector<std::vector<double>> latencies(num_threads);
+    std::vector<std::thread> readers;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+        readers.emplace_back([&, tid] {
+            std::mt19937 rng(tid);
+            std::uniform_int_distribution<size_t> dist(0, num_frames / 2 - 1);
+            latencies[tid].reserve(BENCH_OPS_PER_THREAD / BENCH_SAMPLE_EVERY);
+            for (int i = 0; i < BENCH_OPS_PER_THREAD; i++) {
+                size_t frame = dist(rng);
+                PageId page_id{static_cast<int>(frame % BENCH_NUM_FILES),
+                               static_cast<page_id_t>(frame / BENCH_NUM_FILES)};
+                if (i % BENCH_SAMPLE_EVERY == 0) {
+                    auto op_start = std::chrono::steady_clock::now();
+                    frame_id_t frame_id = table.find(page_id);
+                    std::chrono::duration<double, std::nano> op = std::chrono::steady_clock::now() - op_start;
+                    latencies[tid].push_back(op.count());
+                    // 无锁查找可能因并发删除而漏掉页面，此时缓冲池会在latch下重新查找
+                    EXPECT_TRUE(frame_id == static_cast<frame_id_t>(frame) || frame_id == INVALID_FRAME_ID);
+                } else {
+                    table.find(page_id);
+                }
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stop = true;
+    writer.join();
+
+    std::vector<double> all;
+    for (auto &samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) { return all[static_cast<size_t>(p * (all.size() - 1))]; };
+    return {static_cast<double>(num_threads) * BENCH_OPS_PER_THREAD / elapsed.count() / 1e6, percentile(0.5),
+            percentile(0.99), percentile(0.999)};
+}
+
+TEST(PageTableBench, LookupThroughputAndLatency) {
+    const std::vector<size_t> frame_counts = {size_t{1} << 16, size_t{1} << 18};
+    const std::vector<int> thread_counts = {1, 4, 16};
+    printf("%-8s %-30s %8s %10s %10s %10s %10s\n", "frames", "table", "threads", "Mops/s", "p50(ns)", "p99(ns)",
+           "p99.9(ns)");
+    for (size_t num_frames : frame_counts) {
+        for (int num_threads : thread_counts) {
+            std::vector<std::pair<const char *, BenchResult>> results = {
+                {"unordered_map+latch (legacy)", run_bench<LockedMapTable<LegacyPageIdHash>>(num_frames, num_threads)},
+                {"unordered_map+latch", run_bench<LockedMapTable<PageIdHash>>(num_frames, num_threads)},
+                {"PageTable lock-free lookup", run_bench<LockFreeTable>(num_frames, num_threads)},
+            };
+            for (auto &[name, result] : results) {
+                printf("%-8zu %-30s %8d %10.2f %10.0f %10.0f %10.0f\n", num_frames, name, num_threads, result.mops,
+                       result.p50_ns, result.p99_ns, result.p999_ns);
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include "storage/page_table.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 简单测试PageTable的插入、覆盖、查找和删除
+ */
+TEST(PageTableTest, SimpleTest) {
+    PageTable page_table(8);
+    EXPECT_EQ(16, page_table.capacity());
+
+    page_table.insert(PageId{3, 0}, 1);
+    page_table.insert(PageId{3, 1}, 2);
+    page_table.insert(PageId{4, 0}, 3);
+    EXPECT_EQ(3, page_table.size());
+    EXPECT_EQ(1, page_table.find(PageId{3, 0}));
+    EXPECT_EQ(2, page_table.find(PageId{3, 1}));
+    EXPECT_EQ(3, page_table.find(PageId{4, 0}));
+    EXPECT_EQ(INVALID_FRAME_ID, page_table.find(PageId{4, 1}));
+
+    // 覆盖已有的映射
+    page_table.insert(PageId{3, 1}, 5);
+    EXPECT_EQ(3, page_table.size());
+    EXPECT_EQ(5, page_table.find(PageId{3, 1}));
+
+    page_table.erase(PageId{3, 0});
+    page_table.erase(PageId{3, 0});
+    page_table.erase(PageId{3, INVALID_PAGE_ID});
+    EXPECT_EQ(2, page_table.size());
+    EXPECT_EQ(0, page_table.count(PageId{3, 0}));
+    EXPECT_EQ(1, page_table.count(PageId{3, 1}));
+
+    // fd之间不再共用页号的高位，页号超过65536后也不会冲突
+    PageTable large(4);
+    large.insert(PageId{0, 1 << 16}, 1);
+    large.insert(PageId{1, 0}, 2);
+    EXPECT_EQ(1, large.find(PageId{0, 1 << 16}));
+    EXPECT_EQ(2, large.find(PageId{1, 0}));
+}
+
+/**
+ * @brief 随机插入和删除，与std::unordered_map比较，检验后移删除后探测链仍然完整
+ */
+TEST(PageTableTest, RandomTest) {
+    const size_t num_frames = 1024;
+    PageTable page_table(num_frames);
+    std::unordered_map<PageId, frame_id_t, PageIdHash> expected;
+    std::mt19937 rng(0);
+    for (int i = 0; i < 200000; i++) {
+        PageId page_id{static_cast<int>(rng() % 4), static_cast<page_id_t>(rng() % 4096)};
+        if (expected.size() < num_frames && rng() % 2 == 0) {
+            frame_id_t frame_id = static_cast<frame_id_t>(rng() % num_frames);
+            page_table.insert(page_id, frame_id);
+            expected[page_id] = frame_id;
+        } else {
+            page_table.erase(page_id);
+            expected.erase(page_id);
+        }
+    }
+    EXPECT_EQ(expected.size(), page_table.size());
+    for (int fd = 0; fd < 4; fd++) {
+        for (page_id_t page_no = 0; page_no < 4096; page_no++) {
+            PageId page_id{fd, page_no};
+            auto iter = expected.find(page_id);
+            frame_id_t frame_id = iter == expected.end() ? INVALID_FRAME_ID : iter->second;
+            ASSERT_EQ(frame_id, page_table.find(page_id));
+        }
+    }
+}
+
+/**
+ * @brief 一个线程不断插入删除，多个线程并发地无锁查找：查找可以漏掉页面，但不能返回错误的帧
+ */
+TEST(PageTableTest, ConcurrentLookupTest) {
+    const size_t num_frames = 4096;
+    const int num_stable = 1024;
+    PageTable page_table(num_frames);
+    // 稳定的映射：第i页始终在第i帧
+    for (int i = 0; i < num_stable; i++) {
+        page_table.insert(PageId{1, i}, i);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> misses{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            while (!stop) {
+                int page_no = rng() % num_stable;
+                frame_id_t frame_id = page_table.find(PageId{1, page_no});
+                if (frame_id == INVALID_FRAME_ID) {
+                    misses++;
+                } else {
+                    ASSERT_EQ(page_no, frame_id);
+                }
+            }
+        });
+    }
+
+    std::mt19937 rng(42);
+    for (int i = 0; i < 200000; i++) {
+        PageId page_id{2, static_cast<page_id_t>(rng() % 2048)};
+        if (page_table.size() < num_frames && rng() % 2 == 0) {
+            page_table.insert(page_id, num_stable + rng() % num_stable);
+        } else {
+            page_table.erase(page_id);
+        }
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (int i = 0; i < num_stable; i++) {
+        EXPECT_EQ(i, page_table.find(PageId{1, i}));
+    }
+}
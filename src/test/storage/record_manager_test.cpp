@@ -9,6 +9,7 @@
 #include <ctime>
 #include <iostream>
 #include <unordered_map>
+#include <vector>
 
 #include "gtest/gtest.h"
 #define BUFFER_LENGTH 8192
@@ -223,4 +224,124 @@ TEST(RecordManagerTest, MultipleFilesTest) {
         std::string filename = filenames[i];
         rm_manager->destroy_file(filename);
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief 测试记录视图：视图直接指向缓冲池中的slot，存在期间页面保持pin，销毁或移交后pin被正确释放
+ */
+TEST(RecordManagerTest, RecordViewTest) {
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string filename = "record_view.txt";
+    int record_size = 64;
+    if (disk_manager->is_file(filename)) {
+        disk_manager->destroy_file(filename);
+    }
+    rm_manager->create_file(filename, record_size);
+    auto file_handle = rm_manager->open_file(filename);
+
+    char write_buf[BUFFER_LENGTH];
+    rand_buf(record_size, write_buf);
+    Rid rid = file_handle->insert_record(write_buf, nullptr);
+    rand_buf(record_size, write_buf + record_size);
+    Rid next_rid = file_handle->insert_record(write_buf + record_size, nullptr);
+
+    RmPageHandle page_handle = file_handle->fetch_page_handle(rid.page_no);
+    int pin_count = page_handle.page->pin_count_;
+    {
+        RmRecordView view = file_handle->get_record_view(rid, nullptr);
+        assert(view.is_valid());
+        // 视图指向页面中的slot，没有拷贝
+        assert(view.get()->data == page_handle.get_slot(rid.slot_no));
+        assert(view.get()->size == record_size);
+        assert(page_handle.page->pin_count_ == pin_count + 1);
+
+        // 修改页面中的记录后视图立即可见，to_record得到的拷贝不受之后修改的影响
+        auto copy = view.to_record();
+        assert(memcmp(copy->data, write_buf, record_size) == 0);
+        file_handle->update_record(rid, write_buf + record_size, nullptr);
+        assert(memcmp(view.get()->data, write_buf + record_size, record_size) == 0);
+        assert(memcmp(copy->data, write_buf, record_size) == 0);
+
+        // 移动后只有一个视图持有pin，赋值时释放原来持有的pin
+        RmRecordView moved = std::move(view);
+        assert(!view.is_valid() && moved.is_valid());
+        assert(page_handle.page->pin_count_ == pin_count + 1);
+        moved = file_handle->get_record_view(next_rid, nullptr);
+        assert(page_handle.page->pin_count_ == pin_count + 1);
+        moved.reset();
+        assert(page_handle.page->pin_count_ == pin_count);
+        moved = file_handle->get_record_view(next_rid, nullptr);
+    }
+    assert(page_handle.page->pin_count_ == pin_count);
+    buffer_pool_manager->unpin_page(page_handle.page->get_page_id(), false);
+
+    rm_manager->close_file(file_handle.get());
+    rm_manager->destroy_file(filename);
+}
+
+/**
+ * @brief 测试批量扫描：每个批次只包含一个页面中的记录，按rid顺序给出与逐条读取相同的全部记录，批次存在期间页面保持一次pin
+ */
+TEST(RecordManagerTest, BatchScanTest) {
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string filename = "batch_scan.txt";
+    int record_size = 40;
+    if (disk_manager->is_file(filename)) {
+        disk_manager->destroy_file(filename);
+    }
+    rm_manager->create_file(filename, record_size);
+    auto file_handle = rm_manager->open_file(filename);
+
+    std::unordered_map<Rid, std::string, rid_hash_t, rid_equal_t> mock;
+    char write_buf[BUFFER_LENGTH];
+    std::vector<Rid> rids;
+    for (int i = 0; i < 3000; i++) {
+        rand_buf(record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, nullptr);
+        mock[rid] = std::string(write_buf, record_size);
+        rids.push_back(rid);
+    }
+    // 删除一部分记录，其中包括某些页面上的全部记录
+    for (auto &rid : rids) {
+        if (rand() % 3 == 0 || rid.page_no == RM_FIRST_RECORD_PAGE + 2) {
+            file_handle->delete_record(rid, nullptr);
+            mock.erase(rid);
+        }
+    }
+
+    size_t num_records = 0;
+    Rid prev_rid = {.page_no = -1, .slot_no = -1};
+    RmBatchScan scan(file_handle.get());
+    while (scan.next_batch()) {
+        assert(scan.size() > 0);
+        assert(scan.rid(0).page_no != RM_FIRST_RECORD_PAGE + 2);
+        RmPageHandle page_handle = file_handle->fetch_page_handle(scan.rid(0).page_no);
+        assert(page_handle.page->pin_count_ == 2);
+        for (int i = 0; i < scan.size(); i++) {
+            Rid rid = scan.rid(i);
+            assert(rid.page_no == scan.rid(0).page_no);
+            assert(rid.page_no > prev_rid.page_no || rid.slot_no > prev_rid.slot_no);
+            // 记录指针直接指向页面中的slot
+            assert(scan.record(i) == page_handle.get_slot(rid.slot_no));
+            assert(memcmp(scan.record(i), mock.at(rid).c_str(), record_size) == 0);
+            prev_rid = rid;
+            num_records++;
+        }
+        buffer_pool_manager->unpin_page(page_handle.page->get_page_id(), false);
+    }
+    assert(scan.is_end());
+    assert(!scan.next_batch());
+    assert(num_records == mock.size());
+
+    RmPageHandle page_handle = file_handle->fetch_page_handle(prev_rid.page_no);
+    assert(page_handle.page->pin_count_ == 1);
+    buffer_pool_manager->unpin_page(page_handle.page->get_page_id(), false);
+
+    rm_manager->close_file(file_handle.get());
+    rm_manager->destroy_file(filename);
+}
@@ -0,0 +1,157 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/lru_replacer.h"
+
+constexpr size_t BENCH_POOL_SIZE = 4096;         // 模拟缓冲池的帧数
+constexpr size_t BENCH_TRACE_LENGTH = 2000000;   // 每条访问序列的长度
+
+/**
+ * @brief 生成服从Zipf分布的页面编号，热点页面被随机打散在整个页面空间中
+ */
+class ZipfGenerator {
+   public:
+    ZipfGenerator(size_t num_pages, double theta, uint32_t seed) : rng_(seed), pages_(num_pages) {
+        cdf_.resize(num_pages);
+        double sum = 0;
+        for (size_t i = 0; i < num_pages; i++) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+            cdf_[i] = sum;
+        }
+        for (size_t i = 0; i < num_pages; i++) {
+            cdf_[i] /= sum;
+            pages_[i] = static_cast<int>(i);
+        }
+        std::shuffle(pages_.begin(), pages_.end(), rng_);
+    }
+
+    int next() {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng_);
+        size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return pages_[std::min(rank, pages_.size() - 1)];
+    }
+
+   private:
+    std::mt19937 rng_;
+    std::vector<double> cdf_;
+    std::vector<int> pages_;
+};
+
+/**
+ * @brief 类TPC-C负载：大部分访问集中在少量热点页面（仓库、区域、库存），另有一部分是顺序追加的新页面（订单、历史）
+ */
+static std::vector<int> make_tpcc_like_trace() {
+    const size_t num_pages = BENCH_POOL_SIZE * 8;
+    ZipfGenerator zipf(num_pages, 0.9, 1);
+    std::mt19937 rng(2);
+    std::vector<int> trace;
+    trace.reserve(BENCH_TRACE_LENGTH);
+    int append_page = static_cast<int>(num_pages);
+    for (size_t i = 0; i < BENCH_TRACE_LENGTH; i++) {
+        if (rng() % 10 == 0) {
+            // 每个追加页面被连续写入若干次后换到下一个页面
+            trace.push_back(append_page);
+            if (rng() % 8 == 0) {
+                append_page++;
+            }
+        } else {
+            trace.push_back(zipf.next());
+        }
+    }
+    return trace;
+}
+
+/**
+ * @brief 扫描密集负载：热点点查与大于缓冲池的顺序全表扫描交替进行
+ */
+static std::vector<int> make_scan_heavy_trace() {
+    const size_t hot_pages = BENCH_POOL_SIZE / 2;
+    const size_t scan_pages = BENCH_POOL_SIZE * 3;
+    ZipfGenerator zipf(hot_pages, 0.8, 3);
+    std::vector<int> trace;
+    trace.reserve(BENCH_TRACE_LENGTH);
+    while (trace.size() < BENCH_TRACE_LENGTH) {
+        for (size_t i = 0; i < BENCH_POOL_SIZE * 4 && trace.size() < BENCH_TRACE_LENGTH; i++) {
+            trace.push_back(zipf.next());
+        }
+        for (size_t i = 0; i < scan_pages && trace.size() < BENCH_TRACE_LENGTH; i++) {
+            trace.push_back(static_cast<int>(hot_pages + i));
+        }
+    }
+    return trace;
+}
+
+struct BenchResult {
+    double hit_ratio;
+    double mops;
+};
+
+/**
+ * @brief 以缓冲池的方式驱动replacer重放访问序列：命中时pin/unpin，未命中时淘汰一个frame后装入页面
+ */
+static BenchResult replay(Replacer *replacer, const std::vector<int> &trace) {
+    std::vector<int> page2frame;
+    std::vector<int> frame2page(BENCH_POOL_SIZE, -1);
+    size_t next_free = 0;
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int page : trace) {
+        if (static_cast<size_t>(page) >= page2frame.size()) {
+            page2frame.resize(page + 1, -1);
+        }
+        frame_id_t frame_id = page2frame[page];
+        if (frame_id != -1) {
+            hits++;
+        } else {
+            if (next_free < BENCH_POOL_SIZE) {
+                frame_id = static_cast<frame_id_t>(next_free++);
+            } else {
+                EXPECT_TRUE(replacer->victim(&frame_id));
+                page2frame[frame2page[frame_id]] = -1;
+            }
+            frame2page[frame_id] = page;
+            page2frame[page] = frame_id;
+        }
+        replacer->pin(frame_id);
+        replacer->unpin(frame_id);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {static_cast<double>(hits) / trace.size(), trace.size() / elapsed.count() / 1e6};
+}
+
+/**
+ * @brief 在类TPC-C和扫描密集两种访问序列上比较LRU、CLOCK和LRU-K的命中率与吞吐量
+ */
+TEST(ReplacerBench, TraceDriven) {
+    std::vector<std::pair<std::string, std::vector<int>>> traces = {{"tpcc-like", make_tpcc_like_trace()},
+                                                                    {"scan-heavy", make_scan_heavy_trace()}};
+    printf("%-12s %-8s %12s %14s\n", "trace", "policy", "hit ratio", "Mops/s");
+    for (auto &[trace_name, trace] : traces) {
+        std::vector<std::pair<std::string, std::unique_ptr<Replacer>>> replacers;
+        replacers.emplace_back("LRU", std::make_unique<LRUReplacer>(BENCH_POOL_SIZE));
+        replacers.emplace_back("CLOCK", std::make_unique<ClockReplacer>(BENCH_POOL_SIZE));
+        replacers.emplace_back("LRU-K", std::make_unique<LRUKReplacer>(BENCH_POOL_SIZE, 2));
+        for (auto &[policy, replacer] : replacers) {
+            BenchResult result = replay(replacer.get(), trace);
+            printf("%-12s %-8s %12.4f %14.2f\n", trace_name.c_str(), policy.c_str(), result.hit_ratio, result.mops);
+        }
+    }
+}
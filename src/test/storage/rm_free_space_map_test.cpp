@@ -0,0 +1,204 @@
+#include "record/rm_free_space_map.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+const std::string TEST_DB_NAME = "RmFreeSpaceMapTest_db";
+const std::string TEST_FILE_NAME = "fsm_table";
+constexpr int TEST_RECORD_SIZE = 500;   // 每页可容纳8条记录
+
+/**
+ * @brief 线段树上的占用、释放、回绕查找和扩展
+ */
+TEST(RmFreeSpaceMapTest, AcquireRelease) {
+    RmFreeSpaceMap fsm;
+    fsm.reset(10);
+    EXPECT_EQ(fsm.acquire_page(1, 0), RM_NO_PAGE);
+    for (int page_no = 1; page_no < 10; page_no++) {
+        fsm.set_free_space(page_no, page_no % 3 == 0 ? 0 : 2);
+    }
+
+    // 优先返回hint，被占用的页面和已满的页面被跳过
+    EXPECT_EQ(fsm.acquire_page(1, 4), 4);
+    EXPECT_EQ(fsm.acquire_page(1, 4), 5);
+    EXPECT_EQ(fsm.acquire_page(1, 5), 7);
+    // 到达末尾后从头查找
+    EXPECT_EQ(fsm.acquire_page(1, 8), 8);
+    EXPECT_EQ(fsm.acquire_page(1, 9), 1);
+    EXPECT_EQ(fsm.acquire_page(3, 0), RM_NO_PAGE);
+
+    fsm.release_page(4, 1);
+    EXPECT_EQ(fsm.get_free_space(4), 1);
+    EXPECT_EQ(fsm.acquire_page(1, 3), 4);
+    fsm.release_page(4, 0);
+    EXPECT_EQ(fsm.acquire_page(1, 3), 2);
+
+    // 新页面在释放前不可见，页面号超出容量时映射自动扩展
+    fsm.acquire_new_page(100);
+    EXPECT_EQ(fsm.get_num_pages(), 101);
+    EXPECT_EQ(fsm.acquire_page(1, 90), RM_NO_PAGE);
+    fsm.release_page(100, 5);
+    EXPECT_EQ(fsm.acquire_page(5, 0), 100);
+}
+
+class RmFreeSpaceMapFileTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        rm_manager_->create_file(TEST_FILE_NAME, TEST_RECORD_SIZE);
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    static std::vector<char> make_record(int value) {
+        std::vector<char> record(TEST_RECORD_SIZE, 0);
+        memcpy(record.data(), &value, sizeof(value));
+        return record;
+    }
+};
+
+/**
+ * @brief 多个线程并发插入，每条记录都落在不同的slot上，数据不会互相覆盖
+ */
+TEST_F(RmFreeSpaceMapFileTest, ConcurrentInsert) {
+    constexpr int NUM_THREADS = 8;
+    constexpr int RECORDS_PER_THREAD = 1000;
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+
+    std::vector<std::vector<Rid>> rids(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < RECORDS_PER_THREAD; i++) {
+                auto record = make_record(t * RECORDS_PER_THREAD + i);
+                rids[t].push_back(file_handle->insert_record(record.data(), nullptr));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::set<std::pair<int, int>> slots;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        for (int i = 0; i < RECORDS_PER_THREAD; i++) {
+            Rid rid = rids[t][i];
+            EXPECT_TRUE(slots.emplace(rid.page_no, rid.slot_no).second);
+            auto record = file_handle->get_record(rid, nullptr);
+            EXPECT_EQ(*reinterpret_cast<int *>(record->data), t * RECORDS_PER_THREAD + i);
+        }
+    }
+    size_t num_records = 0;
+    for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+        num_records++;
+    }
+    EXPECT_EQ(num_records, slots.size());
+    // 每个页面都被填满，除了各线程最后使用的页面
+    int num_records_per_page = file_handle->get_file_hdr().num_records_per_page;
+    int min_pages = (NUM_THREADS * RECORDS_PER_THREAD + num_records_per_page - 1) / num_records_per_page;
+    EXPECT_LE(file_handle->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE, min_pages + NUM_THREADS);
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 批量删除后，空出来的整页可以立即被后续插入复用，文件不再增长
+ */
+TEST_F(RmFreeSpaceMapFileTest, BulkDeleteReuse) {
+    constexpr int NUM_RECORDS = 4000;
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    std::vector<Rid> rids;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        auto record = make_record(i);
+        rids.push_back(file_handle->insert_record(record.data(), nullptr));
+    }
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    int num_records_per_page = file_handle->get_file_hdr().num_records_per_page;
+
+    int half_pages = num_pages / 2;
+    int num_deleted = 0;
+    for (auto &rid : rids) {
+        if (rid.page_no < half_pages) {
+            file_handle->delete_record(rid, nullptr);
+            num_deleted++;
+        }
+    }
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < half_pages; page_no++) {
+        EXPECT_EQ(file_handle->get_free_space(page_no), num_records_per_page);
+    }
+    for (int i = 0; i < num_deleted; i++) {
+        auto record = make_record(i);
+        Rid rid = file_handle->insert_record(record.data(), nullptr);
+        EXPECT_LT(rid.page_no, half_pages);
+    }
+    EXPECT_EQ(file_handle->get_file_hdr().num_pages, num_pages);
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 关闭文件时保存映射，重新打开后直接加载；映射文件丢失时扫描页头重建，结果一致
+ */
+TEST_F(RmFreeSpaceMapFileTest, SaveAndRebuild) {
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    std::vector<Rid> rids;
+    for (int i = 0; i < 1000; i++) {
+        auto record = make_record(i);
+        rids.push_back(file_handle->insert_record(record.data(), nullptr));
+    }
+    for (size_t i = 0; i < rids.size(); i += 3) {
+        file_handle->delete_record(rids[i], nullptr);
+    }
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    std::vector<int> free_slots;
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        free_slots.push_back(file_handle->get_free_space(page_no));
+    }
+    rm_manager_->close_file(file_handle.get());
+    EXPECT_TRUE(disk_manager_->is_file(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX));
+
+    RmFreeSpaceMap saved;
+    EXPECT_FALSE(saved.load(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX, num_pages + 1));
+    EXPECT_TRUE(saved.load(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX, num_pages));
+
+    // 加载后映射文件被删除，此后映射只在内存中维护
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        EXPECT_EQ(file_handle->get_free_space(page_no), free_slots[page_no]);
+    }
+    EXPECT_FALSE(disk_manager_->is_file(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX));
+    rm_manager_->close_file(file_handle.get());
+
+    // 模拟崩溃后映射文件不存在
+    disk_manager_->destroy_file(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX);
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        EXPECT_EQ(file_handle->get_free_space(page_no), free_slots[page_no]);
+    }
+    rm_manager_->close_file(file_handle.get());
+    rm_manager_->destroy_file(TEST_FILE_NAME);
+    EXPECT_FALSE(disk_manager_->is_file(TEST_FILE_NAME + RM_FSM_FILE_SUFFIX));
+}
@@ -0,0 +1,114 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+
+constexpr int BENCH_RECORD_SIZE = 64;
+constexpr int BENCH_NUM_RECORDS = 400000;       // 每轮插入的记录总数，平均分给各个客户端
+constexpr size_t BENCH_POOL_SIZE = 65536;       // 表文件完全放在缓冲池中，只测试插入路径本身
+const std::string BENCH_DB_NAME = "RmInsertBench_db";
+const std::string BENCH_FILE_NAME = "bench_table";
+
+/**
+ * @brief 并发插入的基准测试：1到32个客户端向同一张表插入记录，空闲空间映射把客户端分散到不同的未满页面上
+ */
+class RmInsertBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief num_clients个线程各插入BENCH_NUM_RECORDS / num_clients条记录，返回每秒插入的记录数
+     */
+    double run_inserts(RmFileHandle *file_handle, int num_clients, std::vector<std::vector<Rid>> *rids) {
+        rids->assign(num_clients, {});
+        std::vector<std::thread> clients;
+        auto start = std::chrono::steady_clock::now();
+        for (int c = 0; c < num_clients; c++) {
+            clients.emplace_back([=]() {
+                std::vector<char> record(BENCH_RECORD_SIZE, static_cast<char>('a' + c));
+                auto &client_rids = (*rids)[c];
+                client_rids.reserve(BENCH_NUM_RECORDS / num_clients);
+                for (int i = 0; i < BENCH_NUM_RECORDS / num_clients; i++) {
+                    client_rids.push_back(file_handle->insert_record(record.data(), nullptr));
+                }
+            });
+        }
+        for (auto &client : clients) {
+            client.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BENCH_NUM_RECORDS / num_clients * num_clients / elapsed.count();
+    }
+};
+
+/**
+ * @brief 向空表插入，以及删除前半张表的全部记录后再次插入：空出的页面被重新填满，fill%为最终的页面填充率
+ */
+TEST_F(RmInsertBench, ConcurrentInsert) {
+    printf("%-8s %14s %10s %14s %10s %8s\n", "clients", "insert rec/s", "pages", "refill rec/s", "pages", "fill%");
+    for (int num_clients = 1; num_clients <= 32; num_clients *= 2) {
+        // 每轮使用新的缓冲池，避免复用的fd命中上一轮残留的页面
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        rm_manager->create_file(BENCH_FILE_NAME, BENCH_RECORD_SIZE);
+        auto file_handle = rm_manager->open_file(BENCH_FILE_NAME);
+        std::vector<std::vector<Rid>> rids;
+        double insert_rate = run_inserts(file_handle.get(), num_clients, &rids);
+        int num_pages = file_handle->get_file_hdr().num_pages;
+
+        // 删除前半部分页面中的所有记录，之后的插入先填满这些页面，再分配新页面
+        int num_deleted = 0;
+        for (auto &client_rids : rids) {
+            for (auto &rid : client_rids) {
+                if (rid.page_no < num_pages / 2) {
+                    file_handle->delete_record(rid, nullptr);
+                    num_deleted++;
+                }
+            }
+        }
+        int inserted = BENCH_NUM_RECORDS / num_clients * num_clients;
+        double refill_rate = run_inserts(file_handle.get(), num_clients, &rids);
+        int refill_pages = file_handle->get_file_hdr().num_pages;
+        int num_records = 2 * inserted - num_deleted;
+        double fill = 100.0 * num_records /
+                      ((refill_pages - RM_FIRST_RECORD_PAGE) * file_handle->get_file_hdr().num_records_per_page);
+        printf("%-8d %14.0f %10d %14.0f %10d %8.1f\n", num_clients, insert_rate, num_pages, refill_rate, refill_pages,
+               fill);
+
+        rm_manager->close_file(file_handle.get());
+        rm_manager->destroy_file(BENCH_FILE_NAME);
+    }
+}
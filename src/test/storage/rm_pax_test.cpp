@@ -0,0 +1,170 @@
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+const std::string TEST_DB_NAME = "RmPaxTest_db";
+const std::string TEST_FILE_NAME = "pax_table";
+// 四个字段：id INT, name CHAR(16), score FLOAT, note CHAR(40)
+const std::vector<RmVarCol> TEST_COLS = {{0, 4}, {4, 16}, {20, 4}, {24, 40}};
+constexpr int TEST_RECORD_SIZE = 64;
+
+class RmPaxTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        rm_manager_->create_file(TEST_FILE_NAME, TEST_RECORD_SIZE, RM_LAYOUT_PAX, TEST_COLS);
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    static std::vector<char> make_record(int id) {
+        std::vector<char> record(TEST_RECORD_SIZE, 0);
+        std::string name = "name" + std::to_string(id);
+        float score = id * 0.5f;
+        std::string note = std::string(id % 40, static_cast<char>('a' + id % 26));
+        memcpy(record.data(), &id, sizeof(id));
+        memcpy(record.data() + 4, name.data(), name.size());
+        memcpy(record.data() + 20, &score, sizeof(score));
+        memcpy(record.data() + 24, note.data(), note.size());
+        return record;
+    }
+};
+
+/**
+ * @brief PAX格式与定长格式每页容纳的记录数相同；同一字段的值在页面中连续存放，记录的增删改查与rid寻址不变
+ */
+TEST_F(RmPaxTest, MinipageLayout) {
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    auto file_hdr = file_handle->get_file_hdr();
+    EXPECT_EQ(file_hdr.layout, RM_LAYOUT_PAX);
+    rm_manager_->create_file("fixed_table", TEST_RECORD_SIZE);
+    auto fixed_handle = rm_manager_->open_file("fixed_table");
+    EXPECT_EQ(file_hdr.num_records_per_page, fixed_handle->get_file_hdr().num_records_per_page);
+    rm_manager_->close_file(fixed_handle.get());
+
+    auto rid_less = [](const Rid &a, const Rid &b) {
+        return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+    };
+    std::map<Rid, std::vector<char>, bool (*)(const Rid &, const Rid &)> expected(rid_less);
+    for (int i = 0; i < 1000; i++) {
+        auto record = make_record(i);
+        expected[file_handle->insert_record(record.data(), nullptr)] = record;
+    }
+
+    // 第一个页面中id字段的minipage依次存放每条记录的id
+    RmPageHandle page_handle = file_handle->fetch_page_handle(RM_FIRST_RECORD_PAGE);
+    for (int slot_no = 0; slot_no < file_hdr.num_records_per_page; slot_no++) {
+        int id;
+        memcpy(&id, page_handle.slots + slot_no * sizeof(int), sizeof(int));
+        EXPECT_EQ(memcmp(expected.at(Rid{RM_FIRST_RECORD_PAGE, slot_no}).data(), &id, sizeof(int)), 0);
+        EXPECT_EQ(page_handle.get_field(TEST_COLS[1], slot_no),
+                  page_handle.slots + 4 * file_hdr.num_records_per_page + slot_no * 16);
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+
+    // 随机更新和删除后再插入
+    std::mt19937 rng(2023);
+    for (int i = 0; i < 1000; i++) {
+        auto it = expected.begin();
+        std::advance(it, rng() % expected.size());
+        if (rng() % 2 == 0) {
+            it->second = make_record(10000 + i);
+            file_handle->update_record(it->first, it->second.data(), nullptr);
+        } else {
+            file_handle->delete_record(it->first, nullptr);
+            EXPECT_FALSE(file_handle->is_record(it->first));
+            expected.erase(it);
+        }
+        if (rng() % 4 == 0) {
+            auto record = make_record(20000 + i);
+            Rid rid = file_handle->insert_record(record.data(), nullptr);
+            EXPECT_EQ(expected.count(rid), 0u);
+            expected[rid] = record;
+        }
+    }
+    for (auto &[rid, record] : expected) {
+        EXPECT_EQ(memcmp(file_handle->get_record(rid, nullptr)->data, record.data(), TEST_RECORD_SIZE), 0);
+        RmRecordView view = file_handle->get_record_view(rid, nullptr);
+        EXPECT_EQ(memcmp(view.get()->data, record.data(), TEST_RECORD_SIZE), 0);
+    }
+    size_t num_records = 0;
+    for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+        EXPECT_EQ(expected.count(scan.rid()), 1u);
+        num_records++;
+    }
+    EXPECT_EQ(num_records, expected.size());
+    rm_manager_->close_file(file_handle.get());
+
+    // 重新打开文件后字段的划分从文件头中读出
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    for (auto &[rid, record] : expected) {
+        EXPECT_EQ(memcmp(file_handle->get_record(rid, nullptr)->data, record.data(), TEST_RECORD_SIZE), 0);
+    }
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 批量扫描只取出需要的字段，批量插入按字段填充minipage
+ */
+TEST_F(RmPaxTest, ProjectedBatchScan) {
+    constexpr int NUM_RECORDS = 3000;
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    std::vector<char> records;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        auto record = make_record(i);
+        records.insert(records.end(), record.begin(), record.end());
+    }
+    std::vector<Rid> rids;
+    file_handle->bulk_insert_records(records.data(), NUM_RECORDS, &rids);
+    ASSERT_EQ((int)rids.size(), NUM_RECORDS);
+
+    // 不指定字段时取出完整的记录
+    int num_records = 0;
+    for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+        for (int i = 0; i < scan.size(); i++) {
+            EXPECT_EQ(scan.rid(i), rids[num_records]);
+            const char *expected = records.data() + (size_t)num_records * TEST_RECORD_SIZE;
+            EXPECT_EQ(memcmp(scan.record(i), expected, TEST_RECORD_SIZE), 0);
+            num_records++;
+        }
+    }
+    EXPECT_EQ(num_records, NUM_RECORDS);
+
+    // 只取出id和score
+    num_records = 0;
+    for (RmBatchScan scan(file_handle.get(), {TEST_COLS[0], TEST_COLS[2]}); scan.next_batch();) {
+        for (int i = 0; i < scan.size(); i++) {
+            const char *expected = records.data() + (size_t)num_records * TEST_RECORD_SIZE;
+            EXPECT_EQ(memcmp(scan.record(i), expected, 4), 0);
+            EXPECT_EQ(memcmp(scan.record(i) + 20, expected + 20, 4), 0);
+            num_records++;
+        }
+    }
+    EXPECT_EQ(num_records, NUM_RECORDS);
+    rm_manager_->close_file(file_handle.get());
+}
@@ -0,0 +1,172 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+constexpr int BENCH_RECORD_SIZE = 500;          // 每页可容纳8条记录
+constexpr int BENCH_NUM_RECORDS = 262144;       // 表文件约32768页，即128MB
+constexpr size_t BENCH_POOL_SIZE = 4096;        // 缓冲池远小于表文件，扫描总是冷读
+const std::string BENCH_DB_NAME = "RmScanBench_db";
+const std::string BENCH_FILE_NAME = "bench_table";
+constexpr int WARM_RECORD_SIZE = 64;            // 小记录，每页约60条
+constexpr int WARM_NUM_RECORDS = 262144;
+constexpr size_t WARM_POOL_SIZE = 8192;         // 小记录表完全放在缓冲池中
+const std::string WARM_FILE_NAME = "warm_table";
+
+/**
+ * @brief 冷缓存全表扫描的基准测试：比较逐页同步读取与RmScan的顺序预读
+ */
+class RmScanBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        rm_manager->create_file(BENCH_FILE_NAME, BENCH_RECORD_SIZE);
+        auto file_handle = rm_manager->open_file(BENCH_FILE_NAME);
+        std::vector<char> record(BENCH_RECORD_SIZE, 'x');
+        for (int i = 0; i < BENCH_NUM_RECORDS; i++) {
+            file_handle->insert_record(record.data(), nullptr);
+        }
+        fsync(file_handle->GetFd());
+        rm_manager->close_file(file_handle.get());
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 打开表文件并清除其在操作系统页缓存中的内容，对整个文件执行一次扫描，返回扫描速度（MB/s）
+     * @param read_ahead 为true时使用RmScan，否则按页号逐页fetch_page，即不带预读的扫描
+     */
+    double cold_scan(bool read_ahead, int *num_records) {
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        auto file_handle = rm_manager->open_file(BENCH_FILE_NAME);
+        int fd = file_handle->GetFd();
+        int num_pages = file_handle->get_file_hdr().num_pages;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+        *num_records = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (read_ahead) {
+            for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+                (*num_records)++;
+            }
+        } else {
+            for (int page_no = RM_FIRST_RECORD_PAGE; page_no < num_pages; page_no++) {
+                RmPageHandle page_handle = file_handle->fetch_page_handle(page_no);
+                *num_records += page_handle.page_hdr->num_records;
+                bpm->unpin_page(page_handle.page->get_page_id(), false);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        rm_manager->close_file(file_handle.get());
+        return static_cast<double>(num_pages) * PAGE_SIZE / (1 << 20) / elapsed.count();
+    }
+};
+
+TEST_F(RmScanBench, ColdFullScan) {
+    printf("%-24s %12s %12s\n", "scan", "records", "MB/s");
+    int num_records;
+    double mbps = cold_scan(false, &num_records);
+    EXPECT_EQ(BENCH_NUM_RECORDS, num_records);
+    printf("%-24s %12d %12.1f\n", "page-at-a-time", num_records, mbps);
+    mbps = cold_scan(true, &num_records);
+    EXPECT_EQ(BENCH_NUM_RECORDS, num_records);
+    printf("%-24s %12d %12.1f\n", "RmScan read-ahead", num_records, mbps);
+}
+
+/**
+ * @brief 热缓存全表扫描：比较逐条fetch页面的RmScan + get_record、RmScan + get_record_view和按页批量取出的RmBatchScan，
+ * fetches/rec为每条记录平均访问缓冲池的次数，即缓冲池latch的获取次数
+ */
+TEST_F(RmScanBench, WarmFullScan) {
+    auto bpm = std::make_unique<BufferPoolManager>(WARM_POOL_SIZE, disk_manager_.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+    rm_manager->create_file(WARM_FILE_NAME, WARM_RECORD_SIZE);
+    auto file_handle = rm_manager->open_file(WARM_FILE_NAME);
+    std::vector<char> record(WARM_RECORD_SIZE, 'w');
+    for (int i = 0; i < WARM_NUM_RECORDS; i++) {
+        file_handle->insert_record(record.data(), nullptr);
+    }
+
+    printf("%-28s %12s %14s %14s\n", "scan", "records", "records/s", "fetches/rec");
+    auto run = [&](const char *name, auto &&scan) {
+        auto before = bpm->get_stats();
+        auto start = std::chrono::steady_clock::now();
+        long checksum = 0;
+        int num_records = scan(&checksum);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto after = bpm->get_stats();
+        uint64_t fetches = after.get(BP_HIT) + after.get(BP_MISS) - before.get(BP_HIT) - before.get(BP_MISS);
+        EXPECT_EQ(num_records, WARM_NUM_RECORDS);
+        EXPECT_EQ(checksum, (long)'w' * WARM_NUM_RECORDS);
+        printf("%-28s %12d %14.0f %14.2f\n", name, num_records, num_records / elapsed.count(),
+               static_cast<double>(fetches) / num_records);
+    };
+    // 先完整扫描一遍，保证所有页面都在缓冲池中
+    run("warm-up", [&](long *checksum) {
+        int n = 0;
+        for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+            for (int i = 0; i < scan.size(); i++, n++) {
+                *checksum += scan.record(i)[0];
+            }
+        }
+        return n;
+    });
+    run("RmScan + get_record", [&](long *checksum) {
+        int n = 0;
+        for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next(), n++) {
+            *checksum += file_handle->get_record(scan.rid(), nullptr)->data[0];
+        }
+        return n;
+    });
+    run("RmScan + get_record_view", [&](long *checksum) {
+        int n = 0;
+        for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next(), n++) {
+            *checksum += file_handle->get_record_view(scan.rid(), nullptr).get()->data[0];
+        }
+        return n;
+    });
+    run("RmBatchScan", [&](long *checksum) {
+        int n = 0;
+        for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+            for (int i = 0; i < scan.size(); i++, n++) {
+                *checksum += scan.record(i)[0];
+            }
+        }
+        return n;
+    });
+    rm_manager->close_file(file_handle.get());
+}
@@ -0,0 +1,250 @@
+#include "record/rm_slotted_page.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+const std::string TEST_DB_NAME = "RmSlottedPageTest_db";
+const std::string TEST_FILE_NAME = "slotted_table";
+constexpr int TEST_ID_LEN = sizeof(int);
+constexpr int TEST_NAME_LEN = 1000;    // VARCHAR(1000)
+constexpr int TEST_RECORD_SIZE = TEST_ID_LEN + TEST_NAME_LEN;
+
+/**
+ * @brief 删除和更新留下的碎片在空间不足时被压缩整理，slot号保持不变，空slot被复用
+ */
+TEST(RmSlottedPageTest, CompactKeepsSlots) {
+    std::vector<char> data(PAGE_SIZE, 0);
+    RmSlottedPage page(data.data());
+    page.init();
+    int free_space = page.get_free_space();
+    EXPECT_EQ(free_space, RmSlottedPage::MAX_RECORD_SIZE + (int)sizeof(RmSlot));
+
+    // 填满页面：每条记录400字节
+    std::vector<std::string> records;
+    while (true) {
+        std::string record(400, static_cast<char>('a' + records.size()));
+        int slot_no = page.find_free_slot(record.size());
+        if (slot_no == -1) {
+            break;
+        }
+        EXPECT_EQ(slot_no, (int)records.size());
+        page.insert(slot_no, record.data(), record.size());
+        records.push_back(record);
+    }
+    ASSERT_GE(records.size(), 4u);
+
+    // 删除中间的两条记录后，空闲空间只以碎片的形式存在，插入一条更长的记录需要压缩整理
+    page.erase(1);
+    page.erase(2);
+    std::string longer(700, 'z');
+    int slot_no = page.find_free_slot(longer.size());
+    EXPECT_EQ(slot_no, 1);
+    page.insert(slot_no, longer.data(), longer.size());
+    records[1] = longer;
+    EXPECT_EQ(page.find_free_slot(1), 2);
+
+    // 原地变长和变短
+    std::string grown(450, 'y');
+    EXPECT_TRUE(page.update(0, grown.data(), grown.size()));
+    records[0] = grown;
+    std::string shrunk(10, 'x');
+    EXPECT_TRUE(page.update(3, shrunk.data(), shrunk.size()));
+    records[3] = shrunk;
+    std::string too_long(RmSlottedPage::MAX_RECORD_SIZE, 'w');
+    EXPECT_FALSE(page.update(3, too_long.data(), too_long.size()));
+
+    for (int i = 0; i < (int)records.size(); i++) {
+        if (i == 2) {
+            EXPECT_FALSE(page.is_used(i));
+            continue;
+        }
+        int len;
+        char *record = page.get_record(i, &len);
+        ASSERT_NE(record, nullptr);
+        EXPECT_EQ(std::string(record, len), records[i]);
+    }
+
+    // 删除所有记录后页面恢复为空
+    for (int i = 0; i < (int)records.size(); i++) {
+        if (page.is_used(i)) {
+            page.erase(i);
+        }
+    }
+    EXPECT_EQ(page.get_num_slots(), 0);
+    EXPECT_EQ(page.get_free_space(), free_space);
+}
+
+class RmSlottedFileTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        rm_manager_->create_file(TEST_FILE_NAME, TEST_RECORD_SIZE, RM_LAYOUT_SLOTTED,
+                                 {RmVarCol{TEST_ID_LEN, TEST_NAME_LEN}});
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    static std::vector<char> make_record(int id, const std::string &name) {
+        std::vector<char> record(TEST_RECORD_SIZE, 0);
+        memcpy(record.data(), &id, sizeof(id));
+        memcpy(record.data() + TEST_ID_LEN, name.data(), name.size());
+        return record;
+    }
+
+    static void check_record(const RmRecord &record, int id, const std::string &name) {
+        ASSERT_EQ(record.size, TEST_RECORD_SIZE);
+        EXPECT_EQ(*reinterpret_cast<const int *>(record.data), id);
+        EXPECT_EQ(std::string(record.data + TEST_ID_LEN), name);
+        // VARCHAR在内存中与CHAR一样补0到最大长度
+        for (int i = TEST_ID_LEN + name.size(); i < TEST_RECORD_SIZE; i++) {
+            ASSERT_EQ(record.data[i], 0);
+        }
+    }
+};
+
+/**
+ * @brief 短的VARCHAR只占用实际长度，一个页面中能放下远多于定长格式的记录；记录在读出时恢复为定长
+ */
+TEST_F(RmSlottedFileTest, VarcharRoundTrip) {
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    EXPECT_EQ(file_handle->get_file_hdr().layout, RM_LAYOUT_SLOTTED);
+    std::map<int, std::pair<Rid, std::string>> expected;
+    for (int i = 0; i < 1000; i++) {
+        std::string name = "name" + std::to_string(i);
+        auto record = make_record(i, name);
+        expected[i] = {file_handle->insert_record(record.data(), nullptr), name};
+    }
+    // 定长格式下每页只能放4条记录
+    EXPECT_LT(file_handle->get_file_hdr().num_pages, 1000 / 4 / 10);
+
+    for (auto &[id, entry] : expected) {
+        check_record(*file_handle->get_record(entry.first, nullptr), id, entry.second);
+    }
+    rm_manager_->close_file(file_handle.get());
+
+    // 重新打开文件后变长字段的定义从文件头中读出
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    int num_records = 0;
+    for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+        auto record = file_handle->get_record(scan.rid(), nullptr);
+        int id = *reinterpret_cast<int *>(record->data);
+        EXPECT_EQ(expected[id].first, scan.rid());
+        check_record(*record, id, expected[id].second);
+        num_records++;
+    }
+    EXPECT_EQ(num_records, 1000);
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 变长后本页面放不下的记录被移到其他页面，原位置留下转发项，rid保持不变，扫描时每条记录只出现一次
+ */
+TEST_F(RmSlottedFileTest, UpdateForwarding) {
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    std::vector<Rid> rids;
+    std::vector<std::string> names;
+    for (int i = 0; i < 100; i++) {
+        names.push_back(std::string(20, static_cast<char>('a' + i % 26)));
+        auto record = make_record(i, names.back());
+        rids.push_back(file_handle->insert_record(record.data(), nullptr));
+    }
+    ASSERT_EQ(rids.front().page_no, rids.back().page_no);
+
+    // 同一页面上的记录依次变长，页面放不下后记录被移走
+    for (int i = 0; i < 20; i++) {
+        names[i] = std::string(TEST_NAME_LEN - i, static_cast<char>('A' + i));
+        auto record = make_record(i, names[i]);
+        file_handle->update_record(rids[i], record.data(), nullptr);
+    }
+    EXPECT_GT(file_handle->get_file_hdr().num_pages, RM_FIRST_RECORD_PAGE + 1);
+    // 已被移走的记录再次变长和变短
+    for (int i = 0; i < 20; i += 2) {
+        names[i] = i % 4 == 0 ? std::string(TEST_NAME_LEN, '#') : "short";
+        auto record = make_record(i, names[i]);
+        file_handle->update_record(rids[i], record.data(), nullptr);
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(file_handle->is_record(rids[i]));
+        check_record(*file_handle->get_record(rids[i], nullptr), i, names[i]);
+    }
+
+    std::vector<bool> seen(100, false);
+    for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+        auto record = file_handle->get_record(scan.rid(), nullptr);
+        int id = *reinterpret_cast<int *>(record->data);
+        EXPECT_EQ(scan.rid(), rids[id]);
+        EXPECT_FALSE(seen[id]);
+        seen[id] = true;
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 100);
+
+    // 批量扫描时被移走的记录从其新位置读出，仍以原来的rid出现在原页面的批次中
+    seen.assign(100, false);
+    for (RmBatchScan scan(file_handle.get()); scan.next_batch();) {
+        for (int i = 0; i < scan.size(); i++) {
+            RmRecord record(TEST_RECORD_SIZE, scan.record(i));
+            int id = *reinterpret_cast<int *>(record.data);
+            EXPECT_EQ(scan.rid(i), rids[id]);
+            check_record(record, id, names[id]);
+            EXPECT_FALSE(seen[id]);
+            seen[id] = true;
+        }
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 100);
+
+    // 删除被移走的记录时同时释放其转发项和移动后的位置
+    for (int i = 0; i < 100; i++) {
+        file_handle->delete_record(rids[i], nullptr);
+        EXPECT_FALSE(file_handle->is_record(rids[i]));
+        EXPECT_THROW(file_handle->get_record(rids[i], nullptr), RecordNotFoundError);
+    }
+    RmScan scan(file_handle.get());
+    EXPECT_TRUE(scan.is_end());
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_handle->get_file_hdr().num_pages; page_no++) {
+        EXPECT_EQ(file_handle->get_free_space(page_no), RmSlottedPage::MAX_RECORD_SIZE + (int)sizeof(RmSlot));
+    }
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 超过页面容量的记录长度在建表时被拒绝
+ */
+TEST_F(RmSlottedFileTest, MaxRecordSize) {
+    int max_size = RmManager::get_max_record_size(RM_LAYOUT_SLOTTED, 0);
+    EXPECT_NO_THROW(rm_manager_->create_file("max_table", max_size, RM_LAYOUT_SLOTTED));
+    EXPECT_THROW(rm_manager_->create_file("too_large", max_size + 1, RM_LAYOUT_SLOTTED), InvalidRecordSizeError);
+
+    auto file_handle = rm_manager_->open_file("max_table");
+    std::vector<char> record(max_size, 'm');
+    Rid rid0 = file_handle->insert_record(record.data(), nullptr);
+    Rid rid1 = file_handle->insert_record(record.data(), nullptr);
+    EXPECT_NE(rid0.page_no, rid1.page_no);
+    EXPECT_EQ(memcmp(file_handle->get_record(rid1, nullptr)->data, record.data(), max_size), 0);
+    rm_manager_->close_file(file_handle.get());
+}
@@ -0,0 +1,189 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/ix.h"
+#include "record/rm.h"
+#include "system/sm.h"
+
+const std::string TEST_DB_NAME = "RmVacuumTest_db";
+const std::string TEST_FILE_NAME = "vacuum_table";
+const std::vector<std::string> TEST_COL = {"id"};
+constexpr int TEST_NAME_LEN = 500;
+
+class RmVacuumTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+    std::unique_ptr<SmManager> sm_;
+    std::unique_ptr<LockManager> lock_mgr_;
+    std::unique_ptr<Transaction> txn_;
+    std::unique_ptr<Context> context_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        sm_ = std::make_unique<SmManager>(disk_manager_.get(), buffer_pool_manager_.get(), rm_manager_.get(),
+                                          ix_manager_.get());
+        lock_mgr_ = std::make_unique<LockManager>();
+        txn_ = std::make_unique<Transaction>(0);
+        context_ = std::make_unique<Context>(lock_mgr_.get(), nullptr, txn_.get());
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        sm_->create_db(TEST_DB_NAME);
+        sm_->open_db(TEST_DB_NAME);
+    }
+
+    void TearDown() override {
+        sm_->close_db();
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    void create_table(RmLayout layout) {
+        std::vector<ColDef> col_defs = {{"id", TYPE_INT, 4}, {"name", TYPE_STRING, TEST_NAME_LEN, true}};
+        sm_->create_table(TEST_FILE_NAME, col_defs, context_.get(), layout);
+        sm_->create_index(TEST_FILE_NAME, TEST_COL, context_.get());
+    }
+
+    RmFileHandle *fh() { return sm_->fhs_.at(TEST_FILE_NAME).get(); }
+
+    IxIndexHandle *ih() { return sm_->ihs_.at(ix_manager_->get_index_name(TEST_FILE_NAME, TEST_COL)).get(); }
+
+    static std::vector<char> make_record(int id, const std::string &name) {
+        std::vector<char> record(sizeof(int) + TEST_NAME_LEN, 0);
+        memcpy(record.data(), &id, sizeof(id));
+        memcpy(record.data() + sizeof(int), name.data(), name.size());
+        return record;
+    }
+
+    Rid insert(int id, const std::string &name) {
+        auto record = make_record(id, name);
+        Rid rid = fh()->insert_record(record.data(), nullptr);
+        ih()->insert_entry(reinterpret_cast<const char *>(&id), rid, nullptr);
+        return rid;
+    }
+
+    void erase(int id, const Rid &rid) {
+        fh()->delete_record(rid, nullptr);
+        ih()->delete_entry(reinterpret_cast<const char *>(&id), nullptr);
+    }
+
+    /**
+     * @brief 通过索引找到每条记录，记录内容正确；扫描得到的记录条数与预期一致
+     */
+    void check_records(const std::map<int, std::string> &expected) {
+        for (auto &[id, name] : expected) {
+            std::vector<Rid> result;
+            ASSERT_TRUE(ih()->get_value(reinterpret_cast<const char *>(&id), &result, nullptr));
+            auto record = fh()->get_record(result.front(), nullptr);
+            EXPECT_EQ(*reinterpret_cast<int *>(record->data), id);
+            const char *data = record->data + sizeof(int);
+            EXPECT_EQ(std::string(data, strnlen(data, TEST_NAME_LEN)), name);
+        }
+        size_t num_records = 0;
+        for (RmScan scan(fh()); !scan.is_end(); scan.next()) {
+            num_records++;
+        }
+        EXPECT_EQ(num_records, expected.size());
+    }
+};
+
+/**
+ * @brief 定长格式：大量删除后整理，记录集中到文件前部，文件被截断，索引指向记录的新位置；整理后可以继续插入
+ */
+TEST_F(RmVacuumTest, FixedLayout) {
+    constexpr int NUM_RECORDS = 4000;
+    create_table(RM_LAYOUT_FIXED);
+    std::map<int, std::string> expected;
+    std::vector<Rid> rids;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        expected[i] = "name" + std::to_string(i);
+        rids.push_back(insert(i, expected[i]));
+    }
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        if (i % 4 != 0) {
+            erase(i, rids[i]);
+            expected.erase(i);
+        }
+    }
+    int num_pages = fh()->get_file_hdr().num_pages;
+
+    sm_->vacuum_table(TEST_FILE_NAME, context_.get());
+    int num_records_per_page = fh()->get_file_hdr().num_records_per_page;
+    int min_pages = ((int)expected.size() + num_records_per_page - 1) / num_records_per_page;
+    EXPECT_EQ(fh()->get_file_hdr().num_pages, RM_FIRST_RECORD_PAGE + min_pages);
+    EXPECT_LT(fh()->get_file_hdr().num_pages, num_pages / 2);
+    EXPECT_EQ(disk_manager_->get_file_size(TEST_FILE_NAME), fh()->get_file_hdr().num_pages * PAGE_SIZE);
+    // 磁盘上的文件头已经更新
+    RmFileHdr file_hdr;
+    disk_manager_->read_page(fh()->GetFd(), RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
+    EXPECT_EQ(file_hdr.num_pages, fh()->get_file_hdr().num_pages);
+    check_records(expected);
+
+    // 整理后的空闲空间映射与文件一致，新记录从截断后的末尾继续分配页面
+    for (int i = NUM_RECORDS; i < NUM_RECORDS + 100; i++) {
+        expected[i] = "new" + std::to_string(i);
+        EXPECT_LT(insert(i, expected[i]).page_no, RM_FIRST_RECORD_PAGE + min_pages + 100);
+    }
+    check_records(expected);
+}
+
+/**
+ * @brief slotted格式：被移到其他页面的记录随整理回到原位置或更靠前的页面，原rid保持不变；rid改变的记录的索引项被更新
+ */
+TEST_F(RmVacuumTest, SlottedLayout) {
+    constexpr int NUM_RECORDS = 2000;
+    create_table(RM_LAYOUT_SLOTTED);
+    std::map<int, std::string> expected;
+    std::vector<Rid> rids;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        expected[i] = "name" + std::to_string(i);
+        rids.push_back(insert(i, expected[i]));
+    }
+    // 变长的记录被移到文件末尾的新页面
+    for (int i = 0; i < NUM_RECORDS; i += 10) {
+        expected[i] = std::string(TEST_NAME_LEN - 1 - i % 7, static_cast<char>('a' + i % 26));
+        auto record = make_record(i, expected[i]);
+        fh()->update_record(rids[i], record.data(), nullptr);
+    }
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        if (i % 10 != 0 && i % 3 != 0) {
+            erase(i, rids[i]);
+            expected.erase(i);
+        }
+    }
+    int num_pages = fh()->get_file_hdr().num_pages;
+
+    sm_->vacuum_table(TEST_FILE_NAME, context_.get());
+    EXPECT_LT(fh()->get_file_hdr().num_pages, num_pages);
+    EXPECT_EQ(disk_manager_->get_file_size(TEST_FILE_NAME), fh()->get_file_hdr().num_pages * PAGE_SIZE);
+    check_records(expected);
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < fh()->get_file_hdr().num_pages; page_no++) {
+        EXPECT_LE(fh()->get_free_space(page_no), RmSlottedPage::MAX_RECORD_SIZE);
+    }
+
+    // 整理后的记录仍然可以更新和删除
+    for (auto it = expected.begin(); it != expected.end();) {
+        std::vector<Rid> result;
+        int id = it->first;
+        ASSERT_TRUE(ih()->get_value(reinterpret_cast<const char *>(&id), &result, nullptr));
+        if (id % 2 == 0) {
+            erase(id, result.front());
+            it = expected.erase(it);
+        } else {
+            it->second = std::string(TEST_NAME_LEN, '#');
+            auto record = make_record(id, it->second);
+            fh()->update_record(result.front(), record.data(), nullptr);
+            ++it;
+        }
+    }
+    check_records(expected);
+}
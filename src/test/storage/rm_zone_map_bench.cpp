@@ -0,0 +1,134 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+constexpr int BENCH_RECORD_SIZE = 128;          // ts INT, value FLOAT, payload CHAR(120)，每页约31条记录
+constexpr int BENCH_NUM_RECORDS = 1 << 20;      // 表文件约34000页，即130MB
+constexpr size_t BENCH_POOL_SIZE = 4096;        // 缓冲池远小于表文件，扫描总是冷读
+const std::string BENCH_DB_NAME = "RmZoneMapBench_db";
+const std::string BENCH_FILE_NAME = "events";
+const std::vector<RmZoneCol> BENCH_ZONE_COLS = {{0, TYPE_INT}, {4, TYPE_FLOAT}};
+
+/**
+ * @brief 按时间顺序追加的事件表上的范围查询：比较不使用zone map的全表扫描与按zone map跳过页面的扫描。
+ * ts随插入顺序递增，value是与插入顺序无关的随机值，作为zone map难以跳过页面的对照
+ */
+class RmZoneMapBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(BENCH_DB_NAME)) {
+            disk_manager_->destroy_dir(BENCH_DB_NAME);
+        }
+        disk_manager_->create_dir(BENCH_DB_NAME);
+        if (chdir(BENCH_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        rm_manager->create_file(BENCH_FILE_NAME, BENCH_RECORD_SIZE);
+        auto file_handle = rm_manager->open_file(BENCH_FILE_NAME, BENCH_ZONE_COLS);
+        std::vector<char> record(BENCH_RECORD_SIZE, 'p');
+        uint32_t seed = 2023;
+        for (int ts = 0; ts < BENCH_NUM_RECORDS; ts++) {
+            seed = seed * 1103515245 + 12345;
+            float value = (seed >> 8) % 10000 / 100.0f;
+            memcpy(record.data(), &ts, sizeof(ts));
+            memcpy(record.data() + 4, &value, sizeof(value));
+            file_handle->insert_record(record.data(), nullptr);
+        }
+        fsync(file_handle->GetFd());
+        rm_manager->close_file(file_handle.get());
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(BENCH_DB_NAME);
+    }
+
+    /**
+     * @brief 冷缓存下按preds扫描整个表，逐条检查谓词，返回满足条件的记录数
+     * @param use_zone_map 为false时不把谓词交给RmBatchScan，即逐页读取所有页面
+     */
+    static int count_matches(RmFileHandle *file_handle, const std::vector<RmZonePredicate> &preds, bool use_zone_map,
+                             int *num_pages) {
+        int num_matches = 0;
+        *num_pages = 0;
+        for (RmBatchScan scan(file_handle, {}, use_zone_map ? preds : std::vector<RmZonePredicate>());
+             scan.next_batch();) {
+            (*num_pages)++;
+            for (int i = 0; i < scan.size(); i++) {
+                const char *record = scan.record(i);
+                bool match = true;
+                for (auto &pred : preds) {
+                    double value = pred.offset == 0 ? *reinterpret_cast<const int *>(record)
+                                                    : *reinterpret_cast<const float *>(record + 4);
+                    match = match && (pred.op == OP_GE ? value >= pred.value : value < pred.value);
+                }
+                num_matches += match;
+            }
+        }
+        return num_matches;
+    }
+
+    /**
+     * @brief 打开表文件并清除其在操作系统页缓存中的内容，执行一次扫描，打印读取的页面数和耗时
+     */
+    void run(const char *name, const std::vector<RmZonePredicate> &preds, bool use_zone_map, int expected) {
+        auto bpm = std::make_unique<BufferPoolManager>(BENCH_POOL_SIZE, disk_manager_.get());
+        auto rm_manager = std::make_unique<RmManager>(disk_manager_.get(), bpm.get());
+        auto file_handle = rm_manager->open_file(BENCH_FILE_NAME, BENCH_ZONE_COLS);
+        // 第一次使用时读取保存的zone map，不计入扫描时间
+        file_handle->page_may_match(RM_FIRST_RECORD_PAGE, preds);
+        posix_fadvise(file_handle->GetFd(), 0, 0, POSIX_FADV_DONTNEED);
+
+        int num_pages;
+        auto start = std::chrono::steady_clock::now();
+        int num_matches = count_matches(file_handle.get(), preds, use_zone_map, &num_pages);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (expected >= 0) {
+            EXPECT_EQ(num_matches, expected);
+        }
+        printf("%-36s %12d %12d %12.2f\n", name, num_matches, num_pages, elapsed.count() * 1000);
+        rm_manager->close_file(file_handle.get());
+    }
+};
+
+TEST_F(RmZoneMapBench, TimeRangeScan) {
+    printf("%-36s %12s %12s %12s\n", "query", "matches", "pages read", "ms");
+    for (int percent : {1, 10, 50}) {
+        int lo = BENCH_NUM_RECORDS - BENCH_NUM_RECORDS / 100 * percent;
+        std::vector<RmZonePredicate> preds = {{0, OP_GE, (double)lo}, {0, OP_LT, (double)BENCH_NUM_RECORDS}};
+        char name[64];
+        snprintf(name, sizeof(name), "ts in last %d%%, full scan", percent);
+        run(name, preds, false, BENCH_NUM_RECORDS - lo);
+        snprintf(name, sizeof(name), "ts in last %d%%, zone map", percent);
+        run(name, preds, true, BENCH_NUM_RECORDS - lo);
+    }
+    // 与插入顺序无关的字段上，每个页面的范围覆盖大部分取值，只有最大值低于下界的页面能被跳过
+    std::vector<RmZonePredicate> preds = {{4, OP_GE, 99.0}};
+    run("value >= 99, full scan", preds, false, -1);
+    run("value >= 99, zone map", preds, true, -1);
+}
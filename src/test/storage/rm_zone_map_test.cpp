@@ -0,0 +1,248 @@
+#include <cmath>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "record/rm_scan.h"
+
+const std::string TEST_DB_NAME = "RmZoneMapTest_db";
+const std::string TEST_FILE_NAME = "zone_table";
+// 三个字段：ts INT, val FLOAT, note CHAR(56)
+const std::vector<RmZoneCol> TEST_ZONE_COLS = {{0, TYPE_INT}, {4, TYPE_FLOAT}};
+constexpr int TEST_RECORD_SIZE = 64;
+constexpr int TEST_NUM_RECORDS = 5000;
+
+class RmZoneMapTest : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        disk_manager_->destroy_dir(TEST_DB_NAME);
+    }
+
+    static std::vector<char> make_record(int ts, float val) {
+        std::vector<char> record(TEST_RECORD_SIZE, 0);
+        memcpy(record.data(), &ts, sizeof(ts));
+        memcpy(record.data() + 4, &val, sizeof(val));
+        return record;
+    }
+
+    /**
+     * @brief 按时间顺序插入记录，ts依次递增，val = ts / 2
+     */
+    std::vector<Rid> insert_time_ordered(RmFileHandle *file_handle) {
+        std::vector<Rid> rids;
+        for (int ts = 0; ts < TEST_NUM_RECORDS; ts++) {
+            auto record = make_record(ts, ts / 2.0f);
+            rids.push_back(file_handle->insert_record(record.data(), nullptr));
+        }
+        return rids;
+    }
+
+    /**
+     * @brief 带谓词批量扫描，返回满足ts范围[lo, hi)的所有ts，num_batches为扫描读取的页面个数
+     */
+    static std::multiset<int> scan_range(RmFileHandle *file_handle, int lo, int hi, int *num_batches) {
+        std::multiset<int> result;
+        *num_batches = 0;
+        std::vector<RmZonePredicate> preds = {{0, OP_GE, (double)lo}, {0, OP_LT, (double)hi}};
+        for (RmBatchScan scan(file_handle, {}, preds); scan.next_batch();) {
+            (*num_batches)++;
+            for (int i = 0; i < scan.size(); i++) {
+                int ts = *reinterpret_cast<int *>(scan.record(i));
+                if (ts >= lo && ts < hi) {
+                    result.insert(ts);
+                }
+            }
+        }
+        return result;
+    }
+
+    static std::multiset<int> make_range(int lo, int hi) {
+        std::multiset<int> range;
+        for (int ts = lo; ts < hi; ts++) {
+            range.insert(ts);
+        }
+        return range;
+    }
+};
+
+/**
+ * @brief 按时间顺序插入的表上，范围谓词只读取范围所在的页面；更新会扩大页面的范围，删除不会缩小范围
+ */
+TEST_F(RmZoneMapTest, PageSkipping) {
+    rm_manager_->create_file(TEST_FILE_NAME, TEST_RECORD_SIZE);
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME, TEST_ZONE_COLS);
+    auto rids = insert_time_ordered(file_handle.get());
+    int num_records_per_page = file_handle->get_file_hdr().num_records_per_page;
+    int num_pages = file_handle->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE;
+
+    int num_batches;
+    EXPECT_EQ(scan_range(file_handle.get(), 4000, 4100, &num_batches), make_range(4000, 4100));
+    EXPECT_LE(num_batches, 100 / num_records_per_page + 2);
+    EXPECT_EQ(scan_range(file_handle.get(), 0, TEST_NUM_RECORDS, &num_batches), make_range(0, TEST_NUM_RECORDS));
+    EXPECT_EQ(num_batches, num_pages);
+    EXPECT_TRUE(scan_range(file_handle.get(), TEST_NUM_RECORDS, TEST_NUM_RECORDS + 10, &num_batches).empty());
+    EXPECT_EQ(num_batches, 0);
+
+    // FLOAT字段上的等值和不等谓词
+    int matched = 0;
+    for (RmBatchScan scan(file_handle.get(), {}, {{4, OP_EQ, 100.0}}); scan.next_batch();) {
+        matched++;
+    }
+    EXPECT_EQ(matched, 1);
+    for (RmBatchScan scan(file_handle.get(), {}, {{4, OP_NE, 100.0}}); scan.next_batch();) {
+        matched++;
+    }
+    EXPECT_EQ(matched, 1 + num_pages);
+
+    // 第一个页面中的记录被更新到查询范围内
+    auto record = make_record(4050, 0);
+    file_handle->update_record(rids[0], record.data(), nullptr);
+    auto expected = make_range(4000, 4100);
+    expected.insert(4050);
+    EXPECT_EQ(scan_range(file_handle.get(), 4000, 4100, &num_batches), expected);
+
+    // 删除后页面的范围不缩小，扫描结果仍然正确
+    file_handle->delete_record(rids[0], nullptr);
+    expected.erase(expected.find(4050));
+    EXPECT_EQ(scan_range(file_handle.get(), 4000, 4100, &num_batches), expected);
+
+    // 出现NaN的页面不再按FLOAT字段跳过
+    record = make_record(-1, std::numeric_limits<float>::quiet_NaN());
+    Rid rid = file_handle->insert_record(record.data(), nullptr);
+    matched = 0;
+    for (RmBatchScan scan(file_handle.get(), {}, {{4, OP_LT, -100.0}}); scan.next_batch();) {
+        EXPECT_EQ(scan.rid(0).page_no, rid.page_no);
+        matched++;
+    }
+    EXPECT_EQ(matched, 1);
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief 关闭文件时保存zone map，打开后第一次使用时读取并删除；保存的文件缺失或字段不一致时扫描页面重建。
+ * 批量插入同样维护zone map，没有指定字段的表不建立zone map
+ */
+TEST_F(RmZoneMapTest, SaveAndRebuild) {
+    rm_manager_->create_file(TEST_FILE_NAME, TEST_RECORD_SIZE, RM_LAYOUT_PAX,
+                             {RmVarCol{0, 4}, RmVarCol{4, 4}, RmVarCol{8, 56}});
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME, TEST_ZONE_COLS);
+    std::vector<char> records;
+    for (int ts = 0; ts < TEST_NUM_RECORDS; ts++) {
+        auto record = make_record(ts, ts / 2.0f);
+        records.insert(records.end(), record.begin(), record.end());
+    }
+    std::vector<Rid> rids;
+    file_handle->bulk_insert_records(records.data(), TEST_NUM_RECORDS, &rids);
+    int num_batches;
+    EXPECT_EQ(scan_range(file_handle.get(), 1000, 1010, &num_batches), make_range(1000, 1010));
+    EXPECT_LE(num_batches, 2);
+    rm_manager_->close_file(file_handle.get());
+    const std::string zone_map_file = TEST_FILE_NAME + RM_ZONE_MAP_FILE_SUFFIX;
+    EXPECT_TRUE(disk_manager_->is_file(zone_map_file));
+
+    // 读取保存的zone map
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME, TEST_ZONE_COLS);
+    EXPECT_EQ(scan_range(file_handle.get(), 2500, 2600, &num_batches), make_range(2500, 2600));
+    EXPECT_LE(num_batches, 100 / file_handle->get_file_hdr().num_records_per_page + 2);
+    EXPECT_FALSE(disk_manager_->is_file(zone_map_file));
+    auto record = make_record(7, 0);
+    file_handle->update_record(rids.back(), record.data(), nullptr);
+    rm_manager_->close_file(file_handle.get());
+
+    // 模拟崩溃后保存的文件缺失：扫描页面重建，包括最后一次更新的值
+    disk_manager_->destroy_file(zone_map_file);
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME, TEST_ZONE_COLS);
+    auto expected = make_range(0, 10);
+    expected.insert(7);
+    EXPECT_EQ(scan_range(file_handle.get(), 0, 10, &num_batches), expected);
+    EXPECT_EQ(num_batches, 2);
+    rm_manager_->close_file(file_handle.get());
+
+    // 字段与保存的文件不一致时重建
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME, {TEST_ZONE_COLS[0]});
+    EXPECT_EQ(scan_range(file_handle.get(), 0, 10, &num_batches), expected);
+    EXPECT_EQ(num_batches, 2);
+    rm_manager_->close_file(file_handle.get());
+
+    // 没有建立zone map时不跳过任何页面
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME);
+    EXPECT_EQ(scan_range(file_handle.get(), 0, 10, &num_batches), expected);
+    EXPECT_EQ(num_batches, file_handle->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE);
+    rm_manager_->close_file(file_handle.get());
+}
+
+/**
+ * @brief slotted格式下被移到其他页面的记录计入其rid所在的页面；整理数据文件后按记录的新位置重建zone map
+ */
+TEST_F(RmZoneMapTest, SlottedAndCompact) {
+    constexpr int NAME_LEN = 1000;
+    rm_manager_->create_file(TEST_FILE_NAME, 4 + NAME_LEN, RM_LAYOUT_SLOTTED, {RmVarCol{4, NAME_LEN}});
+    auto file_handle = rm_manager_->open_file(TEST_FILE_NAME, {TEST_ZONE_COLS[0]});
+    std::vector<Rid> rids;
+    std::vector<char> record(4 + NAME_LEN, 0);
+    for (int id = 0; id < 1000; id++) {
+        memcpy(record.data(), &id, sizeof(id));
+        rids.push_back(file_handle->insert_record(record.data(), nullptr));
+    }
+    // 第一个页面上的记录变长后被移到文件末尾的页面
+    ASSERT_EQ(rids[10].page_no, RM_FIRST_RECORD_PAGE);
+    for (int id = 0; id < 20; id++) {
+        memcpy(record.data(), &id, sizeof(id));
+        memset(record.data() + 4, 'a' + id % 26, NAME_LEN);
+        file_handle->update_record(rids[id], record.data(), nullptr);
+    }
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    int num_batches;
+    EXPECT_EQ(scan_range(file_handle.get(), 10, 11, &num_batches), make_range(10, 11));
+    EXPECT_EQ(num_batches, 1);
+
+    // 重建后的zone map同样把移走的记录计入原页面
+    rm_manager_->close_file(file_handle.get());
+    disk_manager_->destroy_file(TEST_FILE_NAME + RM_ZONE_MAP_FILE_SUFFIX);
+    file_handle = rm_manager_->open_file(TEST_FILE_NAME, {TEST_ZONE_COLS[0]});
+    EXPECT_EQ(scan_range(file_handle.get(), 10, 11, &num_batches), make_range(10, 11));
+    EXPECT_EQ(num_batches, 1);
+
+    // 删除大部分记录后整理，记录移到前面的页面
+    std::set<int> remaining;
+    for (int id = 0; id < 1000; id++) {
+        if (id % 50 == 0) {
+            remaining.insert(id);
+        } else {
+            file_handle->delete_record(rids[id], nullptr);
+        }
+    }
+    std::vector<std::pair<Rid, Rid>> moves;
+    file_handle->compact(&moves);
+    EXPECT_GT(file_handle->truncate_empty_pages(), 0);
+    EXPECT_LT(file_handle->get_file_hdr().num_pages, num_pages);
+    for (int id : remaining) {
+        EXPECT_EQ(scan_range(file_handle.get(), id, id + 1, &num_batches), make_range(id, id + 1));
+    }
+    rm_manager_->close_file(file_handle.get());
+}
@@ -0,0 +1,75 @@
+#include "storage/stats.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 多个线程同时计数，读取到的总和与计数次数一致
+ */
+TEST(StatsTest, ShardedCountersTest) {
+    constexpr int NUM_THREADS = 8;
+    constexpr int NUM_ADDS = 100000;
+    BufferPoolCounters counters;
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < NUM_THREADS; tid++) {
+        threads.emplace_back([&counters]() {
+            for (int i = 0; i < NUM_ADDS; i++) {
+                counters.add(BP_HIT);
+                if (i % 4 == 0) {
+                    counters.add(BP_MISS, 2);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    BufferPoolStats stats{counters.snapshot()};
+    EXPECT_EQ(stats.get(BP_HIT), static_cast<uint64_t>(NUM_THREADS) * NUM_ADDS);
+    EXPECT_EQ(stats.get(BP_MISS), static_cast<uint64_t>(NUM_THREADS) * NUM_ADDS / 2);
+    EXPECT_EQ(stats.get(BP_EVICTION), 0u);
+    EXPECT_DOUBLE_EQ(stats.hit_ratio(), 2.0 / 3);
+
+    counters.reset();
+    EXPECT_EQ(counters.get(BP_HIT), 0u);
+}
+
+/**
+ * @brief 桶的划分：每个延迟落在以其下界开始的桶中，相邻桶的下界单调递增，相对误差不超过25%
+ */
+TEST(StatsTest, HistogramBucketTest) {
+    for (uint64_t ns : {0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 100ull, 1000ull, 123456ull, 987654321ull}) {
+        size_t bucket = LatencyHistogram::bucket_of(ns);
+        uint64_t lower = LatencyHistogram::bucket_lower_bound(bucket);
+        uint64_t upper = LatencyHistogram::bucket_lower_bound(bucket + 1);
+        EXPECT_LE(lower, ns);
+        EXPECT_LT(ns, upper);
+        EXPECT_LE(upper - lower, std::max<uint64_t>(1, lower / 4));
+    }
+    for (size_t bucket = 0; bucket + 1 < LatencyHistogram::NUM_BUCKETS; bucket++) {
+        EXPECT_EQ(bucket, LatencyHistogram::bucket_of(LatencyHistogram::bucket_lower_bound(bucket)));
+        EXPECT_LT(LatencyHistogram::bucket_lower_bound(bucket), LatencyHistogram::bucket_lower_bound(bucket + 1));
+    }
+}
+
+/**
+ * @brief 记录1~1000微秒各一次，分位数与真实值的误差在桶的精度以内
+ */
+TEST(StatsTest, HistogramSummaryTest) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.summarize().count, 0u);
+    for (int us = 1000; us >= 1; us--) {
+        histogram.record(std::chrono::microseconds(us));
+    }
+    LatencySummary summary = histogram.summarize();
+    EXPECT_EQ(summary.count, 1000u);
+    EXPECT_NEAR(summary.mean_us, 500.5, 0.01);
+    EXPECT_NEAR(summary.p50_us, 500, 500 * 0.25);
+    EXPECT_NEAR(summary.p99_us, 990, 990 * 0.25);
+    EXPECT_DOUBLE_EQ(summary.max_us, 1000);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.summarize().count, 0u);
+}
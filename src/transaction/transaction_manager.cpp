@@ -86,7 +86,7 @@ void TransactionManager::abort(Transaction *txn, LogManager *log_manager) {
         if (type == WType::INSERT_TUPLE) {
             auto &tab_name = item->GetTableName();
             auto &rid = item->GetRid();
-            auto tab = sm_manager_->db_.get_table(tab_name);
+            auto &tab = sm_manager_->db_.get_table(tab_name);
             auto rec = sm_manager_->fhs_.at(tab_name)->get_record(rid, context);
             // Delete index
             for (size_t i = 0; i < tab.indexes.size(); ++i) {
@@ -99,14 +99,15 @@ void TransactionManager::abort(Transaction *txn, LogManager *log_manager) {
                     memcpy(key + offset, rec->data + index.cols[j].offset, index.cols[j].len);
                     offset += index.cols[j].len;
                 }
-                ih->delete_entry(key, context->txn_);
+                // 插入时键值重复的记录没有写入索引，只删除指向该记录的索引项
+                ih->delete_entry(key, rid, context->txn_);
             }
             // Delete record file
             sm_manager_->fhs_.at(tab_name).get()->delete_record(rid, context);
         } else if (type == WType::DELETE_TUPLE) {
             auto &tab_name = item->GetTableName();
             auto &rec = item->GetRecord();
-            auto tab = sm_manager_->db_.get_table(tab_name);
+            auto &tab = sm_manager_->db_.get_table(tab_name);
             // Insert into record file
             auto rid = sm_manager_->fhs_.at(tab_name)->insert_record(rec.data, context);
             // Insert into index
@@ -126,7 +127,7 @@ void TransactionManager::abort(Transaction *txn, LogManager *log_manager) {
             auto &tab_name = item->GetTableName();
             auto &rid = item->GetRid();
             auto &record = item->GetRecord();
-            auto tab = sm_manager_->db_.get_table(tab_name);
+            auto &tab = sm_manager_->db_.get_table(tab_name);
             auto rec = sm_manager_->fhs_.at(tab_name)->get_record(rid, context);
             // Delete index
             for (size_t i = 0; i < tab.indexes.size(); ++i) {